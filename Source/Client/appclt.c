@@ -144,7 +144,7 @@ static void qsc_socket_receive_async_callback(qsc_socket* source, const uint8_t*
 		/* convert the bytes to packet */
 		pkt.pmessage = mpkt;
 		if (skdp_stream_to_packet(message, *msglen, &pkt, sizeof(mpkt)) == true &&
-			pkt.flag == skdp_flag_encrypted_message)
+			(pkt.flag == skdp_flag_encrypted_message || pkt.flag == skdp_flag_key_update))
 		{
 			qerr = skdp_client_decrypt_packet(&m_skdp_client_ctx, &pkt, (uint8_t*)msgstr, sizeof(msgstr), msglen);
 
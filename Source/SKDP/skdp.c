@@ -1,19 +1,25 @@
 #include "skdp.h"
 #include "acp.h"
+#include "async.h"
 #include "intutils.h"
 #include "memutils.h"
 #include "timestamp.h"
+#if defined(__x86_64__) || defined(__i386__)
+#	include <cpuid.h>
+#endif
 
-#if defined(SKDP_USE_RCS_ENCRYPTION)
-#	if defined(SKDP_PROTOCOL_SEC512)
+#if defined(SKDP_PROTOCOL_SEC512)
 const char SKDP_CONFIG_STRING[SKDP_CONFIG_SIZE] = "r03-skdp-rcs512-keccak512";
-#	else
+#elif defined(SKDP_USE_RCS_ENCRYPTION)
 const char SKDP_CONFIG_STRING[SKDP_CONFIG_SIZE] = "r02-skdp-rcs256-keccak256";
-#	endif
 #else
 const char SKDP_CONFIG_STRING[SKDP_CONFIG_SIZE] = "r01-skdp-aes256-keccak256";
 #endif
 
+static const uint8_t SKDP_CONNECTION_ID_LABEL[] = "skdp connection id";
+static const uint8_t SKDP_KEY_UPDATE_LABEL[] = "skdp key update";
+static const uint8_t SKDP_SESSION_EXPORT_LABEL[] = "skdp session export";
+
 const char SKDP_ERROR_STRINGS[SKDP_ERROR_STRING_DEPTH][SKDP_ERROR_STRING_WIDTH] =
 {
 	"No error was detected.",
@@ -33,8 +39,366 @@ const char SKDP_ERROR_STRINGS[SKDP_ERROR_STRING_DEPTH][SKDP_ERROR_STRING_WIDTH]
 	"The packet was received out of sequence.",
 	"The packet valid-time was exceeded",
 	"A general failure occurred",
+	"The device key has been revoked.",
+};
+
+#if defined(SKDP_PROTOCOL_SEC256)
+static void skdp_aes256_dispose(skdp_cipher_state* state)
+{
+	qsc_aes_gcm256_dispose(&state->cipher.aes);
+}
+
+static void skdp_aes256_initialize(skdp_cipher_state* state, const uint8_t* key, uint8_t* nonce, bool encrypt)
+{
+	qsc_aes_keyparams kp = { 0 };
+
+	kp.key = key;
+	kp.keylen = 32U;
+	kp.nonce = nonce;
+	kp.noncelen = 16U;
+	kp.info = NULL;
+	kp.infolen = 0U;
+	qsc_aes_gcm256_initialize(&state->cipher.aes, &kp, encrypt);
+}
+
+static void skdp_aes256_set_associated(skdp_cipher_state* state, const uint8_t* data, size_t length)
+{
+	qsc_aes_gcm256_set_associated(&state->cipher.aes, data, length);
+}
+
+static bool skdp_aes256_transform(skdp_cipher_state* state, uint8_t* output, const uint8_t* input, size_t length)
+{
+	return qsc_aes_gcm256_transform(&state->cipher.aes, output, input, length);
+}
+#endif
+
+static void skdp_rcs_dispose(skdp_cipher_state* state)
+{
+	qsc_rcs_dispose(&state->cipher.rcs);
+}
+
+static void skdp_rcs_initialize(skdp_cipher_state* state, const uint8_t* key, uint8_t* nonce, bool encrypt)
+{
+	qsc_rcs_keyparams kp = { 0 };
+
+	/* the key length selects RCS-256 or RCS-512 */
+	kp.key = key;
+	kp.keylen = state->suite->keysize;
+	kp.nonce = nonce;
+	kp.info = NULL;
+	kp.infolen = 0U;
+	qsc_rcs_initialize(&state->cipher.rcs, &kp, encrypt);
+}
+
+static void skdp_rcs_set_associated(skdp_cipher_state* state, const uint8_t* data, size_t length)
+{
+	qsc_rcs_set_associated(&state->cipher.rcs, data, length);
+}
+
+static bool skdp_rcs_transform(skdp_cipher_state* state, uint8_t* output, const uint8_t* input, size_t length)
+{
+	return qsc_rcs_transform(&state->cipher.rcs, output, input, length);
+}
+
+/* the suites compiled for the configured security level; the default is the entry named by SKDP_CONFIG_STRING */
+static const skdp_cipher_suite SKDP_CIPHER_SUITES[] =
+{
+#if defined(SKDP_PROTOCOL_SEC512)
+	{ "r03-skdp-rcs512-keccak512", &skdp_rcs_dispose, &skdp_rcs_initialize, &skdp_rcs_set_associated, &skdp_rcs_transform, 64U, 32U, 64U, skdp_suite_rcs512 },
+#else
+	{ "r01-skdp-aes256-keccak256", &skdp_aes256_dispose, &skdp_aes256_initialize, &skdp_aes256_set_associated, &skdp_aes256_transform, 32U, 16U, 16U, skdp_suite_aes256 },
+	{ "r02-skdp-rcs256-keccak256", &skdp_rcs_dispose, &skdp_rcs_initialize, &skdp_rcs_set_associated, &skdp_rcs_transform, 32U, 32U, 32U, skdp_suite_rcs256 },
+#endif
 };
 
+static qsc_thread m_skdp_clock_thread;
+static volatile uint64_t m_skdp_cpu_features;
+static volatile uint64_t m_skdp_clock_resolution;
+static volatile uint64_t m_skdp_clock_time;
+
+static void skdp_clock_timer(void* state)
+{
+	(void)state;
+
+	while (SKDP_ATOMIC_LOAD(&m_skdp_clock_resolution) != 0U)
+	{
+		skdp_clock_tick();
+		qsc_async_thread_sleep((uint32_t)SKDP_ATOMIC_LOAD(&m_skdp_clock_resolution));
+	}
+}
+
+static uint32_t skdp_cpu_probe(void)
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	uint32_t reg[4U] = { 0U };
+#endif
+	uint32_t feat;
+
+	feat = skdp_cpu_feature_none;
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	/* leaf 1 ecx holds the aes and pclmulqdq bits */
+#	if defined(QSC_SYSTEM_COMPILER_MSC)
+	__cpuidex((int*)reg, 1, 0);
+#	else
+	__cpuid_count(1U, 0U, reg[0U], reg[1U], reg[2U], reg[3U]);
+#	endif
+
+	if ((reg[2U] & (1UL << 25U)) != 0U)
+	{
+		feat |= skdp_cpu_feature_aesni;
+	}
+
+	if ((reg[2U] & (1UL << 1U)) != 0U)
+	{
+		feat |= skdp_cpu_feature_pclmul;
+	}
+#endif
+
+	return feat;
+}
+
+void skdp_connection_id_derive(uint8_t* cid, const uint8_t* dsec, const uint8_t* ssec)
+{
+	SKDP_ASSERT(cid != NULL);
+	SKDP_ASSERT(dsec != NULL);
+	SKDP_ASSERT(ssec != NULL);
+
+	qsc_keccak_state kctx = { 0 };
+	uint8_t prnd[SKDP_PERMUTATION_RATE] = { 0U };
+
+	if (cid != NULL && dsec != NULL && ssec != NULL)
+	{
+		/* cid = cSHAKE(dsec, label, ssec) */
+		qsc_cshake_initialize(&kctx, SKDP_PERMUTATION_RATE, dsec, SKDP_KEY_UPDATE_SECRET_SIZE, SKDP_CONNECTION_ID_LABEL, sizeof(SKDP_CONNECTION_ID_LABEL) - 1U, ssec, SKDP_KEY_UPDATE_SECRET_SIZE);
+		qsc_cshake_squeezeblocks(&kctx, SKDP_PERMUTATION_RATE, prnd, 1U);
+		qsc_memutils_copy(cid, prnd, SKDP_CONNECTION_ID_SIZE);
+
+		qsc_memutils_secure_erase(&kctx, sizeof(qsc_keccak_state));
+		qsc_memutils_secure_erase(prnd, sizeof(prnd));
+	}
+}
+
+void skdp_connection_id_update(uint8_t* cid, const uint8_t* dsec, const uint8_t* ssec)
+{
+	SKDP_ASSERT(cid != NULL);
+	SKDP_ASSERT(dsec != NULL);
+	SKDP_ASSERT(ssec != NULL);
+
+	qsc_keccak_state kctx = { 0 };
+	uint8_t cust[SKDP_KEY_UPDATE_SECRET_SIZE + SKDP_CONNECTION_ID_SIZE] = { 0U };
+	uint8_t prnd[SKDP_PERMUTATION_RATE] = { 0U };
+
+	if (cid != NULL && dsec != NULL && ssec != NULL)
+	{
+		/* cid = cSHAKE(dsec, label, ssec || cid), the longer customization separates it from the initial derivation */
+		qsc_memutils_copy(cust, ssec, SKDP_KEY_UPDATE_SECRET_SIZE);
+		qsc_memutils_copy(cust + SKDP_KEY_UPDATE_SECRET_SIZE, cid, SKDP_CONNECTION_ID_SIZE);
+		qsc_cshake_initialize(&kctx, SKDP_PERMUTATION_RATE, dsec, SKDP_KEY_UPDATE_SECRET_SIZE, SKDP_CONNECTION_ID_LABEL, sizeof(SKDP_CONNECTION_ID_LABEL) - 1U, cust, sizeof(cust));
+		qsc_cshake_squeezeblocks(&kctx, SKDP_PERMUTATION_RATE, prnd, 1U);
+		qsc_memutils_copy(cid, prnd, SKDP_CONNECTION_ID_SIZE);
+
+		qsc_memutils_secure_erase(&kctx, sizeof(qsc_keccak_state));
+		qsc_memutils_secure_erase(cust, sizeof(cust));
+		qsc_memutils_secure_erase(prnd, sizeof(prnd));
+	}
+}
+
+uint32_t skdp_cipher_cpu_features(void)
+{
+	uint64_t feat;
+
+	feat = SKDP_ATOMIC_LOAD_RELAXED(&m_skdp_cpu_features);
+
+	/* the high bit marks a completed probe; concurrent first calls store the same value */
+	if (feat == 0U)
+	{
+		feat = (uint64_t)skdp_cpu_probe() | (1ULL << 63U);
+		SKDP_ATOMIC_STORE_RELAXED(&m_skdp_cpu_features, feat);
+	}
+
+	return (uint32_t)feat;
+}
+
+void skdp_cipher_dispose(skdp_cipher_state* state)
+{
+	SKDP_ASSERT(state != NULL);
+
+	if (state != NULL)
+	{
+		if (state->suite != NULL)
+		{
+			state->suite->dispose(state);
+		}
+
+		qsc_memutils_secure_erase(state, sizeof(skdp_cipher_state));
+	}
+}
+
+void skdp_cipher_initialize(skdp_cipher_state* state, const skdp_cipher_suite* suite, const uint8_t* key, uint8_t* nonce, bool encrypt)
+{
+	SKDP_ASSERT(state != NULL);
+	SKDP_ASSERT(suite != NULL);
+	SKDP_ASSERT(key != NULL);
+	SKDP_ASSERT(nonce != NULL);
+
+	if (state != NULL && suite != NULL && key != NULL && nonce != NULL)
+	{
+		state->suite = suite;
+		suite->initialize(state, key, nonce, encrypt);
+	}
+}
+
+void skdp_cipher_set_associated(skdp_cipher_state* state, const uint8_t* data, size_t length)
+{
+	SKDP_ASSERT(state != NULL);
+
+	state->suite->set_associated(state, data, length);
+}
+
+const skdp_cipher_suite* skdp_cipher_suite_default(void)
+{
+	const skdp_cipher_suite* suite;
+
+	suite = skdp_cipher_suite_from_config(SKDP_CONFIG_STRING);
+	SKDP_ASSERT(suite != NULL);
+
+	return suite;
+}
+
+const skdp_cipher_suite* skdp_cipher_suite_from_config(const char* config)
+{
+	SKDP_ASSERT(config != NULL);
+
+	const skdp_cipher_suite* suite;
+	size_t i;
+
+	suite = NULL;
+
+	if (config != NULL)
+	{
+		for (i = 0U; i < sizeof(SKDP_CIPHER_SUITES) / sizeof(SKDP_CIPHER_SUITES[0U]); ++i)
+		{
+			if (qsc_intutils_are_equal8((const uint8_t*)config, (const uint8_t*)SKDP_CIPHER_SUITES[i].config, SKDP_CONFIG_SIZE) == true)
+			{
+				suite = &SKDP_CIPHER_SUITES[i];
+				break;
+			}
+		}
+	}
+
+	return suite;
+}
+
+const skdp_cipher_suite* skdp_cipher_suite_from_id(skdp_suite_id id)
+{
+	const skdp_cipher_suite* suite;
+	size_t i;
+
+	suite = NULL;
+
+	for (i = 0U; i < sizeof(SKDP_CIPHER_SUITES) / sizeof(SKDP_CIPHER_SUITES[0U]); ++i)
+	{
+		if (SKDP_CIPHER_SUITES[i].id == id)
+		{
+			suite = &SKDP_CIPHER_SUITES[i];
+			break;
+		}
+	}
+
+	return suite;
+}
+
+const skdp_cipher_suite* skdp_cipher_suite_preferred(void)
+{
+#if defined(SKDP_PROTOCOL_SEC256) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+	const uint32_t GCMHW = skdp_cpu_feature_aesni | skdp_cpu_feature_pclmul;
+#endif
+	const skdp_cipher_suite* suite;
+
+	suite = skdp_cipher_suite_default();
+
+#if defined(SKDP_PROTOCOL_SEC256) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+	/* only a processor probed and known to lack the gcm instructions moves off the default */
+	if ((skdp_cipher_cpu_features() & GCMHW) != GCMHW && skdp_cipher_suite_from_id(skdp_suite_rcs256) != NULL)
+	{
+		suite = skdp_cipher_suite_from_id(skdp_suite_rcs256);
+	}
+#endif
+
+	SKDP_ASSERT(suite != NULL);
+
+	return suite;
+}
+
+bool skdp_cipher_transform(skdp_cipher_state* state, uint8_t* output, const uint8_t* input, size_t length)
+{
+	SKDP_ASSERT(state != NULL);
+
+	return state->suite->transform(state, output, input, length);
+}
+
+uint64_t skdp_clock_now(void)
+{
+	uint64_t ltime;
+
+	ltime = SKDP_ATOMIC_LOAD_RELAXED(&m_skdp_clock_time);
+
+	if (ltime == 0U)
+	{
+		ltime = qsc_timestamp_datetime_utc();
+	}
+
+	return ltime;
+}
+
+bool skdp_clock_start(uint32_t resolution)
+{
+	bool res;
+
+	res = false;
+
+	/* only one timer thread runs at a time */
+	if (SKDP_ATOMIC_CAS(&m_skdp_clock_resolution, 0U, (resolution != 0U) ? resolution : SKDP_CLOCK_RESOLUTION) == true)
+	{
+		skdp_clock_tick();
+		m_skdp_clock_thread = qsc_async_thread_create(&skdp_clock_timer, NULL);
+
+		if (m_skdp_clock_thread != 0)
+		{
+			res = true;
+		}
+		else
+		{
+			skdp_clock_stop();
+		}
+	}
+
+	return res;
+}
+
+void skdp_clock_stop(void)
+{
+	if (SKDP_ATOMIC_LOAD(&m_skdp_clock_resolution) != 0U)
+	{
+		SKDP_ATOMIC_STORE(&m_skdp_clock_resolution, 0U);
+
+		/* wait for the timer to retire so a late tick cannot re-enable the cache */
+		if (m_skdp_clock_thread != 0)
+		{
+			qsc_async_thread_wait(m_skdp_clock_thread);
+			m_skdp_clock_thread = 0;
+		}
+	}
+
+	SKDP_ATOMIC_STORE_RELAXED(&m_skdp_clock_time, 0U);
+}
+
+void skdp_clock_tick(void)
+{
+	SKDP_ATOMIC_STORE_RELAXED(&m_skdp_clock_time, qsc_timestamp_datetime_utc());
+}
+
 void skdp_deserialize_device_key(skdp_device_key* dkey, const uint8_t input[SKDP_DEVKEY_ENCODED_SIZE])
 {
 	SKDP_ASSERT(dkey != NULL);
@@ -225,7 +589,7 @@ skdp_errors skdp_message_to_error(uint8_t message)
 
 	err = (skdp_errors)message;
 
-	if (err == skdp_error_none || err > skdp_error_general_failure)
+	if (err == skdp_error_none || err > skdp_error_device_revoked)
 	{
 		err = skdp_error_general_failure;
 	}
@@ -233,6 +597,80 @@ skdp_errors skdp_message_to_error(uint8_t message)
 	return err;
 }
 
+bool skdp_key_update_account(skdp_key_update* kupdate, size_t msglen)
+{
+	SKDP_ASSERT(kupdate != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (kupdate != NULL)
+	{
+		kupdate->txbytes += msglen;
+		kupdate->txrecords += 1U;
+
+		if ((kupdate->maxbytes != 0U && kupdate->txbytes >= kupdate->maxbytes) ||
+			(kupdate->maxrecords != 0U && kupdate->txrecords >= kupdate->maxrecords))
+		{
+			kupdate->txbytes = 0U;
+			kupdate->txrecords = 0U;
+			res = true;
+		}
+	}
+
+	return res;
+}
+
+void skdp_key_update_derive(uint8_t* secret, const uint8_t* token, size_t toklen, const uint8_t* sth)
+{
+	SKDP_ASSERT(secret != NULL);
+	SKDP_ASSERT(token != NULL);
+	SKDP_ASSERT(sth != NULL);
+
+	qsc_keccak_state kctx = { 0 };
+	uint8_t prnd[SKDP_PERMUTATION_RATE] = { 0U };
+
+	if (secret != NULL && token != NULL && sth != NULL)
+	{
+		/* secret = cSHAKE(token, label, sth), domain separated from the channel cipher key */
+		qsc_cshake_initialize(&kctx, SKDP_PERMUTATION_RATE, token, toklen, SKDP_KEY_UPDATE_LABEL, sizeof(SKDP_KEY_UPDATE_LABEL) - 1U, sth, SKDP_STH_SIZE);
+		qsc_cshake_squeezeblocks(&kctx, SKDP_PERMUTATION_RATE, prnd, 1U);
+		qsc_memutils_copy(secret, prnd, SKDP_KEY_UPDATE_SECRET_SIZE);
+
+		qsc_memutils_secure_erase(&kctx, sizeof(qsc_keccak_state));
+		qsc_memutils_secure_erase(prnd, sizeof(prnd));
+	}
+}
+
+void skdp_key_update_ratchet(skdp_cipher_state* state, uint8_t* secret, bool encrypt)
+{
+	SKDP_ASSERT(state != NULL);
+	SKDP_ASSERT(secret != NULL);
+
+	/* the next key, nonce, and secret fit in three blocks at the 512-bit rate, one at the 256-bit rate */
+	const size_t RNDBLK = (SKDP_CPRKEY_SIZE + SKDP_NONCE_SIZE + SKDP_KEY_UPDATE_SECRET_SIZE + SKDP_PERMUTATION_RATE - 1U) / SKDP_PERMUTATION_RATE;
+	qsc_keccak_state kctx = { 0 };
+	uint8_t prnd[SKDP_PERMUTATION_RATE * 3U] = { 0U };
+	const skdp_cipher_suite* suite;
+
+	if (state != NULL && secret != NULL && state->suite != NULL)
+	{
+		suite = state->suite;
+
+		/* key || nonce || secret = cSHAKE(secret, label) */
+		qsc_cshake_initialize(&kctx, SKDP_PERMUTATION_RATE, secret, SKDP_KEY_UPDATE_SECRET_SIZE, SKDP_KEY_UPDATE_LABEL, sizeof(SKDP_KEY_UPDATE_LABEL) - 1U, NULL, 0U);
+		qsc_cshake_squeezeblocks(&kctx, SKDP_PERMUTATION_RATE, prnd, RNDBLK);
+		qsc_memutils_copy(secret, prnd + suite->keysize + suite->noncesize, SKDP_KEY_UPDATE_SECRET_SIZE);
+
+		skdp_cipher_dispose(state);
+		skdp_cipher_initialize(state, suite, prnd, prnd + suite->keysize, encrypt);
+
+		qsc_memutils_secure_erase(&kctx, sizeof(qsc_keccak_state));
+		qsc_memutils_secure_erase(prnd, sizeof(prnd));
+	}
+}
+
 void skdp_packet_clear(skdp_network_packet* packet)
 {
 	SKDP_ASSERT(packet != NULL);
@@ -291,7 +729,7 @@ void skdp_packet_set_utc_time(skdp_network_packet* packet)
 
 	if (packet != NULL)
 	{
-		packet->utctime = qsc_timestamp_datetime_utc();
+		packet->utctime = skdp_clock_now();
 	}
 }
 
@@ -306,7 +744,7 @@ bool skdp_packet_time_valid(const skdp_network_packet* packet)
 
 	if (packet != NULL)
 	{
-		ltime = qsc_timestamp_datetime_utc();
+		ltime = skdp_clock_now();
 
 		/* two-way variance to account for differences in system clocks */
 		if (ltime > 0U && ltime < UINT64_MAX &&
@@ -320,6 +758,98 @@ bool skdp_packet_time_valid(const skdp_network_packet* packet)
 	return res;
 }
 
+static void skdp_session_cipher(skdp_cipher_state* state, const skdp_cipher_suite* suite, const uint8_t* key, const uint8_t* header, bool encrypt)
+{
+	const size_t RNDBLK = (SKDP_CPRKEY_SIZE + SKDP_NONCE_SIZE + SKDP_PERMUTATION_RATE - 1U) / SKDP_PERMUTATION_RATE;
+	qsc_keccak_state kctx = { 0 };
+	uint8_t prnd[SKDP_PERMUTATION_RATE * 2U] = { 0U };
+
+	/* key || nonce = cSHAKE(export key, label, salt) */
+	qsc_cshake_initialize(&kctx, SKDP_PERMUTATION_RATE, key, SKDP_SESSION_EXPORT_KEY_SIZE, SKDP_SESSION_EXPORT_LABEL, sizeof(SKDP_SESSION_EXPORT_LABEL) - 1U,
+		header + SKDP_SESSION_EXPORT_HEADER_SIZE, SKDP_SESSION_EXPORT_SALT_SIZE);
+	qsc_cshake_squeezeblocks(&kctx, SKDP_PERMUTATION_RATE, prnd, RNDBLK);
+	skdp_cipher_initialize(state, suite, prnd, prnd + suite->keysize, encrypt);
+
+	/* the header and salt are bound to the ciphertext */
+	skdp_cipher_set_associated(state, header, SKDP_SESSION_EXPORT_HEADER_SIZE + SKDP_SESSION_EXPORT_SALT_SIZE);
+
+	qsc_memutils_secure_erase(&kctx, sizeof(qsc_keccak_state));
+	qsc_memutils_secure_erase(prnd, sizeof(prnd));
+}
+
+bool skdp_session_open(uint8_t* output, size_t statelen, const uint8_t* input, size_t inlen, const uint8_t* key, skdp_session_role role)
+{
+	SKDP_ASSERT(output != NULL);
+	SKDP_ASSERT(input != NULL);
+	SKDP_ASSERT(key != NULL);
+
+	skdp_cipher_state cstate = { 0 };
+	const skdp_cipher_suite* suite;
+	bool res;
+
+	res = false;
+
+	if (output != NULL && input != NULL && key != NULL && inlen >= SKDP_SESSION_EXPORT_HEADER_SIZE + SKDP_SESSION_EXPORT_SALT_SIZE)
+	{
+		suite = skdp_cipher_suite_from_id((skdp_suite_id)input[2U]);
+
+		if (input[0U] == SKDP_SESSION_EXPORT_VERSION && input[1U] == (uint8_t)role && suite != NULL &&
+			qsc_intutils_le8to32(input + 4U) == (uint32_t)statelen &&
+			inlen == SKDP_SESSION_EXPORT_HEADER_SIZE + SKDP_SESSION_EXPORT_SALT_SIZE + statelen + suite->tagsize)
+		{
+			skdp_session_cipher(&cstate, suite, key, input, false);
+			res = skdp_cipher_transform(&cstate, output, input + SKDP_SESSION_EXPORT_HEADER_SIZE + SKDP_SESSION_EXPORT_SALT_SIZE, statelen);
+			skdp_cipher_dispose(&cstate);
+
+			if (res == false)
+			{
+				qsc_memutils_secure_erase(output, statelen);
+			}
+		}
+	}
+
+	return res;
+}
+
+size_t skdp_session_seal(uint8_t* output, size_t otplen, const uint8_t* state, size_t statelen, const uint8_t* key, skdp_session_role role)
+{
+	SKDP_ASSERT(output != NULL);
+	SKDP_ASSERT(state != NULL);
+	SKDP_ASSERT(key != NULL);
+
+	skdp_cipher_state cstate = { 0 };
+	const skdp_cipher_suite* suite;
+	size_t res;
+
+	res = 0U;
+	suite = skdp_cipher_suite_default();
+
+	if (output != NULL && state != NULL && key != NULL && suite != NULL && statelen <= UINT32_MAX &&
+		otplen >= SKDP_SESSION_EXPORT_HEADER_SIZE + SKDP_SESSION_EXPORT_SALT_SIZE + statelen + suite->tagsize)
+	{
+		/* version || role || suite || reserved || state length */
+		output[0U] = SKDP_SESSION_EXPORT_VERSION;
+		output[1U] = (uint8_t)role;
+		output[2U] = (uint8_t)suite->id;
+		output[3U] = 0U;
+		qsc_intutils_le32to8(output + 4U, (uint32_t)statelen);
+
+		if (qsc_acp_generate(output + SKDP_SESSION_EXPORT_HEADER_SIZE, SKDP_SESSION_EXPORT_SALT_SIZE) == true)
+		{
+			skdp_session_cipher(&cstate, suite, key, output, true);
+
+			if (skdp_cipher_transform(&cstate, output + SKDP_SESSION_EXPORT_HEADER_SIZE + SKDP_SESSION_EXPORT_SALT_SIZE, state, statelen) == true)
+			{
+				res = SKDP_SESSION_EXPORT_HEADER_SIZE + SKDP_SESSION_EXPORT_SALT_SIZE + statelen + suite->tagsize;
+			}
+
+			skdp_cipher_dispose(&cstate);
+		}
+	}
+
+	return res;
+}
+
 size_t skdp_packet_to_stream(const skdp_network_packet* packet, uint8_t* pstream)
 {
 	SKDP_ASSERT(packet != NULL);
@@ -57,14 +57,16 @@
 
 /*!
 * \def SKDP_USE_RCS_ENCRYPTION
-* \brief If the RCS encryption option is chosen SKDP uses the more modern RCS stream cipher with KMAC/QMAC authentication.
-* The default symmetric cipher/authenticator is AES-256/GCM (GMAC Counter Mode) NIST standardized per SP800-38a.
+* \brief Make the RCS-256 suite the default suite offered by the client, and used for key derivation.
+* All suites of the configured security level are compiled in and negotiated at runtime from the configuration string;
+* this option only selects the default. The default suite is AES-256/GCM (GMAC Counter Mode) NIST standardized per SP800-38a.
 */
 //#define SKDP_USE_RCS_ENCRYPTION
 
 /*!
 * \def SKDP_PROTOCOL_SEC512
 * \brief Use 512-bit end-to-end encryption with the RCS-512 cipher.
+* The 512-bit configuration changes the key and hash sizes, and is selected at compile time.
 */
 //#define SKDP_PROTOCOL_SEC512
 
@@ -80,23 +82,8 @@
 #	endif
 #endif
 
-#if defined(SKDP_USE_RCS_ENCRYPTION)
-#	include "rcs.h"
-#	define skdp_cipher_state qsc_rcs_state
-#	define skdp_cipher_dispose qsc_rcs_dispose
-#	define skdp_cipher_initialize qsc_rcs_initialize
-#	define skdp_cipher_keyparams qsc_rcs_keyparams
-#	define skdp_cipher_set_associated qsc_rcs_set_associated
-#	define skdp_cipher_transform qsc_rcs_transform
-#else
-#	include "aes.h"
-#	define skdp_cipher_state qsc_aes_gcm256_state
-#	define skdp_cipher_dispose qsc_aes_gcm256_dispose
-#	define skdp_cipher_initialize qsc_aes_gcm256_initialize
-#	define skdp_cipher_keyparams qsc_aes_keyparams
-#	define skdp_cipher_set_associated qsc_aes_gcm256_set_associated
-#	define skdp_cipher_transform qsc_aes_gcm256_transform
-#endif
+#include "aes.h"
+#include "rcs.h"
 
 /**
  * \file skdp.h
@@ -136,6 +123,12 @@
  * process.
  */
 
+/*!
+ * \def SKDP_CLOCK_RESOLUTION
+ * \brief The default update interval of the cached clock in milliseconds.
+ */
+#define SKDP_CLOCK_RESOLUTION 250U
+
 /*!
  * \def SKDP_CONFIG_SIZE
  * \brief The size of the protocol configuration string.
@@ -166,6 +159,18 @@
  */
 #define SKDP_KEEPALIVE_MESSAGE 8U
 
+/*!
+ * \def SKDP_KEEPALIVE_PACKET_SIZE
+ * \brief The size (in bytes) of a serialized keep alive packet.
+ */
+#define SKDP_KEEPALIVE_PACKET_SIZE (SKDP_HEADER_SIZE + SKDP_KEEPALIVE_MESSAGE)
+
+/*!
+ * \def SKDP_KEEPALIVE_BATCH
+ * \brief The default number of keep alive packets in a sweep batch.
+ */
+#define SKDP_KEEPALIVE_BATCH 256U
+
 /*!
  * \def SKDP_KEEPALIVE_STRING
  * \brief The keep alive string size in bytes.
@@ -178,6 +183,12 @@
  */
 #define SKDP_KEEPALIVE_TIMEOUT (300U * 1000U)
 
+/*!
+ * \def SKDP_KEEPALIVE_IDLE
+ * \brief The default idle interval (in seconds) without an authenticated record before a keep-alive probe is sent.
+ */
+#define SKDP_KEEPALIVE_IDLE (SKDP_KEEPALIVE_TIMEOUT / 1000U)
+
 /*!
  * \def SKDP_MESSAGE_SIZE
  * \brief The message size (in bytes) used during a communications session.
@@ -191,14 +202,10 @@
 #define SKDP_MESSAGE_MAX (SKDP_MESSAGE_SIZE + SKDP_HEADER_SIZE)
 
 /*!
- * \def SKDP_MESSAGE_SIZE
- * \brief The message size (in bytes) used during a communications session.
+ * \def SKDP_NONCE_SIZE
+ * \brief The maximum cipher nonce size (in bytes) of the compiled cipher suites.
  */
-#if defined(SKDP_USE_RCS_ENCRYPTION)
-#	define SKDP_NONCE_SIZE 32U
-#else
-#	define SKDP_NONCE_SIZE 16U
-#endif
+#define SKDP_NONCE_SIZE 32U
 
 /*!
  * \def SKDP_SERVER_PORT
@@ -243,11 +250,11 @@
 #define SKDP_SEQUENCE_TERMINATOR 0xFFFFFFFFUL
 
 /*!
- * \brief The SKDP configuration string for 256-bit security.
+ * \brief The default SKDP configuration string, used for key derivation and offered by default.
  */
 extern const char SKDP_CONFIG_STRING[SKDP_CONFIG_SIZE];
 
-#if defined(SKDP_PROTOCOL_SEC512) && defined(SKDP_USE_RCS_ENCRYPTION)
+#if defined(SKDP_PROTOCOL_SEC512)
 
 /* 512-bit security configuration definitions */
 
@@ -289,7 +296,7 @@ extern const char SKDP_CONFIG_STRING[SKDP_CONFIG_SIZE];
 
 /*!
  * \def SKDP_MACTAG_SIZE
- * \brief The MAC tag size (in bytes) for 512-bit security.
+ * \brief The maximum MAC tag size (in bytes) for 512-bit security.
  */
 #	define SKDP_MACTAG_SIZE 64U
 
@@ -365,13 +372,13 @@ extern const char SKDP_CONFIG_STRING[SKDP_CONFIG_SIZE];
 
 /*!
 * \def SKDP_MACTAG_SIZE
-* \brief The MAC tag size (in bytes) for 256-bit security.
+* \brief The maximum MAC tag size (in bytes) for 256-bit security.
+*
+* \details
+* Each cipher suite defines its own tag size, 16 bytes for AES-256/GCM and 32 bytes for RCS-256;
+* this value sizes buffers for the largest.
 */
-#	if defined(SKDP_USE_RCS_ENCRYPTION)
 #	define SKDP_MACTAG_SIZE 32U
-#else
-#	define SKDP_MACTAG_SIZE 16U
-#endif
 
 /*!
  * \def SKDP_MDK_SIZE
@@ -476,6 +483,28 @@ extern const char SKDP_CONFIG_STRING[SKDP_CONFIG_SIZE];
  */
 #define SKDP_CONNECT_REQUEST_PACKET_SIZE (SKDP_CONNECT_REQUEST_MESSAGE_SIZE + SKDP_HEADER_SIZE)
 
+/*!
+ * \def SKDP_CONNECTION_ID_SIZE
+ * \brief The size (in bytes) of a session connection identifier.
+ */
+#define SKDP_CONNECTION_ID_SIZE 16U
+
+/*!
+ * \def SKDP_REATTACH_REQUEST_MESSAGE_SIZE
+ * \brief The size (in bytes) of a reattach request message; the connection id, the sealed proof, and the tag.
+ *
+ * \details
+ * The reattach request has the size of a connect request, so a listener can read the first packet of a new
+ * connection and dispatch on its flag.
+ */
+#define SKDP_REATTACH_REQUEST_MESSAGE_SIZE SKDP_CONNECT_REQUEST_MESSAGE_SIZE
+
+/*!
+ * \def SKDP_REATTACH_REQUEST_PACKET_SIZE
+ * \brief The size (in bytes) of a reattach request packet.
+ */
+#define SKDP_REATTACH_REQUEST_PACKET_SIZE SKDP_CONNECT_REQUEST_PACKET_SIZE
+
 /*!
  * \def SKDP_EXCHANGE_REQUEST_MESSAGE_SIZE
  * \brief The size (in bytes) of the key exchange request message.
@@ -493,7 +522,7 @@ extern const char SKDP_CONFIG_STRING[SKDP_CONFIG_SIZE];
 
 /*!
  * \def SKDP_ESTABLISH_REQUEST_MESSAGE_SIZE
- * \brief The size (in bytes) of the establish request message.
+ * \brief The maximum size (in bytes) of the establish request message; the negotiated suite tag size sets the actual size.
  */
 #define SKDP_ESTABLISH_REQUEST_MESSAGE_SIZE (SKDP_STH_SIZE + SKDP_MACTAG_SIZE)
 
@@ -538,7 +567,7 @@ extern const char SKDP_CONFIG_STRING[SKDP_CONFIG_SIZE];
 
 /*!
  * \def SKDP_ESTABLISH_RESPONSE_MESSAGE_SIZE
- * \brief The size (in bytes) of the establish response message.
+ * \brief The maximum size (in bytes) of the establish response message; the negotiated suite tag size sets the actual size.
  */
 #define SKDP_ESTABLISH_RESPONSE_MESSAGE_SIZE (SKDP_HASH_SIZE + SKDP_MACTAG_SIZE)
 
@@ -566,10 +595,98 @@ extern const char SKDP_CONFIG_STRING[SKDP_CONFIG_SIZE];
  */
 #define SKDP_ESTABLISH_VERIFY_PACKET_SIZE (SKDP_ESTABLISH_VERIFY_MESSAGE_SIZE + SKDP_HEADER_SIZE)
 
+/*!
+ * \def SKDP_COOKIE_KEY_SIZE
+ * \brief The size (in bytes) of the server cookie authentication key.
+ */
+#define SKDP_COOKIE_KEY_SIZE 32U
+
+/*!
+ * \def SKDP_COOKIE_LIFETIME
+ * \brief The maximum number of seconds a connect cookie is accepted after it was issued.
+ */
+#define SKDP_COOKIE_LIFETIME 30U
+
+/*!
+ * \def SKDP_COOKIE_TAG_SIZE
+ * \brief The size (in bytes) of the connect cookie authentication tag.
+ */
+#define SKDP_COOKIE_TAG_SIZE 32U
+
+/*!
+ * \def SKDP_COOKIE_SIZE
+ * \brief The size (in bytes) of the connect cookie.
+ *
+ * \details
+ * The cookie carries the issue time, the negotiated cipher suite, the device key identity, the device and server
+ * session hashes, and a KMAC tag over those fields keyed with the server cookie key.
+ */
+#define SKDP_COOKIE_SIZE (SKDP_EXP_SIZE + 1U + SKDP_KID_SIZE + SKDP_STH_SIZE + SKDP_STH_SIZE + SKDP_COOKIE_TAG_SIZE)
+
+/*!
+ * \def SKDP_CONNECT_COOKIE_PACKET_SIZE
+ * \brief The size (in bytes) of a connect response packet carrying a cookie.
+ */
+#define SKDP_CONNECT_COOKIE_PACKET_SIZE (SKDP_CONNECT_RESPONSE_PACKET_SIZE + SKDP_COOKIE_SIZE)
+
+/*!
+ * \def SKDP_EXCHANGE_COOKIE_PACKET_SIZE
+ * \brief The size (in bytes) of an exchange request packet echoing a cookie.
+ */
+#define SKDP_EXCHANGE_COOKIE_PACKET_SIZE (SKDP_EXCHANGE_REQUEST_PACKET_SIZE + SKDP_COOKIE_SIZE)
+
+/*!
+ * \def SKDP_KEY_UPDATE_BYTES
+ * \brief The recommended number of message bytes sealed under one channel key before a key update.
+ */
+#define SKDP_KEY_UPDATE_BYTES (1ULL << 36U)
+
+/*!
+ * \def SKDP_KEY_UPDATE_RECORDS
+ * \brief The recommended number of records sealed under one channel key before a key update.
+ */
+#define SKDP_KEY_UPDATE_RECORDS (1ULL << 24U)
+
+/*!
+ * \def SKDP_KEY_UPDATE_SECRET_SIZE
+ * \brief The size (in bytes) of a channel key-update secret.
+ */
+#define SKDP_KEY_UPDATE_SECRET_SIZE SKDP_CPRKEY_SIZE
+
+/*!
+ * \def SKDP_SESSION_EXPORT_HEADER_SIZE
+ * \brief The size (in bytes) of the sealed session export header; version, role, suite, reserved, and state length.
+ */
+#define SKDP_SESSION_EXPORT_HEADER_SIZE 8U
+
+/*!
+ * \def SKDP_SESSION_EXPORT_KEY_SIZE
+ * \brief The size (in bytes) of the session export key.
+ */
+#define SKDP_SESSION_EXPORT_KEY_SIZE 32U
+
+/*!
+ * \def SKDP_SESSION_EXPORT_SALT_SIZE
+ * \brief The size (in bytes) of the random salt that diversifies each session export.
+ */
+#define SKDP_SESSION_EXPORT_SALT_SIZE 32U
+
+/*!
+ * \def SKDP_SESSION_EXPORT_OVERHEAD
+ * \brief The maximum number of bytes a sealed session export adds to the serialized state.
+ */
+#define SKDP_SESSION_EXPORT_OVERHEAD (SKDP_SESSION_EXPORT_HEADER_SIZE + SKDP_SESSION_EXPORT_SALT_SIZE + SKDP_MACTAG_SIZE)
+
+/*!
+ * \def SKDP_SESSION_EXPORT_VERSION
+ * \brief The sealed session export format version.
+ */
+#define SKDP_SESSION_EXPORT_VERSION 0x01U
+
 /* error code strings */
 
 /** \cond DOXYGEN_NO_DOCUMENT */
-#define SKDP_ERROR_STRING_DEPTH 17U
+#define SKDP_ERROR_STRING_DEPTH 18U
 #define SKDP_ERROR_STRING_WIDTH 128U
 
 extern const char SKDP_ERROR_STRINGS[SKDP_ERROR_STRING_DEPTH][SKDP_ERROR_STRING_WIDTH];
@@ -678,6 +795,7 @@ SKDP_EXPORT_API typedef enum skdp_errors
 	skdp_error_unsequenced = 0x0EU,				/*!< The packet was received out of sequence */
 	skdp_error_packet_expired = 0x0FU,			/*!< The packet valid-time was exceeded */
 	skdp_error_general_failure = 0x10U,			/*!< A general failure occurred */
+	skdp_error_device_revoked = 0x11U,			/*!< The device key has been revoked */
 } skdp_errors;
 
 /*!
@@ -702,8 +820,267 @@ SKDP_EXPORT_API typedef enum skdp_flags
 	skdp_flag_keepalive_request = 0x0AU,		/*!< The packet is a keep alive request */
 	skdp_flag_session_established = 0x0BU,		/*!< Indicates that the session has been established */
 	skdp_flag_error_condition = 0x0CU,			/*!< Indicates that the connection experienced an error */
+	skdp_flag_connect_cookie = 0x0DU,			/*!< The packet contains a connection response with a stateless cookie */
+	skdp_flag_exchange_cookie = 0x0EU,			/*!< The packet contains an exchange request echoing a stateless cookie */
+	skdp_flag_key_update = 0x0FU,				/*!< An encrypted message, after which the sender's channel key is ratcheted forward */
+	skdp_flag_reattach_request = 0x10U,			/*!< The packet contains a session reattach request */
+	skdp_flag_reattach_response = 0x11U,		/*!< The packet contains a session reattach response */
+	skdp_flag_hibernate = 0x12U,				/*!< An encrypted record asking the device to hibernate the session, after which the server's channel key is ratcheted forward */
+	skdp_flag_hibernate_ack = 0x13U,			/*!< An encrypted record acknowledging a hibernate request, after which the device's channel key is ratcheted forward */
 } skdp_flags;
 
+/*!
+ * \enum skdp_suite_id
+ * \brief The SKDP cipher suite identifiers, matching the revision prefix of the configuration string.
+ */
+SKDP_EXPORT_API typedef enum skdp_suite_id
+{
+	skdp_suite_none = 0x00U,					/*!< No suite was selected */
+	skdp_suite_aes256 = 0x01U,					/*!< AES-256/GCM with Keccak-256, r01 */
+	skdp_suite_rcs256 = 0x02U,					/*!< RCS-256 with Keccak-256, r02 */
+	skdp_suite_rcs512 = 0x03U,					/*!< RCS-512 with Keccak-512, r03 */
+} skdp_suite_id;
+
+/*!
+ * \enum skdp_session_role
+ * \brief The role of an exported session state.
+ */
+SKDP_EXPORT_API typedef enum skdp_session_role
+{
+	skdp_session_role_none = 0x00U,				/*!< No role was set */
+	skdp_session_role_server = 0x01U,			/*!< A server session */
+	skdp_session_role_client = 0x02U,			/*!< A client session */
+	skdp_session_role_hibernated = 0x03U,		/*!< A hibernated server session */
+} skdp_session_role;
+
+/*!
+ * \enum skdp_cpu_features
+ * \brief The processor features probed for the cipher suite preference.
+ */
+SKDP_EXPORT_API typedef enum skdp_cpu_features
+{
+	skdp_cpu_feature_none = 0x00U,				/*!< No accelerated feature was detected */
+	skdp_cpu_feature_aesni = 0x01U,				/*!< The AES round instructions */
+	skdp_cpu_feature_pclmul = 0x02U,			/*!< The carry-less multiply instruction, used by GHASH */
+} skdp_cpu_features;
+
+/*!
+ * \struct skdp_cipher_state
+ * \brief The SKDP channel cipher state; the state of the negotiated suite's cipher.
+ */
+SKDP_EXPORT_API typedef struct skdp_cipher_state skdp_cipher_state;
+
+/*!
+ * \struct skdp_cipher_suite
+ * \brief The SKDP cipher suite descriptor and dispatch table.
+ */
+SKDP_EXPORT_API typedef struct skdp_cipher_suite
+{
+	const char* config;	/*!< The suite configuration string */
+	void (*dispose)(skdp_cipher_state* state);	/*!< The cipher dispose function */
+	void (*initialize)(skdp_cipher_state* state, const uint8_t* key, uint8_t* nonce, bool encrypt);	/*!< The cipher initialize function */
+	void (*set_associated)(skdp_cipher_state* state, const uint8_t* data, size_t length);	/*!< The cipher associated data function */
+	bool (*transform)(skdp_cipher_state* state, uint8_t* output, const uint8_t* input, size_t length);	/*!< The cipher transform function */
+	size_t keysize;	/*!< The cipher key size in bytes */
+	size_t noncesize;	/*!< The cipher nonce size in bytes */
+	size_t tagsize;	/*!< The authentication tag size in bytes */
+	skdp_suite_id id;	/*!< The suite identifier */
+} skdp_cipher_suite;
+
+struct skdp_cipher_state
+{
+	union
+	{
+		qsc_aes_gcm256_state aes;				/*!< The AES-256/GCM state */
+		qsc_rcs_state rcs;						/*!< The RCS state */
+	} cipher;									/*!< The suite cipher state */
+	const skdp_cipher_suite* suite;				/*!< The suite that initialized the state */
+};
+
+/*!
+ * \struct skdp_key_update
+ * \brief The SKDP in-session key update state.
+ *
+ * \details
+ * Each channel direction has a secret derived at the key exchange, independent of the channel cipher key.
+ * A key update advances the secret with cSHAKE and re-keys the channel cipher from the output, so that neither
+ * the previous keys nor the next keys can be computed from a current cipher key. The transmitter seals the last record
+ * under the old key with the \c skdp_flag_key_update flag and then re-keys; the receiver re-keys after opening it.
+ * A zero threshold disables that trigger.
+ */
+SKDP_EXPORT_API typedef struct skdp_key_update
+{
+	uint8_t rxsec[SKDP_KEY_UPDATE_SECRET_SIZE];	/*!< The receive channel update secret */
+	uint8_t txsec[SKDP_KEY_UPDATE_SECRET_SIZE];	/*!< The transmit channel update secret */
+	uint64_t maxbytes;							/*!< The message bytes sealed under a key before an update */
+	uint64_t maxrecords;						/*!< The records sealed under a key before an update */
+	uint64_t txbytes;							/*!< The message bytes sealed under the current transmit key */
+	uint64_t txrecords;							/*!< The records sealed under the current transmit key */
+} skdp_key_update;
+
+/**
+ * \brief Derive the connection identifier of a newly established session.
+ *
+ * \details
+ * The identifier is derived with cSHAKE from the initial channel key-update secrets, so both ends compute the
+ * same value without an extra message, and it cannot be computed by an observer of the key exchange.
+ * It must be derived before the first in-session key update.
+ *
+ * \param cid The output connection identifier, \c SKDP_CONNECTION_ID_SIZE bytes.
+ * \param dsec [const] The device-to-server channel secret.
+ * \param ssec [const] The server-to-device channel secret.
+ */
+SKDP_EXPORT_API void skdp_connection_id_derive(uint8_t* cid, const uint8_t* dsec, const uint8_t* ssec);
+
+/**
+ * \brief Advance the connection identifier of a session after a reattach.
+ *
+ * \details
+ * The next identifier is derived with cSHAKE from the current identifier and the current channel secrets, so both
+ * ends move to the same value, and an observer cannot link the identifiers a device presents on successive reattaches.
+ *
+ * \param cid The connection identifier, \c SKDP_CONNECTION_ID_SIZE bytes, replaced with the next identifier.
+ * \param dsec [const] The device-to-server channel secret.
+ * \param ssec [const] The server-to-device channel secret.
+ */
+SKDP_EXPORT_API void skdp_connection_id_update(uint8_t* cid, const uint8_t* dsec, const uint8_t* ssec);
+
+/**
+ * \brief Get the processor features that decide the cipher suite preference.
+ *
+ * \details
+ * The processor is probed with CPUID on first use and the result is cached; on other architectures
+ * no feature is reported. The flags only inform \c skdp_cipher_suite_preferred; the cipher kernels are chosen
+ * inside QSC, and SKDP does not dispatch between them.
+ *
+ * \return Returns the \c skdp_cpu_features flags detected on this processor.
+ */
+SKDP_EXPORT_API uint32_t skdp_cipher_cpu_features(void);
+
+/**
+ * \brief Dispose of a channel cipher state.
+ *
+ * \param state A pointer to the cipher state.
+ */
+SKDP_EXPORT_API void skdp_cipher_dispose(skdp_cipher_state* state);
+
+/**
+ * \brief Initialize a channel cipher state with a cipher suite.
+ *
+ * \param state A pointer to the cipher state.
+ * \param suite [const] A pointer to the negotiated cipher suite.
+ * \param key [const] The cipher key, of the suite key size.
+ * \param nonce The cipher nonce, of the suite nonce size.
+ * \param encrypt Initialize for encryption if true, decryption if false.
+ */
+SKDP_EXPORT_API void skdp_cipher_initialize(skdp_cipher_state* state, const skdp_cipher_suite* suite, const uint8_t* key, uint8_t* nonce, bool encrypt);
+
+/**
+ * \brief Set the associated data for the next transform.
+ *
+ * \param state A pointer to the cipher state.
+ * \param data [const] The associated data.
+ * \param length The associated data length.
+ */
+SKDP_EXPORT_API void skdp_cipher_set_associated(skdp_cipher_state* state, const uint8_t* data, size_t length);
+
+/**
+ * \brief Get the cipher suite for a configuration string.
+ *
+ * \param config [const] The configuration string, \c SKDP_CONFIG_SIZE bytes.
+ *
+ * \return Returns the suite, or NULL if the string does not name a suite compiled into this build.
+ */
+SKDP_EXPORT_API const skdp_cipher_suite* skdp_cipher_suite_from_config(const char* config);
+
+/**
+ * \brief Get the cipher suite for a suite identifier.
+ *
+ * \param id The suite identifier.
+ *
+ * \return Returns the suite, or NULL if the suite is not compiled into this build.
+ */
+SKDP_EXPORT_API const skdp_cipher_suite* skdp_cipher_suite_from_id(skdp_suite_id id);
+
+/**
+ * \brief Get the default cipher suite, the suite named by \c SKDP_CONFIG_STRING.
+ *
+ * \return Returns the default suite.
+ */
+SKDP_EXPORT_API const skdp_cipher_suite* skdp_cipher_suite_default(void);
+
+/**
+ * \brief Get the cipher suite preference for this processor.
+ *
+ * \details
+ * This is a suite preference, not a cipher implementation switch: both suites run through the same QSC transforms
+ * whichever is chosen. Returns the default suite, unless an x86 processor is probed and found to lack the AES round and carry-less
+ * multiply instructions, which the GCM mode needs for both the cipher and GHASH. Without them the table-driven
+ * GHASH dominates the record cost, and RCS-256, authenticated with KMAC, is returned instead. Other architectures,
+ * and the 512-bit configuration, always return the default suite.
+ *
+ * The preference is opt-in: a client offers the default suite unless this suite is selected with
+ * \c skdp_client_set_suite, and the server must accept the suite for the connection to succeed.
+ *
+ * \return Returns the preferred suite.
+ */
+SKDP_EXPORT_API const skdp_cipher_suite* skdp_cipher_suite_preferred(void);
+
+/**
+ * \brief Encrypt and tag, or authenticate and decrypt, a channel message.
+ *
+ * \details
+ * Dispatches to the cipher of the suite that initialized the state. When encrypting, the tag is appended to the output;
+ * when decrypting, the input length excludes the tag, which must follow the input.
+ *
+ * \param state A pointer to the cipher state.
+ * \param output The output buffer.
+ * \param input [const] The input buffer.
+ * \param length The message length, excluding the tag.
+ *
+ * \return Returns false if authentication failed.
+ */
+SKDP_EXPORT_API bool skdp_cipher_transform(skdp_cipher_state* state, uint8_t* output, const uint8_t* input, size_t length);
+
+/**
+ * \brief Read the packet time source.
+ *
+ * \details
+ * Returns the cached UTC time when the cached clock is running, using a single relaxed atomic load;
+ * otherwise returns the time from a direct call to \c qsc_timestamp_datetime_utc.
+ *
+ * \return Returns the current UTC time in seconds.
+ */
+SKDP_EXPORT_API uint64_t skdp_clock_now(void);
+
+/**
+ * \brief Start a timer thread that updates the cached clock.
+ *
+ * \details
+ * Packet time stamping and validation read the cached clock while it runs. The cached time may lag the system clock
+ * by up to the resolution, which should be small compared to \c SKDP_PACKET_TIME_THRESHOLD.
+ * An application with its own event loop can call \c skdp_clock_tick from the loop instead.
+ *
+ * \param resolution The update interval in milliseconds; zero selects \c SKDP_CLOCK_RESOLUTION.
+ *
+ * \return Returns true if the timer thread was started.
+ */
+SKDP_EXPORT_API bool skdp_clock_start(uint32_t resolution);
+
+/**
+ * \brief Stop the cached clock timer, and revert to the direct time call.
+ */
+SKDP_EXPORT_API void skdp_clock_stop(void);
+
+/**
+ * \brief Update the cached clock from the system time.
+ *
+ * \details
+ * Called by the timer thread, or periodically by an application event loop. The first call enables the cached clock;
+ * \c skdp_clock_stop disables it.
+ */
+SKDP_EXPORT_API void skdp_clock_tick(void);
+
 /**
  * \brief Deserialize a client device key.
  *
@@ -811,6 +1188,44 @@ SKDP_EXPORT_API void skdp_generate_server_key(skdp_server_key* skey, const skdp_
  */
 SKDP_EXPORT_API void skdp_generate_device_key(skdp_device_key* dkey, const skdp_server_key* skey, const uint8_t kid[SKDP_KID_SIZE]);
 
+/**
+ * \brief Account an outbound record, and test whether it carries a key update.
+ *
+ * \details
+ * Adds the record to the transmit counters. When a threshold is reached the counters are reset and
+ * the function returns true; the caller seals the record with the \c skdp_flag_key_update flag, then calls
+ * skdp_key_update_ratchet on the transmit channel.
+ *
+ * \param kupdate A pointer to the key update state.
+ * \param msglen The message length of the record.
+ *
+ * \return Returns true if this record must carry the key update.
+ */
+SKDP_EXPORT_API bool skdp_key_update_account(skdp_key_update* kupdate, size_t msglen);
+
+/**
+ * \brief Derive a channel key-update secret at the key exchange.
+ *
+ * \param secret The output secret, \c SKDP_KEY_UPDATE_SECRET_SIZE bytes.
+ * \param token [const] The channel token key.
+ * \param toklen The token key length.
+ * \param sth [const] The session hash of the channel, \c SKDP_STH_SIZE bytes.
+ */
+SKDP_EXPORT_API void skdp_key_update_derive(uint8_t* secret, const uint8_t* token, size_t toklen, const uint8_t* sth);
+
+/**
+ * \brief Ratchet a channel cipher and its update secret forward.
+ *
+ * \details
+ * Expands the secret with cSHAKE into the next cipher key, nonce and secret, erases the old secret and
+ * cipher state, and re-initializes the cipher with the same suite.
+ *
+ * \param state A pointer to the initialized channel cipher state.
+ * \param secret The channel update secret, replaced by the next secret.
+ * \param encrypt Initialize the cipher for encryption if true, decryption if false.
+ */
+SKDP_EXPORT_API void skdp_key_update_ratchet(skdp_cipher_state* state, uint8_t* secret, bool encrypt);
+
 /**
  * \brief Clear a SKDP network packet.
  *
@@ -885,7 +1300,7 @@ SKDP_EXPORT_API void skdp_packet_set_utc_time(skdp_network_packet* packet);
  *
  * \details
  * This function compares the UTC time in the SKDP packet header against the local time to verify that the packet
- * was received within the allowed time threshold.
+ * was received within the allowed time threshold. The local time is read with \c skdp_clock_now.
  *
  * \param packet A pointer to the SKDP network packet structure.
  *
@@ -893,6 +1308,43 @@ SKDP_EXPORT_API void skdp_packet_set_utc_time(skdp_network_packet* packet);
  */
 SKDP_EXPORT_API bool skdp_packet_time_valid(const skdp_network_packet* packet);
 
+/**
+ * \brief Open a sealed session export.
+ *
+ * \details
+ * Verifies the version, role and length in the export header, then authenticates and decrypts the serialized
+ * session state. The header and salt are authenticated as associated data.
+ *
+ * \param output The output buffer, receives the serialized state.
+ * \param statelen The expected serialized state length; the output buffer must hold this many bytes.
+ * \param input [const] The sealed export.
+ * \param inlen The length of the sealed export.
+ * \param key [const] The export key, \c SKDP_SESSION_EXPORT_KEY_SIZE bytes.
+ * \param role The expected session role.
+ *
+ * \return Returns true if the export was authenticated and decrypted.
+ */
+SKDP_EXPORT_API bool skdp_session_open(uint8_t* output, size_t statelen, const uint8_t* input, size_t inlen, const uint8_t* key, skdp_session_role role);
+
+/**
+ * \brief Seal a serialized session state for export.
+ *
+ * \details
+ * The output is: header || salt || ciphertext || tag. The cipher key and nonce are derived with cSHAKE from the
+ * export key and a random salt, so one export key can seal any number of sessions. The state is encrypted and
+ * authenticated with the default cipher suite of this build, whose identifier is recorded in the header.
+ *
+ * \param output The output buffer, at least \c statelen + \c SKDP_SESSION_EXPORT_OVERHEAD bytes.
+ * \param otplen The length of the output buffer.
+ * \param state [const] The serialized session state.
+ * \param statelen The serialized state length.
+ * \param key [const] The export key, \c SKDP_SESSION_EXPORT_KEY_SIZE bytes.
+ * \param role The session role.
+ *
+ * \return Returns the number of bytes written, or zero on failure.
+ */
+SKDP_EXPORT_API size_t skdp_session_seal(uint8_t* output, size_t otplen, const uint8_t* state, size_t statelen, const uint8_t* key, skdp_session_role role);
+
 /**
  * \brief Serialize a SKDP packet into a byte array.
  *
@@ -1,11 +1,24 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#	define _GNU_SOURCE
+#endif
 #include "skdpclient.h"
-#include "acp.h"
+#include "skdpdrbg.h"
 #include "intutils.h"
 #include "memutils.h"
 #include "sha3.h"
 #include "socket.h"
 #include "socketclient.h"
 #include "timestamp.h"
+#if defined(QSC_SYSTEM_OS_POSIX)
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <netinet/in.h>
+#	include <poll.h>
+#	include <string.h>
+#	include <sys/socket.h>
+#	include <time.h>
+#	include <unistd.h>
+#endif
 
 static void client_dispose(skdp_client_state* ctx)
 {
@@ -15,6 +28,11 @@ static void client_dispose(skdp_client_state* ctx)
 	{
 		skdp_cipher_dispose(&ctx->rxcpr);
 		skdp_cipher_dispose(&ctx->txcpr);
+		qsc_memutils_secure_erase(ctx->kupdate.rxsec, SKDP_KEY_UPDATE_SECRET_SIZE);
+		qsc_memutils_secure_erase(ctx->kupdate.txsec, SKDP_KEY_UPDATE_SECRET_SIZE);
+		qsc_memutils_clear(ctx->cid, SKDP_CONNECTION_ID_SIZE);
+		ctx->kupdate.txbytes = 0U;
+		ctx->kupdate.txrecords = 0U;
 		ctx->exflag = skdp_flag_none;
 		ctx->rxseq = 0U;
 		ctx->txseq = 0U;
@@ -35,6 +53,31 @@ static void client_kex_reset(skdp_client_state* ctx)
 	}
 }
 
+static void client_hibernate_seal(skdp_client_state* ctx, skdp_network_packet* packetout)
+{
+	uint8_t hdr[SKDP_HEADER_SIZE] = { 0U };
+
+	/* an empty record, the last sealed under the current transmit key */
+	ctx->txseq += 1U;
+	packetout->flag = skdp_flag_hibernate_ack;
+	packetout->msglen = (uint32_t)ctx->suite->tagsize;
+	packetout->sequence = ctx->txseq;
+	skdp_packet_set_utc_time(packetout);
+	skdp_packet_header_serialize(packetout, hdr);
+	skdp_cipher_set_associated(&ctx->txcpr, hdr, SKDP_HEADER_SIZE);
+	skdp_cipher_transform(&ctx->txcpr, packetout->pmessage, hdr, 0U);
+}
+
+static void client_hibernate_ratchet(skdp_client_state* ctx)
+{
+	/* both channels move to the keys the server re-derives when it wakes the session */
+	skdp_key_update_ratchet(&ctx->rxcpr, ctx->kupdate.rxsec, false);
+	skdp_key_update_ratchet(&ctx->txcpr, ctx->kupdate.txsec, true);
+	ctx->kupdate.txbytes = 0U;
+	ctx->kupdate.txrecords = 0U;
+	ctx->exflag = skdp_flag_session_established;
+}
+
 skdp_errors client_connect_request(skdp_client_state* ctx, skdp_network_packet* packetout)
 {
 	SKDP_ASSERT(ctx != NULL);
@@ -48,13 +91,13 @@ skdp_errors client_connect_request(skdp_client_state* ctx, skdp_network_packet*
 
 		if (qsc_timestamp_epochtime_seconds() < ctx->expiration)
 		{
-			if (qsc_acp_generate(stok, SKDP_STOK_SIZE) == true)
+			if (skdp_drbg_generate(stok, SKDP_STOK_SIZE) == true)
 			{
 				qsc_keccak_state kctx = { 0 };
 
-				/* copy the KID, configuration string, and STOK to the message */
+				/* copy the KID, the configuration string of the offered suite, and STOK to the message */
 				qsc_memutils_copy(packetout->pmessage, ctx->kid, SKDP_KID_SIZE);
-				qsc_memutils_copy(packetout->pmessage + SKDP_KID_SIZE, SKDP_CONFIG_STRING, SKDP_CONFIG_SIZE);
+				qsc_memutils_copy(packetout->pmessage + SKDP_KID_SIZE, ctx->suite->config, SKDP_CONFIG_SIZE);
 				qsc_memutils_copy(packetout->pmessage + SKDP_KID_SIZE + SKDP_CONFIG_SIZE, stok, SKDP_STOK_SIZE);
 
 				/* assemble the connection-request packet */
@@ -101,11 +144,11 @@ static skdp_errors client_exchange_request(skdp_client_state* ctx, const skdp_ne
 
 	/* store a hash of the server token, the configuration string, and the server id: ssh = H(sid || cfg || stok) */
 	qsc_sha3_initialize(&kctx);
-	qsc_sha3_update(&kctx, SKDP_PERMUTATION_RATE, packetin->pmessage, packetin->msglen);
+	qsc_sha3_update(&kctx, SKDP_PERMUTATION_RATE, packetin->pmessage, SKDP_CONNECT_RESPONSE_MESSAGE_SIZE);
 	qsc_sha3_finalize(&kctx, SKDP_PERMUTATION_RATE, ctx->ssh);
 
 	/* generate the client's secret token key */
-	if (qsc_acp_generate(dtk, SKDP_DTK_SIZE) == true)
+	if (skdp_drbg_generate(dtk, SKDP_DTK_SIZE) == true)
 	{
 		uint8_t prnd[QSC_KECCAK_STATE_BYTE_SIZE] = { 0U };
 		uint8_t shdr[SKDP_HEADER_SIZE] = { 0U };
@@ -123,6 +166,14 @@ static skdp_errors client_exchange_request(skdp_client_state* ctx, const skdp_ne
 		packetout->msglen = SKDP_DTK_SIZE + SKDP_MACKEY_SIZE;
 		packetout->sequence = ctx->txseq;
 
+		if (packetin->flag == skdp_flag_connect_cookie)
+		{
+			/* echo the server cookie after the mac tag; the header covers the flag and length */
+			qsc_memutils_copy(packetout->pmessage + SKDP_EXCHANGE_REQUEST_MESSAGE_SIZE, packetin->pmessage + SKDP_CONNECT_RESPONSE_MESSAGE_SIZE, SKDP_COOKIE_SIZE);
+			packetout->flag = skdp_flag_exchange_cookie;
+			packetout->msglen += SKDP_COOKIE_SIZE;
+		}
+
 		/* mac the encrypted token key */
 		qsc_kmac_initialize(&kctx, SKDP_PERMUTATION_RATE, prnd + SKDP_DTK_SIZE, SKDP_DTK_SIZE, ctx->dsh, SKDP_STH_SIZE);
 		qsc_kmac_update(&kctx, SKDP_PERMUTATION_RATE, packetout->pmessage, SKDP_DTK_SIZE);
@@ -132,7 +183,7 @@ static skdp_errors client_exchange_request(skdp_client_state* ctx, const skdp_ne
 		skdp_packet_header_serialize(packetout, shdr);
 		/* change 1.1 anti-replay; add the packet time to the mac */
 		qsc_kmac_update(&kctx, SKDP_PERMUTATION_RATE, shdr, SKDP_HEADER_SIZE);
-		qsc_kmac_finalize(&kctx, SKDP_PERMUTATION_RATE, packetout->pmessage + SKDP_DTK_SIZE, SKDP_MACTAG_SIZE);
+		qsc_kmac_finalize(&kctx, SKDP_PERMUTATION_RATE, packetout->pmessage + SKDP_DTK_SIZE, ctx->suite->tagsize);
 
 		/* generate the cipher key and nonce */
 		qsc_memutils_secure_erase(prnd, QSC_KECCAK_STATE_BYTE_SIZE);
@@ -142,16 +193,11 @@ static skdp_errors client_exchange_request(skdp_client_state* ctx, const skdp_ne
 		qsc_memutils_secure_erase(&kctx, sizeof(qsc_keccak_state));
 
 		/* initialize the symmetric cipher, and raise client channel-1 tx */
-		skdp_cipher_keyparams kp;
-		kp.key = prnd;
-		kp.keylen = SKDP_CPRKEY_SIZE;
-		kp.nonce = (prnd + SKDP_CPRKEY_SIZE);
-#if !defined(SKDP_USE_RCS_ENCRYPTION)
-		kp.noncelen = SKDP_NONCE_SIZE;
-#endif
-		kp.info = NULL;
-		kp.infolen = 0U;
-		skdp_cipher_initialize(&ctx->txcpr, &kp, true);
+		skdp_cipher_initialize(&ctx->txcpr, ctx->suite, prnd, prnd + ctx->suite->keysize, true);
+		skdp_key_update_derive(ctx->kupdate.txsec, dtk, SKDP_DTK_SIZE, ctx->dsh);
+		ctx->kupdate.txbytes = 0U;
+		ctx->kupdate.txrecords = 0U;
+		qsc_memutils_secure_erase(dtk, sizeof(dtk));
 
 		qsc_memutils_secure_erase(prnd, sizeof(prnd));
 
@@ -192,10 +238,10 @@ static skdp_errors client_establish_request(skdp_client_state* ctx, const skdp_n
 		skdp_packet_header_serialize(packetin, shdr);
 		/* change 1.1 anti-replay; add the packet time to the mac */
 		qsc_kmac_update(&kctx, SKDP_PERMUTATION_RATE, shdr, SKDP_HEADER_SIZE);
-		qsc_kmac_finalize(&kctx, SKDP_PERMUTATION_RATE, tmac, SKDP_MACTAG_SIZE);
+		qsc_kmac_finalize(&kctx, SKDP_PERMUTATION_RATE, tmac, ctx->suite->tagsize);
 
 		/* compare the mac tag to the one appended to the ciphertext */
-		if (qsc_intutils_verify(packetin->pmessage + SKDP_STK_SIZE, tmac, SKDP_MACTAG_SIZE) == 0)
+		if (qsc_intutils_verify(packetin->pmessage + SKDP_STK_SIZE, tmac, ctx->suite->tagsize) == 0)
 		{
 			uint8_t stk[SKDP_STK_SIZE] = { 0U };
 
@@ -210,22 +256,15 @@ static skdp_errors client_establish_request(skdp_client_state* ctx, const skdp_n
 			qsc_memutils_secure_erase(&kctx, sizeof(qsc_keccak_state));
 
 			/* initialize the symmetric cipher, and raise client channel-2 rx */
-			skdp_cipher_keyparams kp;
-			kp.key = prnd;
-			kp.keylen = SKDP_CPRKEY_SIZE;
-			kp.nonce = (prnd + SKDP_CPRKEY_SIZE);
-#if !defined(SKDP_USE_RCS_ENCRYPTION)
-			kp.noncelen = SKDP_NONCE_SIZE;
-#endif
-			kp.info = NULL;
-			kp.infolen = 0U;
-			skdp_cipher_initialize(&ctx->rxcpr, &kp, false);
+			skdp_cipher_initialize(&ctx->rxcpr, ctx->suite, prnd, prnd + ctx->suite->keysize, false);
+			skdp_key_update_derive(ctx->kupdate.rxsec, stk, SKDP_STK_SIZE, ctx->ssh);
+			qsc_memutils_secure_erase(stk, sizeof(stk));
 
 			qsc_memutils_secure_erase(prnd, sizeof(prnd));
 
 			/* assemble the establish-request packet */
 			packetout->flag = skdp_flag_establish_request;
-			packetout->msglen = SKDP_STH_SIZE + SKDP_MACTAG_SIZE;
+			packetout->msglen = (uint32_t)(SKDP_STH_SIZE + ctx->suite->tagsize);
 			packetout->sequence = ctx->txseq;
 
 			/* serialize the packet header and add it to the associated data */
@@ -233,7 +272,7 @@ static skdp_errors client_establish_request(skdp_client_state* ctx, const skdp_n
 			skdp_cipher_set_associated(&ctx->txcpr, shdr, SKDP_HEADER_SIZE);
 
 			/* generate a random verification-token and store in the session hash state */
-			if (qsc_acp_generate(ctx->dsh, SKDP_STH_SIZE) == true)
+			if (skdp_drbg_generate(ctx->dsh, SKDP_STH_SIZE) == true)
 			{
 				/* encrypt the verification token */
 				skdp_cipher_transform(&ctx->txcpr, packetout->pmessage, ctx->dsh, SKDP_STH_SIZE);
@@ -267,14 +306,14 @@ static skdp_errors client_establish_verify(skdp_client_state* ctx, const skdp_ne
 	err = skdp_error_none;
 
 	if (packetin->flag == skdp_flag_establish_response &&
-		packetin->msglen == SKDP_ESTABLISH_RESPONSE_MESSAGE_SIZE)
+		packetin->msglen == SKDP_HASH_SIZE + ctx->suite->tagsize)
 	{
 		/* serialize the packet header and add it to associated data */
 		skdp_packet_header_serialize(packetin, hdr);
 		skdp_cipher_set_associated(&ctx->rxcpr, hdr, SKDP_HEADER_SIZE);
 
 		/* authenticate and decrypt the cipher-text */
-		if (skdp_cipher_transform(&ctx->rxcpr, msg, packetin->pmessage, packetin->msglen - SKDP_MACTAG_SIZE) == true)
+		if (skdp_cipher_transform(&ctx->rxcpr, msg, packetin->pmessage, packetin->msglen - ctx->suite->tagsize) == true)
 		{
 			qsc_keccak_state kctx = { 0 };
 			uint8_t vhash[SKDP_HASH_SIZE] = { 0U };
@@ -311,12 +350,13 @@ static skdp_errors client_establish_verify(skdp_client_state* ctx, const skdp_ne
 	return err;
 }
 
-static skdp_errors client_key_exchange(skdp_client_state* ctx, qsc_socket* sock)
+static skdp_errors client_key_exchange(skdp_client_state* ctx, const skdp_transport* trans)
 {
 	skdp_network_packet reqt = { 0 };
 	skdp_network_packet resp = { 0 };
-	uint8_t mreqt[SKDP_EXCHANGE_MAX_MESSAGE_SIZE] = { 0U };
-	uint8_t mresp[SKDP_EXCHANGE_MAX_MESSAGE_SIZE] = { 0U };
+	uint8_t mreqt[SKDP_EXCHANGE_MAX_MESSAGE_SIZE + SKDP_COOKIE_SIZE] = { 0U };
+	uint8_t mresp[SKDP_EXCHANGE_MAX_MESSAGE_SIZE + SKDP_COOKIE_SIZE] = { 0U };
+	size_t plen;
 	size_t rlen;
 	size_t slen;
 	skdp_errors err;
@@ -330,33 +370,57 @@ static skdp_errors client_key_exchange(skdp_client_state* ctx, qsc_socket* sock)
 	if (err == skdp_error_none)
 	{
 		/* send the connection request */
-		slen = qsc_socket_send(sock, mreqt, SKDP_CONNECT_REQUEST_PACKET_SIZE, qsc_socket_send_flag_none);
+		slen = skdp_transport_send(trans, mreqt, SKDP_CONNECT_REQUEST_PACKET_SIZE);
 
 		if (slen == SKDP_CONNECT_REQUEST_PACKET_SIZE)
 		{
 			ctx->txseq += 1U;
 
-			/* blocking receive waits for server */
-			rlen = qsc_socket_receive(sock, mresp, SKDP_CONNECT_RESPONSE_PACKET_SIZE, qsc_socket_receive_flag_wait_all);
+			/* blocking receive waits for server; read the header, the response may carry a cookie */
+			plen = SKDP_CONNECT_RESPONSE_PACKET_SIZE;
+			rlen = skdp_transport_receive(trans, mresp, SKDP_HEADER_SIZE);
 
-			if (rlen == SKDP_CONNECT_RESPONSE_PACKET_SIZE)
+			if (rlen == SKDP_HEADER_SIZE)
 			{
 				/* convert server response to packet */
 				skdp_packet_header_deserialize(mresp, SKDP_HEADER_SIZE, &resp);
 				resp.pmessage = mresp + SKDP_HEADER_SIZE;
+				plen = (resp.flag == skdp_flag_connect_cookie) ? SKDP_CONNECT_COOKIE_PACKET_SIZE : SKDP_CONNECT_RESPONSE_PACKET_SIZE;
+
+				if (resp.flag == skdp_flag_error_condition)
+				{
+					plen = SKDP_HEADER_SIZE + SKDP_ERROR_SIZE;
+				}
+
+				if (resp.msglen == plen - SKDP_HEADER_SIZE)
+				{
+					rlen += skdp_transport_receive(trans, resp.pmessage, resp.msglen);
+				}
+			}
+
+			if (rlen == plen)
+			{
 
 				if (resp.sequence == ctx->rxseq)
 				{
 					ctx->rxseq += 1U;
 
-					if (resp.flag == skdp_flag_connect_response)
+					if (resp.flag == skdp_flag_connect_response || resp.flag == skdp_flag_connect_cookie)
 					{
-						/* clear the request packet */
-						skdp_packet_clear(&reqt);
-						/* create the exchange request packet */
-						err = client_exchange_request(ctx, &resp, &reqt);
-						/* serialize the header */
-						skdp_packet_header_serialize(&reqt, mreqt);
+						/* the server echoes the negotiated suite, which must be the one offered */
+						if (qsc_intutils_are_equal8(resp.pmessage + SKDP_KID_SIZE, (const uint8_t*)ctx->suite->config, SKDP_CONFIG_SIZE) == true)
+						{
+							/* clear the request packet */
+							skdp_packet_clear(&reqt);
+							/* create the exchange request packet */
+							err = client_exchange_request(ctx, &resp, &reqt);
+							/* serialize the header */
+							skdp_packet_header_serialize(&reqt, mreqt);
+						}
+						else
+						{
+							err = skdp_error_unknown_protocol;
+						}
 					}
 					else
 					{
@@ -393,16 +457,17 @@ static skdp_errors client_key_exchange(skdp_client_state* ctx, qsc_socket* sock)
 
 	if (err == skdp_error_none)
 	{
-		/* send the connection request */
-		slen = qsc_socket_send(sock, mreqt, SKDP_EXCHANGE_REQUEST_PACKET_SIZE, qsc_socket_send_flag_none);
+		/* send the exchange request, the size includes the echoed cookie in cookie mode */
+		plen = SKDP_HEADER_SIZE + reqt.msglen;
+		slen = skdp_transport_send(trans, mreqt, plen);
 		qsc_memutils_clear(mreqt, sizeof(mreqt));
 
-		if (slen == SKDP_EXCHANGE_REQUEST_PACKET_SIZE)
+		if (slen == plen)
 		{
 			ctx->txseq += 1U;
 			qsc_memutils_clear(mresp, sizeof(mresp));
 			/* blocking receive waits for server */
-			rlen = qsc_socket_receive(sock, mresp, SKDP_EXCHANGE_RESPONSE_PACKET_SIZE, qsc_socket_receive_flag_wait_all);
+			rlen = skdp_transport_receive(trans, mresp, SKDP_EXCHANGE_RESPONSE_PACKET_SIZE);
 
 			if (rlen == SKDP_EXCHANGE_RESPONSE_PACKET_SIZE)
 			{
@@ -456,18 +521,20 @@ static skdp_errors client_key_exchange(skdp_client_state* ctx, qsc_socket* sock)
 
 	if (err == skdp_error_none)
 	{
-		/* send establish request */
-		slen = qsc_socket_send(sock, mreqt, SKDP_ESTABLISH_REQUEST_PACKET_SIZE, qsc_socket_send_flag_none);
+		/* send establish request, the tag size is set by the negotiated suite */
+		plen = SKDP_HEADER_SIZE + SKDP_STH_SIZE + ctx->suite->tagsize;
+		slen = skdp_transport_send(trans, mreqt, plen);
 		qsc_memutils_clear(mreqt, sizeof(mreqt));
 
-		if (slen == SKDP_ESTABLISH_REQUEST_PACKET_SIZE)
+		if (slen == plen)
 		{
 			ctx->txseq += 1U;
 			/* wait for establish response */
 			qsc_memutils_clear(mresp, sizeof(mresp));
-			rlen = qsc_socket_receive(sock, mresp, SKDP_ESTABLISH_RESPONSE_PACKET_SIZE, qsc_socket_receive_flag_wait_all);
+			plen = SKDP_HEADER_SIZE + SKDP_HASH_SIZE + ctx->suite->tagsize;
+			rlen = skdp_transport_receive(trans, mresp, plen);
 
-			if (rlen == SKDP_ESTABLISH_RESPONSE_PACKET_SIZE)
+			if (rlen == plen)
 			{
 				skdp_packet_header_deserialize(mresp, SKDP_HEADER_SIZE, &resp);
 				resp.pmessage = mresp + SKDP_HEADER_SIZE;
@@ -518,22 +585,285 @@ static skdp_errors client_key_exchange(skdp_client_state* ctx, qsc_socket* sock)
 
 	if (err == skdp_error_none)
 	{
+		/* the identifier used to reattach to this session over a new connection */
+		skdp_connection_id_derive(ctx->cid, ctx->kupdate.txsec, ctx->kupdate.rxsec);
 		ctx->exflag = skdp_flag_session_established;
 	}
 	else
 	{
-		if (sock->connection_status == qsc_socket_state_connected)
+		skdp_transport_send_error(trans, err);
+		skdp_transport_close(trans);
+
+		client_dispose(ctx);
+	}
+
+	return err;
+}
+
+static skdp_errors client_reattach(skdp_client_state* ctx, const skdp_transport* trans)
+{
+	skdp_network_packet resp = { 0 };
+	skdp_network_packet reqt = { 0 };
+	uint8_t mreqt[SKDP_REATTACH_REQUEST_PACKET_SIZE] = { 0U };
+	uint8_t mresp[SKDP_HEADER_SIZE + SKDP_CONNECTION_ID_SIZE + SKDP_MACTAG_SIZE] = { 0U };
+	uint8_t proof[SKDP_REATTACH_REQUEST_MESSAGE_SIZE] = { 0U };
+	skdp_cipher_state rxcpr;
+	skdp_cipher_state txcpr;
+	size_t plen;
+	size_t rlen;
+	skdp_errors err;
+
+	/* cid || E(cid || padding) || tag, the proof fills the request to the size of a connect request */
+	qsc_memutils_copy(&txcpr, &ctx->txcpr, sizeof(skdp_cipher_state));
+	reqt.flag = skdp_flag_reattach_request;
+	reqt.msglen = SKDP_REATTACH_REQUEST_MESSAGE_SIZE;
+	reqt.sequence = ctx->txseq + 1U;
+	reqt.pmessage = mreqt + SKDP_HEADER_SIZE;
+	skdp_packet_set_utc_time(&reqt);
+	skdp_packet_header_serialize(&reqt, mreqt);
+	qsc_memutils_copy(reqt.pmessage, ctx->cid, SKDP_CONNECTION_ID_SIZE);
+	qsc_memutils_copy(proof, ctx->cid, SKDP_CONNECTION_ID_SIZE);
+	plen = SKDP_REATTACH_REQUEST_MESSAGE_SIZE - SKDP_CONNECTION_ID_SIZE - ctx->suite->tagsize;
+	skdp_cipher_set_associated(&txcpr, mreqt, SKDP_HEADER_SIZE);
+	skdp_cipher_transform(&txcpr, reqt.pmessage + SKDP_CONNECTION_ID_SIZE, proof, plen);
+
+	if (skdp_transport_send(trans, mreqt, sizeof(mreqt)) == sizeof(mreqt))
+	{
+		plen = SKDP_HEADER_SIZE + SKDP_CONNECTION_ID_SIZE + ctx->suite->tagsize;
+		rlen = skdp_transport_receive(trans, mresp, SKDP_HEADER_SIZE);
+
+		if (rlen == SKDP_HEADER_SIZE)
+		{
+			skdp_packet_header_deserialize(mresp, SKDP_HEADER_SIZE, &resp);
+			resp.pmessage = mresp + SKDP_HEADER_SIZE;
+
+			if (resp.flag == skdp_flag_reattach_response && resp.msglen == plen - SKDP_HEADER_SIZE &&
+				skdp_transport_receive(trans, resp.pmessage, resp.msglen) == resp.msglen)
+			{
+				if (resp.sequence == ctx->rxseq + 1U && skdp_packet_time_valid(&resp) == true)
+				{
+					/* the session is only advanced once the server has proven it holds the session */
+					qsc_memutils_copy(&rxcpr, &ctx->rxcpr, sizeof(skdp_cipher_state));
+					skdp_cipher_set_associated(&rxcpr, mresp, SKDP_HEADER_SIZE);
+
+					if (skdp_cipher_transform(&rxcpr, proof, resp.pmessage, SKDP_CONNECTION_ID_SIZE) == true &&
+						qsc_intutils_verify(proof, ctx->cid, SKDP_CONNECTION_ID_SIZE) == 0)
+					{
+						qsc_memutils_copy(&ctx->rxcpr, &rxcpr, sizeof(skdp_cipher_state));
+						qsc_memutils_copy(&ctx->txcpr, &txcpr, sizeof(skdp_cipher_state));
+						ctx->rxseq += 1U;
+						ctx->txseq += 1U;
+						/* both ends move to the next identifier, so the one sent in the clear is not reused */
+						skdp_connection_id_update(ctx->cid, ctx->kupdate.txsec, ctx->kupdate.rxsec);
+						err = skdp_error_none;
+					}
+					else
+					{
+						err = skdp_error_cipher_auth_failure;
+					}
+
+					qsc_memutils_secure_erase(&rxcpr, sizeof(skdp_cipher_state));
+				}
+				else
+				{
+					err = skdp_error_unsequenced;
+				}
+			}
+			else if (resp.flag == skdp_flag_error_condition && resp.msglen != 0U &&
+				skdp_transport_receive(trans, resp.pmessage, 1U) == 1U)
+			{
+				err = skdp_message_to_error(resp.pmessage[0U]);
+			}
+			else
+			{
+				err = skdp_error_establish_failure;
+			}
+		}
+		else
 		{
-			skdp_client_send_error(sock, err);
-			qsc_socket_shut_down(sock, qsc_socket_shut_down_flag_both);
+			err = skdp_error_receive_failure;
 		}
+	}
+	else
+	{
+		err = skdp_error_transmit_failure;
+	}
 
-		client_dispose(ctx);
+	qsc_memutils_secure_erase(&txcpr, sizeof(skdp_cipher_state));
+	qsc_memutils_secure_erase(proof, sizeof(proof));
+
+	if (err != skdp_error_none)
+	{
+		/* the session is left as it was, and may be reattached again over another connection */
+		skdp_transport_close(trans);
 	}
 
 	return err;
 }
 
+#if defined(QSC_SYSTEM_OS_POSIX)
+static uint64_t client_race_clock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000U) + ((uint64_t)ts.tv_nsec / 1000000U);
+}
+
+static int32_t client_race_open(const struct sockaddr* addr, socklen_t addrlen)
+{
+	int32_t fd;
+	int32_t flags;
+
+	fd = (int32_t)socket(addr->sa_family, SOCK_STREAM, IPPROTO_TCP);
+
+	if (fd >= 0)
+	{
+		flags = fcntl(fd, F_GETFL, 0);
+
+		/* a non-blocking connect returns at once, the handshake completes in the background */
+		if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0 ||
+			(connect(fd, addr, addrlen) != 0 && errno != EINPROGRESS))
+		{
+			close(fd);
+			fd = -1;
+		}
+	}
+
+	return fd;
+}
+
+static int32_t client_race(const qsc_ipinfo_ipv4_address* ipv4, const qsc_ipinfo_ipv6_address* ipv6, uint16_t port, qsc_socket_address_families* family)
+{
+	struct pollfd pfd[2U] = { 0 };
+	struct sockaddr_in sa4 = { 0 };
+	struct sockaddr_in6 sa6 = { 0 };
+	socklen_t olen;
+	uint64_t elapsed;
+	uint64_t start;
+	int32_t flags;
+	int32_t serr;
+	int32_t tmo;
+	int32_t win;
+	size_t i;
+	bool started;
+	bool run;
+
+	win = -1;
+	run = true;
+	started = false;
+	pfd[0U].fd = -1;
+	pfd[1U].fd = -1;
+
+	/* slot 0 is the IPv6 attempt, slot 1 the IPv4 attempt */
+	if (ipv6 != NULL)
+	{
+		sa6.sin6_family = AF_INET6;
+		sa6.sin6_port = htons(port);
+		qsc_memutils_copy(&sa6.sin6_addr, ipv6->ipv6, sizeof(ipv6->ipv6));
+		pfd[0U].fd = client_race_open((const struct sockaddr*)&sa6, (socklen_t)sizeof(sa6));
+	}
+
+	if (ipv4 != NULL)
+	{
+		sa4.sin_family = AF_INET;
+		sa4.sin_port = htons(port);
+		qsc_memutils_copy(&sa4.sin_addr, ipv4->ipv4, sizeof(ipv4->ipv4));
+	}
+
+	start = client_race_clock();
+
+	while (run == true)
+	{
+		elapsed = client_race_clock() - start;
+
+		/* start IPv4 after the stagger, or at once when there is no live IPv6 attempt */
+		if (ipv4 != NULL && started == false && (pfd[0U].fd < 0 || elapsed >= SKDP_CLIENT_CONNECT_STAGGER))
+		{
+			pfd[1U].fd = client_race_open((const struct sockaddr*)&sa4, (socklen_t)sizeof(sa4));
+			started = true;
+		}
+
+		if (pfd[0U].fd < 0 && pfd[1U].fd < 0 && (started == true || ipv4 == NULL))
+		{
+			/* every attempt has failed */
+			run = false;
+		}
+		else if (elapsed >= SKDP_CLIENT_CONNECT_TIMEOUT)
+		{
+			run = false;
+		}
+		else
+		{
+			if (ipv4 != NULL && started == false)
+			{
+				tmo = (int32_t)(SKDP_CLIENT_CONNECT_STAGGER - elapsed);
+			}
+			else
+			{
+				tmo = (int32_t)(SKDP_CLIENT_CONNECT_TIMEOUT - elapsed);
+			}
+
+			pfd[0U].events = POLLOUT;
+			pfd[0U].revents = 0;
+			pfd[1U].events = POLLOUT;
+			pfd[1U].revents = 0;
+
+			if (poll(pfd, 2U, tmo) > 0)
+			{
+				for (i = 0U; i < 2U && win < 0; ++i)
+				{
+					if (pfd[i].fd >= 0 && pfd[i].revents != 0)
+					{
+						serr = 0;
+						olen = (socklen_t)sizeof(serr);
+
+						if ((pfd[i].revents & POLLOUT) != 0 &&
+							getsockopt(pfd[i].fd, SOL_SOCKET, SO_ERROR, &serr, &olen) == 0 && serr == 0)
+						{
+							win = pfd[i].fd;
+							pfd[i].fd = -1;
+							*family = (i == 0U) ? qsc_socket_address_family_ipv6 : qsc_socket_address_family_ipv4;
+							run = false;
+						}
+						else
+						{
+							/* this attempt was refused or unreachable, the other continues */
+							close(pfd[i].fd);
+							pfd[i].fd = -1;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	/* cancel the losing attempt */
+	for (i = 0U; i < 2U; ++i)
+	{
+		if (pfd[i].fd >= 0)
+		{
+			close(pfd[i].fd);
+		}
+	}
+
+	if (win >= 0)
+	{
+		/* the session runs over a blocking socket */
+		flags = fcntl(win, F_GETFL, 0);
+
+		if (flags < 0 || fcntl(win, F_SETFL, flags & ~O_NONBLOCK) != 0)
+		{
+			close(win);
+			win = -1;
+		}
+	}
+
+	return win;
+}
+#endif
+
 void skdp_client_send_error(const qsc_socket* sock, skdp_errors error)
 {
 	SKDP_ASSERT(sock != NULL);
@@ -567,12 +897,197 @@ void skdp_client_initialize(skdp_client_state* ctx, const skdp_device_key* ckey)
 		qsc_memutils_clear(ctx->dsh, SKDP_STH_SIZE);
 		qsc_memutils_clear(ctx->ssh, SKDP_STH_SIZE);
 		ctx->expiration = ckey->expiration;
+		ctx->suite = skdp_cipher_suite_default();
+		qsc_memutils_clear(&ctx->kupdate, sizeof(skdp_key_update));
 		ctx->rxseq = 0U;
 		ctx->txseq = 0U;
 		ctx->exflag = skdp_flag_none;
 	}
 }
 
+bool skdp_client_session_deserialize(skdp_client_state* ctx, const uint8_t* input, size_t inlen)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(input != NULL);
+
+	const skdp_cipher_suite* suite;
+	size_t pos;
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && input != NULL && inlen >= SKDP_CLIENT_SESSION_SIZE)
+	{
+		suite = skdp_cipher_suite_from_id((skdp_suite_id)input[1U]);
+
+		if (input[0U] == SKDP_CLIENT_SESSION_VERSION && suite != NULL && input[2U] == (uint8_t)skdp_flag_session_established)
+		{
+			pos = 4U;
+			qsc_memutils_copy(ctx->kupdate.rxsec, input + pos, SKDP_KEY_UPDATE_SECRET_SIZE);
+			pos += SKDP_KEY_UPDATE_SECRET_SIZE;
+			qsc_memutils_copy(ctx->kupdate.txsec, input + pos, SKDP_KEY_UPDATE_SECRET_SIZE);
+			pos += SKDP_KEY_UPDATE_SECRET_SIZE;
+			qsc_memutils_copy(ctx->cid, input + pos, SKDP_CONNECTION_ID_SIZE);
+			pos += SKDP_CONNECTION_ID_SIZE;
+			ctx->rxseq = qsc_intutils_le8to64(input + pos);
+			pos += sizeof(uint64_t);
+			ctx->txseq = qsc_intutils_le8to64(input + pos);
+			pos += sizeof(uint64_t);
+			ctx->kupdate.maxbytes = qsc_intutils_le8to64(input + pos);
+			pos += sizeof(uint64_t);
+			ctx->kupdate.maxrecords = qsc_intutils_le8to64(input + pos);
+			ctx->suite = suite;
+			ctx->rxcpr.suite = suite;
+			ctx->txcpr.suite = suite;
+			client_hibernate_ratchet(ctx);
+			res = true;
+		}
+	}
+
+	return res;
+}
+
+skdp_errors skdp_client_session_export(skdp_client_state* ctx, skdp_network_packet* packetout, const uint8_t* key, uint8_t* output, size_t otplen, size_t* outlen)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(packetout != NULL);
+	SKDP_ASSERT(key != NULL);
+	SKDP_ASSERT(output != NULL);
+	SKDP_ASSERT(outlen != NULL);
+
+	uint8_t sbuf[SKDP_CLIENT_SESSION_SIZE] = { 0U };
+	skdp_errors err;
+
+	err = skdp_error_invalid_input;
+
+	if (ctx != NULL && packetout != NULL && key != NULL && output != NULL && outlen != NULL && otplen >= SKDP_CLIENT_SESSION_EXPORT_SIZE)
+	{
+		*outlen = 0U;
+		err = skdp_client_session_serialize(ctx, packetout, sbuf, sizeof(sbuf));
+
+		if (err == skdp_error_none)
+		{
+			*outlen = skdp_session_seal(output, otplen, sbuf, sizeof(sbuf), key, skdp_session_role_client);
+
+			if (*outlen == 0U)
+			{
+				err = skdp_error_random_failure;
+			}
+		}
+
+		qsc_memutils_secure_erase(sbuf, sizeof(sbuf));
+	}
+
+	return err;
+}
+
+bool skdp_client_session_import(skdp_client_state* ctx, const uint8_t* key, const uint8_t* input, size_t inlen)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(key != NULL);
+	SKDP_ASSERT(input != NULL);
+
+	uint8_t sbuf[SKDP_CLIENT_SESSION_SIZE] = { 0U };
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && key != NULL && input != NULL)
+	{
+		if (skdp_session_open(sbuf, sizeof(sbuf), input, inlen, key, skdp_session_role_client) == true)
+		{
+			res = skdp_client_session_deserialize(ctx, sbuf, sizeof(sbuf));
+		}
+
+		qsc_memutils_secure_erase(sbuf, sizeof(sbuf));
+	}
+
+	return res;
+}
+
+skdp_errors skdp_client_session_serialize(skdp_client_state* ctx, skdp_network_packet* packetout, uint8_t* output, size_t otplen)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(packetout != NULL);
+	SKDP_ASSERT(output != NULL);
+
+	size_t pos;
+	skdp_errors err;
+
+	err = skdp_error_invalid_input;
+
+	if (ctx != NULL && packetout != NULL && output != NULL && otplen >= SKDP_CLIENT_SESSION_SIZE)
+	{
+		if (ctx->exflag == skdp_flag_hibernate)
+		{
+			client_hibernate_seal(ctx, packetout);
+
+			/* version || suite || flag || reserved || rxsec || txsec || cid || counters;
+			   the live cipher states are never written, the importer ratchets from the secrets */
+			output[0U] = SKDP_CLIENT_SESSION_VERSION;
+			output[1U] = (uint8_t)ctx->suite->id;
+			output[2U] = (uint8_t)skdp_flag_session_established;
+			output[3U] = 0U;
+			pos = 4U;
+			qsc_memutils_copy(output + pos, ctx->kupdate.rxsec, SKDP_KEY_UPDATE_SECRET_SIZE);
+			pos += SKDP_KEY_UPDATE_SECRET_SIZE;
+			qsc_memutils_copy(output + pos, ctx->kupdate.txsec, SKDP_KEY_UPDATE_SECRET_SIZE);
+			pos += SKDP_KEY_UPDATE_SECRET_SIZE;
+			qsc_memutils_copy(output + pos, ctx->cid, SKDP_CONNECTION_ID_SIZE);
+			pos += SKDP_CONNECTION_ID_SIZE;
+			qsc_intutils_le64to8(output + pos, ctx->rxseq);
+			pos += sizeof(uint64_t);
+			qsc_intutils_le64to8(output + pos, ctx->txseq);
+			pos += sizeof(uint64_t);
+			qsc_intutils_le64to8(output + pos, ctx->kupdate.maxbytes);
+			pos += sizeof(uint64_t);
+			qsc_intutils_le64to8(output + pos, ctx->kupdate.maxrecords);
+			client_dispose(ctx);
+			err = skdp_error_none;
+		}
+		else
+		{
+			err = skdp_error_channel_down;
+		}
+	}
+
+	return err;
+}
+
+void skdp_client_set_key_update(skdp_client_state* ctx, uint64_t maxrecords, uint64_t maxbytes)
+{
+	SKDP_ASSERT(ctx != NULL);
+
+	if (ctx != NULL)
+	{
+		ctx->kupdate.maxbytes = maxbytes;
+		ctx->kupdate.maxrecords = maxrecords;
+	}
+}
+
+bool skdp_client_set_suite(skdp_client_state* ctx, skdp_suite_id id)
+{
+	SKDP_ASSERT(ctx != NULL);
+
+	const skdp_cipher_suite* suite;
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL)
+	{
+		suite = skdp_cipher_suite_from_id(id);
+
+		if (suite != NULL)
+		{
+			ctx->suite = suite;
+			res = true;
+		}
+	}
+
+	return res;
+}
+
 skdp_errors skdp_client_connect_ipv4(skdp_client_state* ctx, qsc_socket* sock, const qsc_ipinfo_ipv4_address* address, uint16_t port)
 {
 	SKDP_ASSERT(ctx != NULL);
@@ -580,6 +1095,7 @@ skdp_errors skdp_client_connect_ipv4(skdp_client_state* ctx, qsc_socket* sock, c
 	SKDP_ASSERT(address != NULL);
 
 	qsc_socket_exceptions serr;
+	skdp_transport trans;
 	skdp_errors err;
 
 	if (ctx != NULL && sock != NULL && address != NULL)
@@ -590,7 +1106,8 @@ skdp_errors skdp_client_connect_ipv4(skdp_client_state* ctx, qsc_socket* sock, c
 
 		if (serr == qsc_socket_exception_success)
 		{
-			err = client_key_exchange(ctx, sock);
+			skdp_transport_from_socket(&trans, sock);
+			err = client_key_exchange(ctx, &trans);
 		}
 		else
 		{
@@ -612,6 +1129,7 @@ skdp_errors skdp_client_connect_ipv6(skdp_client_state* ctx, qsc_socket* sock, c
 	SKDP_ASSERT(address != NULL);
 
 	qsc_socket_exceptions serr;
+	skdp_transport trans;
 	skdp_errors err;
 
 	if (ctx != NULL && sock != NULL && address != NULL)
@@ -622,12 +1140,186 @@ skdp_errors skdp_client_connect_ipv6(skdp_client_state* ctx, qsc_socket* sock, c
 
 		if (serr == qsc_socket_exception_success)
 		{
-			err = client_key_exchange(ctx, sock);
+			skdp_transport_from_socket(&trans, sock);
+			err = client_key_exchange(ctx, &trans);
+		}
+		else
+		{
+			err = skdp_error_connection_failure;
+		}
+	}
+	else
+	{
+		err = skdp_error_general_failure;
+	}
+
+	return err;
+}
+
+skdp_errors skdp_client_connect_dual(skdp_client_state* ctx, qsc_socket* sock, const qsc_ipinfo_ipv4_address* ipv4, const qsc_ipinfo_ipv6_address* ipv6, uint16_t port)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(sock != NULL);
+	SKDP_ASSERT(ipv4 != NULL || ipv6 != NULL);
+
+	skdp_errors err;
+
+	if (ctx != NULL && sock != NULL && (ipv4 != NULL || ipv6 != NULL))
+	{
+#if defined(QSC_SYSTEM_OS_POSIX)
+		char astr[QSC_IPINFO_IPV6_STRNLEN] = { 0 };
+		skdp_transport trans;
+		qsc_socket_address_families family;
+		int32_t fd;
+
+		family = qsc_socket_address_family_none;
+		qsc_socket_client_initialize(sock);
+		fd = client_race(ipv4, ipv6, port, &family);
+
+		if (fd >= 0)
+		{
+			sock->connection = fd;
+			sock->connection_status = qsc_socket_state_connected;
+			sock->address_family = family;
+			sock->socket_protocol = qsc_socket_protocol_tcp;
+			sock->socket_transport = qsc_socket_transport_stream;
+			sock->port = port;
+
+			if (family == qsc_socket_address_family_ipv6)
+			{
+				qsc_ipinfo_ipv6_address_to_string(astr, ipv6);
+			}
+			else
+			{
+				qsc_ipinfo_ipv4_address_to_string(astr, ipv4);
+			}
+
+			qsc_memutils_copy(sock->address, astr, qsc_intutils_min(strlen(astr), (size_t)(QSC_SOCKET_ADDRESS_MAX_SIZE - 1U)));
+			skdp_transport_from_socket(&trans, sock);
+			err = client_key_exchange(ctx, &trans);
 		}
 		else
 		{
 			err = skdp_error_connection_failure;
 		}
+#else
+		/* without a non-blocking connect the families are tried in preference order */
+		err = skdp_error_connection_failure;
+
+		if (ipv6 != NULL)
+		{
+			err = skdp_client_connect_ipv6(ctx, sock, ipv6, port);
+		}
+
+		if (err == skdp_error_connection_failure && ipv4 != NULL)
+		{
+			err = skdp_client_connect_ipv4(ctx, sock, ipv4, port);
+		}
+#endif
+	}
+	else
+	{
+		err = skdp_error_general_failure;
+	}
+
+	return err;
+}
+
+skdp_errors skdp_client_connect_transport(skdp_client_state* ctx, const skdp_transport* trans)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(trans != NULL);
+
+	skdp_errors err;
+
+	if (ctx != NULL && trans != NULL && trans->send != NULL && trans->receive != NULL)
+	{
+		err = client_key_exchange(ctx, trans);
+	}
+	else
+	{
+		err = skdp_error_general_failure;
+	}
+
+	return err;
+}
+
+skdp_errors skdp_client_reattach_ipv4(skdp_client_state* ctx, qsc_socket* sock, const qsc_ipinfo_ipv4_address* address, uint16_t port)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(sock != NULL);
+	SKDP_ASSERT(address != NULL);
+
+	qsc_socket_exceptions serr;
+	skdp_transport trans;
+	skdp_errors err;
+
+	if (ctx != NULL && sock != NULL && address != NULL && ctx->exflag == skdp_flag_session_established)
+	{
+		qsc_socket_client_initialize(sock);
+		serr = qsc_socket_client_connect_ipv4(sock, address, port);
+
+		if (serr == qsc_socket_exception_success)
+		{
+			skdp_transport_from_socket(&trans, sock);
+			err = client_reattach(ctx, &trans);
+		}
+		else
+		{
+			err = skdp_error_connection_failure;
+		}
+	}
+	else
+	{
+		err = skdp_error_general_failure;
+	}
+
+	return err;
+}
+
+skdp_errors skdp_client_reattach_ipv6(skdp_client_state* ctx, qsc_socket* sock, const qsc_ipinfo_ipv6_address* address, uint16_t port)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(sock != NULL);
+	SKDP_ASSERT(address != NULL);
+
+	qsc_socket_exceptions serr;
+	skdp_transport trans;
+	skdp_errors err;
+
+	if (ctx != NULL && sock != NULL && address != NULL && ctx->exflag == skdp_flag_session_established)
+	{
+		qsc_socket_client_initialize(sock);
+		serr = qsc_socket_client_connect_ipv6(sock, address, port);
+
+		if (serr == qsc_socket_exception_success)
+		{
+			skdp_transport_from_socket(&trans, sock);
+			err = client_reattach(ctx, &trans);
+		}
+		else
+		{
+			err = skdp_error_connection_failure;
+		}
+	}
+	else
+	{
+		err = skdp_error_general_failure;
+	}
+
+	return err;
+}
+
+skdp_errors skdp_client_reattach_transport(skdp_client_state* ctx, const skdp_transport* trans)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(trans != NULL);
+
+	skdp_errors err;
+
+	if (ctx != NULL && trans != NULL && trans->send != NULL && trans->receive != NULL && ctx->exflag == skdp_flag_session_established)
+	{
+		err = client_reattach(ctx, trans);
 	}
 	else
 	{
@@ -663,6 +1355,27 @@ void skdp_client_connection_close(skdp_client_state* ctx, qsc_socket* sock, skdp
 	client_dispose(ctx);
 }
 
+bool skdp_client_datagram_initialize(const skdp_client_state* ctx, skdp_datagram_state* dgram)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(dgram != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && dgram != NULL)
+	{
+		if (ctx->exflag == skdp_flag_session_established)
+		{
+			skdp_datagram_initialize(dgram, ctx->suite, ctx->kupdate.txsec, ctx->kupdate.rxsec);
+			res = true;
+		}
+	}
+
+	return res;
+}
+
 skdp_errors skdp_client_decrypt_packet(skdp_client_state* ctx, const skdp_network_packet* packetin, uint8_t* message, size_t message_capacity, size_t* msglen)
 {
 	SKDP_ASSERT(ctx != NULL);
@@ -684,20 +1397,36 @@ skdp_errors skdp_client_decrypt_packet(skdp_client_state* ctx, const skdp_networ
 				/* change 1.1 anti-replay; verify the packet time */
 				if (skdp_packet_time_valid(packetin) == true)
 				{
-					if (packetin->flag == skdp_flag_encrypted_message &&
-						packetin->msglen >= SKDP_MACTAG_SIZE &&
-						packetin->msglen <= SKDP_MESSAGE_SIZE + SKDP_MACTAG_SIZE &&
-						packetin->msglen - SKDP_MACTAG_SIZE <= message_capacity)
+					if ((packetin->flag == skdp_flag_encrypted_message || packetin->flag == skdp_flag_key_update || packetin->flag == skdp_flag_hibernate) &&
+						packetin->msglen >= ctx->suite->tagsize &&
+						packetin->msglen <= SKDP_MESSAGE_SIZE + ctx->suite->tagsize &&
+						packetin->msglen - ctx->suite->tagsize <= message_capacity)
 					{
 						/* serialize the header and add it to the ciphers associated data */
 						skdp_packet_header_serialize(packetin, hdr);
 						skdp_cipher_set_associated(&ctx->rxcpr, hdr, SKDP_HEADER_SIZE);
 
-						*msglen = packetin->msglen - SKDP_MACTAG_SIZE;
+						*msglen = packetin->msglen - ctx->suite->tagsize;
 
 						/* authenticate then decrypt the data */
 						if (skdp_cipher_transform(&ctx->rxcpr, message, packetin->pmessage, *msglen) == true)
 						{
+							if (packetin->flag == skdp_flag_key_update)
+							{
+								/* the sender has moved to its next key, follow it */
+								skdp_key_update_ratchet(&ctx->rxcpr, ctx->kupdate.rxsec, false);
+							}
+							else if (packetin->flag == skdp_flag_hibernate)
+							{
+								/* the server sends nothing more under its current key; both channels
+								   ratchet when the acknowledgement is sealed */
+								ctx->exflag = skdp_flag_hibernate;
+							}
+							else
+							{
+								/* an encrypted message */
+							}
+
 							ctx->rxseq += 1U;
 							err = skdp_error_none;
 						}
@@ -737,6 +1466,32 @@ skdp_errors skdp_client_decrypt_packet(skdp_client_state* ctx, const skdp_networ
 	return err;
 }
 
+skdp_errors skdp_client_hibernate_ack(skdp_client_state* ctx, skdp_network_packet* packetout)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(packetout != NULL);
+
+	skdp_errors err;
+
+	err = skdp_error_invalid_input;
+
+	if (ctx != NULL && packetout != NULL)
+	{
+		if (ctx->exflag == skdp_flag_hibernate)
+		{
+			client_hibernate_seal(ctx, packetout);
+			client_hibernate_ratchet(ctx);
+			err = skdp_error_none;
+		}
+		else
+		{
+			err = skdp_error_channel_down;
+		}
+	}
+
+	return err;
+}
+
 skdp_errors skdp_client_encrypt_packet(skdp_client_state* ctx, const uint8_t* message, size_t msglen, skdp_network_packet* packetout)
 {
 	SKDP_ASSERT(ctx != NULL);
@@ -757,8 +1512,8 @@ skdp_errors skdp_client_encrypt_packet(skdp_client_state* ctx, const uint8_t* me
 
 				/* assemble the encryption packet */
 				ctx->txseq += 1U;
-				packetout->flag = skdp_flag_encrypted_message;
-				packetout->msglen = (uint32_t)msglen + SKDP_MACTAG_SIZE;
+				packetout->flag = (skdp_key_update_account(&ctx->kupdate, msglen) == true) ? skdp_flag_key_update : skdp_flag_encrypted_message;
+				packetout->msglen = (uint32_t)(msglen + ctx->suite->tagsize);
 				packetout->sequence = ctx->txseq;
 				/* change 1.1 anti-replay; set the packet utc time field */
 				skdp_packet_set_utc_time(packetout);
@@ -768,6 +1523,12 @@ skdp_errors skdp_client_encrypt_packet(skdp_client_state* ctx, const uint8_t* me
 				/* encrypt the message */
 				skdp_cipher_transform(&ctx->txcpr, packetout->pmessage, message, msglen);
 
+				if (packetout->flag == skdp_flag_key_update)
+				{
+					/* the record is sealed under the old key, every record after it under the next */
+					skdp_key_update_ratchet(&ctx->txcpr, ctx->kupdate.txsec, true);
+				}
+
 				err = skdp_error_none;
 			}
 			else
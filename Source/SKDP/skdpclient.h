@@ -54,6 +54,8 @@
 
 #include "skdpcommon.h"
 #include "skdp.h"
+#include "skdpdatagram.h"
+#include "skdptransport.h"
 #include "socketclient.h"
 
 /**
@@ -73,6 +75,36 @@
  * \note All functions and structures defined in this header are part of the internal client implementation.
  */
 
+/*!
+ * \def SKDP_CLIENT_CONNECT_STAGGER
+ * \brief The delay in milliseconds before a dual-stack connect starts the IPv4 attempt.
+ */
+#define SKDP_CLIENT_CONNECT_STAGGER 250U
+
+/*!
+ * \def SKDP_CLIENT_CONNECT_TIMEOUT
+ * \brief The time in milliseconds a dual-stack connect waits for either connection.
+ */
+#define SKDP_CLIENT_CONNECT_TIMEOUT 10000U
+
+/*!
+ * \def SKDP_CLIENT_SESSION_SIZE
+ * \brief The byte size of a serialized client session; the channel secrets, the connection identifier and the counters.
+ */
+#define SKDP_CLIENT_SESSION_SIZE (4U + (2U * SKDP_KEY_UPDATE_SECRET_SIZE) + SKDP_CONNECTION_ID_SIZE + (4U * sizeof(uint64_t)))
+
+/*!
+ * \def SKDP_CLIENT_SESSION_EXPORT_SIZE
+ * \brief The maximum byte size of a sealed client session export.
+ */
+#define SKDP_CLIENT_SESSION_EXPORT_SIZE (SKDP_CLIENT_SESSION_SIZE + SKDP_SESSION_EXPORT_OVERHEAD)
+
+/*!
+ * \def SKDP_CLIENT_SESSION_VERSION
+ * \brief The serialized client session format version.
+ */
+#define SKDP_CLIENT_SESSION_VERSION 0x03U
+
 /*!
  * \struct skdp_client_state
  * \brief The SKDP client state structure.
@@ -87,6 +119,9 @@
  * - \c dsh: The device session hash, computed from the device identity, configuration, and a random token.
  * - \c kid: The device identity string.
  * - \c ssh: The server session hash received during the key exchange.
+ * - \c cid: The connection identifier used to reattach to the session over a new connection.
+ * - \c suite: The cipher suite offered to the server, and used for the session.
+ * - \c kupdate: The in-session key update secrets and counters.
  * - \c expiration: The expiration time for the current session (in seconds from epoch).
  * - \c rxseq: The receive channel packet sequence number.
  * - \c txseq: The transmit channel packet sequence number.
@@ -100,6 +135,9 @@ SKDP_EXPORT_API typedef struct skdp_client_state
 	uint8_t dsh[SKDP_STH_SIZE];			/*!< The device session hash */
 	uint8_t kid[SKDP_KID_SIZE];			/*!< The device identity string */
 	uint8_t ssh[SKDP_STH_SIZE];			/*!< The server session hash */
+	uint8_t cid[SKDP_CONNECTION_ID_SIZE];	/*!< The session connection identifier */
+	const skdp_cipher_suite* suite;		/*!< The offered and negotiated cipher suite */
+	skdp_key_update kupdate;			/*!< The in-session key update state */
 	uint64_t expiration;				/*!< The expiration time, in seconds from epoch */
 	uint64_t rxseq;						/*!< The receive channel packet sequence number */
 	uint64_t txseq;						/*!< The transmit channel packet sequence number */
@@ -166,6 +204,81 @@ SKDP_EXPORT_API skdp_errors skdp_client_connect_ipv4(skdp_client_state* ctx, qsc
  */
 SKDP_EXPORT_API skdp_errors skdp_client_connect_ipv6(skdp_client_state* ctx, qsc_socket* sock, const qsc_ipinfo_ipv6_address* address, uint16_t port);
 
+/*!
+ * \brief Race IPv6 and IPv4 connections to a dual-stack server and perform the key exchange on the first to connect.
+ *
+ * \details
+ * The IPv6 connection is started first; the IPv4 connection is started after \c SKDP_CLIENT_CONNECT_STAGGER
+ * milliseconds, or at once if the IPv6 attempt fails. The key exchange continues on whichever connection completes
+ * first, and the other attempt is cancelled, so a dead address family costs at most the stagger rather than a full
+ * TCP timeout. Either address may be NULL to connect over a single family.
+ *
+ * \param ctx A pointer to the SKDP client state structure.
+ * \param sock A pointer to the socket structure, receives the winning connection.
+ * \param ipv4 [const] A pointer to the server's IPv4 address, or NULL.
+ * \param ipv6 [const] A pointer to the server's IPv6 address, or NULL.
+ * \param port The server's port number.
+ *
+ * \return Returns a value of type \c skdp_errors representing the outcome of the connection and key exchange.
+ */
+SKDP_EXPORT_API skdp_errors skdp_client_connect_dual(skdp_client_state* ctx, qsc_socket* sock, const qsc_ipinfo_ipv4_address* ipv4, const qsc_ipinfo_ipv6_address* ipv6, uint16_t port);
+
+/*!
+ * \brief Perform the SKDP key exchange over a transport.
+ *
+ * \details
+ * This function runs the client side of the key exchange over an already connected transport, such as a socketpair,
+ * a pipe, or an application event loop. On failure an error packet is sent and the transport is closed.
+ *
+ * \param ctx A pointer to the SKDP client state structure.
+ * \param trans [const] A pointer to the connected transport.
+ *
+ * \return Returns a value of type \c skdp_errors indicating the success or failure of the key exchange.
+ */
+SKDP_EXPORT_API skdp_errors skdp_client_connect_transport(skdp_client_state* ctx, const skdp_transport* trans);
+
+/*!
+ * \brief Reattach an established session over a new IPv4 connection.
+ *
+ * \details
+ * Connects to the server and sends a single reattach record: the session connection identifier and a proof sealed
+ * under the transmit channel. The server answers with a record sealed under its transmit channel, after which the
+ * session continues with its existing keys and sequence numbers, and both ends move to the next connection
+ * identifier; no key exchange is performed.
+ * On failure the session is left unchanged, and the reattach may be retried over another connection; if only the
+ * response was lost, the server answers the repeated request again.
+ *
+ * \param ctx A pointer to the established SKDP client state.
+ * \param sock A pointer to the socket structure, receives the new connection.
+ * \param address [const] The server IPv4 address.
+ * \param port The server port number.
+ *
+ * \return Returns \c skdp_error_none if the session was reattached, otherwise an \c skdp_errors code.
+ */
+SKDP_EXPORT_API skdp_errors skdp_client_reattach_ipv4(skdp_client_state* ctx, qsc_socket* sock, const qsc_ipinfo_ipv4_address* address, uint16_t port);
+
+/*!
+ * \brief Reattach an established session over a new IPv6 connection.
+ *
+ * \param ctx A pointer to the established SKDP client state.
+ * \param sock A pointer to the socket structure, receives the new connection.
+ * \param address [const] The server IPv6 address.
+ * \param port The server port number.
+ *
+ * \return Returns \c skdp_error_none if the session was reattached, otherwise an \c skdp_errors code.
+ */
+SKDP_EXPORT_API skdp_errors skdp_client_reattach_ipv6(skdp_client_state* ctx, qsc_socket* sock, const qsc_ipinfo_ipv6_address* address, uint16_t port);
+
+/*!
+ * \brief Reattach an established session over a connected transport.
+ *
+ * \param ctx A pointer to the established SKDP client state.
+ * \param trans [const] A pointer to the connected transport.
+ *
+ * \return Returns \c skdp_error_none if the session was reattached, otherwise an \c skdp_errors code.
+ */
+SKDP_EXPORT_API skdp_errors skdp_client_reattach_transport(skdp_client_state* ctx, const skdp_transport* trans);
+
 /*!
  * \brief Close the remote session and dispose of client resources.
  *
@@ -179,6 +292,20 @@ SKDP_EXPORT_API skdp_errors skdp_client_connect_ipv6(skdp_client_state* ctx, qsc
  */
 SKDP_EXPORT_API void skdp_client_connection_close(skdp_client_state* ctx, qsc_socket* sock, skdp_errors error);
 
+/*!
+ * \brief Initialize the datagram mode record state for an established session.
+ *
+ * \details
+ * Derives the datagram record keys from the session secrets. Call this immediately after the key exchange, before
+ * any stream record is sent, since an in-session key update advances the secrets.
+ *
+ * \param ctx [const] A pointer to the established SKDP client state.
+ * \param dgram A pointer to the datagram state.
+ *
+ * \return Returns true if the session is established and the datagram state was initialized.
+ */
+SKDP_EXPORT_API bool skdp_client_datagram_initialize(const skdp_client_state* ctx, skdp_datagram_state* dgram);
+
 /*!
  * \brief Decrypt an SKDP packet.
  *
@@ -186,6 +313,8 @@ SKDP_EXPORT_API void skdp_client_connection_close(skdp_client_state* ctx, qsc_so
  * This function decrypts the message contained in the input SKDP network packet using the client's current
  * decryption state, and copies the plaintext into the provided output buffer. The length of the decrypted
  * message is returned via the msglen parameter.
+ * A record flagged \c skdp_flag_hibernate is an empty hibernate request from the server; the receive channel is
+ * ratcheted forward, and the application sends the acknowledgement made by \c skdp_client_hibernate_ack.
  *
  * \param ctx A pointer to the SKDP client state structure.
  * \param packetin [const] A pointer to the input SKDP network packet.
@@ -215,4 +344,118 @@ SKDP_EXPORT_API skdp_errors skdp_client_decrypt_packet(skdp_client_state* ctx, c
  */
 SKDP_EXPORT_API skdp_errors skdp_client_encrypt_packet(skdp_client_state* ctx, const uint8_t* message, size_t msglen, skdp_network_packet* packetout);
 
+/*!
+ * \brief Acknowledge a hibernate request from the server.
+ *
+ * \details
+ * Seals an empty record flagged \c skdp_flag_hibernate_ack as the last record under the current transmit key, then
+ * ratchets both channels forward. The server hibernates the session once it opens the acknowledgement, and
+ * opens the next record from the device under the ratcheted key after it wakes the session. No other record can be
+ * sent between the request and the acknowledgement.
+ *
+ * \param ctx A pointer to the SKDP client state structure.
+ * \param packetout A pointer to the output packet; the message buffer must hold the authentication tag.
+ *
+ * \return Returns \c skdp_error_none if the acknowledgement was sealed, or \c skdp_error_channel_down if no hibernate
+ * request is pending.
+ */
+SKDP_EXPORT_API skdp_errors skdp_client_hibernate_ack(skdp_client_state* ctx, skdp_network_packet* packetout);
+
+/*!
+ * \brief Restore an established client session from its serialized form.
+ *
+ * \details
+ * Loads the channel secrets and counters written by \c skdp_client_session_serialize and re-expands both channel
+ * cipher states to the keys the server re-derives after the hibernate exchange. The device derivation key is not part
+ * of the session and is left as it is in \c ctx, so the state should be initialized with \c skdp_client_initialize
+ * first. A mismatched version or an unknown suite is rejected.
+ *
+ * \param ctx A pointer to the SKDP client state.
+ * \param input [const] The serialized session.
+ * \param inlen The length of the serialized session, \c SKDP_CLIENT_SESSION_SIZE bytes.
+ *
+ * \return Returns true if the session was restored.
+ */
+SKDP_EXPORT_API bool skdp_client_session_deserialize(skdp_client_state* ctx, const uint8_t* input, size_t inlen);
+
+/*!
+ * \brief Acknowledge a hibernate request and export the client session sealed under an export key.
+ *
+ * \details
+ * Serializes the session with \c skdp_client_session_serialize and encrypts and authenticates it with
+ * \c skdp_session_seal. The acknowledgement written to \c packetout must be sent to the server.
+ *
+ * \param ctx A pointer to the SKDP client state, with a hibernate request pending.
+ * \param packetout A pointer to the output packet; the message buffer must hold the authentication tag.
+ * \param key [const] The export key, \c SKDP_SESSION_EXPORT_KEY_SIZE bytes.
+ * \param output The output buffer, at least \c SKDP_CLIENT_SESSION_EXPORT_SIZE bytes.
+ * \param otplen The length of the output buffer.
+ * \param outlen Receives the length of the sealed export.
+ *
+ * \return Returns \c skdp_error_none if the session was exported, otherwise an \c skdp_errors code.
+ */
+SKDP_EXPORT_API skdp_errors skdp_client_session_export(skdp_client_state* ctx, skdp_network_packet* packetout, const uint8_t* key, uint8_t* output, size_t otplen, size_t* outlen);
+
+/*!
+ * \brief Import a client session sealed by \c skdp_client_session_export.
+ *
+ * \param ctx A pointer to the SKDP client state, initialized with \c skdp_client_initialize.
+ * \param key [const] The export key, \c SKDP_SESSION_EXPORT_KEY_SIZE bytes.
+ * \param input [const] The sealed export.
+ * \param inlen The length of the sealed export.
+ *
+ * \return Returns true if the session was authenticated and restored.
+ */
+SKDP_EXPORT_API bool skdp_client_session_import(skdp_client_state* ctx, const uint8_t* key, const uint8_t* input, size_t inlen);
+
+/*!
+ * \brief Acknowledge a hibernate request and serialize the client session.
+ *
+ * \details
+ * A session carries no portable cipher state, so it is only serialized at the ratchet point both sides agree on: the
+ * hibernate exchange. The acknowledgement is sealed into \c packetout as with \c skdp_client_hibernate_ack, and the
+ * channel secrets both sides ratchet from, the connection identifier and the counters are written to \c output.
+ * On success the local state is disposed of. The output holds session secrets and must be erased after use.
+ *
+ * \param ctx A pointer to the SKDP client state, with a hibernate request pending.
+ * \param packetout A pointer to the output packet; the message buffer must hold the authentication tag.
+ * \param output The output buffer, at least \c SKDP_CLIENT_SESSION_SIZE bytes.
+ * \param otplen The length of the output buffer.
+ *
+ * \return Returns \c skdp_error_none if the session was serialized, or \c skdp_error_channel_down if no hibernate
+ * request is pending.
+ */
+SKDP_EXPORT_API skdp_errors skdp_client_session_serialize(skdp_client_state* ctx, skdp_network_packet* packetout, uint8_t* output, size_t otplen);
+
+/*!
+ * \brief Enable the in-session key update.
+ *
+ * \details
+ * The transmit channel key is ratcheted forward, without a round trip, after the given number of records or
+ * message bytes, whichever is reached first; a zero value disables that trigger. Both are disabled by default,
+ * the recommended values are \c SKDP_KEY_UPDATE_RECORDS and \c SKDP_KEY_UPDATE_BYTES. The receive channel always
+ * follows a key update sent by the peer. Call this function after initialization.
+ *
+ * \param ctx A pointer to the SKDP client state structure.
+ * \param maxrecords The number of records sealed under one key.
+ * \param maxbytes The number of message bytes sealed under one key.
+ */
+SKDP_EXPORT_API void skdp_client_set_key_update(skdp_client_state* ctx, uint64_t maxrecords, uint64_t maxbytes);
+
+/*!
+ * \brief Select the cipher suite offered by the client.
+ *
+ * \details
+ * The client offers a single suite in the connect request, and the server either accepts it or rejects the
+ * connection. The suite is set to the default suite by skdp_client_initialize; call this function after
+ * initialization and before connecting to offer a different suite, for example the suite returned by
+ * skdp_cipher_suite_preferred.
+ *
+ * \param ctx A pointer to the SKDP client state structure.
+ * \param id The cipher suite identifier.
+ *
+ * \return Returns true if the suite is compiled into the library and was selected.
+ */
+SKDP_EXPORT_API bool skdp_client_set_suite(skdp_client_state* ctx, skdp_suite_id id);
+
 #endif
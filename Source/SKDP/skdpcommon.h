@@ -128,6 +128,63 @@
 #  define SKDP_ASSERT(expr) ((void)0)
 #endif
 
+/*!
+ * \def SKDP_ATOMIC_LOAD
+ * \brief Atomically load a 64-bit value (sequentially consistent).
+ */
+/*!
+ * \def SKDP_ATOMIC_STORE
+ * \brief Atomically store a 64-bit value (sequentially consistent).
+ */
+/*!
+ * \def SKDP_ATOMIC_ADD
+ * \brief Atomically add to a 64-bit value, returns the new value.
+ */
+/*!
+ * \def SKDP_ATOMIC_SUB
+ * \brief Atomically subtract from a 64-bit value, returns the new value.
+ */
+/*!
+ * \def SKDP_ATOMIC_CAS
+ * \brief Atomically compare and swap a 64-bit value, returns true on success.
+ */
+/*!
+ * \def SKDP_ATOMIC_LOAD_RELAXED
+ * \brief Atomically load a 64-bit value with no ordering constraint.
+ */
+/*!
+ * \def SKDP_ATOMIC_STORE_RELAXED
+ * \brief Atomically store a 64-bit value with no ordering constraint.
+ */
+#if defined(QSC_SYSTEM_COMPILER_MSC)
+#	include <intrin.h>
+#	define SKDP_ATOMIC_LOAD(ptr) ((uint64_t)_InterlockedOr64((volatile int64_t*)(ptr), 0))
+#	define SKDP_ATOMIC_STORE(ptr, val) ((void)_InterlockedExchange64((volatile int64_t*)(ptr), (int64_t)(val)))
+#	define SKDP_ATOMIC_ADD(ptr, val) ((uint64_t)_InterlockedExchangeAdd64((volatile int64_t*)(ptr), (int64_t)(val)) + (uint64_t)(val))
+#	define SKDP_ATOMIC_SUB(ptr, val) ((uint64_t)_InterlockedExchangeAdd64((volatile int64_t*)(ptr), -(int64_t)(val)) - (uint64_t)(val))
+#	define SKDP_ATOMIC_CAS(ptr, expected, desired) (_InterlockedCompareExchange64((volatile int64_t*)(ptr), (int64_t)(desired), (int64_t)(expected)) == (int64_t)(expected))
+#	define SKDP_ATOMIC_LOAD_RELAXED(ptr) ((uint64_t)__iso_volatile_load64((const volatile int64_t*)(ptr)))
+#	define SKDP_ATOMIC_STORE_RELAXED(ptr, val) __iso_volatile_store64((volatile int64_t*)(ptr), (int64_t)(val))
+#else
+#	define SKDP_ATOMIC_LOAD(ptr) ((uint64_t)__atomic_load_n((ptr), __ATOMIC_SEQ_CST))
+#	define SKDP_ATOMIC_STORE(ptr, val) __atomic_store_n((ptr), (uint64_t)(val), __ATOMIC_SEQ_CST)
+#	define SKDP_ATOMIC_ADD(ptr, val) ((uint64_t)__atomic_add_fetch((ptr), (uint64_t)(val), __ATOMIC_SEQ_CST))
+#	define SKDP_ATOMIC_SUB(ptr, val) ((uint64_t)__atomic_sub_fetch((ptr), (uint64_t)(val), __ATOMIC_SEQ_CST))
+#	define SKDP_ATOMIC_CAS(ptr, expected, desired) __sync_bool_compare_and_swap((ptr), (uint64_t)(expected), (uint64_t)(desired))
+#	define SKDP_ATOMIC_LOAD_RELAXED(ptr) ((uint64_t)__atomic_load_n((ptr), __ATOMIC_RELAXED))
+#	define SKDP_ATOMIC_STORE_RELAXED(ptr, val) __atomic_store_n((ptr), (uint64_t)(val), __ATOMIC_RELAXED)
+#endif
+
+/*!
+ * \def SKDP_THREAD_LOCAL
+ * \brief The thread-local storage class specifier.
+ */
+#if defined(QSC_SYSTEM_COMPILER_MSC)
+#	define SKDP_THREAD_LOCAL __declspec(thread)
+#else
+#	define SKDP_THREAD_LOCAL _Thread_local
+#endif
+
 /** \endcond DOXYGEN_IGNORE */
 
 #endif
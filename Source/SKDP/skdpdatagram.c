@@ -0,0 +1,876 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#	define _GNU_SOURCE
+#endif
+#include "skdpdatagram.h"
+#include "intutils.h"
+#include "memutils.h"
+#include "sha3.h"
+#if !defined(QSC_SYSTEM_OS_WINDOWS)
+#	include <poll.h>
+#	include <sys/socket.h>
+#	include <unistd.h>
+#endif
+#if defined(QSC_SYSTEM_OS_LINUX)
+#	include <netinet/in.h>
+#	include <netinet/udp.h>
+#endif
+
+#define DATAGRAM_GSO_MAX 65000U
+#define DATAGRAM_WINDOW_WORDS (SKDP_DATAGRAM_REPLAY_WINDOW / 64U)
+
+static const uint8_t SKDP_DATAGRAM_LABEL[] = "skdp datagram";
+
+static void datagram_derive(uint8_t* key, uint8_t* nonce, const skdp_cipher_suite* suite, const uint8_t* secret)
+{
+	/* the key and base nonce fit in two blocks at the 512-bit rate, one at the 256-bit rate */
+	const size_t RNDBLK = (SKDP_CPRKEY_SIZE + SKDP_NONCE_SIZE + SKDP_PERMUTATION_RATE - 1U) / SKDP_PERMUTATION_RATE;
+	qsc_keccak_state kctx = { 0 };
+	uint8_t prnd[SKDP_PERMUTATION_RATE * 2U] = { 0U };
+
+	/* key || nonce = cSHAKE(secret, label), domain separated from the stream key update */
+	qsc_cshake_initialize(&kctx, SKDP_PERMUTATION_RATE, secret, SKDP_KEY_UPDATE_SECRET_SIZE, SKDP_DATAGRAM_LABEL, sizeof(SKDP_DATAGRAM_LABEL) - 1U, NULL, 0U);
+	qsc_cshake_squeezeblocks(&kctx, SKDP_PERMUTATION_RATE, prnd, RNDBLK);
+	qsc_memutils_copy(key, prnd, suite->keysize);
+	qsc_memutils_copy(nonce, prnd + suite->keysize, suite->noncesize);
+
+	qsc_memutils_secure_erase(&kctx, sizeof(qsc_keccak_state));
+	qsc_memutils_secure_erase(prnd, sizeof(prnd));
+}
+
+static void datagram_nonce(uint8_t* nonce, const uint8_t* base, size_t noncesize, uint64_t seq)
+{
+	size_t i;
+
+	/* the record nonce is the base nonce with the sequence number folded into the first eight bytes */
+	qsc_memutils_copy(nonce, base, noncesize);
+
+	for (i = 0U; i < sizeof(uint64_t); ++i)
+	{
+		nonce[i] ^= (uint8_t)(seq >> (i * 8U));
+	}
+}
+
+static bool datagram_window_check(const skdp_datagram_window* window, uint64_t seq)
+{
+	uint64_t bit;
+	bool res;
+
+	res = false;
+
+	if (seq != 0U)
+	{
+		if (seq > window->top)
+		{
+			res = true;
+		}
+		else if (seq + (SKDP_DATAGRAM_REPLAY_WINDOW - 64U) > window->top)
+		{
+			/* the word holding the oldest sequence numbers is recycled as the window slides, so one word is reserved */
+			bit = seq % SKDP_DATAGRAM_REPLAY_WINDOW;
+			res = (((window->bitmap[bit / 64U] >> (bit % 64U)) & 1U) == 0U);
+		}
+		else
+		{
+			/* older than the window */
+		}
+	}
+
+	return res;
+}
+
+static void datagram_window_update(skdp_datagram_window* window, uint64_t seq)
+{
+	uint64_t bit;
+	uint64_t cur;
+	uint64_t diff;
+	uint64_t i;
+
+	if (seq > window->top)
+	{
+		/* slide the window, clearing the words that enter it */
+		cur = window->top / 64U;
+		diff = (seq / 64U) - cur;
+
+		if (diff > DATAGRAM_WINDOW_WORDS)
+		{
+			diff = DATAGRAM_WINDOW_WORDS;
+		}
+
+		for (i = 1U; i <= diff; ++i)
+		{
+			window->bitmap[(cur + i) % DATAGRAM_WINDOW_WORDS] = 0U;
+		}
+
+		window->top = seq;
+	}
+
+	bit = seq % SKDP_DATAGRAM_REPLAY_WINDOW;
+	window->bitmap[bit / 64U] |= (1ULL << (bit % 64U));
+}
+
+#if defined(QSC_SYSTEM_OS_LINUX)
+static size_t datagram_send_gso(skdp_datagram_batch* batch, int32_t fd)
+{
+	union
+	{
+		uint8_t buf[CMSG_SPACE(sizeof(uint16_t))];
+		struct cmsghdr align;
+	} cbuf;
+	struct cmsghdr* cmsg;
+	struct iovec iov;
+	struct msghdr msg;
+	size_t i;
+	size_t res;
+	size_t seg;
+	size_t total;
+	uint16_t segsize;
+	bool uniform;
+
+	res = 0U;
+	seg = batch->lengths[0U];
+	total = 0U;
+	uniform = true;
+
+	/* every record but the last must be of the segment size, the last may be shorter */
+	for (i = 0U; i < batch->count; ++i)
+	{
+		if ((i + 1U < batch->count && batch->lengths[i] != seg) || batch->lengths[i] > seg)
+		{
+			uniform = false;
+		}
+
+		total += batch->lengths[i];
+	}
+
+	if (uniform == true && total <= DATAGRAM_GSO_MAX)
+	{
+		/* pack the records back to back at multiples of the segment size */
+		for (i = 1U; i < batch->count; ++i)
+		{
+			memmove(batch->arena + (i * seg), batch->arena + batch->offsets[i], batch->lengths[i]);
+			batch->offsets[i] = i * seg;
+		}
+
+		qsc_memutils_clear(&msg, sizeof(msg));
+		qsc_memutils_clear(&cbuf, sizeof(cbuf));
+		iov.iov_base = batch->arena;
+		iov.iov_len = total;
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1U;
+		msg.msg_control = cbuf.buf;
+		msg.msg_controllen = sizeof(cbuf.buf);
+		cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_UDP;
+		cmsg->cmsg_type = UDP_SEGMENT;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+		segsize = (uint16_t)seg;
+		qsc_memutils_copy(CMSG_DATA(cmsg), &segsize, sizeof(segsize));
+
+		if (sendmsg(fd, &msg, 0) == (ssize_t)total)
+		{
+			res = batch->count;
+		}
+		else if (errno == EINVAL || errno == EIO || errno == ENOPROTOOPT || errno == EOPNOTSUPP)
+		{
+			/* the kernel or the device does not support segmentation offload */
+			batch->gso = false;
+		}
+		else
+		{
+			/* transient failure, the records are sent individually */
+		}
+	}
+
+	return res;
+}
+
+static size_t datagram_send_mmsg(const skdp_datagram_batch* batch, int32_t fd)
+{
+	struct mmsghdr msgs[SKDP_DATAGRAM_BATCH_MAX];
+	struct iovec iovs[SKDP_DATAGRAM_BATCH_MAX];
+	size_t i;
+	size_t res;
+	int32_t ret;
+	bool run;
+
+	qsc_memutils_clear(msgs, sizeof(msgs));
+
+	for (i = 0U; i < batch->count; ++i)
+	{
+		iovs[i].iov_base = batch->arena + batch->offsets[i];
+		iovs[i].iov_len = batch->lengths[i];
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1U;
+	}
+
+	res = 0U;
+	run = true;
+
+	while (res < batch->count && run == true)
+	{
+		ret = sendmmsg(fd, msgs + res, (uint32_t)(batch->count - res), 0);
+
+		if (ret > 0)
+		{
+			res += (size_t)ret;
+		}
+		else if (ret < 0 && errno == EINTR)
+		{
+			/* interrupted, retry */
+		}
+		else
+		{
+			run = false;
+		}
+	}
+
+	return res;
+}
+
+static size_t datagram_receive_gro(skdp_datagram_batch* batch, int32_t fd)
+{
+	union
+	{
+		uint8_t buf[CMSG_SPACE(sizeof(int))];
+		struct cmsghdr align;
+	} cbuf;
+	struct cmsghdr* cmsg;
+	struct iovec iov;
+	struct msghdr msg;
+	ssize_t rlen;
+	size_t pos;
+	size_t res;
+	size_t seg;
+	int gso;
+
+	res = 0U;
+	qsc_memutils_clear(&msg, sizeof(msg));
+	iov.iov_base = batch->arena;
+	iov.iov_len = batch->arenalen;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1U;
+	msg.msg_control = cbuf.buf;
+	msg.msg_controllen = sizeof(cbuf.buf);
+	rlen = recvmsg(fd, &msg, 0);
+
+	if (rlen > 0)
+	{
+		/* a coalesced read carries the segment size, a single datagram does not */
+		seg = (size_t)rlen;
+
+		for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+		{
+			if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO)
+			{
+				qsc_memutils_copy(&gso, CMSG_DATA(cmsg), sizeof(gso));
+
+				if (gso > 0)
+				{
+					seg = (size_t)gso;
+				}
+			}
+		}
+
+		pos = 0U;
+
+		while (pos < (size_t)rlen && res < SKDP_DATAGRAM_BATCH_MAX)
+		{
+			batch->offsets[res] = pos;
+			batch->lengths[res] = qsc_intutils_min(seg, (size_t)rlen - pos);
+			pos += batch->lengths[res];
+			++res;
+		}
+	}
+
+	return res;
+}
+
+static size_t datagram_receive_mmsg(skdp_datagram_batch* batch, int32_t fd)
+{
+	struct mmsghdr msgs[SKDP_DATAGRAM_BATCH_MAX];
+	struct iovec iovs[SKDP_DATAGRAM_BATCH_MAX];
+	size_t i;
+	size_t res;
+	int32_t ret;
+
+	res = 0U;
+	qsc_memutils_clear(msgs, sizeof(msgs));
+
+	for (i = 0U; i < SKDP_DATAGRAM_BATCH_MAX; ++i)
+	{
+		batch->offsets[i] = i * SKDP_DATAGRAM_MTU;
+		iovs[i].iov_base = batch->arena + batch->offsets[i];
+		iovs[i].iov_len = SKDP_DATAGRAM_MTU;
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1U;
+	}
+
+	/* block for the first datagram, then take every datagram already queued */
+	ret = recvmmsg(fd, msgs, SKDP_DATAGRAM_BATCH_MAX, MSG_WAITFORONE, NULL);
+
+	if (ret > 0)
+	{
+		res = (size_t)ret;
+
+		for (i = 0U; i < res; ++i)
+		{
+			/* a truncated datagram is not a valid record */
+			batch->lengths[i] = ((msgs[i].msg_hdr.msg_flags & MSG_TRUNC) == 0) ? msgs[i].msg_len : 0U;
+		}
+	}
+
+	return res;
+}
+#endif
+
+#if !defined(QSC_SYSTEM_OS_WINDOWS)
+static bool datagram_link_resend(const skdp_datagram_link* link)
+{
+	bool res;
+
+	res = false;
+
+	if (link->lastlen != 0U)
+	{
+		res = (send(link->fd, link->last, link->lastlen, 0) == (ssize_t)link->lastlen);
+	}
+
+	return res;
+}
+
+static bool datagram_link_fill(skdp_datagram_link* link)
+{
+	struct pollfd pfd;
+	ssize_t rlen;
+	uint32_t attempts;
+	int32_t tmo;
+	int32_t ret;
+	bool res;
+	bool run;
+
+	res = false;
+	run = true;
+	attempts = 0U;
+	tmo = (int32_t)SKDP_DATAGRAM_RETRANSMIT_INITIAL;
+	pfd.fd = link->fd;
+	pfd.events = POLLIN;
+
+	while (res == false && run == true)
+	{
+		pfd.revents = 0;
+		ret = poll(&pfd, 1U, tmo);
+
+		if (ret > 0)
+		{
+			rlen = recv(link->fd, link->rbuf, sizeof(link->rbuf), 0);
+
+			if (rlen > 0)
+			{
+				if ((size_t)rlen == link->prevlen && qsc_intutils_are_equal8(link->rbuf, link->prev, (size_t)rlen) == true)
+				{
+					/* a retransmitted request means the response was lost; the initiator drops duplicates */
+					if (link->initiator == false)
+					{
+						datagram_link_resend(link);
+					}
+				}
+				else
+				{
+					qsc_memutils_copy(link->prev, link->rbuf, (size_t)rlen);
+					link->prevlen = (size_t)rlen;
+					link->rlen = (size_t)rlen;
+					link->rpos = 0U;
+					res = true;
+				}
+			}
+			else if (rlen < 0 && (errno == EINTR || errno == ECONNREFUSED))
+			{
+				/* interrupted, or the peer is not yet listening */
+			}
+			else
+			{
+				run = false;
+			}
+		}
+		else if (ret == 0)
+		{
+			++attempts;
+
+			if (attempts > SKDP_DATAGRAM_RETRANSMIT_ATTEMPTS)
+			{
+				run = false;
+			}
+			else
+			{
+				if (link->initiator == true)
+				{
+					datagram_link_resend(link);
+				}
+
+				tmo = (tmo * 2 > (int32_t)SKDP_DATAGRAM_RETRANSMIT_MAX) ? (int32_t)SKDP_DATAGRAM_RETRANSMIT_MAX : tmo * 2;
+			}
+		}
+		else if (errno != EINTR)
+		{
+			run = false;
+		}
+		else
+		{
+			/* interrupted, retry */
+		}
+	}
+
+	return res;
+}
+
+static size_t datagram_link_receive(void* user, uint8_t* output, size_t otplen)
+{
+	skdp_datagram_link* link;
+	size_t res;
+
+	res = 0U;
+	link = (skdp_datagram_link*)user;
+
+	/* a handshake message is one datagram; reads are served from it until it is consumed */
+	if (link->rpos == link->rlen)
+	{
+		link->rlen = 0U;
+		link->rpos = 0U;
+		datagram_link_fill(link);
+	}
+
+	if (otplen <= link->rlen - link->rpos)
+	{
+		qsc_memutils_copy(output, link->rbuf + link->rpos, otplen);
+		link->rpos += otplen;
+		res = otplen;
+	}
+	else
+	{
+		/* the datagram is shorter than the message, discard it */
+		link->rpos = link->rlen;
+	}
+
+	return res;
+}
+
+static size_t datagram_link_send(void* user, const uint8_t* input, size_t inlen)
+{
+	skdp_datagram_link* link;
+	size_t res;
+
+	res = 0U;
+	link = (skdp_datagram_link*)user;
+
+	if (inlen <= sizeof(link->last))
+	{
+		/* keep the datagram for retransmission */
+		qsc_memutils_copy(link->last, input, inlen);
+		link->lastlen = inlen;
+
+		if (send(link->fd, input, inlen, 0) == (ssize_t)inlen)
+		{
+			res = inlen;
+		}
+	}
+
+	return res;
+}
+#endif
+
+void skdp_datagram_batch_dispose(skdp_datagram_batch* batch)
+{
+	SKDP_ASSERT(batch != NULL);
+
+	if (batch != NULL)
+	{
+		if (batch->arena != NULL)
+		{
+			qsc_memutils_alloc_free(batch->arena);
+		}
+
+		qsc_memutils_clear(batch, sizeof(skdp_datagram_batch));
+	}
+}
+
+bool skdp_datagram_batch_initialize(skdp_datagram_batch* batch)
+{
+	SKDP_ASSERT(batch != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (batch != NULL)
+	{
+		qsc_memutils_clear(batch, sizeof(skdp_datagram_batch));
+		/* the arena also holds the largest coalesced receive */
+		batch->arenalen = SKDP_DATAGRAM_BATCH_MAX * SKDP_DATAGRAM_MTU;
+		batch->arena = (uint8_t*)qsc_memutils_malloc(batch->arenalen);
+
+		if (batch->arena != NULL)
+		{
+			res = true;
+		}
+		else
+		{
+			batch->arenalen = 0U;
+		}
+	}
+
+	return res;
+}
+
+bool skdp_datagram_batch_offload(skdp_datagram_batch* batch, int32_t fd)
+{
+	SKDP_ASSERT(batch != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (batch != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_LINUX)
+		int one;
+
+		one = 1;
+		batch->gso = true;
+		batch->gro = (setsockopt(fd, SOL_UDP, UDP_GRO, &one, sizeof(one)) == 0);
+		res = batch->gro;
+#else
+		(void)fd;
+#endif
+	}
+
+	return res;
+}
+
+size_t skdp_datagram_batch_receive(skdp_datagram_batch* batch, int32_t fd)
+{
+	SKDP_ASSERT(batch != NULL);
+
+	size_t res;
+
+	res = 0U;
+
+	if (batch != NULL && batch->arena != NULL)
+	{
+		batch->count = 0U;
+
+#if defined(QSC_SYSTEM_OS_LINUX)
+		if (batch->gro == true)
+		{
+			res = datagram_receive_gro(batch, fd);
+		}
+		else
+		{
+			res = datagram_receive_mmsg(batch, fd);
+		}
+#elif !defined(QSC_SYSTEM_OS_WINDOWS)
+		ssize_t rlen;
+		int32_t flags;
+		bool run;
+
+		flags = 0;
+		run = true;
+
+		while (res < SKDP_DATAGRAM_BATCH_MAX && run == true)
+		{
+			batch->offsets[res] = res * SKDP_DATAGRAM_MTU;
+			rlen = recv(fd, batch->arena + batch->offsets[res], SKDP_DATAGRAM_MTU, flags);
+
+			if (rlen > 0)
+			{
+				batch->lengths[res] = (size_t)rlen;
+				++res;
+				flags = MSG_DONTWAIT;
+			}
+			else
+			{
+				run = false;
+			}
+		}
+#else
+		(void)fd;
+#endif
+
+		batch->count = res;
+	}
+
+	return res;
+}
+
+skdp_errors skdp_datagram_batch_seal(skdp_datagram_batch* batch, skdp_datagram_state* state, const uint8_t* message, size_t msglen)
+{
+	SKDP_ASSERT(batch != NULL);
+	SKDP_ASSERT(state != NULL);
+	SKDP_ASSERT(message != NULL);
+
+	size_t rlen;
+	skdp_errors err;
+
+	err = skdp_error_invalid_input;
+
+	if (batch != NULL && batch->arena != NULL && state != NULL && message != NULL && batch->count < SKDP_DATAGRAM_BATCH_MAX)
+	{
+		batch->offsets[batch->count] = batch->count * SKDP_DATAGRAM_MTU;
+		err = skdp_datagram_seal(state, message, msglen, batch->arena + batch->offsets[batch->count], SKDP_DATAGRAM_MTU, &rlen);
+
+		if (err == skdp_error_none)
+		{
+			batch->lengths[batch->count] = rlen;
+			++batch->count;
+		}
+	}
+
+	return err;
+}
+
+size_t skdp_datagram_batch_send(skdp_datagram_batch* batch, int32_t fd)
+{
+	SKDP_ASSERT(batch != NULL);
+
+	size_t res;
+
+	res = 0U;
+
+	if (batch != NULL && batch->arena != NULL && batch->count != 0U)
+	{
+#if defined(QSC_SYSTEM_OS_LINUX)
+		if (batch->gso == true && batch->count > 1U)
+		{
+			res = datagram_send_gso(batch, fd);
+		}
+
+		if (res == 0U)
+		{
+			res = datagram_send_mmsg(batch, fd);
+		}
+#elif !defined(QSC_SYSTEM_OS_WINDOWS)
+		size_t i;
+
+		for (i = 0U; i < batch->count; ++i)
+		{
+			if (send(fd, batch->arena + batch->offsets[i], batch->lengths[i], 0) == (ssize_t)batch->lengths[i])
+			{
+				++res;
+			}
+		}
+#else
+		(void)fd;
+#endif
+
+		batch->count = 0U;
+	}
+
+	return res;
+}
+
+void skdp_datagram_dispose(skdp_datagram_state* state)
+{
+	SKDP_ASSERT(state != NULL);
+
+	if (state != NULL)
+	{
+		qsc_memutils_secure_erase(state, sizeof(skdp_datagram_state));
+	}
+}
+
+void skdp_datagram_initialize(skdp_datagram_state* state, const skdp_cipher_suite* suite, const uint8_t* txsecret, const uint8_t* rxsecret)
+{
+	SKDP_ASSERT(state != NULL);
+	SKDP_ASSERT(suite != NULL);
+	SKDP_ASSERT(txsecret != NULL);
+	SKDP_ASSERT(rxsecret != NULL);
+
+	if (state != NULL && suite != NULL && txsecret != NULL && rxsecret != NULL)
+	{
+		qsc_memutils_clear(state, sizeof(skdp_datagram_state));
+		datagram_derive(state->txkey, state->txnonce, suite, txsecret);
+		datagram_derive(state->rxkey, state->rxnonce, suite, rxsecret);
+		state->suite = suite;
+	}
+}
+
+void skdp_datagram_link_initialize(skdp_datagram_link* link, int32_t fd, bool initiator)
+{
+	SKDP_ASSERT(link != NULL);
+
+	if (link != NULL)
+	{
+		qsc_memutils_clear(link, sizeof(skdp_datagram_link));
+		link->fd = fd;
+		link->initiator = initiator;
+	}
+}
+
+bool skdp_datagram_link_retransmit(skdp_datagram_link* link)
+{
+	SKDP_ASSERT(link != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (link != NULL)
+	{
+#if !defined(QSC_SYSTEM_OS_WINDOWS)
+		res = datagram_link_resend(link);
+#endif
+	}
+
+	return res;
+}
+
+void skdp_datagram_link_transport(skdp_datagram_link* link, skdp_transport* trans)
+{
+	SKDP_ASSERT(link != NULL);
+	SKDP_ASSERT(trans != NULL);
+
+	if (link != NULL && trans != NULL)
+	{
+		qsc_memutils_clear(trans, sizeof(skdp_transport));
+#if !defined(QSC_SYSTEM_OS_WINDOWS)
+		trans->send = &datagram_link_send;
+		trans->receive = &datagram_link_receive;
+#endif
+		trans->close = NULL;
+		trans->user = link;
+	}
+}
+
+void skdp_datagram_set_link(skdp_datagram_state* state, skdp_datagram_link* link)
+{
+	SKDP_ASSERT(state != NULL);
+	SKDP_ASSERT(link != NULL);
+
+	if (state != NULL && link != NULL)
+	{
+		state->link = link;
+	}
+}
+
+skdp_errors skdp_datagram_open(skdp_datagram_state* state, const uint8_t* input, size_t inlen, uint8_t* message, size_t capacity, size_t* msglen)
+{
+	SKDP_ASSERT(state != NULL);
+	SKDP_ASSERT(input != NULL);
+	SKDP_ASSERT(message != NULL);
+	SKDP_ASSERT(msglen != NULL);
+
+	skdp_network_packet pkt = { 0 };
+	uint8_t nonce[SKDP_NONCE_SIZE] = { 0U };
+	skdp_cipher_state cpr;
+	size_t mlen;
+	skdp_errors err;
+
+	err = skdp_error_invalid_input;
+
+	if (state != NULL && state->suite != NULL && input != NULL && message != NULL && msglen != NULL)
+	{
+		*msglen = 0U;
+
+		if (state->link != NULL && inlen == state->link->prevlen && qsc_intutils_are_equal8(input, state->link->prev, inlen) == true)
+		{
+			/* the establish response was lost and the client repeated its request */
+#if !defined(QSC_SYSTEM_OS_WINDOWS)
+			datagram_link_resend(state->link);
+#endif
+			err = skdp_error_unsequenced;
+		}
+		else if (skdp_packet_header_deserialize(input, inlen, &pkt) == true &&
+			pkt.flag == skdp_flag_encrypted_message &&
+			pkt.msglen == inlen - SKDP_HEADER_SIZE &&
+			pkt.msglen >= state->suite->tagsize &&
+			pkt.msglen <= SKDP_MESSAGE_SIZE + state->suite->tagsize &&
+			pkt.msglen - state->suite->tagsize <= capacity)
+		{
+			/* reject replays before spending a decryption on them */
+			if (datagram_window_check(&state->window, pkt.sequence) == true)
+			{
+				if (skdp_packet_time_valid(&pkt) == true)
+				{
+					mlen = pkt.msglen - state->suite->tagsize;
+					datagram_nonce(nonce, state->rxnonce, state->suite->noncesize, pkt.sequence);
+					skdp_cipher_initialize(&cpr, state->suite, state->rxkey, nonce, false);
+					/* the header is authenticated as associated data */
+					skdp_cipher_set_associated(&cpr, input, SKDP_HEADER_SIZE);
+
+					if (skdp_cipher_transform(&cpr, message, input + SKDP_HEADER_SIZE, mlen) == true)
+					{
+						/* only an authenticated record moves the window, and proves the exchange completed */
+						datagram_window_update(&state->window, pkt.sequence);
+						state->link = NULL;
+						*msglen = mlen;
+						err = skdp_error_none;
+					}
+					else
+					{
+						err = skdp_error_cipher_auth_failure;
+					}
+
+					skdp_cipher_dispose(&cpr);
+					qsc_memutils_secure_erase(nonce, sizeof(nonce));
+				}
+				else
+				{
+					err = skdp_error_packet_expired;
+				}
+			}
+			else
+			{
+				err = skdp_error_unsequenced;
+			}
+		}
+	}
+
+	return err;
+}
+
+skdp_errors skdp_datagram_seal(skdp_datagram_state* state, const uint8_t* message, size_t msglen, uint8_t* output, size_t capacity, size_t* outlen)
+{
+	SKDP_ASSERT(state != NULL);
+	SKDP_ASSERT(message != NULL);
+	SKDP_ASSERT(output != NULL);
+	SKDP_ASSERT(outlen != NULL);
+
+	skdp_network_packet pkt = { 0 };
+	uint8_t nonce[SKDP_NONCE_SIZE] = { 0U };
+	skdp_cipher_state cpr;
+	size_t rlen;
+	skdp_errors err;
+
+	err = skdp_error_invalid_input;
+
+	if (state != NULL && state->suite != NULL && message != NULL && output != NULL && outlen != NULL)
+	{
+		*outlen = 0U;
+		rlen = SKDP_HEADER_SIZE + msglen + state->suite->tagsize;
+
+		if (msglen <= SKDP_MESSAGE_SIZE && rlen <= capacity && rlen <= SKDP_DATAGRAM_MTU)
+		{
+			state->txseq += 1U;
+			pkt.flag = skdp_flag_encrypted_message;
+			pkt.msglen = (uint32_t)(msglen + state->suite->tagsize);
+			pkt.sequence = state->txseq;
+			skdp_packet_set_utc_time(&pkt);
+			skdp_packet_header_serialize(&pkt, output);
+
+			/* each record is sealed under its own nonce, so records can be opened in any order */
+			datagram_nonce(nonce, state->txnonce, state->suite->noncesize, state->txseq);
+			skdp_cipher_initialize(&cpr, state->suite, state->txkey, nonce, true);
+			skdp_cipher_set_associated(&cpr, output, SKDP_HEADER_SIZE);
+
+			if (skdp_cipher_transform(&cpr, output + SKDP_HEADER_SIZE, message, msglen) == true)
+			{
+				*outlen = rlen;
+				err = skdp_error_none;
+			}
+
+			skdp_cipher_dispose(&cpr);
+			qsc_memutils_secure_erase(nonce, sizeof(nonce));
+		}
+	}
+
+	return err;
+}
@@ -0,0 +1,350 @@
+/* 2021-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SKDP_DATAGRAM_H
+#define SKDP_DATAGRAM_H
+
+#include "skdpcommon.h"
+#include "skdp.h"
+#include "skdptransport.h"
+
+/**
+ * \file skdpdatagram.h
+ * \brief The SKDP datagram mode.
+ *
+ * \details
+ * This header defines a datagram mode for SKDP in which each sealed record is one UDP datagram. On lossy links the
+ * stream mode stalls every record behind a lost TCP segment; in datagram mode a lost record costs only that record.
+ *
+ * Records are independent:
+ * - Each direction has a record key and a base nonce, derived after the key exchange from the session secrets with
+ * cSHAKE and the label "skdp datagram". The nonce of a record is the base nonce with the record sequence number
+ * XORed into its first eight bytes, so any record can be opened without the ones before it.
+ * - The sequence number is carried in the record header, which is authenticated as associated data.
+ * - The strict in-order sequence check of the stream mode is replaced by a sliding-window replay bitmap of
+ * \c SKDP_DATAGRAM_REPLAY_WINDOW records. A record is accepted once; records older than the window are rejected.
+ * The window is updated only after the record authenticates.
+ *
+ * The key exchange runs over a datagram link, a \c skdp_transport bound to a connected UDP socket. The initiator
+ * retransmits its last handshake message when a response does not arrive within the retransmission timeout, doubling
+ * the timeout on each attempt. The responder answers a retransmitted request by resending its last response. If the
+ * final server response is lost, the client retransmits the establish request after the server has completed the
+ * exchange. A server that holds its link with \c skdp_datagram_set_link answers it from \c skdp_datagram_open by
+ * resending the establish response, until the first record from the client authenticates. A server learns the peer
+ * address of a new session with a peeking receive, and connects the socket before starting the link.
+ *
+ * Records are sent and received in batches. On Linux a batch is sent with one \c sendmmsg call, or as a single
+ * UDP GSO super-datagram when the records are of equal size, and received with one \c recvmmsg call, or as one
+ * coalesced UDP GRO read when receive offload is enabled.
+ */
+
+/*!
+ * \def SKDP_DATAGRAM_BATCH_MAX
+ * \brief The number of records in a datagram batch; also the UDP segmentation offload segment limit.
+ */
+#define SKDP_DATAGRAM_BATCH_MAX 64U
+
+/*!
+ * \def SKDP_DATAGRAM_HANDSHAKE_MAX
+ * \brief The maximum size in bytes of a handshake datagram.
+ */
+#define SKDP_DATAGRAM_HANDSHAKE_MAX (SKDP_EXCHANGE_MAX_MESSAGE_SIZE + SKDP_COOKIE_SIZE)
+
+/*!
+ * \def SKDP_DATAGRAM_MTU
+ * \brief The maximum size in bytes of a record datagram.
+ */
+#define SKDP_DATAGRAM_MTU 1400U
+
+/*!
+ * \def SKDP_DATAGRAM_REPLAY_WINDOW
+ * \brief The replay window size in records, a multiple of 64.
+ */
+#define SKDP_DATAGRAM_REPLAY_WINDOW 1024U
+
+/*!
+ * \def SKDP_DATAGRAM_RETRANSMIT_ATTEMPTS
+ * \brief The number of handshake retransmissions before the exchange fails.
+ */
+#define SKDP_DATAGRAM_RETRANSMIT_ATTEMPTS 6U
+
+/*!
+ * \def SKDP_DATAGRAM_RETRANSMIT_INITIAL
+ * \brief The initial handshake retransmission timeout in milliseconds.
+ */
+#define SKDP_DATAGRAM_RETRANSMIT_INITIAL 250U
+
+/*!
+ * \def SKDP_DATAGRAM_RETRANSMIT_MAX
+ * \brief The maximum handshake retransmission timeout in milliseconds.
+ */
+#define SKDP_DATAGRAM_RETRANSMIT_MAX 4000U
+
+/*!
+ * \struct skdp_datagram_window
+ * \brief The datagram sliding-window replay bitmap.
+ */
+SKDP_EXPORT_API typedef struct skdp_datagram_window
+{
+	uint64_t bitmap[SKDP_DATAGRAM_REPLAY_WINDOW / 64U];	/*!< The received record bitmap */
+	uint64_t top;										/*!< The highest authenticated sequence number */
+} skdp_datagram_window;
+
+/*!
+ * \struct skdp_datagram_link
+ * \brief The datagram handshake link state.
+ */
+SKDP_EXPORT_API typedef struct skdp_datagram_link
+{
+	uint8_t last[SKDP_DATAGRAM_HANDSHAKE_MAX];			/*!< The last datagram sent, kept for retransmission */
+	uint8_t prev[SKDP_DATAGRAM_HANDSHAKE_MAX];			/*!< The last datagram received, kept for duplicate detection */
+	uint8_t rbuf[SKDP_DATAGRAM_HANDSHAKE_MAX];			/*!< The datagram being read */
+	size_t lastlen;										/*!< The length of the last datagram sent */
+	size_t prevlen;										/*!< The length of the last datagram received */
+	size_t rlen;										/*!< The length of the datagram being read */
+	size_t rpos;										/*!< The read position in the datagram */
+	int32_t fd;											/*!< The connected UDP socket descriptor */
+	bool initiator;										/*!< The link retransmits on timeout */
+} skdp_datagram_link;
+
+/*!
+ * \struct skdp_datagram_state
+ * \brief The datagram mode record state.
+ */
+SKDP_EXPORT_API typedef struct skdp_datagram_state
+{
+	QSC_SIMD_ALIGN uint8_t rxkey[SKDP_CPRKEY_SIZE];		/*!< The receive record key */
+	QSC_SIMD_ALIGN uint8_t rxnonce[SKDP_NONCE_SIZE];	/*!< The receive base nonce */
+	QSC_SIMD_ALIGN uint8_t txkey[SKDP_CPRKEY_SIZE];		/*!< The transmit record key */
+	QSC_SIMD_ALIGN uint8_t txnonce[SKDP_NONCE_SIZE];	/*!< The transmit base nonce */
+	skdp_datagram_window window;						/*!< The receive replay window */
+	const skdp_cipher_suite* suite;						/*!< The session cipher suite */
+	skdp_datagram_link* link;							/*!< The server handshake link, held until the first record authenticates */
+	uint64_t txseq;										/*!< The transmit record sequence number */
+} skdp_datagram_state;
+
+/*!
+ * \struct skdp_datagram_batch
+ * \brief A batch of record datagrams.
+ *
+ * \details
+ * Record \c i of a batch occupies \c lengths[i] bytes at \c arena + \c offsets[i].
+ */
+SKDP_EXPORT_API typedef struct skdp_datagram_batch
+{
+	uint8_t* arena;										/*!< The record arena */
+	size_t offsets[SKDP_DATAGRAM_BATCH_MAX];			/*!< The offset of each record in the arena */
+	size_t lengths[SKDP_DATAGRAM_BATCH_MAX];			/*!< The length of each record */
+	size_t arenalen;									/*!< The arena size in bytes */
+	size_t count;										/*!< The number of records in the batch */
+	bool gro;											/*!< Receive offload is enabled on the socket */
+	bool gso;											/*!< Send offload is available */
+} skdp_datagram_batch;
+
+/*!
+ * \brief Dispose of a datagram batch.
+ *
+ * \param batch A pointer to the batch.
+ */
+SKDP_EXPORT_API void skdp_datagram_batch_dispose(skdp_datagram_batch* batch);
+
+/*!
+ * \brief Initialize a datagram batch.
+ *
+ * \param batch A pointer to the batch.
+ *
+ * \return Returns true if the arena was allocated.
+ */
+SKDP_EXPORT_API bool skdp_datagram_batch_initialize(skdp_datagram_batch* batch);
+
+/*!
+ * \brief Enable UDP segmentation and receive offload for a batch and its socket.
+ *
+ * \details
+ * Receive offload is enabled on the socket when the kernel supports it. Send offload is attempted on each send
+ * of equal-size records, and disabled for the batch if the kernel rejects it.
+ *
+ * \param batch A pointer to the batch.
+ * \param fd The UDP socket descriptor.
+ *
+ * \return Returns true if receive offload was enabled.
+ */
+SKDP_EXPORT_API bool skdp_datagram_batch_offload(skdp_datagram_batch* batch, int32_t fd);
+
+/*!
+ * \brief Receive a batch of record datagrams.
+ *
+ * \details
+ * Blocks until at least one datagram arrives, then reads every datagram already queued up to the batch size.
+ *
+ * \param batch A pointer to the batch.
+ * \param fd The connected UDP socket descriptor.
+ *
+ * \return Returns the number of records received.
+ */
+SKDP_EXPORT_API size_t skdp_datagram_batch_receive(skdp_datagram_batch* batch, int32_t fd);
+
+/*!
+ * \brief Seal a message and append the record to a batch.
+ *
+ * \param batch A pointer to the batch.
+ * \param state A pointer to the datagram state.
+ * \param message [const] The plaintext message.
+ * \param msglen The message length.
+ *
+ * \return Returns \c skdp_error_none on success, or \c skdp_error_invalid_input if the batch is full or the message
+ * does not fit in a datagram.
+ */
+SKDP_EXPORT_API skdp_errors skdp_datagram_batch_seal(skdp_datagram_batch* batch, skdp_datagram_state* state, const uint8_t* message, size_t msglen);
+
+/*!
+ * \brief Send the records in a batch and empty it.
+ *
+ * \param batch A pointer to the batch.
+ * \param fd The connected UDP socket descriptor.
+ *
+ * \return Returns the number of records sent.
+ */
+SKDP_EXPORT_API size_t skdp_datagram_batch_send(skdp_datagram_batch* batch, int32_t fd);
+
+/*!
+ * \brief Erase the datagram state.
+ *
+ * \param state A pointer to the datagram state.
+ */
+SKDP_EXPORT_API void skdp_datagram_dispose(skdp_datagram_state* state);
+
+/*!
+ * \brief Initialize the datagram state from the session secrets.
+ *
+ * \details
+ * Use \c skdp_client_datagram_initialize or \c skdp_server_datagram_initialize immediately after the key exchange.
+ *
+ * \param state A pointer to the datagram state.
+ * \param suite [const] The session cipher suite.
+ * \param txsecret [const] The transmit channel secret, \c SKDP_KEY_UPDATE_SECRET_SIZE bytes.
+ * \param rxsecret [const] The receive channel secret, \c SKDP_KEY_UPDATE_SECRET_SIZE bytes.
+ */
+SKDP_EXPORT_API void skdp_datagram_initialize(skdp_datagram_state* state, const skdp_cipher_suite* suite, const uint8_t* txsecret, const uint8_t* rxsecret);
+
+/*!
+ * \brief Initialize a datagram handshake link.
+ *
+ * \param link A pointer to the link state.
+ * \param fd The connected UDP socket descriptor.
+ * \param initiator Set to true on the client, which retransmits on timeout.
+ */
+SKDP_EXPORT_API void skdp_datagram_link_initialize(skdp_datagram_link* link, int32_t fd, bool initiator);
+
+/*!
+ * \brief Resend the last handshake datagram.
+ *
+ * \param link A pointer to the link state.
+ *
+ * \return Returns true if the datagram was sent.
+ */
+SKDP_EXPORT_API bool skdp_datagram_link_retransmit(skdp_datagram_link* link);
+
+/*!
+ * \brief Bind a transport to a datagram handshake link.
+ *
+ * \param link A pointer to the link state.
+ * \param trans A pointer to the transport.
+ */
+SKDP_EXPORT_API void skdp_datagram_link_transport(skdp_datagram_link* link, skdp_transport* trans);
+
+/*!
+ * \brief Hold the server handshake link for retransmission of the establish response.
+ *
+ * \details
+ * Call on the server after the exchange completes. The link must remain valid until the first record authenticates,
+ * after which the state releases it.
+ *
+ * \param state A pointer to the datagram state.
+ * \param link A pointer to the link state the exchange ran on.
+ */
+SKDP_EXPORT_API void skdp_datagram_set_link(skdp_datagram_state* state, skdp_datagram_link* link);
+
+/*!
+ * \brief Authenticate and decrypt a record datagram.
+ *
+ * \details
+ * The record is checked against the replay window before decryption, and the window is updated only if the record
+ * authenticates. Records may arrive in any order. While a handshake link is held, a retransmitted establish request
+ * is answered by resending the establish response and reported as \c skdp_error_unsequenced.
+ *
+ * \param state A pointer to the datagram state.
+ * \param input [const] The record datagram.
+ * \param inlen The datagram length.
+ * \param message The output plaintext buffer.
+ * \param capacity The capacity of the output buffer.
+ * \param msglen A pointer to the plaintext length.
+ *
+ * \return Returns \c skdp_error_none on success, \c skdp_error_unsequenced for a replayed or too old record,
+ * \c skdp_error_packet_expired for a stale record, or \c skdp_error_cipher_auth_failure.
+ */
+SKDP_EXPORT_API skdp_errors skdp_datagram_open(skdp_datagram_state* state, const uint8_t* input, size_t inlen, uint8_t* message, size_t capacity, size_t* msglen);
+
+/*!
+ * \brief Encrypt a message into a record datagram.
+ *
+ * \param state A pointer to the datagram state.
+ * \param message [const] The plaintext message.
+ * \param msglen The message length.
+ * \param output The output record buffer.
+ * \param capacity The capacity of the output buffer.
+ * \param outlen A pointer to the record length.
+ *
+ * \return Returns \c skdp_error_none on success, or \c skdp_error_invalid_input.
+ */
+SKDP_EXPORT_API skdp_errors skdp_datagram_seal(skdp_datagram_state* state, const uint8_t* message, size_t msglen, uint8_t* output, size_t capacity, size_t* outlen);
+
+#endif
@@ -0,0 +1,152 @@
+#if !defined(_POSIX_C_SOURCE)
+#	define _POSIX_C_SOURCE 200809L
+#endif
+#include "skdpdrbg.h"
+#include "acp.h"
+#include "memutils.h"
+#include "timestamp.h"
+#if !defined(QSC_SYSTEM_OS_WINDOWS)
+#	include <pthread.h>
+#endif
+
+typedef struct drbg_state
+{
+	qsc_keccak_state kstate;
+	uint8_t buffer[SKDP_DRBG_BATCH_SIZE];
+	uint64_t epoch;
+	uint64_t generated;
+	uint64_t rtime;
+	size_t position;
+	bool seeded;
+} drbg_state;
+
+static const char DRBG_CUSTOM[] = "SKDP-DRBG";
+static SKDP_THREAD_LOCAL drbg_state m_drbg_state;
+static volatile uint64_t m_drbg_fork_epoch;
+
+#if !defined(QSC_SYSTEM_OS_WINDOWS)
+static pthread_once_t m_drbg_once = PTHREAD_ONCE_INIT;
+
+static void drbg_fork_child(void)
+{
+	/* every thread-local generator in the child is now stale */
+	m_drbg_fork_epoch += 1U;
+}
+
+static void drbg_register_fork(void)
+{
+	pthread_atfork(NULL, NULL, &drbg_fork_child);
+}
+#endif
+
+static void drbg_clear(drbg_state* st)
+{
+	qsc_memutils_secure_erase(st, sizeof(drbg_state));
+	st->position = SKDP_DRBG_BATCH_SIZE;
+}
+
+static bool drbg_seed(drbg_state* st)
+{
+	uint8_t seed[SKDP_DRBG_SEED_SIZE] = { 0U };
+	bool res;
+
+#if !defined(QSC_SYSTEM_OS_WINDOWS)
+	pthread_once(&m_drbg_once, &drbg_register_fork);
+#endif
+
+	drbg_clear(st);
+	res = qsc_acp_generate(seed, sizeof(seed));
+
+	if (res == true)
+	{
+		qsc_cshake_initialize(&st->kstate, SKDP_PERMUTATION_RATE, seed, sizeof(seed), NULL, 0U, (const uint8_t*)DRBG_CUSTOM, sizeof(DRBG_CUSTOM) - 1U);
+		st->epoch = m_drbg_fork_epoch;
+		st->rtime = qsc_timestamp_epochtime_seconds();
+		st->seeded = true;
+	}
+
+	qsc_memutils_secure_erase(seed, sizeof(seed));
+
+	return res;
+}
+
+static bool drbg_refill(drbg_state* st)
+{
+	bool res;
+
+	res = true;
+
+	/* reseed limits are checked once per batch, off the per-token path */
+	if (st->seeded == false || st->generated >= SKDP_DRBG_RESEED_BYTES ||
+		qsc_timestamp_epochtime_seconds() - st->rtime >= SKDP_DRBG_RESEED_SECONDS)
+	{
+		res = drbg_seed(st);
+	}
+
+	if (res == true)
+	{
+		qsc_cshake_squeezeblocks(&st->kstate, SKDP_PERMUTATION_RATE, st->buffer, SKDP_DRBG_BATCH_BLOCKS);
+
+		/* fast key erasure; re-key from the head of the batch so earlier output cannot be recomputed */
+		qsc_cshake_initialize(&st->kstate, SKDP_PERMUTATION_RATE, st->buffer, SKDP_DRBG_KEY_SIZE, NULL, 0U, (const uint8_t*)DRBG_CUSTOM, sizeof(DRBG_CUSTOM) - 1U);
+		qsc_memutils_secure_erase(st->buffer, SKDP_DRBG_KEY_SIZE);
+		st->position = SKDP_DRBG_KEY_SIZE;
+		st->generated += SKDP_DRBG_BATCH_SIZE - SKDP_DRBG_KEY_SIZE;
+	}
+
+	return res;
+}
+
+void skdp_drbg_dispose(void)
+{
+	drbg_clear(&m_drbg_state);
+}
+
+bool skdp_drbg_generate(uint8_t* output, size_t length)
+{
+	SKDP_ASSERT(output != NULL);
+
+	drbg_state* st;
+	size_t n;
+	bool res;
+
+	res = false;
+
+	if (output != NULL)
+	{
+		st = &m_drbg_state;
+		res = true;
+
+		/* a forked child discards the parent's buffered output and reseeds */
+		if (st->seeded == false || st->epoch != m_drbg_fork_epoch)
+		{
+			res = drbg_seed(st);
+		}
+
+		while (length != 0U && res == true)
+		{
+			if (st->position >= SKDP_DRBG_BATCH_SIZE)
+			{
+				res = drbg_refill(st);
+			}
+
+			if (res == true)
+			{
+				n = SKDP_DRBG_BATCH_SIZE - st->position;
+				n = (length < n) ? length : n;
+				qsc_memutils_copy(output, st->buffer + st->position, n);
+				qsc_memutils_secure_erase(st->buffer + st->position, n);
+				st->position += n;
+				output += n;
+				length -= n;
+			}
+		}
+	}
+
+	return res;
+}
+
+bool skdp_drbg_reseed(void)
+{
+	return drbg_seed(&m_drbg_state);
+}
@@ -0,0 +1,146 @@
+/* 2021-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SKDP_DRBG_H
+#define SKDP_DRBG_H
+
+#include "skdpcommon.h"
+#include "skdp.h"
+#include "sha3.h"
+
+/**
+ * \file skdpdrbg.h
+ * \brief The SKDP per-thread session token generator.
+ *
+ * \details
+ * This header defines a cSHAKE-based deterministic random bit generator used for the ephemeral handshake tokens.
+ * Each thread owns a generator, so no locking is needed. The generator is seeded from the system entropy provider
+ * (\c qsc_acp_generate), and output is squeezed in batches of \c SKDP_DRBG_BATCH_BLOCKS Keccak blocks, so the entropy
+ * provider is called once per reseed interval rather than once per token. The cSHAKE instance runs at the protocol
+ * permutation rate, \c SKDP_PERMUTATION_RATE, so the tokens carry the security level of the configured protocol.
+ *
+ * After each batch is squeezed, the generator is re-keyed from the head of the batch and that key material is erased,
+ * so a later compromise of the generator state does not reveal earlier output. Buffered bytes are erased as they are
+ * handed out.
+ *
+ * The generator is reseeded from the entropy provider after \c SKDP_DRBG_RESEED_BYTES of output, after
+ * \c SKDP_DRBG_RESEED_SECONDS, and in a child process after a fork, so that parent and child never share output.
+ *
+ * Long-term keys are still generated directly from the entropy provider.
+ */
+
+/*!
+ * \def SKDP_DRBG_BATCH_BLOCKS
+ * \brief The number of Keccak blocks squeezed per batch.
+ */
+#define SKDP_DRBG_BATCH_BLOCKS 16U
+
+/*!
+ * \def SKDP_DRBG_BATCH_SIZE
+ * \brief The size (in bytes) of the generator output buffer.
+ */
+#define SKDP_DRBG_BATCH_SIZE (SKDP_DRBG_BATCH_BLOCKS * SKDP_PERMUTATION_RATE)
+
+/*!
+ * \def SKDP_DRBG_KEY_SIZE
+ * \brief The size (in bytes) of the re-key material taken from each batch.
+ */
+#if defined(SKDP_PROTOCOL_SEC512)
+#	define SKDP_DRBG_KEY_SIZE 64U
+#else
+#	define SKDP_DRBG_KEY_SIZE 32U
+#endif
+
+/*!
+ * \def SKDP_DRBG_RESEED_BYTES
+ * \brief The number of bytes generated before the generator is reseeded.
+ */
+#define SKDP_DRBG_RESEED_BYTES (1024U * 1024U)
+
+/*!
+ * \def SKDP_DRBG_RESEED_SECONDS
+ * \brief The number of seconds after which the generator is reseeded.
+ */
+#define SKDP_DRBG_RESEED_SECONDS 300U
+
+/*!
+ * \def SKDP_DRBG_SEED_SIZE
+ * \brief The size (in bytes) of the seed drawn from the entropy provider.
+ */
+#define SKDP_DRBG_SEED_SIZE 64U
+
+/*!
+ * \brief Erase the calling thread's generator state.
+ *
+ * \details
+ * Call before a thread that has generated tokens exits, so that its buffered output does not remain in memory.
+ * The next call to \c skdp_drbg_generate on the thread reseeds the generator.
+ */
+SKDP_EXPORT_API void skdp_drbg_dispose(void);
+
+/*!
+ * \brief Generate random bytes from the calling thread's generator.
+ *
+ * \param output The output buffer.
+ * \param length The number of bytes to generate.
+ *
+ * \return Returns false if the generator could not be seeded from the entropy provider.
+ */
+SKDP_EXPORT_API bool skdp_drbg_generate(uint8_t* output, size_t length);
+
+/*!
+ * \brief Force the calling thread's generator to reseed from the entropy provider.
+ *
+ * \return Returns true if the generator was reseeded.
+ */
+SKDP_EXPORT_API bool skdp_drbg_reseed(void);
+
+#endif
@@ -0,0 +1,1312 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#	define _GNU_SOURCE
+#endif
+#include "skdpengine.h"
+#include "memutils.h"
+#if defined(QSC_SYSTEM_OS_LINUX)
+#	include <linux/io_uring.h>
+#	include <sys/epoll.h>
+#	include <sys/mman.h>
+#	include <sys/socket.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+#if defined(QSC_SYSTEM_OS_LINUX)
+
+#define ENGINE_OP_ACCEPT 0x01ULL
+#define ENGINE_OP_RECEIVE 0x02ULL
+#define ENGINE_OP_SEND 0x03ULL
+#define ENGINE_OP_CANCEL 0x04ULL
+#define ENGINE_OP_SHIFT 32U
+#define ENGINE_OP_MASK ((1ULL << ENGINE_OP_SHIFT) - 1ULL)
+#define ENGINE_OP_DATA(op, val) (((op) << ENGINE_OP_SHIFT) | ((uint64_t)(val) & ENGINE_OP_MASK))
+
+typedef struct engine_send
+{
+	struct engine_send* next;
+	size_t length;
+	size_t offset;
+	int32_t fd;
+	uint8_t data[];
+} engine_send;
+
+typedef struct engine_queue
+{
+	engine_send* head;
+	engine_send* tail;
+	bool closing;
+	bool open;
+} engine_queue;
+
+typedef struct engine_ring
+{
+	struct io_uring_sqe* sqes;
+	struct io_uring_cqe* cqes;
+	struct io_uring_buf_ring* bufring;
+	uint8_t* map;
+	uint32_t* sqhead;
+	uint32_t* sqtail;
+	uint32_t* cqhead;
+	uint32_t* cqtail;
+	size_t maplen;
+	size_t sqeslen;
+	size_t brlen;
+	uint32_t cqmask;
+	uint32_t sqentries;
+	uint32_t sqmask;
+	uint32_t submitted;
+	uint32_t tail;
+	int32_t fd;
+	uint16_t brtail;
+} engine_ring;
+
+static int32_t engine_uring_setup(uint32_t entries, struct io_uring_params* params)
+{
+	return (int32_t)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int32_t engine_uring_enter(int32_t fd, uint32_t submit, uint32_t complete, uint32_t flags, const void* arg, size_t argsz)
+{
+	return (int32_t)syscall(__NR_io_uring_enter, fd, submit, complete, flags, arg, argsz);
+}
+
+static int32_t engine_uring_register(int32_t fd, uint32_t opcode, const void* arg, uint32_t nargs)
+{
+	return (int32_t)syscall(__NR_io_uring_register, fd, opcode, arg, nargs);
+}
+
+static bool engine_probe_op(const struct io_uring_probe* probe, uint32_t op)
+{
+	return (op <= probe->last_op && op < probe->ops_len && (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0U);
+}
+
+static bool engine_uring_probe(int32_t fd)
+{
+	struct io_uring_probe* probe;
+	size_t plen;
+	bool res;
+
+	res = false;
+	plen = sizeof(struct io_uring_probe) + ((size_t)IORING_OP_LAST * sizeof(struct io_uring_probe_op));
+	probe = (struct io_uring_probe*)qsc_memutils_malloc(plen);
+
+	if (probe != NULL)
+	{
+		qsc_memutils_clear(probe, plen);
+
+		if (engine_uring_register(fd, IORING_REGISTER_PROBE, probe, (uint32_t)IORING_OP_LAST) == 0)
+		{
+			/* the multishot receive flag has no probe bit; it arrived in 6.0 with the zero-copy send opcode,
+			   which stands in for it, while the buffer ring registration alone only proves 5.19 */
+			res = (engine_probe_op(probe, IORING_OP_ACCEPT) == true &&
+				engine_probe_op(probe, IORING_OP_RECV) == true &&
+				engine_probe_op(probe, IORING_OP_SEND) == true &&
+				engine_probe_op(probe, IORING_OP_ASYNC_CANCEL) == true &&
+				engine_probe_op(probe, IORING_OP_SEND_ZC) == true);
+		}
+
+		qsc_memutils_alloc_free(probe);
+	}
+
+	return res;
+}
+
+static void engine_ring_destroy(engine_ring* ring)
+{
+	if (ring->bufring != NULL)
+	{
+		munmap(ring->bufring, ring->brlen);
+	}
+
+	if (ring->sqes != NULL)
+	{
+		munmap(ring->sqes, ring->sqeslen);
+	}
+
+	if (ring->map != NULL)
+	{
+		munmap(ring->map, ring->maplen);
+	}
+
+	if (ring->fd >= 0)
+	{
+		close(ring->fd);
+	}
+
+	qsc_memutils_alloc_free(ring);
+}
+
+static engine_ring* engine_ring_create(void)
+{
+	struct io_uring_params params;
+	struct io_uring_buf_reg reg;
+	engine_ring* ring;
+	uint32_t* array;
+	void* mem;
+	size_t cqlen;
+	uint32_t i;
+	bool res;
+
+	res = false;
+	ring = (engine_ring*)qsc_memutils_malloc(sizeof(engine_ring));
+
+	if (ring != NULL)
+	{
+		qsc_memutils_clear(ring, sizeof(engine_ring));
+		qsc_memutils_clear(&params, sizeof(params));
+		ring->fd = engine_uring_setup(SKDP_ENGINE_QUEUE_DEPTH, &params);
+
+		/* a single ring mapping, the extended wait argument, and the multishot operations are required */
+		if (ring->fd >= 0 && (params.features & IORING_FEAT_SINGLE_MMAP) != 0U && (params.features & IORING_FEAT_EXT_ARG) != 0U &&
+			engine_uring_probe(ring->fd) == true)
+		{
+			ring->maplen = params.sq_off.array + (params.sq_entries * sizeof(uint32_t));
+			cqlen = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+
+			if (cqlen > ring->maplen)
+			{
+				ring->maplen = cqlen;
+			}
+
+			mem = mmap(NULL, ring->maplen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, (off_t)IORING_OFF_SQ_RING);
+			ring->map = (mem != MAP_FAILED) ? (uint8_t*)mem : NULL;
+			ring->sqeslen = params.sq_entries * sizeof(struct io_uring_sqe);
+			mem = mmap(NULL, ring->sqeslen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, (off_t)IORING_OFF_SQES);
+			ring->sqes = (mem != MAP_FAILED) ? (struct io_uring_sqe*)mem : NULL;
+			ring->brlen = SKDP_ENGINE_BUFFER_COUNT * sizeof(struct io_uring_buf);
+			mem = mmap(NULL, ring->brlen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			ring->bufring = (mem != MAP_FAILED) ? (struct io_uring_buf_ring*)mem : NULL;
+
+			if (ring->map != NULL && ring->sqes != NULL && ring->bufring != NULL)
+			{
+				ring->sqhead = (uint32_t*)(ring->map + params.sq_off.head);
+				ring->sqtail = (uint32_t*)(ring->map + params.sq_off.tail);
+				ring->sqmask = *(uint32_t*)(ring->map + params.sq_off.ring_mask);
+				ring->sqentries = params.sq_entries;
+				ring->cqhead = (uint32_t*)(ring->map + params.cq_off.head);
+				ring->cqtail = (uint32_t*)(ring->map + params.cq_off.tail);
+				ring->cqmask = *(uint32_t*)(ring->map + params.cq_off.ring_mask);
+				ring->cqes = (struct io_uring_cqe*)(ring->map + params.cq_off.cqes);
+				ring->tail = *ring->sqtail;
+				ring->submitted = ring->tail;
+
+				/* the submission array maps each slot to its own entry */
+				array = (uint32_t*)(ring->map + params.sq_off.array);
+
+				for (i = 0U; i < params.sq_entries; ++i)
+				{
+					array[i] = i;
+				}
+
+				/* register the provided receive buffer ring as group zero */
+				qsc_memutils_clear(&reg, sizeof(reg));
+				reg.ring_addr = (uint64_t)(uintptr_t)ring->bufring;
+				reg.ring_entries = SKDP_ENGINE_BUFFER_COUNT;
+				reg.bgid = 0U;
+
+				if (engine_uring_register(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1U) == 0)
+				{
+					res = true;
+				}
+			}
+		}
+
+		if (res == false)
+		{
+			engine_ring_destroy(ring);
+			ring = NULL;
+		}
+	}
+
+	return ring;
+}
+
+static void engine_ring_provide(engine_ring* ring, uint8_t* buffers, uint16_t bid)
+{
+	struct io_uring_buf* buf;
+
+	buf = &ring->bufring->bufs[ring->brtail & (SKDP_ENGINE_BUFFER_COUNT - 1U)];
+	buf->addr = (uint64_t)(uintptr_t)(buffers + ((size_t)bid * SKDP_ENGINE_BUFFER_SIZE));
+	buf->len = SKDP_ENGINE_BUFFER_SIZE;
+	buf->bid = bid;
+	++ring->brtail;
+	__atomic_store_n(&ring->bufring->tail, ring->brtail, __ATOMIC_RELEASE);
+}
+
+static bool engine_ring_submit(engine_ring* ring, uint32_t wait, const struct __kernel_timespec* ts)
+{
+	struct io_uring_getevents_arg arg;
+	uint32_t count;
+	uint32_t flags;
+	int32_t ret;
+	bool res;
+
+	res = true;
+	count = ring->tail - ring->submitted;
+	__atomic_store_n(ring->sqtail, ring->tail, __ATOMIC_RELEASE);
+
+	if (count != 0U || wait != 0U)
+	{
+		/* one call submits the whole batch and optionally waits for completions */
+		qsc_memutils_clear(&arg, sizeof(arg));
+		arg.ts = (uint64_t)(uintptr_t)ts;
+		flags = IORING_ENTER_EXT_ARG | ((wait != 0U) ? IORING_ENTER_GETEVENTS : 0U);
+		ret = engine_uring_enter(ring->fd, count, wait, flags, &arg, sizeof(arg));
+
+		if (ret >= 0)
+		{
+			ring->submitted += (uint32_t)ret;
+		}
+		else if (errno != ETIME && errno != EINTR)
+		{
+			res = false;
+		}
+	}
+
+	return res;
+}
+
+static struct io_uring_sqe* engine_ring_sqe(engine_ring* ring)
+{
+	struct io_uring_sqe* sqe;
+	uint32_t head;
+
+	sqe = NULL;
+	head = __atomic_load_n(ring->sqhead, __ATOMIC_ACQUIRE);
+
+	if (ring->tail - head >= ring->sqentries)
+	{
+		/* the queue is full, submit the batch to free entries */
+		engine_ring_submit(ring, 0U, NULL);
+		head = __atomic_load_n(ring->sqhead, __ATOMIC_ACQUIRE);
+	}
+
+	if (ring->tail - head < ring->sqentries)
+	{
+		sqe = &ring->sqes[ring->tail & ring->sqmask];
+		qsc_memutils_clear(sqe, sizeof(struct io_uring_sqe));
+		++ring->tail;
+	}
+
+	return sqe;
+}
+
+static bool engine_uring_accept(skdp_engine* engine)
+{
+	struct io_uring_sqe* sqe;
+	bool res;
+
+	res = false;
+	sqe = engine_ring_sqe((engine_ring*)engine->ring);
+
+	if (sqe != NULL)
+	{
+		sqe->opcode = IORING_OP_ACCEPT;
+		sqe->fd = engine->lfd;
+		sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+		sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+		sqe->user_data = ENGINE_OP_DATA(ENGINE_OP_ACCEPT, (uint32_t)engine->lfd);
+		res = true;
+	}
+
+	return res;
+}
+
+static bool engine_uring_receive(skdp_engine* engine, int32_t fd)
+{
+	struct io_uring_sqe* sqe;
+	bool res;
+
+	res = false;
+	sqe = engine_ring_sqe((engine_ring*)engine->ring);
+
+	if (sqe != NULL)
+	{
+		sqe->opcode = IORING_OP_RECV;
+		sqe->fd = fd;
+		sqe->ioprio = IORING_RECV_MULTISHOT;
+		sqe->flags = IOSQE_BUFFER_SELECT;
+		sqe->buf_group = 0U;
+		sqe->user_data = ENGINE_OP_DATA(ENGINE_OP_RECEIVE, (uint32_t)fd);
+		res = true;
+	}
+
+	return res;
+}
+
+static engine_queue* engine_queue_get(skdp_engine* engine, int32_t fd)
+{
+	engine_queue* res;
+
+	res = NULL;
+
+	if (fd >= 0 && (size_t)fd < engine->qcount)
+	{
+		res = &((engine_queue*)engine->queues)[fd];
+	}
+
+	return res;
+}
+
+static engine_queue* engine_queue_open(skdp_engine* engine, int32_t fd)
+{
+	engine_queue* res;
+	void* tbl;
+	size_t count;
+
+	if ((size_t)fd >= engine->qcount)
+	{
+		/* the table is indexed by descriptor, and grows to the next power of two */
+		count = (engine->qcount != 0U) ? engine->qcount : SKDP_ENGINE_EVENTS_MAX;
+
+		while (count <= (size_t)fd)
+		{
+			count <<= 1U;
+		}
+
+		tbl = qsc_memutils_realloc(engine->queues, count * sizeof(engine_queue));
+
+		if (tbl != NULL)
+		{
+			qsc_memutils_clear((uint8_t*)tbl + (engine->qcount * sizeof(engine_queue)), (count - engine->qcount) * sizeof(engine_queue));
+			engine->queues = tbl;
+			engine->qcount = count;
+		}
+	}
+
+	res = engine_queue_get(engine, fd);
+
+	if (res != NULL)
+	{
+		qsc_memutils_clear(res, sizeof(engine_queue));
+		res->open = true;
+	}
+
+	return res;
+}
+
+static engine_send* engine_send_create(engine_queue* queue, int32_t fd, const uint8_t* data, size_t length)
+{
+	engine_send* snd;
+
+	snd = (engine_send*)qsc_memutils_malloc(sizeof(engine_send) + length);
+
+	if (snd != NULL)
+	{
+		qsc_memutils_copy(snd->data, data, length);
+		snd->length = length;
+		snd->offset = 0U;
+		snd->fd = fd;
+		snd->next = NULL;
+
+		if (queue->tail != NULL)
+		{
+			queue->tail->next = snd;
+		}
+		else
+		{
+			queue->head = snd;
+		}
+
+		queue->tail = snd;
+	}
+
+	return snd;
+}
+
+static void engine_send_release(engine_queue* queue)
+{
+	engine_send* snd;
+
+	snd = queue->head;
+	queue->head = snd->next;
+
+	if (queue->head == NULL)
+	{
+		queue->tail = NULL;
+	}
+
+	qsc_memutils_alloc_free(snd);
+}
+
+static void engine_queue_clear(engine_queue* queue)
+{
+	while (queue->head != NULL)
+	{
+		engine_send_release(queue);
+	}
+}
+
+static bool engine_accept_exhausted(int32_t err)
+{
+	/* out of descriptors or memory; an accept retried before a descriptor is released fails again at once */
+	return (err == EMFILE || err == ENFILE || err == ENOBUFS || err == ENOMEM);
+}
+
+static bool engine_accept_transient(int32_t err)
+{
+	/* the pending connection failed, the listener is still usable */
+	return (err == EINTR || err == EAGAIN || err == EWOULDBLOCK || err == ECONNABORTED || err == EPROTO || err == EPERM);
+}
+
+static void engine_accept_stop(skdp_engine* engine, int32_t err)
+{
+	if (engine_accept_exhausted(err) == true)
+	{
+		/* resumed when a connection is closed */
+		engine->apause = true;
+	}
+	else
+	{
+		/* the listener is unusable, the application is told once */
+		engine->callback(engine->context, skdp_engine_event_error, engine->lfd, NULL, 0U);
+		engine->lfd = -1;
+	}
+}
+
+static void engine_accept_resume(skdp_engine* engine)
+{
+	struct epoll_event ev;
+
+	if (engine->apause == true && engine->lfd >= 0)
+	{
+		engine->apause = false;
+
+		if (engine->backend == skdp_engine_backend_io_uring)
+		{
+			engine_uring_accept(engine);
+		}
+		else
+		{
+			qsc_memutils_clear(&ev, sizeof(ev));
+			ev.events = EPOLLIN;
+			ev.data.fd = engine->lfd;
+			epoll_ctl(engine->epfd, EPOLL_CTL_ADD, engine->lfd, &ev);
+		}
+	}
+}
+
+static void engine_queue_close(skdp_engine* engine, engine_queue* queue, int32_t fd)
+{
+	/* the descriptor is closed once its queued sends have drained or failed */
+	engine_queue_clear(queue);
+
+	if (engine->backend == skdp_engine_backend_epoll)
+	{
+		epoll_ctl(engine->epfd, EPOLL_CTL_DEL, fd, NULL);
+	}
+
+	qsc_memutils_clear(queue, sizeof(engine_queue));
+	close(fd);
+
+	/* a released descriptor lets a paused accept make progress */
+	engine_accept_resume(engine);
+}
+
+static bool engine_uring_send(skdp_engine* engine, engine_send* snd)
+{
+	struct io_uring_sqe* sqe;
+	bool res;
+
+	res = false;
+	sqe = engine_ring_sqe((engine_ring*)engine->ring);
+
+	if (sqe != NULL)
+	{
+		/* one send per connection is in flight, the next is submitted when it completes */
+		sqe->opcode = IORING_OP_SEND;
+		sqe->fd = snd->fd;
+		sqe->addr = (uint64_t)(uintptr_t)(snd->data + snd->offset);
+		sqe->len = (uint32_t)(snd->length - snd->offset);
+		sqe->msg_flags = MSG_NOSIGNAL;
+		sqe->user_data = ENGINE_OP_DATA(ENGINE_OP_SEND, (uint32_t)snd->fd);
+		res = true;
+	}
+
+	return res;
+}
+
+static void engine_uring_sent(skdp_engine* engine, engine_queue* queue, int32_t fd, int32_t cres)
+{
+	engine_send* snd;
+	bool valid;
+
+	snd = queue->head;
+	valid = (cres > 0);
+
+	if (valid == true)
+	{
+		snd->offset += (size_t)cres;
+
+		if (snd->offset < snd->length)
+		{
+			/* a short send, submit the remainder */
+			valid = engine_uring_send(engine, snd);
+		}
+		else
+		{
+			if (queue->closing == false)
+			{
+				engine->callback(engine->context, skdp_engine_event_sent, fd, NULL, snd->length);
+			}
+
+			engine_send_release(queue);
+
+			if (queue->head != NULL)
+			{
+				valid = engine_uring_send(engine, queue->head);
+			}
+		}
+	}
+
+	if (valid == false)
+	{
+		/* the connection cannot carry the remaining records */
+		engine_queue_clear(queue);
+
+		if (queue->closing == false && cres != -ECANCELED)
+		{
+			engine->callback(engine->context, skdp_engine_event_error, fd, NULL, 0U);
+		}
+	}
+
+	if (queue->open == true && queue->closing == true && queue->head == NULL)
+	{
+		engine_queue_close(engine, queue, fd);
+	}
+}
+
+static size_t engine_uring_dispatch(skdp_engine* engine)
+{
+	engine_queue* queue;
+	engine_ring* ring;
+	uint64_t data;
+	uint64_t op;
+	uint32_t flags;
+	uint32_t head;
+	uint32_t tail;
+	uint16_t bid;
+	int32_t cres;
+	int32_t fd;
+	size_t res;
+
+	res = 0U;
+	ring = (engine_ring*)engine->ring;
+	head = *ring->cqhead;
+	tail = __atomic_load_n(ring->cqtail, __ATOMIC_ACQUIRE);
+
+	while (head != tail)
+	{
+		/* copy the completion and release the slot before dispatching */
+		data = ring->cqes[head & ring->cqmask].user_data;
+		cres = ring->cqes[head & ring->cqmask].res;
+		flags = ring->cqes[head & ring->cqmask].flags;
+		++head;
+		__atomic_store_n(ring->cqhead, head, __ATOMIC_RELEASE);
+		op = data >> ENGINE_OP_SHIFT;
+
+		if (op == ENGINE_OP_ACCEPT)
+		{
+			if (cres >= 0)
+			{
+				queue = engine_queue_open(engine, cres);
+
+				if (queue != NULL && engine_uring_receive(engine, cres) == true)
+				{
+					engine->callback(engine->context, skdp_engine_event_accept, cres, NULL, 0U);
+					++res;
+				}
+				else
+				{
+					if (queue != NULL)
+					{
+						queue->open = false;
+					}
+
+					close(cres);
+				}
+			}
+
+			if ((flags & IORING_CQE_F_MORE) == 0U && cres != -ECANCELED && engine->lfd >= 0)
+			{
+				/* the multishot accept ended; re-arm only if the next attempt can succeed */
+				if (cres >= 0 || engine_accept_transient(-cres) == true)
+				{
+					engine_uring_accept(engine);
+				}
+				else
+				{
+					engine_accept_stop(engine, -cres);
+				}
+			}
+		}
+		else if (op == ENGINE_OP_RECEIVE)
+		{
+			fd = (int32_t)(uint32_t)(data & ENGINE_OP_MASK);
+			queue = engine_queue_get(engine, fd);
+
+			if (queue == NULL || queue->open == false || queue->closing == true)
+			{
+				/* the connection is being closed; return any buffer and drop the data */
+				if (cres > 0 && (flags & IORING_CQE_F_BUFFER) != 0U)
+				{
+					engine_ring_provide(ring, engine->buffers, (uint16_t)(flags >> IORING_CQE_BUFFER_SHIFT));
+				}
+			}
+			else if (cres > 0 && (flags & IORING_CQE_F_BUFFER) != 0U)
+			{
+				bid = (uint16_t)(flags >> IORING_CQE_BUFFER_SHIFT);
+				engine->callback(engine->context, skdp_engine_event_receive, fd, engine->buffers + ((size_t)bid * SKDP_ENGINE_BUFFER_SIZE), (size_t)cres);
+				engine_ring_provide(ring, engine->buffers, bid);
+				++res;
+
+				if ((flags & IORING_CQE_F_MORE) == 0U && queue->open == true && queue->closing == false)
+				{
+					engine_uring_receive(engine, fd);
+				}
+			}
+			else if (cres == -ENOBUFS)
+			{
+				/* the buffer ring ran dry; buffers are returned as callbacks complete */
+				engine_uring_receive(engine, fd);
+			}
+			else if (cres != -ECANCELED)
+			{
+				engine->callback(engine->context, skdp_engine_event_closed, fd, NULL, 0U);
+				++res;
+			}
+			else
+			{
+				/* the receive was canceled by a close */
+			}
+		}
+		else if (op == ENGINE_OP_SEND)
+		{
+			/* the completion carries the descriptor; the completed send is always the head of its connection queue */
+			fd = (int32_t)(uint32_t)(data & ENGINE_OP_MASK);
+			queue = engine_queue_get(engine, fd);
+
+			if (queue != NULL && queue->head != NULL)
+			{
+				engine_uring_sent(engine, queue, fd, cres);
+				++res;
+			}
+		}
+		else
+		{
+			/* cancel completions carry no event */
+		}
+	}
+
+	return res;
+}
+
+static bool engine_epoll_arm(skdp_engine* engine, const engine_queue* queue, int32_t fd)
+{
+	struct epoll_event ev;
+
+	/* a closing connection only waits to drain its queue */
+	qsc_memutils_clear(&ev, sizeof(ev));
+	ev.events = ((queue->closing == false) ? (EPOLLIN | EPOLLRDHUP) : 0U) | ((queue->head != NULL) ? EPOLLOUT : 0U);
+	ev.data.fd = fd;
+
+	return (epoll_ctl(engine->epfd, EPOLL_CTL_MOD, fd, &ev) == 0);
+}
+
+static bool engine_epoll_write(int32_t fd, const uint8_t* data, size_t length, size_t* offset)
+{
+	ssize_t slen;
+	bool res;
+	bool run;
+
+	res = true;
+	run = true;
+
+	/* write until the data is sent or the socket would block */
+	while (*offset < length && run == true)
+	{
+		slen = send(fd, data + *offset, length - *offset, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+		if (slen > 0)
+		{
+			*offset += (size_t)slen;
+		}
+		else if (slen < 0 && errno == EINTR)
+		{
+			/* interrupted, retry */
+		}
+		else if (slen < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			run = false;
+		}
+		else
+		{
+			res = false;
+			run = false;
+		}
+	}
+
+	return res;
+}
+
+static void engine_epoll_drain(skdp_engine* engine, engine_queue* queue, int32_t fd)
+{
+	bool res;
+	bool run;
+
+	res = true;
+	run = true;
+
+	while (queue->head != NULL && run == true)
+	{
+		res = engine_epoll_write(fd, queue->head->data, queue->head->length, &queue->head->offset);
+
+		if (res == true && queue->head->offset == queue->head->length)
+		{
+			engine_send_release(queue);
+		}
+		else
+		{
+			run = false;
+		}
+	}
+
+	if (res == false)
+	{
+		engine_queue_clear(queue);
+
+		if (queue->closing == false)
+		{
+			engine->callback(engine->context, skdp_engine_event_error, fd, NULL, 0U);
+		}
+	}
+
+	if (queue->open == true)
+	{
+		if (queue->closing == true && queue->head == NULL)
+		{
+			engine_queue_close(engine, queue, fd);
+		}
+		else
+		{
+			/* stop waiting for writability once the queue is empty */
+			engine_epoll_arm(engine, queue, fd);
+		}
+	}
+}
+
+static size_t engine_epoll_dispatch(skdp_engine* engine, int32_t timeout)
+{
+	struct epoll_event evs[SKDP_ENGINE_EVENTS_MAX];
+	struct epoll_event ev;
+	engine_queue* queue;
+	ssize_t rlen;
+	size_t res;
+	int32_t cfd;
+	int32_t fd;
+	int32_t i;
+	int32_t n;
+
+	res = 0U;
+	n = epoll_wait(engine->epfd, evs, (int32_t)SKDP_ENGINE_EVENTS_MAX, timeout);
+
+	for (i = 0; i < n; ++i)
+	{
+		fd = evs[i].data.fd;
+
+		if (fd == engine->lfd)
+		{
+			/* accepted sockets are non-blocking, a slow peer never stalls the loop */
+			cfd = accept4(engine->lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+			if (cfd >= 0)
+			{
+				qsc_memutils_clear(&ev, sizeof(ev));
+				ev.events = EPOLLIN | EPOLLRDHUP;
+				ev.data.fd = cfd;
+
+				queue = engine_queue_open(engine, cfd);
+
+				if (queue != NULL && epoll_ctl(engine->epfd, EPOLL_CTL_ADD, cfd, &ev) == 0)
+				{
+					engine->callback(engine->context, skdp_engine_event_accept, cfd, NULL, 0U);
+					++res;
+				}
+				else
+				{
+					if (queue != NULL)
+					{
+						queue->open = false;
+					}
+
+					close(cfd);
+				}
+			}
+			else if (engine_accept_transient(errno) == false)
+			{
+				/* a level-triggered listener that cannot accept is reported ready again at once */
+				epoll_ctl(engine->epfd, EPOLL_CTL_DEL, engine->lfd, NULL);
+				engine_accept_stop(engine, errno);
+			}
+			else
+			{
+				/* the connection was lost before it was accepted */
+			}
+		}
+		else
+		{
+			queue = engine_queue_get(engine, fd);
+
+			if (queue != NULL && queue->open == true && (evs[i].events & EPOLLOUT) != 0U)
+			{
+				engine_epoll_drain(engine, queue, fd);
+			}
+
+			/* the callback may have closed the connection */
+			queue = engine_queue_get(engine, fd);
+
+			if (queue != NULL && queue->open == true && queue->closing == false && (evs[i].events & (uint32_t)~EPOLLOUT) != 0U)
+			{
+				rlen = recv(fd, engine->buffers, SKDP_ENGINE_BUFFER_SIZE, MSG_DONTWAIT);
+
+				if (rlen > 0)
+				{
+					engine->callback(engine->context, skdp_engine_event_receive, fd, engine->buffers, (size_t)rlen);
+					++res;
+				}
+				else if (rlen == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+				{
+					/* the peer is gone, queued records are dropped and the close does not wait for them */
+					epoll_ctl(engine->epfd, EPOLL_CTL_DEL, fd, NULL);
+					engine_queue_clear(queue);
+					engine->callback(engine->context, skdp_engine_event_closed, fd, NULL, 0U);
+					++res;
+				}
+				else
+				{
+					/* spurious wakeup */
+				}
+			}
+		}
+	}
+
+	return res;
+}
+
+#endif
+
+bool skdp_engine_available(skdp_engine_backends backend)
+{
+	bool res;
+
+	res = false;
+
+#if defined(QSC_SYSTEM_OS_LINUX)
+	engine_ring* ring;
+
+	if (backend == skdp_engine_backend_epoll || backend == skdp_engine_backend_none)
+	{
+		res = true;
+	}
+	else if (backend == skdp_engine_backend_io_uring)
+	{
+		ring = engine_ring_create();
+
+		if (ring != NULL)
+		{
+			engine_ring_destroy(ring);
+			res = true;
+		}
+	}
+	else
+	{
+		/* unknown backend */
+	}
+#else
+	(void)backend;
+#endif
+
+	return res;
+}
+
+void skdp_engine_close(skdp_engine* engine, int32_t fd)
+{
+	SKDP_ASSERT(engine != NULL);
+
+#if defined(QSC_SYSTEM_OS_LINUX)
+	engine_queue* queue;
+	struct io_uring_sqe* sqe;
+
+	if (engine != NULL && fd >= 0)
+	{
+		queue = engine_queue_get(engine, fd);
+
+		if (queue != NULL && queue->open == true && queue->closing == false)
+		{
+			queue->closing = true;
+
+			if (engine->backend == skdp_engine_backend_io_uring)
+			{
+				sqe = engine_ring_sqe((engine_ring*)engine->ring);
+
+				if (sqe != NULL)
+				{
+					/* stop receiving; a send in flight completes and the queue drains before the close */
+					sqe->opcode = IORING_OP_ASYNC_CANCEL;
+					sqe->addr = ENGINE_OP_DATA(ENGINE_OP_RECEIVE, (uint32_t)fd);
+					sqe->cancel_flags = IORING_ASYNC_CANCEL_ALL;
+					sqe->user_data = ENGINE_OP_DATA(ENGINE_OP_CANCEL, (uint32_t)fd);
+					engine_ring_submit((engine_ring*)engine->ring, 0U, NULL);
+				}
+			}
+
+			if (queue->head == NULL)
+			{
+				engine_queue_close(engine, queue, fd);
+			}
+			else if (engine->backend == skdp_engine_backend_epoll)
+			{
+				engine_epoll_arm(engine, queue, fd);
+			}
+			else
+			{
+				/* the send completion closes the connection */
+			}
+		}
+	}
+#else
+	(void)engine;
+	(void)fd;
+#endif
+}
+
+void skdp_engine_dispose(skdp_engine* engine)
+{
+	SKDP_ASSERT(engine != NULL);
+
+	if (engine != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_LINUX)
+		size_t i;
+
+		if (engine->ring != NULL)
+		{
+			/* closing the ring cancels the outstanding operations */
+			engine_ring_destroy((engine_ring*)engine->ring);
+		}
+
+		if (engine->queues != NULL)
+		{
+			/* connections remain open, their unsent records are released */
+			for (i = 0U; i < engine->qcount; ++i)
+			{
+				engine_queue_clear(&((engine_queue*)engine->queues)[i]);
+			}
+
+			qsc_memutils_alloc_free(engine->queues);
+		}
+
+		if (engine->epfd >= 0)
+		{
+			close(engine->epfd);
+		}
+#endif
+
+		if (engine->buffers != NULL)
+		{
+			qsc_memutils_alloc_free(engine->buffers);
+		}
+
+		qsc_memutils_clear(engine, sizeof(skdp_engine));
+		engine->epfd = -1;
+		engine->lfd = -1;
+	}
+}
+
+bool skdp_engine_flush(skdp_engine* engine)
+{
+	SKDP_ASSERT(engine != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (engine != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_LINUX)
+		if (engine->backend == skdp_engine_backend_io_uring)
+		{
+			res = engine_ring_submit((engine_ring*)engine->ring, 0U, NULL);
+		}
+		else
+		{
+			res = (engine->backend == skdp_engine_backend_epoll);
+		}
+#endif
+	}
+
+	return res;
+}
+
+bool skdp_engine_initialize(skdp_engine* engine, skdp_engine_backends backend, skdp_engine_callback callback, void* context)
+{
+	SKDP_ASSERT(engine != NULL);
+	SKDP_ASSERT(callback != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (engine != NULL && callback != NULL)
+	{
+		qsc_memutils_clear(engine, sizeof(skdp_engine));
+		engine->callback = callback;
+		engine->context = context;
+		engine->epfd = -1;
+		engine->lfd = -1;
+		engine->backend = skdp_engine_backend_none;
+
+#if defined(QSC_SYSTEM_OS_LINUX)
+		uint16_t i;
+
+		if (backend != skdp_engine_backend_epoll)
+		{
+			engine->ring = engine_ring_create();
+
+			if (engine->ring != NULL)
+			{
+				engine->buffers = (uint8_t*)qsc_memutils_malloc(SKDP_ENGINE_BUFFER_COUNT * SKDP_ENGINE_BUFFER_SIZE);
+
+				if (engine->buffers != NULL)
+				{
+					for (i = 0U; i < SKDP_ENGINE_BUFFER_COUNT; ++i)
+					{
+						engine_ring_provide((engine_ring*)engine->ring, engine->buffers, i);
+					}
+
+					engine->backend = skdp_engine_backend_io_uring;
+					res = true;
+				}
+				else
+				{
+					engine_ring_destroy((engine_ring*)engine->ring);
+					engine->ring = NULL;
+				}
+			}
+		}
+
+		if (res == false)
+		{
+			/* the epoll fallback */
+			engine->epfd = epoll_create1(EPOLL_CLOEXEC);
+			engine->buffers = (uint8_t*)qsc_memutils_malloc(SKDP_ENGINE_BUFFER_SIZE);
+
+			if (engine->epfd >= 0 && engine->buffers != NULL)
+			{
+				engine->backend = skdp_engine_backend_epoll;
+				res = true;
+			}
+			else
+			{
+				skdp_engine_dispose(engine);
+			}
+		}
+#else
+		(void)backend;
+#endif
+	}
+
+	return res;
+}
+
+size_t skdp_engine_keep_alive_submit(void* context, const qsc_socket* const* socks, const uint8_t* arena, size_t count)
+{
+	SKDP_ASSERT(context != NULL);
+	SKDP_ASSERT(socks != NULL);
+	SKDP_ASSERT(arena != NULL);
+
+	skdp_engine* engine;
+	size_t i;
+	size_t res;
+
+	res = 0U;
+
+	if (context != NULL && socks != NULL && arena != NULL)
+	{
+		engine = (skdp_engine*)context;
+
+		for (i = 0U; i < count; ++i)
+		{
+			if (socks[i] != NULL)
+			{
+				if (skdp_engine_send(engine, (int32_t)socks[i]->connection, arena + (i * SKDP_KEEPALIVE_PACKET_SIZE), SKDP_KEEPALIVE_PACKET_SIZE) == true)
+				{
+					++res;
+				}
+			}
+		}
+
+		/* the batch is submitted with one call */
+		skdp_engine_flush(engine);
+	}
+
+	return res;
+}
+
+bool skdp_engine_listen(skdp_engine* engine, int32_t lfd)
+{
+	SKDP_ASSERT(engine != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (engine != NULL && lfd >= 0)
+	{
+#if defined(QSC_SYSTEM_OS_LINUX)
+		struct epoll_event ev;
+
+		engine->lfd = lfd;
+		engine->apause = false;
+
+		if (engine->backend == skdp_engine_backend_io_uring)
+		{
+			res = engine_uring_accept(engine);
+		}
+		else if (engine->backend == skdp_engine_backend_epoll)
+		{
+			qsc_memutils_clear(&ev, sizeof(ev));
+			ev.events = EPOLLIN;
+			ev.data.fd = lfd;
+			res = (epoll_ctl(engine->epfd, EPOLL_CTL_ADD, lfd, &ev) == 0);
+		}
+		else
+		{
+			/* not initialized */
+		}
+
+		if (res == false)
+		{
+			engine->lfd = -1;
+		}
+#endif
+	}
+
+	return res;
+}
+
+size_t skdp_engine_poll(skdp_engine* engine, int32_t timeout)
+{
+	SKDP_ASSERT(engine != NULL);
+
+	size_t res;
+
+	res = 0U;
+
+	if (engine != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_LINUX)
+		struct __kernel_timespec ts;
+
+		if (engine->backend == skdp_engine_backend_io_uring)
+		{
+			/* dispatch completions that are already available before waiting */
+			res = engine_uring_dispatch(engine);
+			ts.tv_sec = timeout / 1000;
+			ts.tv_nsec = (long long)(timeout % 1000) * 1000000LL;
+
+			if (res == 0U && timeout != 0)
+			{
+				engine_ring_submit((engine_ring*)engine->ring, 1U, (timeout > 0) ? &ts : NULL);
+			}
+			else
+			{
+				engine_ring_submit((engine_ring*)engine->ring, 0U, NULL);
+			}
+
+			res += engine_uring_dispatch(engine);
+		}
+		else if (engine->backend == skdp_engine_backend_epoll)
+		{
+			res = engine_epoll_dispatch(engine, timeout);
+		}
+		else
+		{
+			/* not initialized */
+		}
+#else
+		(void)timeout;
+#endif
+	}
+
+	return res;
+}
+
+bool skdp_engine_send(skdp_engine* engine, int32_t fd, const uint8_t* data, size_t length)
+{
+	SKDP_ASSERT(engine != NULL);
+	SKDP_ASSERT(data != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (engine != NULL && data != NULL && fd >= 0 && length != 0U)
+	{
+#if defined(QSC_SYSTEM_OS_LINUX)
+		engine_queue* queue;
+		engine_send* snd;
+		size_t pos;
+
+		queue = engine_queue_get(engine, fd);
+
+		if (queue != NULL && queue->open == true && queue->closing == false)
+		{
+			if (engine->backend == skdp_engine_backend_io_uring)
+			{
+				snd = engine_send_create(queue, fd, data, length);
+
+				if (snd != NULL)
+				{
+					/* records to the same connection are sent in order, one at a time */
+					if (queue->head != snd || engine_uring_send(engine, snd) == true)
+					{
+						res = true;
+					}
+					else
+					{
+						engine_send_release(queue);
+					}
+				}
+			}
+			else if (engine->backend == skdp_engine_backend_epoll)
+			{
+				pos = 0U;
+
+				/* write directly while nothing is queued, and queue what the socket does not accept */
+				if (queue->head == NULL)
+				{
+					res = engine_epoll_write(fd, data, length, &pos);
+				}
+				else
+				{
+					res = true;
+				}
+
+				if (res == true && pos < length)
+				{
+					snd = engine_send_create(queue, fd, data + pos, length - pos);
+					res = (snd != NULL && engine_epoll_arm(engine, queue, fd) == true);
+				}
+			}
+			else
+			{
+				/* not initialized */
+			}
+		}
+#endif
+	}
+
+	return res;
+}
@@ -0,0 +1,281 @@
+/* 2021-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SKDP_ENGINE_H
+#define SKDP_ENGINE_H
+
+#include "skdpcommon.h"
+#include "skdp.h"
+#include "socketbase.h"
+
+/**
+ * \file skdpengine.h
+ * \brief The SKDP server network engine.
+ *
+ * \details
+ * This header defines an event-driven network engine for SKDP servers on Linux. The engine replaces the blocking
+ * \c qsc_socket_receive loop and the thread-per-connection \c qsc_socket_receive_async model with a single
+ * completion loop that accepts connections, receives handshake packets and sealed records, and sends responses.
+ * Accepted sockets are non-blocking and no engine call waits on a peer. The application frames packets from the
+ * received bytes and drives the key exchange with \c skdp_server_handshake, then carries records with
+ * \c skdp_server_encrypt_packet and \c skdp_server_decrypt_packet; the blocking listeners are not used on
+ * engine connections.
+ *
+ * Two backends are available and selected at runtime:
+ * - io_uring: a multishot accept on the listening socket, a multishot receive on each connection drawing from a
+ * provided buffer ring, and a send queue per connection. One send per connection is in flight; the next is
+ * submitted when the previous one completes, so records to the same peer are sent in order and a short send is
+ * resumed where it stopped. Submissions are batched; one \c io_uring_enter call submits every queued operation and
+ * waits for completions, so there is no system call per operation. The ring is driven through raw system calls and
+ * has no library dependency.
+ * - epoll: a level-triggered readiness loop, used when io_uring is unavailable, disabled, or fails to initialize.
+ * A send writes what the socket accepts and queues the remainder, which is written when the socket is writable.
+ *
+ * Data passed to \c skdp_engine_send is copied, so the caller may reuse its buffer as soon as the call returns.
+ * The engine reports accepted connections, received data, completed sends, and closed connections through a single
+ * callback; the connection is closed by the application with \c skdp_engine_close, after its queued sends drain.
+ * The engine is driven by one thread. On platforms other than Linux, initialization fails and the application uses
+ * the blocking socket API.
+ */
+
+/*!
+ * \def SKDP_ENGINE_BUFFER_COUNT
+ * \brief The number of receive buffers in the provided buffer ring (a power of two).
+ */
+#define SKDP_ENGINE_BUFFER_COUNT 256U
+
+/*!
+ * \def SKDP_ENGINE_BUFFER_SIZE
+ * \brief The size in bytes of each receive buffer.
+ */
+#define SKDP_ENGINE_BUFFER_SIZE 4096U
+
+/*!
+ * \def SKDP_ENGINE_EVENTS_MAX
+ * \brief The maximum number of readiness events processed per epoll wait.
+ */
+#define SKDP_ENGINE_EVENTS_MAX 64U
+
+/*!
+ * \def SKDP_ENGINE_QUEUE_DEPTH
+ * \brief The io_uring submission queue depth.
+ */
+#define SKDP_ENGINE_QUEUE_DEPTH 256U
+
+/*!
+ * \enum skdp_engine_backends
+ * \brief The engine backend types.
+ */
+SKDP_EXPORT_API typedef enum skdp_engine_backends
+{
+	skdp_engine_backend_none = 0x00U,			/*!< No backend, select the best available */
+	skdp_engine_backend_epoll = 0x01U,			/*!< The epoll readiness backend */
+	skdp_engine_backend_io_uring = 0x02U,		/*!< The io_uring completion backend */
+} skdp_engine_backends;
+
+/*!
+ * \enum skdp_engine_events
+ * \brief The engine event types.
+ */
+SKDP_EXPORT_API typedef enum skdp_engine_events
+{
+	skdp_engine_event_accept = 0x01U,			/*!< A connection was accepted, the descriptor is the new connection */
+	skdp_engine_event_receive = 0x02U,			/*!< Data was received on a connection */
+	skdp_engine_event_sent = 0x03U,				/*!< A send completed, the length is the number of bytes sent */
+	skdp_engine_event_closed = 0x04U,			/*!< The peer closed the connection or a receive failed */
+	skdp_engine_event_error = 0x05U,			/*!< A send failed, or the listener failed and was dropped; the descriptor is the listener */
+} skdp_engine_events;
+
+/*!
+ * \brief The engine event callback.
+ *
+ * \details
+ * Received data is valid only for the duration of the callback. The callback may call \c skdp_engine_send and
+ * \c skdp_engine_close.
+ */
+typedef void (*skdp_engine_callback)(void* context, skdp_engine_events event, int32_t fd, const uint8_t* data, size_t length);
+
+/*!
+ * \struct skdp_engine
+ * \brief The SKDP network engine state.
+ */
+SKDP_EXPORT_API typedef struct skdp_engine
+{
+	skdp_engine_callback callback;				/*!< The event callback */
+	void* context;								/*!< The event callback context */
+	void* ring;									/*!< The io_uring state (internal) */
+	void* queues;								/*!< The per-connection send queues, indexed by descriptor (internal) */
+	size_t qcount;								/*!< The number of send queue slots (internal) */
+	uint8_t* buffers;							/*!< The receive buffer pool */
+	int32_t epfd;								/*!< The epoll descriptor */
+	int32_t lfd;								/*!< The listening socket descriptor */
+	bool apause;								/*!< The accept waits for a descriptor to be released (internal) */
+	skdp_engine_backends backend;				/*!< The active backend */
+} skdp_engine;
+
+/*!
+ * \brief Test whether a backend is supported by the running kernel.
+ *
+ * \param backend The backend type.
+ *
+ * \return Returns true if the backend can be initialized.
+ */
+SKDP_EXPORT_API bool skdp_engine_available(skdp_engine_backends backend);
+
+/*!
+ * \brief Close a connection.
+ *
+ * \details
+ * Receiving stops at once. The descriptor is closed after the records already queued for the connection have been
+ * sent, or immediately if none are queued; no further events are reported for it. A descriptor that was not
+ * accepted by the engine is ignored.
+ *
+ * \param engine A pointer to the engine state.
+ * \param fd The connection descriptor.
+ */
+SKDP_EXPORT_API void skdp_engine_close(skdp_engine* engine, int32_t fd);
+
+/*!
+ * \brief Dispose of the engine and release its resources.
+ *
+ * \details
+ * Connections remain open; the listening socket is not closed.
+ *
+ * \param engine A pointer to the engine state.
+ */
+SKDP_EXPORT_API void skdp_engine_dispose(skdp_engine* engine);
+
+/*!
+ * \brief Submit the queued operations without waiting for completions.
+ *
+ * \param engine A pointer to the engine state.
+ *
+ * \return Returns true if the queued operations were submitted.
+ */
+SKDP_EXPORT_API bool skdp_engine_flush(skdp_engine* engine);
+
+/*!
+ * \brief Initialize the engine.
+ *
+ * \details
+ * Requesting \c skdp_engine_backend_none selects io_uring when the kernel supports it. If the io_uring backend
+ * cannot be initialized, the engine falls back to epoll; the active backend is stored in the engine state.
+ *
+ * \param engine A pointer to the engine state.
+ * \param backend The preferred backend type.
+ * \param callback The event callback.
+ * \param context The optional event callback context.
+ *
+ * \return Returns true if a backend was initialized.
+ */
+SKDP_EXPORT_API bool skdp_engine_initialize(skdp_engine* engine, skdp_engine_backends backend, skdp_engine_callback callback, void* context);
+
+/*!
+ * \brief Keep-alive sweep submission callback for the engine.
+ *
+ * \details
+ * Queues every packet in a keep-alive sweep arena as a send, and submits the batch with a single call.
+ * Pass this function and the engine to \c skdp_server_keep_alive_sweep_initialize.
+ *
+ * \param context A pointer to the engine state.
+ * \param socks [const] The destination socket of each packet.
+ * \param arena [const] The keep-alive packet arena.
+ * \param count The number of packets in the arena.
+ *
+ * \return Returns the number of packets queued.
+ */
+SKDP_EXPORT_API size_t skdp_engine_keep_alive_submit(void* context, const qsc_socket* const* socks, const uint8_t* arena, size_t count);
+
+/*!
+ * \brief Accept connections on a listening socket.
+ *
+ * \details
+ * If an accept fails because the process or system is out of descriptors or memory, accepting pauses until the
+ * engine closes a connection, rather than retrying at once. On any other persistent failure the listener is dropped
+ * and reported with \c skdp_engine_event_error; the descriptor stays open and belongs to the application.
+ *
+ * \param engine A pointer to the engine state.
+ * \param lfd The bound and listening socket descriptor.
+ *
+ * \return Returns true if the listening socket was added to the engine.
+ */
+SKDP_EXPORT_API bool skdp_engine_listen(skdp_engine* engine, int32_t lfd);
+
+/*!
+ * \brief Submit queued operations, wait for events, and dispatch them to the callback.
+ *
+ * \param engine A pointer to the engine state.
+ * \param timeout The maximum wait in milliseconds, zero does not wait, a negative value waits indefinitely.
+ *
+ * \return Returns the number of events dispatched.
+ */
+SKDP_EXPORT_API size_t skdp_engine_poll(skdp_engine* engine, int32_t timeout);
+
+/*!
+ * \brief Queue data for sending on a connection.
+ *
+ * \details
+ * The data is appended to the connection's send queue, and records are sent in the order they were queued.
+ * With io_uring the send is submitted by the next flush or poll, and a send event is reported as each one completes.
+ * With epoll the data is written at once if nothing is queued, the remainder is written when the socket becomes
+ * writable, and no send event is reported. A failed queued send is reported as an error event, and the remaining
+ * queue is dropped.
+ *
+ * \param engine A pointer to the engine state.
+ * \param fd The connection descriptor.
+ * \param data [const] The data to send.
+ * \param length The number of bytes to send.
+ *
+ * \return Returns true if the send was queued or completed.
+ */
+SKDP_EXPORT_API bool skdp_engine_send(skdp_engine* engine, int32_t fd, const uint8_t* data, size_t length);
+
+#endif
@@ -0,0 +1,121 @@
+#if !defined(_POSIX_C_SOURCE)
+#	define _POSIX_C_SOURCE 200809L
+#endif
+#include "skdpfilemap.h"
+#include "memutils.h"
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+void skdp_filemap_close(skdp_filemap* map)
+{
+	SKDP_ASSERT(map != NULL);
+
+	if (map != NULL)
+	{
+		if (map->data != NULL)
+		{
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+			UnmapViewOfFile(map->data);
+
+			if (map->hmap != NULL)
+			{
+				CloseHandle((HANDLE)map->hmap);
+			}
+
+			if (map->hfile != NULL)
+			{
+				CloseHandle((HANDLE)map->hfile);
+			}
+#else
+			munmap((void*)map->data, map->length);
+#endif
+		}
+
+		qsc_memutils_clear(map, sizeof(skdp_filemap));
+	}
+}
+
+bool skdp_filemap_open(skdp_filemap* map, const char* fpath)
+{
+	SKDP_ASSERT(map != NULL);
+	SKDP_ASSERT(fpath != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (map != NULL && fpath != NULL)
+	{
+		qsc_memutils_clear(map, sizeof(skdp_filemap));
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+		HANDLE hfile;
+		HANDLE hmap;
+		LARGE_INTEGER flen;
+
+		hfile = CreateFileA(fpath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+		if (hfile != INVALID_HANDLE_VALUE)
+		{
+			if (GetFileSizeEx(hfile, &flen) == TRUE && flen.QuadPart > 0)
+			{
+				hmap = CreateFileMappingA(hfile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+				if (hmap != NULL)
+				{
+					map->data = (const uint8_t*)MapViewOfFile(hmap, FILE_MAP_READ, 0, 0, 0);
+
+					if (map->data != NULL)
+					{
+						map->length = (size_t)flen.QuadPart;
+						map->hfile = (void*)hfile;
+						map->hmap = (void*)hmap;
+						res = true;
+					}
+					else
+					{
+						CloseHandle(hmap);
+					}
+				}
+			}
+
+			if (res == false)
+			{
+				CloseHandle(hfile);
+			}
+		}
+#else
+		struct stat fst;
+		void* pmap;
+		int fd;
+
+		fd = open(fpath, O_RDONLY);
+
+		if (fd >= 0)
+		{
+			if (fstat(fd, &fst) == 0 && fst.st_size > 0)
+			{
+				pmap = mmap(NULL, (size_t)fst.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+				if (pmap != MAP_FAILED)
+				{
+					map->data = (const uint8_t*)pmap;
+					map->length = (size_t)fst.st_size;
+					res = true;
+				}
+			}
+
+			/* the mapping remains valid after the descriptor is closed */
+			close(fd);
+		}
+#endif
+	}
+
+	return res;
+}
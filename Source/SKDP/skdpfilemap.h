@@ -0,0 +1,96 @@
+/* 2021-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SKDP_FILEMAP_H
+#define SKDP_FILEMAP_H
+
+#include "skdpcommon.h"
+
+/**
+ * \file skdpfilemap.h
+ * \brief The SKDP read-only file mapping.
+ *
+ * \details
+ * This header defines a minimal platform abstraction used to map SKDP data files (key stores and revocation sets)
+ * read-only into the process address space. Mapping a file costs a constant number of system calls regardless of
+ * the file size; pages are loaded on demand by the operating system.
+ */
+
+/*!
+ * \struct skdp_filemap
+ * \brief The SKDP file mapping state.
+ */
+SKDP_EXPORT_API typedef struct skdp_filemap
+{
+	const uint8_t* data;						/*!< The mapped file contents */
+	size_t length;								/*!< The mapped length in bytes */
+	void* hfile;								/*!< The platform file handle (Windows only) */
+	void* hmap;									/*!< The platform mapping handle (Windows only) */
+} skdp_filemap;
+
+/*!
+ * \brief Unmap a file and clear the mapping state.
+ *
+ * \param map A pointer to the file mapping state.
+ */
+SKDP_EXPORT_API void skdp_filemap_close(skdp_filemap* map);
+
+/*!
+ * \brief Map a file read-only into memory.
+ *
+ * \param map A pointer to the file mapping state.
+ * \param fpath [const] The full path to the file.
+ *
+ * \return Returns true if the file was mapped; false if the file is missing, empty, or cannot be mapped.
+ */
+SKDP_EXPORT_API bool skdp_filemap_open(skdp_filemap* map, const char* fpath);
+
+#endif
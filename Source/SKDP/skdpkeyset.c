@@ -0,0 +1,146 @@
+#include "skdpkeyset.h"
+#include "async.h"
+#include "memutils.h"
+#include "timestamp.h"
+
+static void keyset_wait_readers(skdp_server_keyset* keyset, size_t slot)
+{
+	/* the grace period ends when every reader holding the slot has released it */
+	while (SKDP_ATOMIC_LOAD(&keyset->readers[slot]) != 0U)
+	{
+		qsc_async_thread_sleep(SKDP_KEYSET_GRACE_WAIT);
+	}
+}
+
+static void keyset_writer_lock(skdp_server_keyset* keyset)
+{
+	while (SKDP_ATOMIC_CAS(&keyset->wlock, 0U, 1U) == false)
+	{
+		qsc_async_thread_sleep(SKDP_KEYSET_GRACE_WAIT);
+	}
+}
+
+static void keyset_writer_unlock(skdp_server_keyset* keyset)
+{
+	SKDP_ATOMIC_STORE(&keyset->wlock, 0U);
+}
+
+bool skdp_keyset_acquire(skdp_server_keyset* keyset, skdp_server_key* skey)
+{
+	SKDP_ASSERT(keyset != NULL);
+	SKDP_ASSERT(skey != NULL);
+
+	size_t slot;
+	bool res;
+
+	res = false;
+
+	if (keyset != NULL && skey != NULL && SKDP_ATOMIC_LOAD(&keyset->generation) != 0U)
+	{
+		while (res == false)
+		{
+			slot = (size_t)SKDP_ATOMIC_LOAD(&keyset->active);
+			SKDP_ATOMIC_ADD(&keyset->readers[slot], 1U);
+
+			/* the slot is safe to read only if it is still the published slot after taking the reference */
+			if ((size_t)SKDP_ATOMIC_LOAD(&keyset->active) == slot)
+			{
+				qsc_memutils_copy(skey, &keyset->slots[slot], sizeof(skdp_server_key));
+				res = true;
+			}
+
+			SKDP_ATOMIC_SUB(&keyset->readers[slot], 1U);
+		}
+	}
+
+	return res;
+}
+
+void skdp_keyset_dispose(skdp_server_keyset* keyset)
+{
+	SKDP_ASSERT(keyset != NULL);
+
+	size_t i;
+
+	if (keyset != NULL)
+	{
+		keyset_writer_lock(keyset);
+		SKDP_ATOMIC_STORE(&keyset->generation, 0U);
+
+		for (i = 0U; i < SKDP_KEYSET_SLOTS; ++i)
+		{
+			keyset_wait_readers(keyset, i);
+			qsc_memutils_secure_erase(&keyset->slots[i], sizeof(skdp_server_key));
+		}
+
+		SKDP_ATOMIC_STORE(&keyset->active, 0U);
+		keyset_writer_unlock(keyset);
+	}
+}
+
+uint64_t skdp_keyset_generation(const skdp_server_keyset* keyset)
+{
+	SKDP_ASSERT(keyset != NULL);
+
+	uint64_t gen;
+
+	gen = 0U;
+
+	if (keyset != NULL)
+	{
+		gen = SKDP_ATOMIC_LOAD(&keyset->generation);
+	}
+
+	return gen;
+}
+
+void skdp_keyset_initialize(skdp_server_keyset* keyset, const skdp_server_key* skey)
+{
+	SKDP_ASSERT(keyset != NULL);
+	SKDP_ASSERT(skey != NULL);
+
+	if (keyset != NULL && skey != NULL)
+	{
+		qsc_memutils_clear(keyset, sizeof(skdp_server_keyset));
+		qsc_memutils_copy(&keyset->slots[0U], skey, sizeof(skdp_server_key));
+		SKDP_ATOMIC_STORE(&keyset->active, 0U);
+		SKDP_ATOMIC_STORE(&keyset->generation, 1U);
+	}
+}
+
+bool skdp_keyset_publish(skdp_server_keyset* keyset, const skdp_server_key* skey)
+{
+	SKDP_ASSERT(keyset != NULL);
+	SKDP_ASSERT(skey != NULL);
+
+	size_t next;
+	size_t prev;
+	bool res;
+
+	res = false;
+
+	if (keyset != NULL && skey != NULL && qsc_timestamp_epochtime_seconds() < skey->expiration)
+	{
+		keyset_writer_lock(keyset);
+
+		prev = (size_t)SKDP_ATOMIC_LOAD(&keyset->active);
+		next = (prev + 1U) % SKDP_KEYSET_SLOTS;
+
+		/* a slow reader may still hold the slot retired by the previous publish */
+		keyset_wait_readers(keyset, next);
+		qsc_memutils_copy(&keyset->slots[next], skey, sizeof(skdp_server_key));
+
+		/* publish the new key; new readers see only the new slot from this point */
+		SKDP_ATOMIC_STORE(&keyset->active, next);
+		SKDP_ATOMIC_ADD(&keyset->generation, 1U);
+
+		/* wait out the grace period and zeroize the retired key */
+		keyset_wait_readers(keyset, prev);
+		qsc_memutils_secure_erase(&keyset->slots[prev], sizeof(skdp_server_key));
+
+		keyset_writer_unlock(keyset);
+		res = true;
+	}
+
+	return res;
+}
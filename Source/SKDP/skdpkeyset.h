@@ -0,0 +1,158 @@
+/* 2021-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SKDP_KEYSET_H
+#define SKDP_KEYSET_H
+
+#include "skdpcommon.h"
+#include "skdp.h"
+
+/**
+ * \file skdpkeyset.h
+ * \brief The SKDP server key publisher.
+ *
+ * \details
+ * This header defines a published server key container used to replace the server derivation key of a running
+ * listener without restarting it. The keyset holds two key slots; one slot is published (active), the other is
+ * either empty or retired. Publishing writes the new key into the inactive slot and atomically swaps the active
+ * index, in the manner of a read-copy-update publish. Readers take a momentary reference on the active slot while
+ * copying the key into their handshake state, and the previous key is zeroized once every reader of its slot has
+ * drained (the grace period).
+ *
+ * Established sessions are not affected by a key swap; the server key is only used during the key exchange, and the
+ * session cipher states are derived from ephemeral tokens. New handshakes acquire the published key when the connect
+ * request is received, so a swap takes effect immediately.
+ *
+ * \note Publication is serialized internally; acquisition is lock-free.
+ */
+
+/*!
+ * \def SKDP_KEYSET_SLOTS
+ * \brief The number of key slots in a keyset.
+ */
+#define SKDP_KEYSET_SLOTS 2U
+
+/*!
+ * \def SKDP_KEYSET_GRACE_WAIT
+ * \brief The wait interval in milliseconds between reader drain checks during the grace period.
+ */
+#define SKDP_KEYSET_GRACE_WAIT 1U
+
+/*!
+ * \struct skdp_server_keyset
+ * \brief The SKDP published server key container.
+ *
+ * \details
+ * The \c active field holds the index of the published slot, \c generation is incremented on every publish, and
+ * \c readers counts the in-flight readers of each slot. The \c wlock field serializes publishers.
+ */
+SKDP_EXPORT_API typedef struct skdp_server_keyset
+{
+	skdp_server_key slots[SKDP_KEYSET_SLOTS];		/*!< The key slots */
+	volatile uint64_t readers[SKDP_KEYSET_SLOTS];	/*!< The slot reader reference counts */
+	volatile uint64_t active;						/*!< The index of the published slot */
+	volatile uint64_t generation;					/*!< The publication generation counter */
+	volatile uint64_t wlock;						/*!< The publisher lock */
+} skdp_server_keyset;
+
+/*!
+ * \brief Acquire a copy of the published server key.
+ *
+ * \details
+ * Copies the currently published key into the output structure. The function is lock-free and never blocks
+ * a publisher for longer than the copy itself.
+ *
+ * \param keyset A pointer to the keyset.
+ * \param skey The output server key structure.
+ *
+ * \return Returns true if a published key was copied; false if the keyset is empty or invalid.
+ */
+SKDP_EXPORT_API bool skdp_keyset_acquire(skdp_server_keyset* keyset, skdp_server_key* skey);
+
+/*!
+ * \brief Dispose of the keyset and zeroize all key slots.
+ *
+ * \param keyset A pointer to the keyset.
+ */
+SKDP_EXPORT_API void skdp_keyset_dispose(skdp_server_keyset* keyset);
+
+/*!
+ * \brief Return the current publication generation.
+ *
+ * \param keyset [const] A pointer to the keyset.
+ *
+ * \return Returns the generation counter, zero if no key has been published.
+ */
+SKDP_EXPORT_API uint64_t skdp_keyset_generation(const skdp_server_keyset* keyset);
+
+/*!
+ * \brief Initialize the keyset and publish the initial server key.
+ *
+ * \param keyset A pointer to the keyset.
+ * \param skey [const] A pointer to the initial server key.
+ */
+SKDP_EXPORT_API void skdp_keyset_initialize(skdp_server_keyset* keyset, const skdp_server_key* skey);
+
+/*!
+ * \brief Publish a new server key.
+ *
+ * \details
+ * The new key is written to the inactive slot and made visible with a single atomic store. The function then waits
+ * for readers of the previous slot to drain and zeroizes the retired key.
+ *
+ * \param keyset A pointer to the keyset.
+ * \param skey [const] A pointer to the new server key.
+ *
+ * \return Returns true if the key was published; false if the key has expired or the input is invalid.
+ */
+SKDP_EXPORT_API bool skdp_keyset_publish(skdp_server_keyset* keyset, const skdp_server_key* skey);
+
+#endif
@@ -0,0 +1,395 @@
+#include "skdpkeystore.h"
+#include "acp.h"
+#include "fileutils.h"
+#include "intutils.h"
+#include "memutils.h"
+#include "sha3.h"
+
+#define KEYSTORE_DISPLACE_MULTIPLIER 0x9E3779B97F4A7C15ULL
+#define KEYSTORE_DISPLACEMENT_SIZE 4U
+
+static uint64_t keystore_hash(const uint8_t* kid, uint64_t seed)
+{
+	uint64_t x;
+	size_t i;
+
+	x = seed;
+
+	/* fold the server identity, then finalize with a 64-bit avalanche mix */
+	for (i = 0U; i < SKDP_SID_SIZE; ++i)
+	{
+		x ^= (uint64_t)kid[i] << ((i % sizeof(uint64_t)) * 8U);
+
+		if ((i % sizeof(uint64_t)) == sizeof(uint64_t) - 1U)
+		{
+			x *= 0xFF51AFD7ED558CCDULL;
+		}
+	}
+
+	x ^= x >> 33U;
+	x *= 0xFF51AFD7ED558CCDULL;
+	x ^= x >> 33U;
+	x *= 0xC4CEB9FE1A85EC53ULL;
+	x ^= x >> 33U;
+
+	return x;
+}
+
+static uint32_t keystore_bucket(const uint8_t* kid, uint64_t seed, uint32_t buckets)
+{
+	return (uint32_t)(keystore_hash(kid, seed) % buckets);
+}
+
+static uint32_t keystore_slot(const uint8_t* kid, uint64_t seed, uint32_t disp, uint32_t count)
+{
+	return (uint32_t)(keystore_hash(kid, seed + (((uint64_t)disp + 1U) * KEYSTORE_DISPLACE_MULTIPLIER)) % count);
+}
+
+static size_t keystore_file_size(uint32_t buckets, uint32_t count)
+{
+	return SKDP_KEYSTORE_HEADER_SIZE + ((size_t)buckets * KEYSTORE_DISPLACEMENT_SIZE) + ((size_t)count * SKDP_SRVKEY_ENCODED_SIZE);
+}
+
+static bool keystore_has_duplicates(const skdp_server_key* keys, const uint32_t* bkey, const uint32_t* bstart, uint32_t buckets)
+{
+	uint32_t b;
+	uint32_t i;
+	uint32_t j;
+	bool res;
+
+	res = false;
+
+	/* keys with the same identity always share a bucket */
+	for (b = 0U; b < buckets && res == false; ++b)
+	{
+		for (i = bstart[b]; i < bstart[b + 1U] && res == false; ++i)
+		{
+			for (j = i + 1U; j < bstart[b + 1U]; ++j)
+			{
+				if (qsc_intutils_are_equal8(keys[bkey[i]].kid, keys[bkey[j]].kid, SKDP_SID_SIZE) == true)
+				{
+					res = true;
+					break;
+				}
+			}
+		}
+	}
+
+	return res;
+}
+
+static bool keystore_place_bucket(const skdp_server_key* keys, const uint32_t* bkey, uint32_t bsize, uint32_t count, uint64_t seed, uint8_t* used, uint32_t* pslot, uint32_t* slots, uint32_t* disp)
+{
+	uint32_t d;
+	uint32_t i;
+	uint32_t j;
+	bool res;
+
+	res = false;
+
+	/* search for a displacement that maps every key in the bucket to a distinct free slot */
+	for (d = 0U; d <= SKDP_KEYSTORE_MAX_DISPLACEMENT && res == false; ++d)
+	{
+		res = true;
+
+		for (i = 0U; i < bsize && res == true; ++i)
+		{
+			pslot[i] = keystore_slot(keys[bkey[i]].kid, seed, d, count);
+
+			if (used[pslot[i]] != 0U)
+			{
+				res = false;
+			}
+			else
+			{
+				for (j = 0U; j < i; ++j)
+				{
+					if (pslot[j] == pslot[i])
+					{
+						res = false;
+						break;
+					}
+				}
+			}
+		}
+
+		if (res == true)
+		{
+			for (i = 0U; i < bsize; ++i)
+			{
+				used[pslot[i]] = 1U;
+				slots[bkey[i]] = pslot[i];
+			}
+
+			*disp = d;
+		}
+	}
+
+	return res;
+}
+
+static bool keystore_place(const skdp_server_key* keys, uint32_t count, uint32_t buckets, uint64_t seed, uint8_t* disp, uint32_t* slots)
+{
+	uint32_t* bfill;
+	uint32_t* bkey;
+	uint32_t* bstart;
+	uint32_t* pslot;
+	uint8_t* used;
+	uint32_t b;
+	uint32_t bsize;
+	uint32_t d;
+	uint32_t i;
+	uint32_t maxb;
+	bool res;
+
+	res = false;
+	bfill = (uint32_t*)qsc_memutils_malloc((size_t)buckets * sizeof(uint32_t));
+	bkey = (uint32_t*)qsc_memutils_malloc((size_t)count * sizeof(uint32_t));
+	bstart = (uint32_t*)qsc_memutils_malloc(((size_t)buckets + 1U) * sizeof(uint32_t));
+	pslot = (uint32_t*)qsc_memutils_malloc((size_t)count * sizeof(uint32_t));
+	used = (uint8_t*)qsc_memutils_malloc((size_t)count);
+
+	if (bfill != NULL && bkey != NULL && bstart != NULL && pslot != NULL && used != NULL)
+	{
+		qsc_memutils_clear(bfill, (size_t)buckets * sizeof(uint32_t));
+		qsc_memutils_clear(bstart, ((size_t)buckets + 1U) * sizeof(uint32_t));
+		qsc_memutils_clear(used, (size_t)count);
+		qsc_memutils_clear(disp, (size_t)buckets * KEYSTORE_DISPLACEMENT_SIZE);
+		maxb = 0U;
+
+		/* group the key indices by bucket with a counting sort */
+		for (i = 0U; i < count; ++i)
+		{
+			bstart[keystore_bucket(keys[i].kid, seed, buckets) + 1U] += 1U;
+		}
+
+		for (b = 0U; b < buckets; ++b)
+		{
+			maxb = (bstart[b + 1U] > maxb) ? bstart[b + 1U] : maxb;
+			bstart[b + 1U] += bstart[b];
+		}
+
+		for (i = 0U; i < count; ++i)
+		{
+			b = keystore_bucket(keys[i].kid, seed, buckets);
+			bkey[bstart[b] + bfill[b]] = i;
+			bfill[b] += 1U;
+		}
+
+		if (keystore_has_duplicates(keys, bkey, bstart, buckets) == false)
+		{
+			res = true;
+
+			/* place the largest buckets first, while the table is still sparse */
+			for (bsize = maxb; bsize > 0U && res == true; --bsize)
+			{
+				for (b = 0U; b < buckets && res == true; ++b)
+				{
+					if (bstart[b + 1U] - bstart[b] == bsize)
+					{
+						d = 0U;
+						res = keystore_place_bucket(keys, bkey + bstart[b], bsize, count, seed, used, pslot, slots, &d);
+						qsc_intutils_le32to8(disp + ((size_t)b * KEYSTORE_DISPLACEMENT_SIZE), d);
+					}
+				}
+			}
+		}
+	}
+
+	qsc_memutils_alloc_free(used);
+	qsc_memutils_alloc_free(pslot);
+	qsc_memutils_alloc_free(bstart);
+	qsc_memutils_alloc_free(bkey);
+	qsc_memutils_alloc_free(bfill);
+
+	return res;
+}
+
+bool skdp_keystore_build(const char* fpath, const skdp_server_key* keys, size_t count)
+{
+	SKDP_ASSERT(fpath != NULL);
+	SKDP_ASSERT(keys != NULL);
+
+	uint8_t* pfile;
+	uint32_t* slots;
+	size_t flen;
+	size_t i;
+	size_t j;
+	uint64_t seed;
+	uint32_t buckets;
+	bool res;
+
+	res = false;
+
+	if (fpath != NULL && keys != NULL && count != 0U && count <= (size_t)UINT32_MAX)
+	{
+		buckets = (uint32_t)((count + SKDP_KEYSTORE_BUCKET_LOAD - 1U) / SKDP_KEYSTORE_BUCKET_LOAD);
+		flen = keystore_file_size(buckets, (uint32_t)count);
+		pfile = (uint8_t*)qsc_memutils_malloc(flen);
+		slots = (uint32_t*)qsc_memutils_malloc(count * sizeof(uint32_t));
+
+		if (pfile != NULL && slots != NULL)
+		{
+			qsc_memutils_clear(pfile, flen);
+
+			for (i = 0U; i < SKDP_KEYSTORE_MAX_SEEDS && res == false; ++i)
+			{
+				uint8_t rnd[sizeof(uint64_t)] = { 0U };
+
+				if (qsc_acp_generate(rnd, sizeof(rnd)) == true)
+				{
+					seed = qsc_intutils_le8to64(rnd);
+					res = keystore_place(keys, (uint32_t)count, buckets, seed, pfile + SKDP_KEYSTORE_HEADER_SIZE, slots);
+				}
+				else
+				{
+					break;
+				}
+			}
+
+			if (res == true)
+			{
+				uint8_t* precs;
+
+				/* write the records in slot order */
+				precs = pfile + SKDP_KEYSTORE_HEADER_SIZE + ((size_t)buckets * KEYSTORE_DISPLACEMENT_SIZE);
+
+				for (j = 0U; j < count; ++j)
+				{
+					skdp_serialize_server_key(precs + ((size_t)slots[j] * SKDP_SRVKEY_ENCODED_SIZE), &keys[j]);
+				}
+
+				/* assemble the header */
+				qsc_memutils_copy(pfile, SKDP_KEYSTORE_MAGIC, sizeof(SKDP_KEYSTORE_MAGIC));
+				qsc_intutils_le32to8(pfile + 8U, SKDP_KEYSTORE_VERSION);
+				qsc_intutils_le32to8(pfile + 12U, SKDP_SRVKEY_ENCODED_SIZE);
+				qsc_intutils_le32to8(pfile + 16U, (uint32_t)count);
+				qsc_intutils_le32to8(pfile + 20U, buckets);
+				qsc_intutils_le64to8(pfile + 24U, seed);
+				qsc_sha3_compute256(pfile + 32U, pfile + SKDP_KEYSTORE_HEADER_SIZE, flen - SKDP_KEYSTORE_HEADER_SIZE);
+
+				res = qsc_fileutils_copy_stream_to_file(fpath, (const char*)pfile, flen);
+			}
+		}
+
+		if (pfile != NULL)
+		{
+			qsc_memutils_secure_erase(pfile, flen);
+			qsc_memutils_alloc_free(pfile);
+		}
+
+		if (slots != NULL)
+		{
+			qsc_memutils_alloc_free(slots);
+		}
+	}
+
+	return res;
+}
+
+void skdp_keystore_close(skdp_keystore* store)
+{
+	SKDP_ASSERT(store != NULL);
+
+	if (store != NULL)
+	{
+		skdp_filemap_close(&store->map);
+		qsc_memutils_clear(store, sizeof(skdp_keystore));
+	}
+}
+
+bool skdp_keystore_find(const skdp_keystore* store, const uint8_t kid[SKDP_KID_SIZE], skdp_server_key* skey)
+{
+	SKDP_ASSERT(store != NULL);
+	SKDP_ASSERT(kid != NULL);
+	SKDP_ASSERT(skey != NULL);
+
+	const uint8_t* prec;
+	uint32_t b;
+	uint32_t d;
+	uint32_t slot;
+	bool res;
+
+	res = false;
+
+	if (store != NULL && kid != NULL && skey != NULL && store->records != NULL)
+	{
+		/* bucket, displacement, slot; then confirm the stored identity */
+		b = keystore_bucket(kid, store->seed, store->buckets);
+		d = qsc_intutils_le8to32(store->disp + ((size_t)b * KEYSTORE_DISPLACEMENT_SIZE));
+		slot = keystore_slot(kid, store->seed, d, store->count);
+		prec = store->records + ((size_t)slot * SKDP_SRVKEY_ENCODED_SIZE);
+
+		if (qsc_intutils_are_equal8(prec, kid, SKDP_SID_SIZE) == true)
+		{
+			skdp_deserialize_server_key(skey, prec);
+			res = true;
+		}
+	}
+
+	return res;
+}
+
+bool skdp_keystore_open(skdp_keystore* store, const char* fpath)
+{
+	SKDP_ASSERT(store != NULL);
+	SKDP_ASSERT(fpath != NULL);
+
+	const uint8_t* phdr;
+	bool res;
+
+	res = false;
+
+	if (store != NULL && fpath != NULL)
+	{
+		qsc_memutils_clear(store, sizeof(skdp_keystore));
+
+		if (skdp_filemap_open(&store->map, fpath) == true && store->map.length >= SKDP_KEYSTORE_HEADER_SIZE)
+		{
+			phdr = store->map.data;
+
+			if (qsc_intutils_are_equal8(phdr, (const uint8_t*)SKDP_KEYSTORE_MAGIC, sizeof(SKDP_KEYSTORE_MAGIC)) == true &&
+				qsc_intutils_le8to32(phdr + 8U) == SKDP_KEYSTORE_VERSION &&
+				qsc_intutils_le8to32(phdr + 12U) == SKDP_SRVKEY_ENCODED_SIZE)
+			{
+				store->count = qsc_intutils_le8to32(phdr + 16U);
+				store->buckets = qsc_intutils_le8to32(phdr + 20U);
+				store->seed = qsc_intutils_le8to64(phdr + 24U);
+
+				/* the file geometry must match the header exactly */
+				if (store->count != 0U && store->buckets != 0U &&
+					store->map.length == keystore_file_size(store->buckets, store->count))
+				{
+					store->disp = phdr + SKDP_KEYSTORE_HEADER_SIZE;
+					store->records = store->disp + ((size_t)store->buckets * KEYSTORE_DISPLACEMENT_SIZE);
+					res = true;
+				}
+			}
+		}
+
+		if (res == false)
+		{
+			skdp_keystore_close(store);
+		}
+	}
+
+	return res;
+}
+
+bool skdp_keystore_verify(const skdp_keystore* store)
+{
+	SKDP_ASSERT(store != NULL);
+
+	uint8_t hash[SKDP_KEYSTORE_CHECKSUM_SIZE] = { 0U };
+	bool res;
+
+	res = false;
+
+	if (store != NULL && store->map.data != NULL)
+	{
+		qsc_sha3_compute256(hash, store->map.data + SKDP_KEYSTORE_HEADER_SIZE, store->map.length - SKDP_KEYSTORE_HEADER_SIZE);
+		res = (qsc_intutils_verify(hash, store->map.data + 32U, SKDP_KEYSTORE_CHECKSUM_SIZE) == 0);
+	}
+
+	return res;
+}
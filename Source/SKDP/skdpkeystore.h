@@ -0,0 +1,190 @@
+/* 2021-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SKDP_KEYSTORE_H
+#define SKDP_KEYSTORE_H
+
+#include "skdpcommon.h"
+#include "skdp.h"
+#include "skdpfilemap.h"
+
+/**
+ * \file skdpkeystore.h
+ * \brief The SKDP server key store.
+ *
+ * \details
+ * This header defines a versioned, checksummed binary store holding many server keys in a single file.
+ * The store is mapped read-only at startup, so opening it costs the same regardless of the number of keys,
+ * and a key is located with a minimal perfect hash over the server identity (the leading \c SKDP_SID_SIZE
+ * bytes of the key identity), so lookup takes constant time.
+ *
+ * The perfect hash is built with the hash-and-displace method: keys are hashed into buckets, and each bucket
+ * stores the displacement value that maps all of its keys to distinct free slots. A lookup computes the bucket,
+ * reads its displacement, and computes the slot, then compares the stored identity to reject unknown keys.
+ *
+ * File layout (little-endian):
+ * - magic (8 bytes), version (4), record size (4), key count (4), bucket count (4), hash seed (8), checksum (32)
+ * - the displacement table, one 32-bit value per bucket
+ * - the key records, each an encoded server key of \c SKDP_SRVKEY_ENCODED_SIZE bytes, in slot order
+ *
+ * The checksum is a SHA3-256 hash of the displacement table and the records. \c skdp_keystore_open validates the
+ * header and file geometry only; \c skdp_keystore_verify checks the full checksum and can be run when time permits.
+ */
+
+/*!
+ * \def SKDP_KEYSTORE_BUCKET_LOAD
+ * \brief The average number of keys per hash bucket.
+ */
+#define SKDP_KEYSTORE_BUCKET_LOAD 2U
+
+/*!
+ * \def SKDP_KEYSTORE_CHECKSUM_SIZE
+ * \brief The key store checksum size in bytes.
+ */
+#define SKDP_KEYSTORE_CHECKSUM_SIZE 32U
+
+/*!
+ * \def SKDP_KEYSTORE_HEADER_SIZE
+ * \brief The key store file header size in bytes.
+ */
+#define SKDP_KEYSTORE_HEADER_SIZE 64U
+
+/*!
+ * \def SKDP_KEYSTORE_MAX_DISPLACEMENT
+ * \brief The maximum displacement value tried for a bucket before the build is re-seeded.
+ */
+#define SKDP_KEYSTORE_MAX_DISPLACEMENT 0x00FFFFFFUL
+
+/*!
+ * \def SKDP_KEYSTORE_MAX_SEEDS
+ * \brief The number of hash seeds tried before a build fails.
+ */
+#define SKDP_KEYSTORE_MAX_SEEDS 16U
+
+/*!
+ * \def SKDP_KEYSTORE_VERSION
+ * \brief The key store format version.
+ */
+#define SKDP_KEYSTORE_VERSION 1U
+
+/*!
+ * \brief The key store file magic value.
+ */
+static const char SKDP_KEYSTORE_MAGIC[8U] = { 'S', 'K', 'D', 'P', 'K', 'S', 'T', 'R' };
+
+/*!
+ * \struct skdp_keystore
+ * \brief The SKDP mapped key store state.
+ */
+SKDP_EXPORT_API typedef struct skdp_keystore
+{
+	skdp_filemap map;							/*!< The read-only file mapping */
+	const uint8_t* disp;						/*!< The displacement table */
+	const uint8_t* records;						/*!< The encoded key records */
+	uint64_t seed;								/*!< The perfect hash seed */
+	uint32_t buckets;							/*!< The number of hash buckets */
+	uint32_t count;								/*!< The number of keys */
+} skdp_keystore;
+
+/*!
+ * \brief Build a key store file from an array of server keys.
+ *
+ * \param fpath [const] The full path of the store file to write.
+ * \param keys [const] The array of server keys.
+ * \param count The number of keys in the array.
+ *
+ * \return Returns true if the store was written; false if the input contains duplicate server identities,
+ * the perfect hash could not be built, or the file could not be written.
+ */
+SKDP_EXPORT_API bool skdp_keystore_build(const char* fpath, const skdp_server_key* keys, size_t count);
+
+/*!
+ * \brief Close the key store and unmap the file.
+ *
+ * \param store A pointer to the key store state.
+ */
+SKDP_EXPORT_API void skdp_keystore_close(skdp_keystore* store);
+
+/*!
+ * \brief Find a server key by key identity.
+ *
+ * \details
+ * The lookup uses the leading \c SKDP_SID_SIZE bytes of the key identity, so a device key identity can be used
+ * directly to find the server key it was derived from.
+ *
+ * \param store [const] A pointer to the key store state.
+ * \param kid [const] The key identity.
+ * \param skey The output server key.
+ *
+ * \return Returns true if a matching key was found.
+ */
+SKDP_EXPORT_API bool skdp_keystore_find(const skdp_keystore* store, const uint8_t kid[SKDP_KID_SIZE], skdp_server_key* skey);
+
+/*!
+ * \brief Map a key store file and validate its header.
+ *
+ * \param store A pointer to the key store state.
+ * \param fpath [const] The full path to the store file.
+ *
+ * \return Returns true if the store was mapped and its header and geometry are valid.
+ */
+SKDP_EXPORT_API bool skdp_keystore_open(skdp_keystore* store, const char* fpath);
+
+/*!
+ * \brief Verify the key store checksum.
+ *
+ * \param store [const] A pointer to the key store state.
+ *
+ * \return Returns true if the checksum matches the store contents.
+ */
+SKDP_EXPORT_API bool skdp_keystore_verify(const skdp_keystore* store);
+
+#endif
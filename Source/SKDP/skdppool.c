@@ -0,0 +1,551 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#	define _GNU_SOURCE
+#endif
+#include "skdppool.h"
+#include "intutils.h"
+#include "memutils.h"
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+#	include <winsock2.h>
+#	include <windows.h>
+#else
+#	include <poll.h>
+#	include <time.h>
+#endif
+
+static void pool_close(skdp_pool_session* session, skdp_errors error)
+{
+	/* close the connection and dispose of the session keys */
+	skdp_client_connection_close(&session->ctx, &session->sock, error);
+	qsc_memutils_clear(&session->sock, sizeof(qsc_socket));
+}
+
+static void pool_suspend(skdp_pool_session* session)
+{
+	/* drop the connection but keep the session keys, so the session can be reattached */
+	if (qsc_socket_is_connected(&session->sock) == true)
+	{
+		qsc_socket_close_socket(&session->sock);
+	}
+
+	qsc_memutils_clear(&session->sock, sizeof(qsc_socket));
+}
+
+static bool pool_endpoint_equals(const skdp_pool_endpoint* a, const skdp_pool_endpoint* b)
+{
+	bool res;
+
+	res = (a->family == b->family && a->port == b->port);
+
+	if (res == true)
+	{
+		if (a->family == qsc_socket_address_family_ipv6)
+		{
+			res = qsc_intutils_are_equal8(a->ipv6.ipv6, b->ipv6.ipv6, sizeof(a->ipv6.ipv6));
+		}
+		else
+		{
+			res = qsc_intutils_are_equal8(a->ipv4.ipv4, b->ipv4.ipv4, sizeof(a->ipv4.ipv4));
+		}
+	}
+
+	return res;
+}
+
+static uint64_t pool_clock(void)
+{
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	return (uint64_t)GetTickCount64();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000U) + ((uint64_t)ts.tv_nsec / 1000000U);
+#endif
+}
+
+static bool pool_readable(const qsc_socket* sock, uint32_t timeout)
+{
+	struct pollfd pfd;
+	int32_t ret;
+
+	pfd.fd = sock->connection;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	ret = (int32_t)WSAPoll(&pfd, 1U, (INT)timeout);
+#else
+	ret = (int32_t)poll(&pfd, 1U, (int)timeout);
+#endif
+
+	return (ret > 0 && (pfd.revents & (POLLIN | POLLHUP | POLLERR)) != 0);
+}
+
+static bool pool_receive(const qsc_socket* sock, uint8_t* output, size_t length, uint64_t deadline)
+{
+	size_t pos;
+	size_t rlen;
+	uint64_t ltime;
+	bool run;
+
+	pos = 0U;
+	run = true;
+
+	/* read what has arrived as it arrives, and give up on the record at the deadline */
+	while (pos < length && run == true)
+	{
+		ltime = pool_clock();
+
+		if (ltime < deadline && pool_readable(sock, (uint32_t)(deadline - ltime)) == true)
+		{
+			rlen = qsc_socket_receive(sock, output + pos, length - pos, qsc_socket_receive_flag_none);
+
+			if (rlen != 0U && rlen <= length - pos)
+			{
+				pos += rlen;
+			}
+			else
+			{
+				/* closed by the peer, or a socket error */
+				run = false;
+			}
+		}
+		else
+		{
+			run = false;
+		}
+	}
+
+	return (pos == length);
+}
+
+static skdp_errors pool_connect(skdp_pool* pool, skdp_pool_session* session)
+{
+	skdp_errors err;
+
+	err = skdp_error_connection_failure;
+
+	/* a session that still holds its keys is reattached without a key exchange */
+	if (session->ctx.exflag == skdp_flag_session_established && session->expiration > skdp_clock_now())
+	{
+		if (session->endpoint.family == qsc_socket_address_family_ipv6)
+		{
+			err = skdp_client_reattach_ipv6(&session->ctx, &session->sock, &session->endpoint.ipv6, session->endpoint.port);
+		}
+		else
+		{
+			err = skdp_client_reattach_ipv4(&session->ctx, &session->sock, &session->endpoint.ipv4, session->endpoint.port);
+		}
+	}
+
+	if (err != skdp_error_none)
+	{
+		pool_close(session, skdp_error_none);
+		skdp_client_initialize(&session->ctx, &pool->dkey);
+		/* the exchange clears the key expiration from the client state, the session keeps its own copy */
+		session->expiration = pool->dkey.expiration;
+
+		if (session->endpoint.family == qsc_socket_address_family_ipv6)
+		{
+			err = skdp_client_connect_ipv6(&session->ctx, &session->sock, &session->endpoint.ipv6, session->endpoint.port);
+		}
+		else
+		{
+			err = skdp_client_connect_ipv4(&session->ctx, &session->sock, &session->endpoint.ipv4, session->endpoint.port);
+		}
+
+		if (err != skdp_error_none)
+		{
+			pool_close(session, err);
+		}
+	}
+
+	return err;
+}
+
+static skdp_pool_states pool_service(skdp_pool_session* session)
+{
+	uint8_t hdr[SKDP_HEADER_SIZE] = { 0U };
+	uint8_t* msg;
+	uint8_t* pmsg;
+	skdp_network_packet ack = { 0 };
+	skdp_network_packet pkt = { 0 };
+	uint64_t deadline;
+	size_t mlen;
+	size_t plen;
+	skdp_pool_states state;
+
+	state = skdp_pool_state_idle;
+
+	if (session->expiration <= skdp_clock_now())
+	{
+		/* re-key an expired session with a new key exchange */
+		pool_close(session, skdp_error_none);
+		state = skdp_pool_state_failed;
+	}
+	else if (pool_readable(&session->sock, 0U) == true)
+	{
+		msg = (uint8_t*)qsc_memutils_malloc(SKDP_HEADER_SIZE + SKDP_MESSAGE_MAX);
+		pmsg = (uint8_t*)qsc_memutils_malloc(SKDP_MESSAGE_MAX);
+
+		if (msg != NULL && pmsg != NULL)
+		{
+			while (state == skdp_pool_state_idle && pool_readable(&session->sock, 0U) == true)
+			{
+				state = skdp_pool_state_failed;
+				deadline = pool_clock() + SKDP_POOL_RECEIVE_TIMEOUT;
+
+				if (pool_receive(&session->sock, hdr, sizeof(hdr), deadline) == true)
+				{
+					if (skdp_packet_header_deserialize(hdr, sizeof(hdr), &pkt) == true && pkt.msglen <= SKDP_MESSAGE_MAX)
+					{
+						qsc_memutils_copy(msg, hdr, sizeof(hdr));
+						pkt.pmessage = msg + SKDP_HEADER_SIZE;
+
+						if (pool_receive(&session->sock, pkt.pmessage, pkt.msglen, deadline) == true)
+						{
+							if (pkt.flag == skdp_flag_keepalive_request)
+							{
+								/* echo the keep-alive so the server does not time the session out */
+								plen = SKDP_HEADER_SIZE + pkt.msglen;
+
+								if (qsc_socket_send(&session->sock, msg, plen, qsc_socket_send_flag_none) == plen)
+								{
+									state = skdp_pool_state_idle;
+								}
+							}
+							else if (pkt.flag == skdp_flag_encrypted_message || pkt.flag == skdp_flag_key_update)
+							{
+								/* an unsolicited record is discarded, decrypting keeps the channel in step */
+								if (skdp_client_decrypt_packet(&session->ctx, &pkt, pmsg, SKDP_MESSAGE_MAX, &mlen) == skdp_error_none)
+								{
+									state = skdp_pool_state_idle;
+								}
+							}
+							else if (pkt.flag == skdp_flag_hibernate)
+							{
+								/* acknowledge the request; the session stays connected and idle, and the server
+								   wakes it when the next record arrives */
+								if (skdp_client_decrypt_packet(&session->ctx, &pkt, pmsg, SKDP_MESSAGE_MAX, &mlen) == skdp_error_none)
+								{
+									ack.pmessage = pmsg;
+
+									if (skdp_client_hibernate_ack(&session->ctx, &ack) == skdp_error_none)
+									{
+										plen = skdp_packet_to_stream(&ack, msg);
+
+										if (qsc_socket_send(&session->sock, msg, plen, qsc_socket_send_flag_none) == plen)
+										{
+											state = skdp_pool_state_idle;
+										}
+									}
+								}
+							}
+							else
+							{
+								/* terminate, error, or an unexpected packet */
+							}
+						}
+					}
+				}
+				else
+				{
+					/* the connection was lost or stalled; the session keys remain valid for a reattach */
+					pool_suspend(session);
+				}
+
+				if (state == skdp_pool_state_failed && qsc_socket_is_connected(&session->sock) == true)
+				{
+					pool_close(session, skdp_error_connection_failure);
+				}
+			}
+
+			qsc_memutils_clear(pmsg, SKDP_MESSAGE_MAX);
+		}
+
+		if (msg != NULL)
+		{
+			qsc_memutils_alloc_free(msg);
+		}
+
+		if (pmsg != NULL)
+		{
+			qsc_memutils_alloc_free(pmsg);
+		}
+	}
+	else
+	{
+		/* the session is idle with nothing pending */
+	}
+
+	return state;
+}
+
+static void pool_maintain(skdp_pool* pool)
+{
+	skdp_pool_session* ps;
+	size_t i;
+	skdp_pool_states state;
+	bool connect;
+	bool service;
+
+	for (i = 0U; i < pool->count && pool->run == true; ++i)
+	{
+		ps = &pool->sessions[i];
+		connect = false;
+		service = false;
+
+		qsc_async_mutex_lock(pool->mtx);
+
+		if (ps->state == skdp_pool_state_failed && skdp_clock_now() >= ps->attempt + SKDP_POOL_RETRY_INTERVAL)
+		{
+			ps->state = skdp_pool_state_connecting;
+			ps->attempt = skdp_clock_now();
+			connect = true;
+		}
+		else if (ps->state == skdp_pool_state_idle)
+		{
+			ps->state = skdp_pool_state_servicing;
+			service = true;
+		}
+		else
+		{
+			/* busy sessions belong to the caller */
+		}
+
+		qsc_async_mutex_unlock(pool->mtx);
+
+		/* the session is claimed, the network work is done outside the lock */
+		state = skdp_pool_state_failed;
+
+		if (connect == true)
+		{
+			if (pool_connect(pool, ps) == skdp_error_none)
+			{
+				state = skdp_pool_state_idle;
+			}
+		}
+		else if (service == true)
+		{
+			state = pool_service(ps);
+		}
+		else
+		{
+			/* nothing to do */
+		}
+
+		if (connect == true || service == true)
+		{
+			qsc_async_mutex_lock(pool->mtx);
+			ps->state = state;
+			qsc_async_mutex_unlock(pool->mtx);
+		}
+	}
+}
+
+static void pool_worker(void* state)
+{
+	skdp_pool* pool;
+
+	pool = (skdp_pool*)state;
+
+	while (pool->run == true)
+	{
+		pool_maintain(pool);
+		qsc_async_thread_sleep(pool->interval);
+	}
+}
+
+bool skdp_pool_add(skdp_pool* pool, const skdp_pool_endpoint* endpoint, size_t count)
+{
+	SKDP_ASSERT(pool != NULL);
+	SKDP_ASSERT(endpoint != NULL);
+
+	skdp_pool_session* ps;
+	size_t i;
+	bool res;
+
+	res = false;
+
+	if (pool != NULL && endpoint != NULL && pool->sessions != NULL)
+	{
+		qsc_async_mutex_lock(pool->mtx);
+
+		if (count <= pool->capacity - pool->count)
+		{
+			for (i = 0U; i < count; ++i)
+			{
+				ps = &pool->sessions[pool->count + i];
+				qsc_memutils_clear(ps, sizeof(skdp_pool_session));
+				qsc_memutils_copy(&ps->endpoint, endpoint, sizeof(skdp_pool_endpoint));
+				ps->state = skdp_pool_state_failed;
+			}
+
+			/* the new sessions are published last, the maintenance thread establishes them */
+			pool->count += count;
+			res = true;
+		}
+
+		qsc_async_mutex_unlock(pool->mtx);
+	}
+
+	return res;
+}
+
+skdp_pool_session* skdp_pool_checkout(skdp_pool* pool, const skdp_pool_endpoint* endpoint)
+{
+	SKDP_ASSERT(pool != NULL);
+	SKDP_ASSERT(endpoint != NULL);
+
+	skdp_pool_session* ps;
+	size_t i;
+
+	ps = NULL;
+
+	if (pool != NULL && endpoint != NULL && pool->sessions != NULL)
+	{
+		qsc_async_mutex_lock(pool->mtx);
+
+		for (i = 0U; i < pool->count && ps == NULL; ++i)
+		{
+			if (pool->sessions[i].state == skdp_pool_state_idle &&
+				pool_endpoint_equals(&pool->sessions[i].endpoint, endpoint) == true)
+			{
+				ps = &pool->sessions[i];
+				ps->state = skdp_pool_state_busy;
+			}
+		}
+
+		qsc_async_mutex_unlock(pool->mtx);
+	}
+
+	return ps;
+}
+
+void skdp_pool_checkin(skdp_pool* pool, skdp_pool_session* session, skdp_errors error)
+{
+	SKDP_ASSERT(pool != NULL);
+	SKDP_ASSERT(session != NULL);
+
+	if (pool != NULL && session != NULL && session->state == skdp_pool_state_busy)
+	{
+		if (error != skdp_error_none)
+		{
+			/* the caller owns the session until it is published, close it before the state changes */
+			pool_close(session, error);
+		}
+
+		qsc_async_mutex_lock(pool->mtx);
+
+		if (error == skdp_error_none)
+		{
+			session->state = skdp_pool_state_idle;
+		}
+		else
+		{
+			/* retry on the next maintenance pass */
+			session->attempt = 0U;
+			session->state = skdp_pool_state_failed;
+		}
+
+		qsc_async_mutex_unlock(pool->mtx);
+	}
+}
+
+void skdp_pool_dispose(skdp_pool* pool)
+{
+	SKDP_ASSERT(pool != NULL);
+
+	size_t i;
+
+	if (pool != NULL)
+	{
+		if (pool->run == true)
+		{
+			pool->run = false;
+			qsc_async_thread_wait(pool->worker);
+		}
+
+		if (pool->sessions != NULL)
+		{
+			for (i = 0U; i < pool->count; ++i)
+			{
+				pool_close(&pool->sessions[i], skdp_error_none);
+			}
+
+			qsc_memutils_clear(pool->sessions, pool->capacity * sizeof(skdp_pool_session));
+			qsc_memutils_alloc_free(pool->sessions);
+		}
+
+		if (pool->mtx != NULL)
+		{
+			qsc_async_mutex_destroy(pool->mtx);
+		}
+
+		qsc_memutils_clear(pool, sizeof(skdp_pool));
+	}
+}
+
+void skdp_pool_endpoint_ipv4(skdp_pool_endpoint* endpoint, const qsc_ipinfo_ipv4_address* address, uint16_t port)
+{
+	SKDP_ASSERT(endpoint != NULL);
+	SKDP_ASSERT(address != NULL);
+
+	if (endpoint != NULL && address != NULL)
+	{
+		qsc_memutils_clear(endpoint, sizeof(skdp_pool_endpoint));
+		qsc_memutils_copy(endpoint->ipv4.ipv4, address->ipv4, sizeof(endpoint->ipv4.ipv4));
+		endpoint->family = qsc_socket_address_family_ipv4;
+		endpoint->port = port;
+	}
+}
+
+void skdp_pool_endpoint_ipv6(skdp_pool_endpoint* endpoint, const qsc_ipinfo_ipv6_address* address, uint16_t port)
+{
+	SKDP_ASSERT(endpoint != NULL);
+	SKDP_ASSERT(address != NULL);
+
+	if (endpoint != NULL && address != NULL)
+	{
+		qsc_memutils_clear(endpoint, sizeof(skdp_pool_endpoint));
+		qsc_memutils_copy(endpoint->ipv6.ipv6, address->ipv6, sizeof(endpoint->ipv6.ipv6));
+		endpoint->family = qsc_socket_address_family_ipv6;
+		endpoint->port = port;
+	}
+}
+
+bool skdp_pool_initialize(skdp_pool* pool, const skdp_device_key* dkey, size_t capacity, uint32_t interval)
+{
+	SKDP_ASSERT(pool != NULL);
+	SKDP_ASSERT(dkey != NULL);
+	SKDP_ASSERT(capacity != 0U);
+
+	bool res;
+
+	res = false;
+
+	if (pool != NULL && dkey != NULL && capacity != 0U)
+	{
+		qsc_memutils_clear(pool, sizeof(skdp_pool));
+		qsc_memutils_copy(&pool->dkey, dkey, sizeof(skdp_device_key));
+		pool->capacity = capacity;
+		pool->interval = (interval != 0U) ? interval : SKDP_POOL_INTERVAL_DEFAULT;
+		pool->sessions = (skdp_pool_session*)qsc_memutils_malloc(capacity * sizeof(skdp_pool_session));
+		pool->mtx = qsc_async_mutex_create();
+
+		if (pool->sessions != NULL && pool->mtx != NULL)
+		{
+			qsc_memutils_clear(pool->sessions, capacity * sizeof(skdp_pool_session));
+			pool->run = true;
+			pool->worker = qsc_async_thread_create(&pool_worker, pool);
+			res = true;
+		}
+		else
+		{
+			skdp_pool_dispose(pool);
+		}
+	}
+
+	return res;
+}
@@ -0,0 +1,243 @@
+/* 2021-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SKDP_POOL_H
+#define SKDP_POOL_H
+
+#include "skdpcommon.h"
+#include "skdp.h"
+#include "skdpclient.h"
+#include "async.h"
+#include "ipinfo.h"
+#include "socketbase.h"
+
+/**
+ * \file skdppool.h
+ * \brief The SKDP client connection pool.
+ *
+ * \details
+ * This header defines a client-side pool of established SKDP sessions, keyed by server address. Rather than
+ * connecting, sending, and closing for every interaction, an application adds a number of sessions per server to the
+ * pool, and threads check a session out, use it, and check it back in; the key exchange is paid once per session
+ * rather than once per interaction.
+ *
+ * A maintenance thread keeps the idle sessions warm:
+ * - Keep-alive requests from the server are answered on idle sessions, so the server does not time them out.
+ * - Records arriving on an idle session are decrypted and discarded, which keeps the channel sequence and key updates
+ * in step with the server. The rest of a record is awaited for at most \c SKDP_POOL_RECEIVE_TIMEOUT, so a stalled
+ * peer cannot hold the maintenance thread.
+ * - A hibernate request from the server is acknowledged, and the session stays connected and idle; the server wakes
+ * it when the next record arrives.
+ * - Sessions that fail or expire are re-established in the background; a session that still holds its keys is
+ * reattached first, and a full key exchange is used if the reattach is refused.
+ *
+ * A checked-out session is owned by the calling thread until it is checked in; the maintenance thread never touches a
+ * busy session. Checkout does not block: if no idle session is available for the server, it returns NULL and the
+ * caller may retry.
+ */
+
+/*!
+ * \def SKDP_POOL_INTERVAL_DEFAULT
+ * \brief The default maintenance interval in milliseconds.
+ */
+#define SKDP_POOL_INTERVAL_DEFAULT 100U
+
+/*!
+ * \def SKDP_POOL_RECEIVE_TIMEOUT
+ * \brief The maximum time the maintenance thread waits to read a record on an idle session, in milliseconds.
+ */
+#define SKDP_POOL_RECEIVE_TIMEOUT 1000U
+
+/*!
+ * \def SKDP_POOL_RETRY_INTERVAL
+ * \brief The minimum interval between connection attempts on a failed session, in seconds.
+ */
+#define SKDP_POOL_RETRY_INTERVAL 2U
+
+/*!
+ * \enum skdp_pool_states
+ * \brief The pool session states.
+ */
+SKDP_EXPORT_API typedef enum skdp_pool_states
+{
+	skdp_pool_state_failed = 0x00U,				/*!< The session is down and waiting to be re-established */
+	skdp_pool_state_connecting = 0x01U,			/*!< The maintenance thread is establishing the session */
+	skdp_pool_state_idle = 0x02U,				/*!< The session is established and available for checkout */
+	skdp_pool_state_busy = 0x03U,				/*!< The session is checked out by a caller */
+	skdp_pool_state_servicing = 0x04U,			/*!< The maintenance thread is servicing the idle session */
+} skdp_pool_states;
+
+/*!
+ * \struct skdp_pool_endpoint
+ * \brief A pool server address, the key used to select sessions.
+ */
+SKDP_EXPORT_API typedef struct skdp_pool_endpoint
+{
+	qsc_ipinfo_ipv4_address ipv4;				/*!< The server IPv4 address */
+	qsc_ipinfo_ipv6_address ipv6;				/*!< The server IPv6 address */
+	qsc_socket_address_families family;			/*!< The address family in use */
+	uint16_t port;								/*!< The server port number */
+} skdp_pool_endpoint;
+
+/*!
+ * \struct skdp_pool_session
+ * \brief A pooled client session.
+ */
+SKDP_EXPORT_API typedef struct skdp_pool_session
+{
+	skdp_client_state ctx;						/*!< The client session state */
+	qsc_socket sock;							/*!< The session socket */
+	skdp_pool_endpoint endpoint;				/*!< The server address */
+	uint64_t attempt;							/*!< The time of the last connection attempt, in seconds from epoch */
+	uint64_t expiration;						/*!< The session key expiration time, in seconds from epoch */
+	skdp_pool_states state;						/*!< The session state */
+} skdp_pool_session;
+
+/*!
+ * \struct skdp_pool
+ * \brief The SKDP client connection pool state.
+ */
+SKDP_EXPORT_API typedef struct skdp_pool
+{
+	skdp_device_key dkey;						/*!< The client device key used to establish sessions */
+	skdp_pool_session* sessions;				/*!< The session array */
+	qsc_mutex mtx;								/*!< The session state mutex */
+	qsc_thread worker;							/*!< The maintenance thread */
+	size_t capacity;							/*!< The session array capacity */
+	size_t count;								/*!< The number of sessions in the pool */
+	uint32_t interval;							/*!< The maintenance interval in milliseconds */
+	volatile bool run;							/*!< The maintenance thread run flag */
+} skdp_pool;
+
+/*!
+ * \brief Add sessions for a server to the pool.
+ *
+ * \details
+ * Appends count sessions for the server address; the sessions are established by the maintenance thread, and become
+ * available for checkout as each key exchange completes.
+ *
+ * \param pool A pointer to the pool state.
+ * \param endpoint [const] A pointer to the server address.
+ * \param count The number of sessions to add.
+ *
+ * \return Returns true if the sessions were added, false if the pool capacity would be exceeded.
+ */
+SKDP_EXPORT_API bool skdp_pool_add(skdp_pool* pool, const skdp_pool_endpoint* endpoint, size_t count);
+
+/*!
+ * \brief Check out an established session for a server.
+ *
+ * \details
+ * Returns an idle session connected to the server address and marks it busy. The caller uses the session's
+ * client state and socket exclusively, and must return it with \c skdp_pool_checkin.
+ *
+ * \param pool A pointer to the pool state.
+ * \param endpoint [const] A pointer to the server address.
+ *
+ * \return Returns a pointer to the session, or NULL if no idle session is available.
+ */
+SKDP_EXPORT_API skdp_pool_session* skdp_pool_checkout(skdp_pool* pool, const skdp_pool_endpoint* endpoint);
+
+/*!
+ * \brief Return a checked-out session to the pool.
+ *
+ * \details
+ * A session returned with \c skdp_error_none is made available again. A session returned with an error is closed
+ * with that error, and re-established by the maintenance thread.
+ *
+ * \param pool A pointer to the pool state.
+ * \param session A pointer to the session returned by \c skdp_pool_checkout.
+ * \param error The result of the caller's use of the session.
+ */
+SKDP_EXPORT_API void skdp_pool_checkin(skdp_pool* pool, skdp_pool_session* session, skdp_errors error);
+
+/*!
+ * \brief Dispose of the pool.
+ *
+ * \details
+ * Stops the maintenance thread, closes every session, and releases the pool resources. No session may be checked
+ * out when the pool is disposed.
+ *
+ * \param pool A pointer to the pool state.
+ */
+SKDP_EXPORT_API void skdp_pool_dispose(skdp_pool* pool);
+
+/*!
+ * \brief Set a pool server address to an IPv4 address.
+ *
+ * \param endpoint A pointer to the server address.
+ * \param address [const] The server IPv4 address.
+ * \param port The server port number.
+ */
+SKDP_EXPORT_API void skdp_pool_endpoint_ipv4(skdp_pool_endpoint* endpoint, const qsc_ipinfo_ipv4_address* address, uint16_t port);
+
+/*!
+ * \brief Set a pool server address to an IPv6 address.
+ *
+ * \param endpoint A pointer to the server address.
+ * \param address [const] The server IPv6 address.
+ * \param port The server port number.
+ */
+SKDP_EXPORT_API void skdp_pool_endpoint_ipv6(skdp_pool_endpoint* endpoint, const qsc_ipinfo_ipv6_address* address, uint16_t port);
+
+/*!
+ * \brief Initialize the pool and start the maintenance thread.
+ *
+ * \param pool A pointer to the pool state.
+ * \param dkey [const] A pointer to the client device key used to establish sessions.
+ * \param capacity The maximum number of sessions in the pool.
+ * \param interval The maintenance interval in milliseconds, zero selects \c SKDP_POOL_INTERVAL_DEFAULT.
+ *
+ * \return Returns true if the pool was initialized.
+ */
+SKDP_EXPORT_API bool skdp_pool_initialize(skdp_pool* pool, const skdp_device_key* dkey, size_t capacity, uint32_t interval);
+
+#endif
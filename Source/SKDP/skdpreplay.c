@@ -0,0 +1,207 @@
+#include "skdpreplay.h"
+#include "acp.h"
+#include "intutils.h"
+#include "memutils.h"
+#include "timestamp.h"
+
+#define REPLAY_FINGERPRINT_MASK 0x0000FFFFFFFFFFFFULL
+#define REPLAY_TAG_MASK 0xFFFFU
+#define REPLAY_TAG_SHIFT 48U
+
+static uint64_t replay_mix(uint64_t x)
+{
+	x ^= x >> 33U;
+	x *= 0xFF51AFD7ED558CCDULL;
+	x ^= x >> 33U;
+	x *= 0xC4CEB9FE1A85EC53ULL;
+	x ^= x >> 33U;
+
+	return x;
+}
+
+static bool replay_live(uint64_t v, uint64_t tag)
+{
+	/* an empty slot, or one from a bucket outside the window, is free */
+	return (v != 0U && ((tag - (v >> REPLAY_TAG_SHIFT)) & REPLAY_TAG_MASK) <= SKDP_REPLAY_WINDOW_BUCKETS);
+}
+
+static volatile uint64_t* replay_locate(const skdp_replay_cache* cache, const uint8_t* key, uint64_t* fp)
+{
+	/* the set index and fingerprint are keyed by the secret seed */
+	*fp = replay_mix(qsc_intutils_le8to64(key) ^ cache->seed) & REPLAY_FINGERPRINT_MASK;
+	*fp = (*fp == 0U) ? 1U : *fp;
+
+	return cache->slots + ((replay_mix(qsc_intutils_le8to64(key + sizeof(uint64_t)) ^ ~cache->seed) & cache->smask) * SKDP_REPLAY_WAYS);
+}
+
+static bool replay_match(const volatile uint64_t* pset, size_t count, uint64_t fp, uint64_t tag)
+{
+	uint64_t v;
+	size_t i;
+	bool res;
+
+	res = false;
+
+	for (i = 0U; i < count && res == false; ++i)
+	{
+		v = SKDP_ATOMIC_LOAD(&pset[i]);
+		res = (replay_live(v, tag) == true && (v & REPLAY_FINGERPRINT_MASK) == fp);
+	}
+
+	return res;
+}
+
+static uint64_t replay_tag(void)
+{
+	return (qsc_timestamp_epochtime_seconds() / SKDP_REPLAY_BUCKET_SECONDS) & REPLAY_TAG_MASK;
+}
+
+bool skdp_replay_contains(const skdp_replay_cache* cache, const uint8_t key[SKDP_REPLAY_KEY_SIZE])
+{
+	SKDP_ASSERT(cache != NULL);
+	SKDP_ASSERT(key != NULL);
+
+	const volatile uint64_t* pset;
+	uint64_t fp;
+	bool res;
+
+	res = false;
+
+	if (cache != NULL && key != NULL && cache->slots != NULL)
+	{
+		pset = replay_locate(cache, key, &fp);
+		res = replay_match(pset, SKDP_REPLAY_WAYS, fp, replay_tag());
+	}
+
+	return res;
+}
+
+void skdp_replay_dispose(skdp_replay_cache* cache)
+{
+	SKDP_ASSERT(cache != NULL);
+
+	if (cache != NULL)
+	{
+		if (cache->slots != NULL)
+		{
+			qsc_memutils_alloc_free((void*)cache->slots);
+		}
+
+		qsc_memutils_clear(cache, sizeof(skdp_replay_cache));
+	}
+}
+
+bool skdp_replay_initialize(skdp_replay_cache* cache, size_t capacity)
+{
+	SKDP_ASSERT(cache != NULL);
+
+	uint8_t rnd[sizeof(uint64_t)] = { 0U };
+	size_t sets;
+	bool res;
+
+	res = false;
+
+	if (cache != NULL)
+	{
+		qsc_memutils_clear(cache, sizeof(skdp_replay_cache));
+		sets = 1U;
+
+		/* size the table at half load, rounded up to a power of two sets */
+		while (sets * SKDP_REPLAY_WAYS < capacity * 2U && sets < ((size_t)1U << 28U))
+		{
+			sets <<= 1U;
+		}
+
+		if (qsc_acp_generate(rnd, sizeof(rnd)) == true)
+		{
+			cache->slots = (volatile uint64_t*)qsc_memutils_malloc(sets * SKDP_REPLAY_WAYS * sizeof(uint64_t));
+
+			if (cache->slots != NULL)
+			{
+				qsc_memutils_clear((void*)cache->slots, sets * SKDP_REPLAY_WAYS * sizeof(uint64_t));
+				cache->seed = qsc_intutils_le8to64(rnd);
+				cache->smask = (uint64_t)sets - 1U;
+				res = true;
+			}
+		}
+	}
+
+	return res;
+}
+
+bool skdp_replay_insert(skdp_replay_cache* cache, const uint8_t key[SKDP_REPLAY_KEY_SIZE])
+{
+	SKDP_ASSERT(cache != NULL);
+	SKDP_ASSERT(key != NULL);
+
+	volatile uint64_t* pset;
+	uint64_t best;
+	uint64_t fp;
+	uint64_t nv;
+	uint64_t old;
+	uint64_t score;
+	uint64_t tag;
+	uint64_t v;
+	size_t att;
+	size_t i;
+	size_t j;
+	size_t pos;
+	size_t sel;
+	bool dup;
+	bool res;
+
+	res = false;
+
+	if (cache != NULL && key != NULL && cache->slots != NULL)
+	{
+		pset = replay_locate(cache, key, &fp);
+		tag = replay_tag();
+		nv = (tag << REPLAY_TAG_SHIFT) | fp;
+		pos = SKDP_REPLAY_WAYS;
+		dup = false;
+
+		for (att = 0U; att < SKDP_REPLAY_WAYS && pos == SKDP_REPLAY_WAYS && dup == false; ++att)
+		{
+			sel = SKDP_REPLAY_WAYS;
+			old = 0U;
+			best = 0U;
+
+			/* the scan starts at a key-dependent slot, so evictions among entries of equal age are spread over the set */
+			for (j = 0U; j < SKDP_REPLAY_WAYS && dup == false; ++j)
+			{
+				i = (size_t)(fp + j) & (SKDP_REPLAY_WAYS - 1U);
+				v = SKDP_ATOMIC_LOAD(&pset[i]);
+
+				if (replay_live(v, tag) == true && (v & REPLAY_FINGERPRINT_MASK) == fp)
+				{
+					dup = true;
+				}
+				else
+				{
+					/* prefer a free slot, otherwise evict the oldest live entry */
+					score = (replay_live(v, tag) == true) ? ((tag - (v >> REPLAY_TAG_SHIFT)) & REPLAY_TAG_MASK) : (REPLAY_TAG_MASK + 1U);
+
+					if (sel == SKDP_REPLAY_WAYS || score > best)
+					{
+						sel = i;
+						old = v;
+						best = score;
+					}
+				}
+			}
+
+			if (dup == false && sel != SKDP_REPLAY_WAYS && SKDP_ATOMIC_CAS(&pset[sel], old, nv) == true)
+			{
+				pos = sel;
+			}
+		}
+
+		if (pos != SKDP_REPLAY_WAYS)
+		{
+			/* a concurrent insertion of the same key at a lower index wins */
+			res = (replay_match(pset, pos, fp, tag) == false);
+		}
+	}
+
+	return res;
+}
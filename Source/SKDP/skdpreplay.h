@@ -0,0 +1,159 @@
+/* 2021-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SKDP_REPLAY_H
+#define SKDP_REPLAY_H
+
+#include "skdpcommon.h"
+#include "skdp.h"
+
+/**
+ * \file skdpreplay.h
+ * \brief The SKDP handshake replay cache.
+ *
+ * \details
+ * This header defines a lock-free, time-bucketed set of recently seen handshake keys. The server derives a key from
+ * the device session hash (\c dsh) and the exchange request MAC tag. It looks the key up before any cSHAKE derivation,
+ * so a captured exchange request replayed inside the packet time window is rejected without forcing the server through
+ * the key derivations, and records the key only after the MAC tag verifies, so forged requests cannot occupy the cache.
+ *
+ * The cache is a set-associative table of 64-bit slots, \c SKDP_REPLAY_WAYS slots (one cache line) per set. A slot
+ * holds a 16-bit time bucket tag and a 48-bit fingerprint of the key; a slot whose bucket is older than the packet
+ * time window is treated as empty and reused, so entries expire without a sweep. Slots are claimed with a
+ * compare-and-swap. When two threads insert the same key at once, each re-scans its set after inserting, and only the
+ * insertion at the lower slot index is accepted. When every slot in a set is live, the oldest entry is evicted.
+ *
+ * Memory is bounded by the capacity given at initialization, which should be the expected number of handshakes within
+ * the packet time window (twice \c SKDP_PACKET_TIME_THRESHOLD).
+ */
+
+/*!
+ * \def SKDP_REPLAY_BUCKET_SECONDS
+ * \brief The width of a time bucket in seconds.
+ */
+#define SKDP_REPLAY_BUCKET_SECONDS 16U
+
+/*!
+ * \def SKDP_REPLAY_KEY_SIZE
+ * \brief The size (in bytes) of a replay cache key.
+ */
+#define SKDP_REPLAY_KEY_SIZE 16U
+
+/*!
+ * \def SKDP_REPLAY_WAYS
+ * \brief The number of slots in a cache set.
+ */
+#define SKDP_REPLAY_WAYS 8U
+
+/*!
+ * \def SKDP_REPLAY_WINDOW_BUCKETS
+ * \brief The number of time buckets an entry remains live, covering the packet time window in both directions.
+ */
+#define SKDP_REPLAY_WINDOW_BUCKETS ((((2U * SKDP_PACKET_TIME_THRESHOLD) + SKDP_REPLAY_BUCKET_SECONDS - 1U) / SKDP_REPLAY_BUCKET_SECONDS) + 1U)
+
+/*!
+ * \struct skdp_replay_cache
+ * \brief The SKDP replay cache state.
+ */
+SKDP_EXPORT_API typedef struct skdp_replay_cache
+{
+	volatile uint64_t* slots;					/*!< The cache slots */
+	uint64_t seed;								/*!< The secret index seed */
+	uint64_t smask;								/*!< The set index mask */
+} skdp_replay_cache;
+
+/*!
+ * \brief Look a key up in the cache without recording it.
+ *
+ * \details
+ * The set index and fingerprint are derived with a secret seed, so a remote party cannot choose keys that collide
+ * in a set. This function is safe to call from multiple threads.
+ *
+ * \param cache [const] A pointer to the replay cache.
+ * \param key [const] The handshake key.
+ *
+ * \return Returns true if the key was seen within the window.
+ */
+SKDP_EXPORT_API bool skdp_replay_contains(const skdp_replay_cache* cache, const uint8_t key[SKDP_REPLAY_KEY_SIZE]);
+
+/*!
+ * \brief Dispose of the replay cache and release its memory.
+ *
+ * \param cache A pointer to the replay cache.
+ */
+SKDP_EXPORT_API void skdp_replay_dispose(skdp_replay_cache* cache);
+
+/*!
+ * \brief Initialize the replay cache.
+ *
+ * \param cache A pointer to the replay cache.
+ * \param capacity The expected number of handshakes within the packet time window.
+ *
+ * \return Returns true if the cache was initialized.
+ */
+SKDP_EXPORT_API bool skdp_replay_initialize(skdp_replay_cache* cache, size_t capacity);
+
+/*!
+ * \brief Record an authenticated key in the cache.
+ *
+ * \details
+ * Called only after the request carrying the key has been authenticated. A free or expired slot is used if the set
+ * has one, otherwise the oldest entry in the set is evicted. This function is safe to call from multiple threads.
+ *
+ * \param cache A pointer to the replay cache.
+ * \param key [const] The handshake key.
+ *
+ * \return Returns true if the key was recorded; false if it is already present, including a concurrent insertion
+ * of the same key.
+ */
+SKDP_EXPORT_API bool skdp_replay_insert(skdp_replay_cache* cache, const uint8_t key[SKDP_REPLAY_KEY_SIZE]);
+
+#endif
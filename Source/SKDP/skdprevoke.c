@@ -0,0 +1,680 @@
+#include "skdprevoke.h"
+#include "acp.h"
+#include "async.h"
+#include "fileutils.h"
+#include "intutils.h"
+#include "memutils.h"
+#include "sha3.h"
+#include <stdio.h>
+#include <string.h>
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+#	include <windows.h>
+#endif
+
+#define REVOKE_TEMP_SUFFIX ".tmp"
+
+static uint64_t revoke_mix(uint64_t x)
+{
+	x ^= x >> 33U;
+	x *= 0xFF51AFD7ED558CCDULL;
+	x ^= x >> 33U;
+	x *= 0xC4CEB9FE1A85EC53ULL;
+	x ^= x >> 33U;
+
+	return x;
+}
+
+static void revoke_hash(const uint8_t* kid, uint64_t seed, uint64_t* h1, uint64_t* h2)
+{
+	uint64_t hi;
+	uint64_t lo;
+
+	/* the identity is structured (server id || device id), so both halves are fully mixed */
+	lo = qsc_intutils_le8to64(kid);
+	hi = qsc_intutils_le8to64(kid + sizeof(uint64_t));
+	*h1 = revoke_mix(revoke_mix(lo ^ seed) ^ hi);
+	*h2 = revoke_mix(*h1 ^ hi ^ 0x9E3779B97F4A7C15ULL) | 1U;
+}
+
+static uint32_t revoke_bloom_words(uint64_t entries)
+{
+	uint64_t bits;
+	uint32_t words;
+
+	bits = (entries + SKDP_REVOKE_DELTA_CAPACITY) * SKDP_REVOKE_BLOOM_BITS;
+	words = 1U;
+
+	/* a power of two table lets the probe index be masked */
+	while ((uint64_t)words * 64U < bits && words < 0x80000000UL)
+	{
+		words <<= 1U;
+	}
+
+	return words;
+}
+
+static void revoke_bloom_set(volatile uint64_t* bloom, uint32_t bmask, uint64_t seed, const uint8_t* kid)
+{
+	uint64_t bit;
+	uint64_t h1;
+	uint64_t h2;
+	uint64_t m;
+	uint64_t old;
+	size_t i;
+	uint32_t w;
+
+	revoke_hash(kid, seed, &h1, &h2);
+
+	for (i = 0U; i < SKDP_REVOKE_BLOOM_HASHES; ++i)
+	{
+		bit = h1 + ((uint64_t)i * h2);
+		w = (uint32_t)(bit >> 6U) & bmask;
+		m = (uint64_t)1U << (bit & 63U);
+
+		do
+		{
+			old = bloom[w];
+		}
+		while ((old & m) == 0U && SKDP_ATOMIC_CAS(&bloom[w], old, old | m) == false);
+	}
+}
+
+static bool revoke_bloom_test(const volatile uint64_t* bloom, uint32_t bmask, uint64_t seed, const uint8_t* kid)
+{
+	uint64_t bit;
+	uint64_t h1;
+	uint64_t h2;
+	size_t i;
+	bool res;
+
+	revoke_hash(kid, seed, &h1, &h2);
+	res = true;
+
+	for (i = 0U; i < SKDP_REVOKE_BLOOM_HASHES; ++i)
+	{
+		bit = h1 + ((uint64_t)i * h2);
+
+		if ((bloom[(uint32_t)(bit >> 6U) & bmask] & ((uint64_t)1U << (bit & 63U))) == 0U)
+		{
+			res = false;
+			break;
+		}
+	}
+
+	return res;
+}
+
+static int32_t revoke_compare(const uint8_t* a, const uint8_t* b)
+{
+	size_t i;
+	int32_t res;
+
+	res = 0;
+
+	for (i = 0U; i < SKDP_KID_SIZE; ++i)
+	{
+		if (a[i] != b[i])
+		{
+			res = (a[i] < b[i]) ? -1 : 1;
+			break;
+		}
+	}
+
+	return res;
+}
+
+static bool revoke_search(const uint8_t* entries, uint32_t count, const uint8_t* kid)
+{
+	uint32_t hi;
+	uint32_t lo;
+	uint32_t mid;
+	int32_t cmp;
+	bool res;
+
+	res = false;
+	lo = 0U;
+	hi = count;
+
+	while (lo < hi)
+	{
+		mid = lo + ((hi - lo) / 2U);
+		cmp = revoke_compare(entries + ((size_t)mid * SKDP_KID_SIZE), kid);
+
+		if (cmp == 0)
+		{
+			res = true;
+			break;
+		}
+		else if (cmp < 0)
+		{
+			lo = mid + 1U;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	return res;
+}
+
+static bool revoke_delta_search(const skdp_revocation_table* tbl, const uint8_t* kid)
+{
+	uint64_t dcount;
+	uint64_t i;
+	bool res;
+
+	res = false;
+	dcount = SKDP_ATOMIC_LOAD(&tbl->dcount);
+
+	for (i = 0U; i < dcount; ++i)
+	{
+		if (qsc_intutils_are_equal8(tbl->delta + (i * SKDP_KID_SIZE), kid, SKDP_KID_SIZE) == true)
+		{
+			res = true;
+			break;
+		}
+	}
+
+	return res;
+}
+
+static void revoke_sort(uint8_t* entries, size_t count)
+{
+	uint8_t tmp[SKDP_KID_SIZE] = { 0U };
+	size_t i;
+	size_t j;
+
+	/* insertion sort, the delta is bounded and usually small */
+	for (i = 1U; i < count; ++i)
+	{
+		qsc_memutils_copy(tmp, entries + (i * SKDP_KID_SIZE), SKDP_KID_SIZE);
+
+		for (j = i; j > 0U && revoke_compare(entries + ((j - 1U) * SKDP_KID_SIZE), tmp) > 0; --j)
+		{
+			qsc_memutils_copy(entries + (j * SKDP_KID_SIZE), entries + ((j - 1U) * SKDP_KID_SIZE), SKDP_KID_SIZE);
+		}
+
+		qsc_memutils_copy(entries + (j * SKDP_KID_SIZE), tmp, SKDP_KID_SIZE);
+	}
+}
+
+static size_t revoke_file_size(uint32_t words, uint32_t count)
+{
+	return SKDP_REVOKE_HEADER_SIZE + ((size_t)words * sizeof(uint64_t)) + ((size_t)count * SKDP_KID_SIZE);
+}
+
+static const skdp_revocation_table* revoke_active(const skdp_revocation* rset)
+{
+	/* the writer side; additions, saves, and reopens are serialized by the caller */
+	return &rset->tables[SKDP_ATOMIC_LOAD(&rset->epoch) & 1U];
+}
+
+static bool revoke_table_allocate(skdp_revocation_table* tbl, uint32_t words)
+{
+	bool res;
+
+	res = false;
+	tbl->bloom = (volatile uint64_t*)qsc_memutils_malloc((size_t)words * sizeof(uint64_t));
+	tbl->delta = (uint8_t*)qsc_memutils_malloc((size_t)SKDP_REVOKE_DELTA_CAPACITY * SKDP_KID_SIZE);
+
+	if (tbl->bloom != NULL && tbl->delta != NULL)
+	{
+		qsc_memutils_clear((void*)tbl->bloom, (size_t)words * sizeof(uint64_t));
+		qsc_memutils_clear(tbl->delta, (size_t)SKDP_REVOKE_DELTA_CAPACITY * SKDP_KID_SIZE);
+		tbl->bmask = words - 1U;
+		tbl->dcount = 0U;
+		res = true;
+	}
+
+	return res;
+}
+
+static bool revoke_table_contains(const skdp_revocation_table* tbl, const uint8_t* kid)
+{
+	bool res;
+
+	res = false;
+
+	if (tbl->bloom != NULL && revoke_bloom_test(tbl->bloom, tbl->bmask, tbl->seed, kid) == true)
+	{
+		res = revoke_search(tbl->entries, tbl->count, kid);
+
+		if (res == false)
+		{
+			res = revoke_delta_search(tbl, kid);
+		}
+	}
+
+	return res;
+}
+
+static void revoke_table_dispose(skdp_revocation_table* tbl)
+{
+	skdp_filemap_close(&tbl->map);
+
+	if (tbl->bloom != NULL)
+	{
+		qsc_memutils_alloc_free((void*)tbl->bloom);
+	}
+
+	if (tbl->delta != NULL)
+	{
+		qsc_memutils_alloc_free(tbl->delta);
+	}
+
+	qsc_memutils_clear(tbl, sizeof(skdp_revocation_table));
+}
+
+static bool revoke_table_open(skdp_revocation_table* tbl, const char* fpath)
+{
+	const uint8_t* phdr;
+	size_t i;
+	uint32_t words;
+	bool res;
+
+	res = false;
+	qsc_memutils_clear(tbl, sizeof(skdp_revocation_table));
+
+	if (skdp_filemap_open(&tbl->map, fpath) == true && tbl->map.length >= SKDP_REVOKE_HEADER_SIZE)
+	{
+		phdr = tbl->map.data;
+
+		if (qsc_intutils_are_equal8(phdr, (const uint8_t*)SKDP_REVOKE_MAGIC, sizeof(SKDP_REVOKE_MAGIC)) == true &&
+			qsc_intutils_le8to32(phdr + 8U) == SKDP_REVOKE_VERSION &&
+			qsc_intutils_le8to32(phdr + 12U) == SKDP_REVOKE_BLOOM_HASHES)
+		{
+			tbl->count = qsc_intutils_le8to32(phdr + 16U);
+			words = qsc_intutils_le8to32(phdr + 20U);
+			tbl->seed = qsc_intutils_le8to64(phdr + 24U);
+
+			/* the bloom table must be a power of two, and the file geometry must match the header */
+			if (words != 0U && (words & (words - 1U)) == 0U &&
+				tbl->map.length == revoke_file_size(words, tbl->count))
+			{
+				if (revoke_table_allocate(tbl, words) == true)
+				{
+					for (i = 0U; i < words; ++i)
+					{
+						tbl->bloom[i] = qsc_intutils_le8to64(phdr + SKDP_REVOKE_HEADER_SIZE + (i * sizeof(uint64_t)));
+					}
+
+					tbl->entries = phdr + SKDP_REVOKE_HEADER_SIZE + ((size_t)words * sizeof(uint64_t));
+					res = true;
+				}
+			}
+		}
+	}
+
+	if (res == false)
+	{
+		revoke_table_dispose(tbl);
+	}
+
+	return res;
+}
+
+static bool revoke_table_add(skdp_revocation_table* tbl, const uint8_t* kid)
+{
+	uint64_t dcount;
+	bool res;
+
+	res = false;
+
+	if (revoke_table_contains(tbl, kid) == true)
+	{
+		res = true;
+	}
+	else
+	{
+		dcount = SKDP_ATOMIC_LOAD(&tbl->dcount);
+
+		if (dcount < SKDP_REVOKE_DELTA_CAPACITY)
+		{
+			/* publish the exact entry before the bloom bits that lead a lookup to it */
+			qsc_memutils_copy(tbl->delta + (dcount * SKDP_KID_SIZE), kid, SKDP_KID_SIZE);
+			SKDP_ATOMIC_STORE(&tbl->dcount, dcount + 1U);
+			revoke_bloom_set(tbl->bloom, tbl->bmask, tbl->seed, kid);
+			res = true;
+		}
+	}
+
+	return res;
+}
+
+static void revoke_quiesce(skdp_revocation* rset, size_t index)
+{
+	/* wait until every lookup registered on the table has finished */
+	while (SKDP_ATOMIC_LOAD(&rset->readers[index]) != 0U)
+	{
+		qsc_async_thread_sleep(1U);
+	}
+}
+
+static bool revoke_replace(const char* tpath, const char* fpath)
+{
+	bool res;
+
+#if defined(QSC_SYSTEM_OS_WINDOWS)
+	res = (MoveFileExA(tpath, fpath, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+#else
+	/* rename is atomic; an existing mapping of the old file stays valid */
+	res = (rename(tpath, fpath) == 0);
+#endif
+
+	return res;
+}
+
+bool skdp_revocation_add(skdp_revocation* rset, const uint8_t kid[SKDP_KID_SIZE])
+{
+	SKDP_ASSERT(rset != NULL);
+	SKDP_ASSERT(kid != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (rset != NULL && kid != NULL)
+	{
+		res = revoke_table_add(&rset->tables[SKDP_ATOMIC_LOAD(&rset->epoch) & 1U], kid);
+	}
+
+	return res;
+}
+
+bool skdp_revocation_contains(skdp_revocation* rset, const uint8_t kid[SKDP_KID_SIZE])
+{
+	SKDP_ASSERT(rset != NULL);
+	SKDP_ASSERT(kid != NULL);
+
+	uint64_t epoch;
+	size_t idx;
+	bool res;
+	bool run;
+
+	res = false;
+
+	if (rset != NULL && kid != NULL)
+	{
+		run = true;
+
+		while (run == true)
+		{
+			/* register on the active table, then confirm it is still active before using it */
+			epoch = SKDP_ATOMIC_LOAD(&rset->epoch);
+			idx = (size_t)(epoch & 1U);
+			SKDP_ATOMIC_ADD(&rset->readers[idx], 1U);
+
+			if (SKDP_ATOMIC_LOAD(&rset->epoch) == epoch)
+			{
+				res = revoke_table_contains(&rset->tables[idx], kid);
+				run = false;
+			}
+
+			SKDP_ATOMIC_SUB(&rset->readers[idx], 1U);
+		}
+	}
+
+	return res;
+}
+
+void skdp_revocation_dispose(skdp_revocation* rset)
+{
+	SKDP_ASSERT(rset != NULL);
+
+	if (rset != NULL)
+	{
+		revoke_table_dispose(&rset->tables[0U]);
+		revoke_table_dispose(&rset->tables[1U]);
+		qsc_memutils_clear(rset, sizeof(skdp_revocation));
+	}
+}
+
+bool skdp_revocation_initialize(skdp_revocation* rset)
+{
+	SKDP_ASSERT(rset != NULL);
+
+	uint8_t rnd[sizeof(uint64_t)] = { 0U };
+	bool res;
+
+	res = false;
+
+	if (rset != NULL)
+	{
+		qsc_memutils_clear(rset, sizeof(skdp_revocation));
+
+		if (qsc_acp_generate(rnd, sizeof(rnd)) == true)
+		{
+			rset->tables[0U].seed = qsc_intutils_le8to64(rnd);
+			res = revoke_table_allocate(&rset->tables[0U], revoke_bloom_words(0U));
+		}
+
+		if (res == false)
+		{
+			skdp_revocation_dispose(rset);
+		}
+	}
+
+	return res;
+}
+
+bool skdp_revocation_open(skdp_revocation* rset, const char* fpath)
+{
+	SKDP_ASSERT(rset != NULL);
+	SKDP_ASSERT(fpath != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (rset != NULL && fpath != NULL)
+	{
+		qsc_memutils_clear(rset, sizeof(skdp_revocation));
+		res = revoke_table_open(&rset->tables[0U], fpath);
+	}
+
+	return res;
+}
+
+bool skdp_revocation_reopen(skdp_revocation* rset, const char* fpath)
+{
+	SKDP_ASSERT(rset != NULL);
+	SKDP_ASSERT(fpath != NULL);
+
+	const skdp_revocation_table* pold;
+	skdp_revocation_table* pnew;
+	uint64_t dcount;
+	uint64_t epoch;
+	uint64_t i;
+	size_t nidx;
+	size_t oidx;
+	bool res;
+
+	res = false;
+
+	if (rset != NULL && fpath != NULL)
+	{
+		epoch = SKDP_ATOMIC_LOAD(&rset->epoch);
+		oidx = (size_t)(epoch & 1U);
+		nidx = oidx ^ 1U;
+		pold = &rset->tables[oidx];
+		pnew = &rset->tables[nidx];
+
+		/* a lookup that registered on the standby table during the last switch may still be leaving it */
+		revoke_quiesce(rset, nidx);
+		revoke_table_dispose(pnew);
+
+		if (revoke_table_open(pnew, fpath) == true)
+		{
+			res = true;
+			dcount = SKDP_ATOMIC_LOAD(&pold->dcount);
+
+			/* identities added after the file was saved are carried forward */
+			for (i = 0U; i < dcount && res == true; ++i)
+			{
+				res = revoke_table_add(pnew, pold->delta + (i * SKDP_KID_SIZE));
+			}
+
+			if (res == true)
+			{
+				/* switch lookups to the new table, then release the old one once its lookups have drained */
+				SKDP_ATOMIC_STORE(&rset->epoch, epoch + 1U);
+				revoke_quiesce(rset, oidx);
+				revoke_table_dispose(&rset->tables[oidx]);
+			}
+			else
+			{
+				revoke_table_dispose(pnew);
+			}
+		}
+	}
+
+	return res;
+}
+
+bool skdp_revocation_save(const skdp_revocation* rset, const char* fpath)
+{
+	SKDP_ASSERT(rset != NULL);
+	SKDP_ASSERT(fpath != NULL);
+
+	const skdp_revocation_table* tbl;
+	volatile uint64_t* bloom;
+	char* tpath;
+	uint8_t* pdelta;
+	uint8_t* pent;
+	uint8_t* pfile;
+	size_t flen;
+	size_t i;
+	size_t j;
+	size_t k;
+	size_t plen;
+	uint64_t dcount;
+	uint32_t total;
+	uint32_t words;
+	bool res;
+
+	res = false;
+
+	if (rset != NULL && fpath != NULL && revoke_active(rset)->bloom != NULL)
+	{
+		tbl = revoke_active(rset);
+		dcount = SKDP_ATOMIC_LOAD(&tbl->dcount);
+		total = tbl->count + (uint32_t)dcount;
+		words = revoke_bloom_words(total);
+		flen = revoke_file_size(words, total);
+		pfile = (uint8_t*)qsc_memutils_malloc(flen);
+		bloom = (volatile uint64_t*)qsc_memutils_malloc((size_t)words * sizeof(uint64_t));
+		pdelta = (uint8_t*)qsc_memutils_malloc(((size_t)dcount * SKDP_KID_SIZE) + 1U);
+
+		if (pfile != NULL && bloom != NULL && pdelta != NULL)
+		{
+			qsc_memutils_clear(pfile, flen);
+			qsc_memutils_clear((void*)bloom, (size_t)words * sizeof(uint64_t));
+			qsc_memutils_copy(pdelta, tbl->delta, (size_t)dcount * SKDP_KID_SIZE);
+			revoke_sort(pdelta, (size_t)dcount);
+
+			/* merge the mapped entries and the sorted delta */
+			pent = pfile + SKDP_REVOKE_HEADER_SIZE + ((size_t)words * sizeof(uint64_t));
+			i = 0U;
+			j = 0U;
+
+			for (k = 0U; k < total; ++k)
+			{
+				if (j >= dcount || (i < tbl->count &&
+					revoke_compare(tbl->entries + (i * SKDP_KID_SIZE), pdelta + (j * SKDP_KID_SIZE)) < 0))
+				{
+					qsc_memutils_copy(pent + (k * SKDP_KID_SIZE), tbl->entries + (i * SKDP_KID_SIZE), SKDP_KID_SIZE);
+					++i;
+				}
+				else
+				{
+					qsc_memutils_copy(pent + (k * SKDP_KID_SIZE), pdelta + (j * SKDP_KID_SIZE), SKDP_KID_SIZE);
+					++j;
+				}
+
+				revoke_bloom_set(bloom, words - 1U, tbl->seed, pent + (k * SKDP_KID_SIZE));
+			}
+
+			for (i = 0U; i < words; ++i)
+			{
+				qsc_intutils_le64to8(pfile + SKDP_REVOKE_HEADER_SIZE + (i * sizeof(uint64_t)), bloom[i]);
+			}
+
+			/* assemble the header */
+			qsc_memutils_copy(pfile, SKDP_REVOKE_MAGIC, sizeof(SKDP_REVOKE_MAGIC));
+			qsc_intutils_le32to8(pfile + 8U, SKDP_REVOKE_VERSION);
+			qsc_intutils_le32to8(pfile + 12U, SKDP_REVOKE_BLOOM_HASHES);
+			qsc_intutils_le32to8(pfile + 16U, total);
+			qsc_intutils_le32to8(pfile + 20U, words);
+			qsc_intutils_le64to8(pfile + 24U, tbl->seed);
+			qsc_sha3_compute256(pfile + 32U, pfile + SKDP_REVOKE_HEADER_SIZE, flen - SKDP_REVOKE_HEADER_SIZE);
+
+			/* write beside the target and rename over it, so the target is never seen partly written */
+			plen = strlen(fpath);
+			tpath = (char*)qsc_memutils_malloc(plen + sizeof(REVOKE_TEMP_SUFFIX));
+
+			if (tpath != NULL)
+			{
+				qsc_memutils_copy(tpath, fpath, plen);
+				qsc_memutils_copy(tpath + plen, REVOKE_TEMP_SUFFIX, sizeof(REVOKE_TEMP_SUFFIX));
+
+				if (qsc_fileutils_copy_stream_to_file(tpath, (const char*)pfile, flen) == true)
+				{
+					res = revoke_replace(tpath, fpath);
+
+					if (res == false)
+					{
+						remove(tpath);
+					}
+				}
+
+				qsc_memutils_alloc_free(tpath);
+			}
+		}
+
+		if (pdelta != NULL)
+		{
+			qsc_memutils_alloc_free(pdelta);
+		}
+
+		if (bloom != NULL)
+		{
+			qsc_memutils_alloc_free((void*)bloom);
+		}
+
+		if (pfile != NULL)
+		{
+			qsc_memutils_alloc_free(pfile);
+		}
+	}
+
+	return res;
+}
+
+bool skdp_revocation_verify(const skdp_revocation* rset)
+{
+	SKDP_ASSERT(rset != NULL);
+
+	uint8_t hash[SKDP_REVOKE_CHECKSUM_SIZE] = { 0U };
+	const skdp_revocation_table* tbl;
+	bool res;
+
+	res = false;
+
+	if (rset != NULL)
+	{
+		tbl = revoke_active(rset);
+
+		if (tbl->map.data != NULL)
+		{
+			qsc_sha3_compute256(hash, tbl->map.data + SKDP_REVOKE_HEADER_SIZE, tbl->map.length - SKDP_REVOKE_HEADER_SIZE);
+			res = (qsc_intutils_verify(hash, tbl->map.data + 32U, SKDP_REVOKE_CHECKSUM_SIZE) == 0);
+		}
+		else
+		{
+			res = true;
+		}
+	}
+
+	return res;
+}
@@ -0,0 +1,254 @@
+/* 2021-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SKDP_REVOKE_H
+#define SKDP_REVOKE_H
+
+#include "skdpcommon.h"
+#include "skdp.h"
+#include "skdpfilemap.h"
+
+/**
+ * \file skdprevoke.h
+ * \brief The SKDP device revocation set.
+ *
+ * \details
+ * This header defines a revocation set used by the server to refuse compromised devices without rotating the
+ * server key. The set is checked with the device key identity carried in the connect request, before the server
+ * hashes the transcript or generates its session token, so a revoked device costs the server no handshake work.
+ *
+ * Membership is tested in two stages. A bloom filter answers the common case, a device that is not revoked, with
+ * a fixed number of bit probes into a single table. Only a bloom hit is confirmed against the exact set: a sorted
+ * array of revoked key identities searched with a binary search, followed by a short scan of the entries added since
+ * the set was loaded.
+ *
+ * The set is stored in a file that is mapped read-only when opened; the sorted identities are used in place, and the
+ * bloom filter is copied to memory so that it can take incremental additions. Additions are appended to a bounded
+ * in-memory delta by a single writer, and may run concurrently with lookups. \c skdp_revocation_save merges the
+ * delta into a new file, written to a temporary path and renamed into place, so a reader of the old file never sees a
+ * partly written one.
+ *
+ * \c skdp_revocation_reopen moves a live set to a new file without stopping lookups. The set holds two tables; the
+ * new file is loaded into the inactive table, identities added since the save are carried forward, and the active
+ * table index is switched. Lookups register on the table they use, and the old mapping is released only once its
+ * last lookup has finished. Additions, saves, and reopens must be serialized by the caller.
+ *
+ * File layout (little-endian):
+ * - magic (8 bytes), version (4), hash count (4), entry count (4), bloom word count (4), hash seed (8), checksum (32)
+ * - the bloom filter, as 64-bit words
+ * - the revoked key identities, \c SKDP_KID_SIZE bytes each, in ascending byte order
+ *
+ * The checksum is a SHA3-256 hash of the bloom filter and the entries, and is checked by \c skdp_revocation_verify.
+ */
+
+/*!
+ * \def SKDP_REVOKE_BLOOM_BITS
+ * \brief The number of bloom filter bits allocated per revoked identity.
+ */
+#define SKDP_REVOKE_BLOOM_BITS 16U
+
+/*!
+ * \def SKDP_REVOKE_BLOOM_HASHES
+ * \brief The number of bloom filter bit probes per identity.
+ */
+#define SKDP_REVOKE_BLOOM_HASHES 8U
+
+/*!
+ * \def SKDP_REVOKE_CHECKSUM_SIZE
+ * \brief The revocation file checksum size in bytes.
+ */
+#define SKDP_REVOKE_CHECKSUM_SIZE 32U
+
+/*!
+ * \def SKDP_REVOKE_DELTA_CAPACITY
+ * \brief The maximum number of identities that can be added before the set must be saved and reopened.
+ */
+#define SKDP_REVOKE_DELTA_CAPACITY 4096U
+
+/*!
+ * \def SKDP_REVOKE_HEADER_SIZE
+ * \brief The revocation file header size in bytes.
+ */
+#define SKDP_REVOKE_HEADER_SIZE 64U
+
+/*!
+ * \def SKDP_REVOKE_VERSION
+ * \brief The revocation file format version.
+ */
+#define SKDP_REVOKE_VERSION 1U
+
+/*!
+ * \brief The revocation file magic value.
+ */
+static const char SKDP_REVOKE_MAGIC[8U] = { 'S', 'K', 'D', 'P', 'R', 'V', 'K', 'S' };
+
+/*!
+ * \struct skdp_revocation_table
+ * \brief A loaded revocation file and its additions.
+ */
+SKDP_EXPORT_API typedef struct skdp_revocation_table
+{
+	skdp_filemap map;							/*!< The read-only file mapping */
+	const uint8_t* entries;						/*!< The sorted revoked identities */
+	volatile uint64_t* bloom;					/*!< The bloom filter words */
+	uint8_t* delta;								/*!< The identities added since the set was loaded */
+	volatile uint64_t dcount;					/*!< The number of delta identities */
+	uint64_t seed;								/*!< The bloom hash seed */
+	uint32_t bmask;								/*!< The bloom word index mask */
+	uint32_t count;								/*!< The number of sorted identities */
+} skdp_revocation_table;
+
+/*!
+ * \struct skdp_revocation
+ * \brief The SKDP device revocation set state.
+ */
+SKDP_EXPORT_API typedef struct skdp_revocation
+{
+	skdp_revocation_table tables[2U];			/*!< The active and the standby tables */
+	volatile uint64_t readers[2U];				/*!< The number of lookups in progress on each table */
+	volatile uint64_t epoch;					/*!< The table generation, the active table is the low bit */
+} skdp_revocation;
+
+/*!
+ * \brief Add a device key identity to the revocation set.
+ *
+ * \details
+ * The identity is visible to lookups as soon as the function returns. Additions must be serialized by the caller,
+ * but lookups may run concurrently.
+ *
+ * \param rset A pointer to the revocation set.
+ * \param kid [const] The device key identity to revoke.
+ *
+ * \return Returns true if the identity was added or is already revoked; false if the delta is full.
+ */
+SKDP_EXPORT_API bool skdp_revocation_add(skdp_revocation* rset, const uint8_t kid[SKDP_KID_SIZE]);
+
+/*!
+ * \brief Test whether a device key identity is revoked.
+ *
+ * \details
+ * Safe to call concurrently with additions and with \c skdp_revocation_reopen.
+ *
+ * \param rset A pointer to the revocation set.
+ * \param kid [const] The device key identity.
+ *
+ * \return Returns true if the identity is revoked.
+ */
+SKDP_EXPORT_API bool skdp_revocation_contains(skdp_revocation* rset, const uint8_t kid[SKDP_KID_SIZE]);
+
+/*!
+ * \brief Dispose of the revocation set, releasing memory and unmapping the file.
+ *
+ * \param rset A pointer to the revocation set.
+ */
+SKDP_EXPORT_API void skdp_revocation_dispose(skdp_revocation* rset);
+
+/*!
+ * \brief Initialize an empty revocation set.
+ *
+ * \param rset A pointer to the revocation set.
+ *
+ * \return Returns true if the set was initialized.
+ */
+SKDP_EXPORT_API bool skdp_revocation_initialize(skdp_revocation* rset);
+
+/*!
+ * \brief Open a revocation file, mapping its sorted identities and loading its bloom filter.
+ *
+ * \param rset A pointer to the revocation set.
+ * \param fpath [const] The full path to the revocation file.
+ *
+ * \return Returns true if the file was mapped and its header and geometry are valid.
+ */
+SKDP_EXPORT_API bool skdp_revocation_open(skdp_revocation* rset, const char* fpath);
+
+/*!
+ * \brief Move a live revocation set to a new file.
+ *
+ * \details
+ * Typically called after \c skdp_revocation_save has replaced the file. The file is loaded into the standby table,
+ * identities added to the active table that are not in the file are carried forward, and lookups are switched to the
+ * new table. The function returns once every lookup on the old table has finished and its mapping is released.
+ * On failure the active table is left unchanged.
+ *
+ * \param rset A pointer to the revocation set.
+ * \param fpath [const] The full path to the revocation file.
+ *
+ * \return Returns true if the new file was loaded and is now in use.
+ */
+SKDP_EXPORT_API bool skdp_revocation_reopen(skdp_revocation* rset, const char* fpath);
+
+/*!
+ * \brief Write the revocation set, including the delta, to a new file.
+ *
+ * \details
+ * The bloom filter in the new file is sized for the merged entry count plus \c SKDP_REVOKE_DELTA_CAPACITY additions.
+ * The file is written to a temporary path beside the target and renamed over it, so the path may be the file the set
+ * is currently mapped from; the existing mapping stays valid, and \c skdp_revocation_reopen moves the set to the
+ * new file.
+ *
+ * \param rset [const] A pointer to the revocation set.
+ * \param fpath [const] The full path of the file to write.
+ *
+ * \return Returns true if the file was written.
+ */
+SKDP_EXPORT_API bool skdp_revocation_save(const skdp_revocation* rset, const char* fpath);
+
+/*!
+ * \brief Verify the revocation file checksum.
+ *
+ * \param rset [const] A pointer to the revocation set.
+ *
+ * \return Returns true if the set is not file backed, or the checksum matches the file contents.
+ */
+SKDP_EXPORT_API bool skdp_revocation_verify(const skdp_revocation* rset);
+
+#endif
@@ -0,0 +1,283 @@
+#include "skdpscheduler.h"
+#include "memutils.h"
+
+static bool scheduler_push(skdp_scheduler_queue* pq, const uint8_t* data, size_t length, bool raw)
+{
+	size_t pos;
+	bool res;
+
+	res = false;
+
+	if (pq->count < pq->depth)
+	{
+		pos = (pq->head + pq->count) % pq->depth;
+		qsc_memutils_copy(pq->slots + (pos * SKDP_MESSAGE_MAX), data, length);
+		pq->entries[pos].length = (uint32_t)length;
+		pq->entries[pos].raw = raw;
+		++pq->count;
+		res = true;
+	}
+
+	return res;
+}
+
+static void scheduler_pop(skdp_scheduler_queue* pq, uint8_t* output, size_t* outlen, bool* raw)
+{
+	uint8_t* pslot;
+
+	pslot = pq->slots + (pq->head * SKDP_MESSAGE_MAX);
+	*outlen = pq->entries[pq->head].length;
+	*raw = pq->entries[pq->head].raw;
+	qsc_memutils_copy(output, pslot, *outlen);
+	qsc_memutils_clear(pslot, *outlen);
+	pq->head = (pq->head + 1U) % pq->depth;
+	--pq->count;
+}
+
+static void scheduler_advance(skdp_scheduler* sched)
+{
+	sched->current = (sched->current == skdp_scheduler_class_interactive) ? skdp_scheduler_class_bulk : skdp_scheduler_class_interactive;
+	sched->topped = false;
+}
+
+static bool scheduler_weighted(skdp_scheduler* sched, uint8_t* output, size_t* outlen, bool* raw)
+{
+	skdp_scheduler_queue* pq;
+	bool res;
+
+	res = false;
+
+	/* deficit round-robin; a quantum covers the largest record, so this ends within two visits per class */
+	while (res == false && (sched->queues[skdp_scheduler_class_interactive].count != 0U || sched->queues[skdp_scheduler_class_bulk].count != 0U))
+	{
+		pq = &sched->queues[sched->current];
+
+		if (pq->count == 0U)
+		{
+			pq->deficit = 0U;
+			scheduler_advance(sched);
+		}
+		else if (pq->quantum == 0U)
+		{
+			/* a strict lowest priority class is served only when the other class is empty */
+			if (sched->queues[skdp_scheduler_class_interactive].count == 0U)
+			{
+				scheduler_pop(pq, output, outlen, raw);
+				res = true;
+			}
+			else
+			{
+				scheduler_advance(sched);
+			}
+		}
+		else
+		{
+			if (sched->topped == false)
+			{
+				pq->deficit += pq->quantum;
+				sched->topped = true;
+			}
+
+			if (pq->deficit >= pq->entries[pq->head].length)
+			{
+				pq->deficit -= pq->entries[pq->head].length;
+				scheduler_pop(pq, output, outlen, raw);
+				res = true;
+
+				if (pq->count == 0U)
+				{
+					pq->deficit = 0U;
+					scheduler_advance(sched);
+				}
+			}
+			else
+			{
+				scheduler_advance(sched);
+			}
+		}
+	}
+
+	return res;
+}
+
+bool skdp_scheduler_dequeue(skdp_scheduler* sched, uint8_t* output, size_t* outlen, bool* raw)
+{
+	SKDP_ASSERT(sched != NULL);
+	SKDP_ASSERT(output != NULL);
+	SKDP_ASSERT(outlen != NULL);
+	SKDP_ASSERT(raw != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (sched != NULL && output != NULL && outlen != NULL && raw != NULL && sched->mtx != NULL)
+	{
+		*outlen = 0U;
+		*raw = false;
+		qsc_async_mutex_lock(sched->mtx);
+
+		/* control records have strict priority */
+		if (sched->queues[skdp_scheduler_class_control].count != 0U)
+		{
+			scheduler_pop(&sched->queues[skdp_scheduler_class_control], output, outlen, raw);
+			res = true;
+		}
+		else
+		{
+			res = scheduler_weighted(sched, output, outlen, raw);
+		}
+
+		qsc_async_mutex_unlock(sched->mtx);
+	}
+
+	return res;
+}
+
+void skdp_scheduler_dispose(skdp_scheduler* sched)
+{
+	SKDP_ASSERT(sched != NULL);
+
+	size_t i;
+
+	if (sched != NULL)
+	{
+		for (i = 0U; i < SKDP_SCHEDULER_CLASSES; ++i)
+		{
+			if (sched->queues[i].slots != NULL)
+			{
+				qsc_memutils_secure_erase(sched->queues[i].slots, sched->queues[i].depth * SKDP_MESSAGE_MAX);
+				qsc_memutils_alloc_free(sched->queues[i].slots);
+			}
+
+			if (sched->queues[i].entries != NULL)
+			{
+				qsc_memutils_alloc_free(sched->queues[i].entries);
+			}
+		}
+
+		if (sched->mtx != NULL)
+		{
+			qsc_async_mutex_destroy(sched->mtx);
+		}
+
+		qsc_memutils_clear(sched, sizeof(skdp_scheduler));
+	}
+}
+
+bool skdp_scheduler_enqueue(skdp_scheduler* sched, skdp_scheduler_classes sclass, const uint8_t* message, size_t msglen)
+{
+	SKDP_ASSERT(sched != NULL);
+	SKDP_ASSERT(message != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (sched != NULL && message != NULL && sched->mtx != NULL && (size_t)sclass < SKDP_SCHEDULER_CLASSES && msglen <= SKDP_MESSAGE_SIZE)
+	{
+		qsc_async_mutex_lock(sched->mtx);
+		res = scheduler_push(&sched->queues[sclass], message, msglen, false);
+		qsc_async_mutex_unlock(sched->mtx);
+	}
+
+	return res;
+}
+
+bool skdp_scheduler_enqueue_packet(skdp_scheduler* sched, const skdp_network_packet* packet)
+{
+	SKDP_ASSERT(sched != NULL);
+	SKDP_ASSERT(packet != NULL);
+
+	uint8_t spkt[SKDP_MESSAGE_MAX] = { 0U };
+	size_t plen;
+	bool res;
+
+	res = false;
+
+	if (sched != NULL && packet != NULL && sched->mtx != NULL && packet->msglen <= SKDP_MESSAGE_SIZE)
+	{
+		plen = skdp_packet_to_stream(packet, spkt);
+		qsc_async_mutex_lock(sched->mtx);
+		res = scheduler_push(&sched->queues[skdp_scheduler_class_control], spkt, plen, true);
+		qsc_async_mutex_unlock(sched->mtx);
+	}
+
+	return res;
+}
+
+bool skdp_scheduler_initialize(skdp_scheduler* sched, size_t depth, uint32_t iweight, uint32_t bweight)
+{
+	SKDP_ASSERT(sched != NULL);
+
+	skdp_scheduler_queue* pq;
+	size_t i;
+	bool res;
+
+	res = false;
+
+	if (sched != NULL && iweight != 0U)
+	{
+		qsc_memutils_clear(sched, sizeof(skdp_scheduler));
+		depth = (depth != 0U) ? depth : SKDP_SCHEDULER_DEPTH;
+		res = true;
+
+		for (i = 0U; i < SKDP_SCHEDULER_CLASSES; ++i)
+		{
+			pq = &sched->queues[i];
+			pq->depth = depth;
+			pq->slots = (uint8_t*)qsc_memutils_malloc(depth * SKDP_MESSAGE_MAX);
+			pq->entries = (skdp_scheduler_entry*)qsc_memutils_malloc(depth * sizeof(skdp_scheduler_entry));
+
+			if (pq->slots == NULL || pq->entries == NULL)
+			{
+				res = false;
+				break;
+			}
+
+			qsc_memutils_clear(pq->slots, depth * SKDP_MESSAGE_MAX);
+			qsc_memutils_clear(pq->entries, depth * sizeof(skdp_scheduler_entry));
+		}
+
+		sched->queues[skdp_scheduler_class_interactive].quantum = (size_t)iweight * SKDP_MESSAGE_MAX;
+		sched->queues[skdp_scheduler_class_bulk].quantum = (size_t)bweight * SKDP_MESSAGE_MAX;
+		sched->current = skdp_scheduler_class_interactive;
+
+		if (res == true)
+		{
+			sched->mtx = qsc_async_mutex_create();
+			res = (sched->mtx != NULL);
+		}
+
+		if (res == false)
+		{
+			skdp_scheduler_dispose(sched);
+		}
+	}
+
+	return res;
+}
+
+size_t skdp_scheduler_pending(skdp_scheduler* sched)
+{
+	SKDP_ASSERT(sched != NULL);
+
+	size_t i;
+	size_t cnt;
+
+	cnt = 0U;
+
+	if (sched != NULL && sched->mtx != NULL)
+	{
+		qsc_async_mutex_lock(sched->mtx);
+
+		for (i = 0U; i < SKDP_SCHEDULER_CLASSES; ++i)
+		{
+			cnt += sched->queues[i].count;
+		}
+
+		qsc_async_mutex_unlock(sched->mtx);
+	}
+
+	return cnt;
+}
@@ -0,0 +1,212 @@
+/* 2021-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SKDP_SCHEDULER_H
+#define SKDP_SCHEDULER_H
+
+#include "skdpcommon.h"
+#include "skdp.h"
+#include "async.h"
+
+/**
+ * \file skdpscheduler.h
+ * \brief The SKDP outbound record scheduler.
+ *
+ * \details
+ * This header defines a per-session send scheduler that interleaves outbound records of different priority at record
+ * granularity, so that a command does not wait behind megabytes of queued bulk data.
+ *
+ * Records are queued as plaintext and encrypted by the caller when they are dequeued. The channel sequence number and
+ * the packet time are assigned at encryption, so records can be reordered between classes without breaking the
+ * receiver's sequence check. Unsequenced control packets, keep-alive and connection-terminate, are queued already
+ * serialized and sent as they are.
+ *
+ * There are three classes:
+ * - control: strict priority; keep-alive and terminate packets, and control messages such as stream open, close,
+ * and window frames. Control records always go ahead of interactive and bulk data.
+ * - interactive and bulk: served by deficit round-robin with a quantum of weight times \c SKDP_MESSAGE_MAX bytes.
+ * A newly queued interactive record waits for at most one bulk quantum. A zero bulk weight gives interactive
+ * records strict priority over bulk.
+ *
+ * Each class is a fixed-depth ring allocated at initialization; enqueue fails when a ring is full, which is the
+ * back-pressure signal to the producer. The scheduler is safe for concurrent producers and one sending thread.
+ */
+
+/*!
+ * \def SKDP_SCHEDULER_CLASSES
+ * \brief The number of scheduler classes.
+ */
+#define SKDP_SCHEDULER_CLASSES 3U
+
+/*!
+ * \def SKDP_SCHEDULER_DEPTH
+ * \brief The default number of records queued per class.
+ */
+#define SKDP_SCHEDULER_DEPTH 64U
+
+/*!
+ * \enum skdp_scheduler_classes
+ * \brief The scheduler priority classes.
+ */
+SKDP_EXPORT_API typedef enum skdp_scheduler_classes
+{
+	skdp_scheduler_class_control = 0x00U,		/*!< Strict priority control records and packets */
+	skdp_scheduler_class_interactive = 0x01U,	/*!< Latency sensitive records, weighted */
+	skdp_scheduler_class_bulk = 0x02U,			/*!< Throughput records, weighted */
+} skdp_scheduler_classes;
+
+/*!
+ * \struct skdp_scheduler_entry
+ * \brief A queued record descriptor.
+ */
+SKDP_EXPORT_API typedef struct skdp_scheduler_entry
+{
+	uint32_t length;							/*!< The record length */
+	bool raw;									/*!< The record is a serialized packet, sent without encryption */
+} skdp_scheduler_entry;
+
+/*!
+ * \struct skdp_scheduler_queue
+ * \brief A scheduler class ring.
+ */
+SKDP_EXPORT_API typedef struct skdp_scheduler_queue
+{
+	uint8_t* slots;								/*!< The record storage, depth slots of SKDP_MESSAGE_MAX bytes */
+	skdp_scheduler_entry* entries;				/*!< The record descriptors */
+	size_t count;								/*!< The number of queued records */
+	size_t deficit;								/*!< The round-robin byte deficit */
+	size_t depth;								/*!< The ring depth */
+	size_t head;								/*!< The ring head index */
+	size_t quantum;								/*!< The round-robin quantum in bytes, zero for strict lowest priority */
+} skdp_scheduler_queue;
+
+/*!
+ * \struct skdp_scheduler
+ * \brief The SKDP send scheduler state.
+ */
+SKDP_EXPORT_API typedef struct skdp_scheduler
+{
+	skdp_scheduler_queue queues[SKDP_SCHEDULER_CLASSES];	/*!< The class rings */
+	qsc_mutex mtx;								/*!< The queue mutex */
+	size_t current;								/*!< The weighted class being served */
+	bool topped;								/*!< The current class received its quantum for this visit */
+} skdp_scheduler;
+
+/*!
+ * \brief Remove the next record to send.
+ *
+ * \details
+ * If \c raw is false on return, the output is a plaintext message to be sealed with the session encrypt function;
+ * otherwise it is a serialized packet to be sent as it is.
+ *
+ * \param sched A pointer to the scheduler state.
+ * \param output The output buffer, at least \c SKDP_MESSAGE_MAX bytes.
+ * \param outlen A pointer receiving the record length.
+ * \param raw A pointer receiving the record type.
+ *
+ * \return Returns true if a record was dequeued, false if the scheduler is empty.
+ */
+SKDP_EXPORT_API bool skdp_scheduler_dequeue(skdp_scheduler* sched, uint8_t* output, size_t* outlen, bool* raw);
+
+/*!
+ * \brief Dispose of the scheduler and release its memory; queued records are discarded.
+ *
+ * \param sched A pointer to the scheduler state.
+ */
+SKDP_EXPORT_API void skdp_scheduler_dispose(skdp_scheduler* sched);
+
+/*!
+ * \brief Queue a plaintext message in a class.
+ *
+ * \param sched A pointer to the scheduler state.
+ * \param sclass The priority class.
+ * \param message [const] The plaintext message.
+ * \param msglen The message length, at most \c SKDP_MESSAGE_SIZE.
+ *
+ * \return Returns true if the message was queued, false if the class ring is full.
+ */
+SKDP_EXPORT_API bool skdp_scheduler_enqueue(skdp_scheduler* sched, skdp_scheduler_classes sclass, const uint8_t* message, size_t msglen);
+
+/*!
+ * \brief Queue an unsequenced control packet, a keep-alive or connection-terminate packet.
+ *
+ * \details
+ * The packet is serialized into the control class and is sent ahead of all interactive and bulk records.
+ *
+ * \param sched A pointer to the scheduler state.
+ * \param packet [const] The packet.
+ *
+ * \return Returns true if the packet was queued.
+ */
+SKDP_EXPORT_API bool skdp_scheduler_enqueue_packet(skdp_scheduler* sched, const skdp_network_packet* packet);
+
+/*!
+ * \brief Initialize the scheduler.
+ *
+ * \param sched A pointer to the scheduler state.
+ * \param depth The number of records queued per class, zero selects \c SKDP_SCHEDULER_DEPTH.
+ * \param iweight The interactive class weight, at least one.
+ * \param bweight The bulk class weight; zero gives interactive records strict priority over bulk.
+ *
+ * \return Returns true if the scheduler was initialized.
+ */
+SKDP_EXPORT_API bool skdp_scheduler_initialize(skdp_scheduler* sched, size_t depth, uint32_t iweight, uint32_t bweight);
+
+/*!
+ * \brief Get the number of queued records.
+ *
+ * \param sched A pointer to the scheduler state.
+ *
+ * \return Returns the number of records queued in all classes.
+ */
+SKDP_EXPORT_API size_t skdp_scheduler_pending(skdp_scheduler* sched);
+
+#endif
@@ -1,11 +1,10 @@
 #include "skdpserver.h"
-#include "acp.h"
+#include "skdpdrbg.h"
 #include "intutils.h"
 #include "memutils.h"
 #include "sha3.h"
 #include "socket.h"
 #include "socketserver.h"
-#include "stringutils.h"
 #include "timestamp.h"
 
 static void server_dispose(skdp_server_state* ctx)
@@ -16,6 +15,16 @@ static void server_dispose(skdp_server_state* ctx)
 	{
 		skdp_cipher_dispose(&ctx->rxcpr);
 		skdp_cipher_dispose(&ctx->txcpr);
+		qsc_memutils_secure_erase(&ctx->rtcpr, sizeof(skdp_cipher_state));
+		qsc_memutils_secure_erase(ctx->kupdate.rxsec, SKDP_KEY_UPDATE_SECRET_SIZE);
+		qsc_memutils_secure_erase(ctx->kupdate.txsec, SKDP_KEY_UPDATE_SECRET_SIZE);
+		qsc_memutils_clear(ctx->cid, SKDP_CONNECTION_ID_SIZE);
+		qsc_memutils_clear(ctx->pcid, SKDP_CONNECTION_ID_SIZE);
+		qsc_memutils_clear(ctx->rtresp, sizeof(ctx->rtresp));
+		ctx->rtrxseq = 0U;
+		ctx->rttxseq = 0U;
+		ctx->kupdate.txbytes = 0U;
+		ctx->kupdate.txrecords = 0U;
 		ctx->exflag = skdp_flag_none;
 		ctx->rxseq = 0U;
 		ctx->txseq = 0U;
@@ -37,9 +46,160 @@ static void server_kex_reset(skdp_server_state* ctx)
 	}
 }
 
+static void server_key_refresh(skdp_server_state* ctx, const uint8_t* did)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(did != NULL);
+
+	skdp_server_key skey = { 0 };
+
+	if (ctx->kstore != NULL)
+	{
+		/* select the server key addressed by the device identity */
+		if (skdp_keystore_find(ctx->kstore, did, &skey) == true)
+		{
+			qsc_memutils_copy(ctx->kid, skey.kid, SKDP_KID_SIZE);
+			qsc_memutils_copy(ctx->sdk, skey.sdk, SKDP_SDK_SIZE);
+			ctx->expiration = skey.expiration;
+		}
+		else
+		{
+			/* an unknown identity fails the server id comparison, and the zero expiration */
+			qsc_memutils_secure_erase(ctx->kid, SKDP_KID_SIZE);
+			qsc_memutils_secure_erase(ctx->sdk, SKDP_SDK_SIZE);
+			ctx->expiration = 0U;
+		}
+
+		qsc_memutils_secure_erase(&skey, sizeof(skdp_server_key));
+	}
+	else if (ctx->keyset != NULL)
+	{
+		/* pick up the currently published server key for this handshake */
+		if (skdp_keyset_acquire(ctx->keyset, &skey) == true)
+		{
+			qsc_memutils_copy(ctx->kid, skey.kid, SKDP_KID_SIZE);
+			qsc_memutils_copy(ctx->sdk, skey.sdk, SKDP_SDK_SIZE);
+			ctx->expiration = skey.expiration;
+		}
+
+		qsc_memutils_secure_erase(&skey, sizeof(skdp_server_key));
+	}
+}
+
+static void server_cookie_mac(const skdp_server_state* ctx, const uint8_t* cookie, uint8_t* tag)
+{
+	qsc_keccak_state kctx = { 0 };
+
+	/* tag = KMAC(ckey, time || suite || did || dsh || ssh) */
+	qsc_kmac_initialize(&kctx, SKDP_PERMUTATION_RATE, ctx->ckey, SKDP_COOKIE_KEY_SIZE, (const uint8_t*)SKDP_CONFIG_STRING, SKDP_CONFIG_SIZE);
+	qsc_kmac_update(&kctx, SKDP_PERMUTATION_RATE, cookie, SKDP_COOKIE_SIZE - SKDP_COOKIE_TAG_SIZE);
+	qsc_kmac_finalize(&kctx, SKDP_PERMUTATION_RATE, tag, SKDP_COOKIE_TAG_SIZE);
+	qsc_memutils_secure_erase(&kctx, sizeof(qsc_keccak_state));
+}
+
+static void server_cookie_create(skdp_server_state* ctx, uint8_t* cookie)
+{
+	size_t pos;
+
+	/* encode the half-open handshake state, then release it */
+	qsc_intutils_le64to8(cookie, qsc_timestamp_epochtime_seconds());
+	pos = SKDP_EXP_SIZE;
+	cookie[pos] = (uint8_t)ctx->suite->id;
+	pos += 1U;
+	qsc_memutils_copy(cookie + pos, ctx->did, SKDP_KID_SIZE);
+	pos += SKDP_KID_SIZE;
+	qsc_memutils_copy(cookie + pos, ctx->dsh, SKDP_STH_SIZE);
+	pos += SKDP_STH_SIZE;
+	qsc_memutils_copy(cookie + pos, ctx->ssh, SKDP_STH_SIZE);
+	pos += SKDP_STH_SIZE;
+	server_cookie_mac(ctx, cookie, cookie + pos);
+
+	qsc_memutils_secure_erase(ctx->did, SKDP_KID_SIZE);
+	qsc_memutils_secure_erase(ctx->dsh, SKDP_STH_SIZE);
+	qsc_memutils_secure_erase(ctx->ssh, SKDP_STH_SIZE);
+}
+
+static skdp_errors server_cookie_restore(skdp_server_state* ctx, const uint8_t* cookie)
+{
+	uint8_t tag[SKDP_COOKIE_TAG_SIZE] = { 0U };
+	const skdp_cipher_suite* suite;
+	uint64_t ctime;
+	uint64_t ltime;
+	size_t pos;
+	skdp_errors err;
+
+	server_cookie_mac(ctx, cookie, tag);
+
+	if (qsc_intutils_verify(tag, cookie + (SKDP_COOKIE_SIZE - SKDP_COOKIE_TAG_SIZE), SKDP_COOKIE_TAG_SIZE) == 0)
+	{
+		ctime = qsc_intutils_le8to64(cookie);
+		ltime = qsc_timestamp_epochtime_seconds();
+
+		/* an abandoned handshake simply expires */
+		if (ctime <= ltime && ltime - ctime <= SKDP_COOKIE_LIFETIME)
+		{
+			pos = SKDP_EXP_SIZE;
+			suite = skdp_cipher_suite_from_id((skdp_suite_id)cookie[pos]);
+			pos += 1U;
+
+			if (suite != NULL)
+			{
+				ctx->suite = suite;
+				qsc_memutils_copy(ctx->did, cookie + pos, SKDP_KID_SIZE);
+				pos += SKDP_KID_SIZE;
+				qsc_memutils_copy(ctx->dsh, cookie + pos, SKDP_STH_SIZE);
+				pos += SKDP_STH_SIZE;
+				qsc_memutils_copy(ctx->ssh, cookie + pos, SKDP_STH_SIZE);
+				err = skdp_error_none;
+			}
+			else
+			{
+				err = skdp_error_unknown_protocol;
+			}
+		}
+		else
+		{
+			err = skdp_error_packet_expired;
+		}
+	}
+	else
+	{
+		err = skdp_error_kex_auth_failure;
+	}
+
+	return err;
+}
+
+static skdp_errors server_device_admit(const skdp_server_state* ctx)
+{
+	skdp_errors err;
+
+	/* the device checks of the connect response, repeated on a restored cookie; the device may have been revoked,
+	   or the server key rotated or expired, while the handshake state was held by the device */
+	if (ctx->revoked != NULL && skdp_revocation_contains(ctx->revoked, ctx->did) == true)
+	{
+		err = skdp_error_device_revoked;
+	}
+	else if (qsc_intutils_are_equal8(ctx->kid, ctx->did, SKDP_SID_SIZE) == false)
+	{
+		err = skdp_error_key_not_recognized;
+	}
+	else if (qsc_timestamp_epochtime_seconds() >= ctx->expiration)
+	{
+		err = skdp_error_invalid_input;
+	}
+	else
+	{
+		err = skdp_error_none;
+	}
+
+	return err;
+}
+
 static skdp_errors server_connect_response(skdp_server_state* ctx, const skdp_network_packet* packetin, skdp_network_packet* packetout)
 {
 	uint8_t dcfg[SKDP_CONFIG_SIZE + 1U] = { 0U };
+	const skdp_cipher_suite* suite;
 	skdp_errors err;
 
 	err = skdp_error_none;
@@ -48,12 +208,22 @@ static skdp_errors server_connect_response(skdp_server_state* ctx, const skdp_ne
 	qsc_memutils_copy(ctx->did, packetin->pmessage, SKDP_KID_SIZE);
 	qsc_memutils_copy(dcfg, packetin->pmessage + SKDP_KID_SIZE, SKDP_CONFIG_SIZE);
 
+	/* refuse a revoked device before any transcript hashing or token generation */
+	if (ctx->revoked != NULL && skdp_revocation_contains(ctx->revoked, ctx->did) == true)
+	{
+		ctx->exflag = skdp_flag_none;
+		err = skdp_error_device_revoked;
+	}
 	/* test for a matching server id contained in the client id */
-	if (qsc_intutils_are_equal8(ctx->kid, ctx->did, SKDP_SID_SIZE) == true)
+	else if (qsc_intutils_are_equal8(ctx->kid, ctx->did, SKDP_SID_SIZE) == true)
 	{
-		/* compare for equivalent configuration strings */
-		if (qsc_stringutils_compare_strings((char*)dcfg, SKDP_CONFIG_STRING, SKDP_CONFIG_SIZE) == true)
+		/* negotiate the cipher suite offered in the configuration string */
+		suite = skdp_cipher_suite_from_config((const char*)dcfg);
+
+		if (suite != NULL)
 		{
+			ctx->suite = suite;
+
 			if (qsc_timestamp_epochtime_seconds() < ctx->expiration)
 			{
 				qsc_keccak_state kctx = { 0 };
@@ -66,11 +236,11 @@ static skdp_errors server_connect_response(skdp_server_state* ctx, const skdp_ne
 				qsc_sha3_finalize(&kctx, SKDP_PERMUTATION_RATE, ctx->dsh);
 
 				/* generate the server session token */
-				if (qsc_acp_generate(stok, SKDP_DTK_SIZE) == true)
+				if (skdp_drbg_generate(stok, SKDP_DTK_SIZE) == true)
 				{
 					/* assign the packet parameters */
 					qsc_memutils_copy(packetout->pmessage, ctx->kid, SKDP_KID_SIZE);
-					qsc_memutils_copy(packetout->pmessage + SKDP_KID_SIZE, SKDP_CONFIG_STRING, SKDP_CONFIG_SIZE);
+					qsc_memutils_copy(packetout->pmessage + SKDP_KID_SIZE, ctx->suite->config, SKDP_CONFIG_SIZE);
 					qsc_memutils_copy(packetout->pmessage + SKDP_KID_SIZE + SKDP_CONFIG_SIZE, stok, SKDP_STOK_SIZE);
 
 					packetout->flag = skdp_flag_connect_response;
@@ -83,6 +253,14 @@ static skdp_errors server_connect_response(skdp_server_state* ctx, const skdp_ne
 					qsc_sha3_finalize(&kctx, SKDP_PERMUTATION_RATE, ctx->ssh);
 
 					ctx->exflag = skdp_flag_connect_response;
+
+					if (ctx->ckey != NULL)
+					{
+						/* cookie mode; the server keeps no transcript state until the exchange request */
+						server_cookie_create(ctx, packetout->pmessage + packetout->msglen);
+						packetout->flag = skdp_flag_connect_cookie;
+						packetout->msglen += SKDP_COOKIE_SIZE;
+					}
 				}
 				else
 				{
@@ -117,6 +295,7 @@ static skdp_errors server_exchange_response(skdp_server_state* ctx, const skdp_n
 	qsc_keccak_state kctx = { 0 };
 	uint8_t ddk[SKDP_DDK_SIZE] = { 0U };
 	uint8_t shdr[SKDP_HEADER_SIZE] = { 0U };
+	uint8_t rkey[SKDP_REPLAY_KEY_SIZE] = { 0U };
 	uint8_t prnd[QSC_KECCAK_STATE_BYTE_SIZE] = { 0U };
 	uint8_t tmac[SKDP_MACTAG_SIZE] = { 0U };
 	skdp_errors err;
@@ -124,8 +303,44 @@ static skdp_errors server_exchange_response(skdp_server_state* ctx, const skdp_n
 	err = skdp_error_none;
 	ctx->exflag = skdp_flag_none;
 
+	if (ctx->ckey != NULL)
+	{
+		/* cookie mode; recover the handshake state from the echoed cookie */
+		if (packetin->flag == skdp_flag_exchange_cookie && packetin->msglen == SKDP_EXCHANGE_REQUEST_MESSAGE_SIZE + SKDP_COOKIE_SIZE)
+		{
+			err = server_cookie_restore(ctx, packetin->pmessage + SKDP_EXCHANGE_REQUEST_MESSAGE_SIZE);
+
+			if (err == skdp_error_none)
+			{
+				server_key_refresh(ctx, ctx->did);
+				err = server_device_admit(ctx);
+			}
+		}
+		else
+		{
+			err = skdp_error_invalid_input;
+		}
+	}
+
 	/* change 1.1 anti-replay; packet valid-time verification */
-	if (skdp_packet_time_valid(packetin) == true)
+	if (err == skdp_error_none && skdp_packet_time_valid(packetin) == false)
+	{
+		err = skdp_error_packet_expired;
+	}
+
+	if (err == skdp_error_none && ctx->replay != NULL)
+	{
+		/* reject a replayed exchange request before any derivation work; the key is recorded once the mac verifies */
+		qsc_memutils_copy(rkey, ctx->dsh, SKDP_REPLAY_KEY_SIZE);
+		qsc_memutils_xor(rkey, packetin->pmessage + SKDP_DTK_SIZE, SKDP_REPLAY_KEY_SIZE);
+
+		if (skdp_replay_contains(ctx->replay, rkey) == true)
+		{
+			err = skdp_error_kex_auth_failure;
+		}
+	}
+
+	if (err == skdp_error_none)
 	{
 		/* derive the client's device key */
 		qsc_cshake_initialize(&kctx, SKDP_PERMUTATION_RATE, ctx->sdk, SKDP_SDK_SIZE, (const uint8_t*)SKDP_CONFIG_STRING, SKDP_CONFIG_SIZE, ctx->did, SKDP_KID_SIZE);
@@ -145,14 +360,15 @@ static skdp_errors server_exchange_response(skdp_server_state* ctx, const skdp_n
 		skdp_packet_header_serialize(packetin, shdr);
 		/* change 1.1 anti-replay; add the packet time to the mac */
 		qsc_kmac_update(&kctx, SKDP_PERMUTATION_RATE, shdr, SKDP_HEADER_SIZE);
-		qsc_kmac_finalize(&kctx, SKDP_PERMUTATION_RATE, tmac, SKDP_MACTAG_SIZE);
+		qsc_kmac_finalize(&kctx, SKDP_PERMUTATION_RATE, tmac, ctx->suite->tagsize);
 
 		/* compare the mac tag to the one appended to the cipher-text */
-		if (qsc_intutils_verify(packetin->pmessage + SKDP_DTK_SIZE, tmac, SKDP_MACTAG_SIZE) == 0)
+		/* a concurrent replay of the same request is caught when its key is recorded */
+		if (qsc_intutils_verify(packetin->pmessage + SKDP_DTK_SIZE, tmac, ctx->suite->tagsize) == 0 &&
+			(ctx->replay == NULL || skdp_replay_insert(ctx->replay, rkey) == true))
 		{
 			uint8_t dtk[SKDP_DTK_SIZE] = { 0U };
 			uint8_t stk[SKDP_STK_SIZE] = { 0U };
-			skdp_cipher_keyparams kp;
 
 			/* decrypt the device token key */
 			qsc_memutils_copy(dtk, packetin->pmessage, SKDP_DTK_SIZE);
@@ -163,20 +379,14 @@ static skdp_errors server_exchange_response(skdp_server_state* ctx, const skdp_n
 			qsc_cshake_squeezeblocks(&kctx, SKDP_PERMUTATION_RATE, prnd, RNDBLK);
 
 			/* initialize the symmetric cipher, and raise server channel-1 rx */
-			kp.key = prnd;
-			kp.keylen = SKDP_CPRKEY_SIZE;
-			kp.nonce = (prnd + SKDP_CPRKEY_SIZE);
-#if !defined(SKDP_USE_RCS_ENCRYPTION)
-			kp.noncelen = SKDP_NONCE_SIZE;
-#endif
-			kp.info = NULL;
-			kp.infolen = 0U;
-			skdp_cipher_initialize(&ctx->rxcpr, &kp, false);
+			skdp_cipher_initialize(&ctx->rxcpr, ctx->suite, prnd, prnd + ctx->suite->keysize, false);
+			skdp_key_update_derive(ctx->kupdate.rxsec, dtk, SKDP_DTK_SIZE, ctx->dsh);
+			qsc_memutils_secure_erase(dtk, sizeof(dtk));
 
 			/* create a new secret token used to key channel-2, encrypt, mac, and send to client */
 
 			/* generate the session token random */
-			if (qsc_acp_generate(stk, SKDP_STK_SIZE) == true)
+			if (skdp_drbg_generate(stk, SKDP_STK_SIZE) == true)
 			{
 				/* generate the cipher key and nonce */
 				qsc_memutils_clear(prnd, SKDP_PERMUTATION_RATE);
@@ -184,15 +394,10 @@ static skdp_errors server_exchange_response(skdp_server_state* ctx, const skdp_n
 				qsc_cshake_squeezeblocks(&kctx, SKDP_PERMUTATION_RATE, prnd, RNDBLK);
 
 				/* initialize the symmetric cipher, and raise server channel-2 tx */
-				kp.key = prnd;
-				kp.keylen = SKDP_CPRKEY_SIZE;
-				kp.nonce = (prnd + SKDP_CPRKEY_SIZE);
-#if !defined(SKDP_USE_RCS_ENCRYPTION)
-				kp.noncelen = SKDP_NONCE_SIZE;
-#endif
-				kp.info = NULL;
-				kp.infolen = 0U;
-				skdp_cipher_initialize(&ctx->txcpr, &kp, true);
+				skdp_cipher_initialize(&ctx->txcpr, ctx->suite, prnd, prnd + ctx->suite->keysize, true);
+				skdp_key_update_derive(ctx->kupdate.txsec, stk, SKDP_STK_SIZE, ctx->ssh);
+				ctx->kupdate.txbytes = 0U;
+				ctx->kupdate.txrecords = 0U;
 
 				/* generate the encryption and mac keys */
 				qsc_memutils_clear(prnd, SKDP_PERMUTATION_RATE);
@@ -217,7 +422,7 @@ static skdp_errors server_exchange_response(skdp_server_state* ctx, const skdp_n
 				skdp_packet_header_serialize(packetout, shdr);
 				/* change 1.1 anti-replay; add the packet time to the mac */
 				qsc_kmac_update(&kctx, SKDP_PERMUTATION_RATE, shdr, SKDP_HEADER_SIZE);
-				qsc_kmac_finalize(&kctx, SKDP_PERMUTATION_RATE, packetout->pmessage + SKDP_STK_SIZE, SKDP_MACTAG_SIZE);
+				qsc_kmac_finalize(&kctx, SKDP_PERMUTATION_RATE, packetout->pmessage + SKDP_STK_SIZE, ctx->suite->tagsize);
 				ctx->exflag = skdp_flag_exchange_response;
 
 				qsc_memutils_secure_erase(&kctx, sizeof(qsc_keccak_state));
@@ -233,10 +438,6 @@ static skdp_errors server_exchange_response(skdp_server_state* ctx, const skdp_n
 			err = skdp_error_kex_auth_failure;
 		}
 	}
-	else
-	{
-		err = skdp_error_packet_expired;
-	}
 
 	return err;
 }
@@ -250,21 +451,21 @@ static skdp_errors server_establish_response(skdp_server_state* ctx, const skdp_
 	err = skdp_error_none;
 
 	if (packetin->flag == skdp_flag_establish_request &&
-		packetin->msglen == SKDP_ESTABLISH_REQUEST_MESSAGE_SIZE)
+		packetin->msglen == SKDP_STH_SIZE + ctx->suite->tagsize)
 	{
 		/* serialize the packet header and add it to associated data */
 		skdp_packet_header_serialize(packetin, shdr);
 		skdp_cipher_set_associated(&ctx->rxcpr, shdr, SKDP_HEADER_SIZE);
 
 		/* authenticate and decrypt the cipher-text */
-		if (skdp_cipher_transform(&ctx->rxcpr, msg, packetin->pmessage, packetin->msglen - SKDP_MACTAG_SIZE) == true)
+		if (skdp_cipher_transform(&ctx->rxcpr, msg, packetin->pmessage, packetin->msglen - ctx->suite->tagsize) == true)
 		{
 			qsc_keccak_state kctx = { 0 };
 			uint8_t mhash[SKDP_HASH_SIZE] = { 0U };
 
 			/* assemble the establish-response packet */
 			packetout->flag = skdp_flag_establish_response;
-			packetout->msglen = SKDP_HASH_SIZE + SKDP_MACTAG_SIZE;
+			packetout->msglen = (uint32_t)(SKDP_HASH_SIZE + ctx->suite->tagsize);
 			packetout->sequence = ctx->txseq;
 
 			/* serialize the packet header and add it to the associated data */
@@ -298,250 +499,649 @@ static skdp_errors server_establish_response(skdp_server_state* ctx, const skdp_
 	return err;
 }
 
-static skdp_errors server_key_exchange(skdp_server_state* ctx, qsc_socket* sock)
+static size_t server_receive_packet(const skdp_transport* trans, uint8_t* output, size_t otplen)
 {
-	skdp_network_packet resp = { 0 };
-	skdp_network_packet reqt = { 0 };
-	uint8_t mreqt[SKDP_EXCHANGE_MAX_MESSAGE_SIZE] = { 0U };
-	uint8_t mresp[SKDP_EXCHANGE_MAX_MESSAGE_SIZE] = { 0U };
-	size_t rlen;
-	size_t slen;
-	skdp_errors err;
+	skdp_network_packet pkt = { 0 };
+	size_t res;
 
-	/* blocking receive waits for client */
-	rlen = qsc_socket_receive(sock, mreqt, SKDP_CONNECT_REQUEST_PACKET_SIZE, qsc_socket_receive_flag_wait_all);
+	res = 0U;
 
-	if (rlen == SKDP_CONNECT_REQUEST_PACKET_SIZE)
+	/* read the header, then the message length it declares */
+	if (skdp_transport_receive(trans, output, SKDP_HEADER_SIZE) == SKDP_HEADER_SIZE)
 	{
-		/* convert server response to packet */
-		skdp_packet_header_deserialize(mreqt, SKDP_HEADER_SIZE, &reqt);
-		reqt.pmessage = mreqt + SKDP_HEADER_SIZE;
+		skdp_packet_header_deserialize(output, SKDP_HEADER_SIZE, &pkt);
 
-		if (reqt.sequence == ctx->rxseq)
-		{
-			ctx->rxseq += 1U;
-
-			if (reqt.flag == skdp_flag_connect_request)
-			{
-				resp.pmessage = mresp + SKDP_HEADER_SIZE;
-				/* create the connection request packet */
-				err = server_connect_response(ctx, &reqt, &resp);
-				/* convert the header to bytes */
-				skdp_packet_header_serialize(&resp, mresp);
-			}
-			else
-			{
-				if (reqt.flag == skdp_flag_error_condition)
-				{
-					err = skdp_message_to_error(reqt.pmessage[0U]);
-				}
-				else
-				{
-					err = skdp_error_connection_failure;
-				}
-			}
-		}
-		else
+		if (pkt.msglen <= otplen - SKDP_HEADER_SIZE &&
+			skdp_transport_receive(trans, output + SKDP_HEADER_SIZE, pkt.msglen) == pkt.msglen)
 		{
-			err = skdp_error_unsequenced;
+			res = SKDP_HEADER_SIZE + pkt.msglen;
 		}
 	}
-	else
-	{
-		err = skdp_error_connection_failure;
-	}
-
-	if (err == skdp_error_none)
-	{
-		/* send the connection response */
-		slen = qsc_socket_send(sock, mresp, SKDP_CONNECT_RESPONSE_PACKET_SIZE, qsc_socket_send_flag_none);
-
-		if (slen == SKDP_CONNECT_RESPONSE_PACKET_SIZE)
-		{
-			/* blocking receive waits for client */
-			ctx->txseq += 1U;
-			rlen = qsc_socket_receive(sock, mreqt, SKDP_EXCHANGE_REQUEST_PACKET_SIZE, qsc_socket_receive_flag_wait_all);
 
-			if (rlen == SKDP_EXCHANGE_REQUEST_PACKET_SIZE)
-			{
-				skdp_packet_header_deserialize(mreqt, SKDP_HEADER_SIZE, &reqt);
-				reqt.pmessage = mreqt + SKDP_HEADER_SIZE;
+	return res;
+}
 
-				if (reqt.sequence == ctx->rxseq)
-				{
-					ctx->rxseq += 1U;
+static skdp_errors server_key_exchange(skdp_server_state* ctx, const skdp_transport* trans, const uint8_t* first)
+{
+	uint8_t mreqt[SKDP_SERVER_HANDSHAKE_BUFFER_SIZE] = { 0U };
+	uint8_t mresp[SKDP_SERVER_HANDSHAKE_BUFFER_SIZE] = { 0U };
+	size_t plen;
+	size_t rlen;
+	skdp_errors err;
 
-					if (reqt.flag == skdp_flag_exchange_request)
-					{
-						qsc_memutils_clear(mresp, sizeof(mresp));
-						/* create the establish response packet */
-						err = server_exchange_response(ctx, &reqt, &resp);
-						/* serialize the header to bytes */
-						skdp_packet_header_serialize(&resp, mresp);
-					}
-					else
-					{
-						/* get the error message */
-						if (reqt.flag == skdp_flag_error_condition)
-						{
-							err = skdp_message_to_error(reqt.pmessage[0U]);
-						}
-						else
-						{
-							err = skdp_error_establish_failure;
-						}
-					}
-				}
-				else
-				{
-					err = skdp_error_unsequenced;
-				}
-			}
-			else
-			{
-				err = skdp_error_receive_failure;
-			}
-		}
-		else
-		{
-			err = skdp_error_transmit_failure;
-		}
+	if (first != NULL)
+	{
+		/* the connect request was read by the registry listener */
+		qsc_memutils_copy(mreqt, first, SKDP_CONNECT_REQUEST_PACKET_SIZE);
+		rlen = SKDP_CONNECT_REQUEST_PACKET_SIZE;
 	}
 	else
 	{
-		err = skdp_error_connection_failure;
+		/* blocking receive waits for client */
+		rlen = skdp_transport_receive(trans, mreqt, SKDP_CONNECT_REQUEST_PACKET_SIZE);
 	}
 
-	if (err == skdp_error_none)
+	err = (rlen == SKDP_CONNECT_REQUEST_PACKET_SIZE) ? skdp_error_none : skdp_error_connection_failure;
+
+	/* each request is answered by the handshake step until the session is established */
+	while (err == skdp_error_none && ctx->exflag != skdp_flag_session_established)
 	{
-		/* send the connection response */
-		slen = qsc_socket_send(sock, mresp, SKDP_EXCHANGE_RESPONSE_PACKET_SIZE, qsc_socket_send_flag_none);
+		err = skdp_server_handshake(ctx, mreqt, rlen, mresp, sizeof(mresp), &plen);
 
-		if (slen == SKDP_EXCHANGE_RESPONSE_PACKET_SIZE)
+		if (err == skdp_error_none)
 		{
-			/* blocking receive waits for client */
-			ctx->txseq += 1U;
-			rlen = qsc_socket_receive(sock, mreqt, SKDP_ESTABLISH_REQUEST_PACKET_SIZE, qsc_socket_receive_flag_wait_all);
-
-			if (rlen == SKDP_ESTABLISH_REQUEST_PACKET_SIZE)
+			if (skdp_transport_send(trans, mresp, plen) != plen)
 			{
-				skdp_packet_header_deserialize(mreqt, SKDP_HEADER_SIZE, &reqt);
-				reqt.pmessage = mreqt + SKDP_HEADER_SIZE;
-
-				if (reqt.sequence == ctx->rxseq)
-				{
-					ctx->rxseq += 1U;
-
-					if (reqt.flag == skdp_flag_establish_request)
-					{
-						qsc_memutils_clear(mresp, sizeof(mresp));
-						/* create the establish response packet */
-						err = server_establish_response(ctx, &reqt, &resp);
-						skdp_packet_header_serialize(&resp, mresp);
-					}
-					else
-					{
-						/* get the error message */
-						if (reqt.flag == skdp_flag_error_condition)
-						{
-							err = skdp_message_to_error(reqt.pmessage[0U]);
-						}
-						else
-						{
-							err = skdp_error_establish_failure;
-						}
-					}
-				}
-				else
-				{
-					err = skdp_error_unsequenced;
-				}
+				err = skdp_error_transmit_failure;
+			}
+			else if (ctx->exflag != skdp_flag_session_established)
+			{
+				/* blocking receive waits for client */
+				rlen = server_receive_packet(trans, mreqt, sizeof(mreqt));
+				err = (rlen != 0U) ? skdp_error_none : skdp_error_receive_failure;
 			}
 			else
 			{
-				err = skdp_error_receive_failure;
+				/* the session is established */
 			}
 		}
-		else
-		{
-			err = skdp_error_transmit_failure;
-		}
 	}
-	else
+
+	if (err != skdp_error_none)
 	{
-		err = skdp_error_connection_failure;
+		skdp_transport_send_error(trans, err);
+		skdp_transport_close(trans);
+
+		server_kex_reset(ctx);
+		server_dispose(ctx);
 	}
 
+	return err;
+}
+
+static size_t server_registry_index(const skdp_server_registry* reg, const uint8_t* cid)
+{
+	/* the identifier is a pseudo-random function output, its first bytes index the table directly */
+	return (size_t)qsc_intutils_le8to64(cid) & (reg->capacity - 1U);
+}
+
+static size_t server_registry_find(const skdp_server_registry* reg, const uint8_t* cid)
+{
+	size_t pos;
+	size_t res;
 
-	if (err == skdp_error_none)
-	{
-		slen = qsc_socket_send(sock, mresp, SKDP_ESTABLISH_RESPONSE_PACKET_SIZE, qsc_socket_send_flag_none);
+	/* returns the slot indexed by the identifier, or the capacity if there is none */
+	res = reg->capacity;
+	pos = server_registry_index(reg, cid);
 
-		if (slen == SKDP_ESTABLISH_RESPONSE_PACKET_SIZE)
+	while (reg->slots[pos].state != NULL && res == reg->capacity)
+	{
+		if (qsc_memutils_are_equal(reg->slots[pos].cid, cid, SKDP_CONNECTION_ID_SIZE) == true)
 		{
-			ctx->txseq += 1U;
+			res = pos;
 		}
 		else
 		{
-			err = skdp_error_transmit_failure;
+			pos = (pos + 1U) & (reg->capacity - 1U);
 		}
 	}
 
-	server_kex_reset(ctx);
+	return res;
+}
 
-	if (err == skdp_error_none)
+static void server_registry_insert(skdp_server_registry* reg, skdp_server_state* ctx, const uint8_t* cid)
+{
+	size_t pos;
+
+	pos = server_registry_index(reg, cid);
+
+	while (reg->slots[pos].state != NULL)
 	{
-		ctx->exflag = skdp_flag_session_established;
+		pos = (pos + 1U) & (reg->capacity - 1U);
 	}
-	else
+
+	reg->slots[pos].state = ctx;
+	qsc_memutils_copy(reg->slots[pos].cid, cid, SKDP_CONNECTION_ID_SIZE);
+}
+
+static void server_registry_erase(skdp_server_registry* reg, size_t pos)
+{
+	size_t home;
+	size_t next;
+	bool run;
+
+	/* backward-shift deletion keeps every probe sequence unbroken without tombstones */
+	qsc_memutils_clear(&reg->slots[pos], sizeof(skdp_server_registry_entry));
+	next = (pos + 1U) & (reg->capacity - 1U);
+	run = true;
+
+	while (reg->slots[next].state != NULL && run == true)
 	{
-		if (sock->connection_status == qsc_socket_state_connected)
+		home = server_registry_index(reg, reg->slots[next].cid);
+
+		/* move the entry back if its home position is not cyclically within (pos, next] */
+		if (((next - home) & (reg->capacity - 1U)) >= ((next - pos) & (reg->capacity - 1U)))
 		{
-			skdp_server_send_error(sock, err);
-			qsc_socket_shut_down(sock, qsc_socket_shut_down_flag_both);
+			reg->slots[pos] = reg->slots[next];
+			qsc_memutils_clear(&reg->slots[next], sizeof(skdp_server_registry_entry));
+			pos = next;
 		}
 
-		server_dispose(ctx);
+		next = (next + 1U) & (reg->capacity - 1U);
+		run = (next != pos);
 	}
-
-	return err;
 }
 
-void skdp_server_send_error(const qsc_socket* sock, skdp_errors error)
+static bool server_registry_unlink(skdp_server_registry* reg, const skdp_server_state* ctx, const uint8_t* cid)
 {
-	SKDP_ASSERT(sock != NULL);
+	size_t pos;
+	bool res;
 
-	if (sock != NULL)
-	{
-		if (qsc_socket_is_connected(sock) == true)
-		{
-			skdp_network_packet resp = { 0 };
-			uint8_t spct[SKDP_HEADER_SIZE + SKDP_ERROR_SIZE] = { 0U };
+	res = false;
+	pos = server_registry_find(reg, cid);
 
-			resp.flag = skdp_flag_error_condition;
-			resp.msglen = sizeof(uint8_t);
-			resp.sequence = SKDP_SEQUENCE_TERMINATOR;
-			skdp_packet_header_serialize(&resp, spct);
-			spct[SKDP_HEADER_SIZE] = (uint8_t)error;
-			qsc_socket_send(sock, spct, sizeof(spct), qsc_socket_send_flag_none);
-		}
+	if (pos != reg->capacity && reg->slots[pos].state == ctx)
+	{
+		server_registry_erase(reg, pos);
+		res = true;
 	}
+
+	return res;
 }
 
-skdp_errors skdp_server_send_keep_alive(skdp_keep_alive_state* kctx, const qsc_socket* sock)
+static void server_registry_rekey(skdp_server_registry* reg, skdp_server_state* ctx, const uint8_t* ocid)
 {
-	SKDP_ASSERT(kctx != NULL);
+	qsc_async_mutex_lock(reg->mtx);
+
+	/* the identifier before last is retired, the previous one stays indexed for a repeated request */
+	server_registry_unlink(reg, ctx, ocid);
+	server_registry_insert(reg, ctx, ctx->cid);
+
+	qsc_async_mutex_unlock(reg->mtx);
+}
 
+static skdp_errors server_reattach_verify(skdp_cipher_state* cpr, const uint8_t* first, const skdp_network_packet* reqt, const uint8_t* cid, size_t plen)
+{
+	uint8_t proof[SKDP_REATTACH_REQUEST_MESSAGE_SIZE] = { 0U };
 	skdp_errors err;
 
-	err = skdp_error_bad_keep_alive;
+	/* the proof is opened on a copy, so a forged request cannot advance the session cipher */
+	skdp_cipher_set_associated(cpr, first, SKDP_HEADER_SIZE);
 
-	if (kctx != NULL)
+	if (skdp_cipher_transform(cpr, proof, reqt->pmessage + SKDP_CONNECTION_ID_SIZE, plen) == true &&
+		qsc_intutils_verify(proof, cid, SKDP_CONNECTION_ID_SIZE) == 0)
 	{
-		if (qsc_socket_is_connected(sock) == true)
-		{
-			uint8_t spct[SKDP_HEADER_SIZE + SKDP_KEEPALIVE_MESSAGE] = { 0U };
-			skdp_network_packet resp = { 0 };
+		err = skdp_error_none;
+	}
+	else
+	{
+		err = skdp_error_cipher_auth_failure;
+	}
+
+	qsc_memutils_secure_erase(proof, sizeof(proof));
+
+	return err;
+}
+
+static skdp_errors server_reattach(skdp_server_registry* reg, const skdp_transport* trans, const uint8_t* first, skdp_server_state** session)
+{
+	skdp_network_packet resp = { 0 };
+	skdp_network_packet reqt = { 0 };
+	uint8_t hdr[SKDP_HEADER_SIZE] = { 0U };
+	uint8_t mresp[SKDP_HEADER_SIZE + SKDP_CONNECTION_ID_SIZE + SKDP_MACTAG_SIZE] = { 0U };
+	uint8_t ocid[SKDP_CONNECTION_ID_SIZE] = { 0U };
+	skdp_cipher_state rxcpr;
+	skdp_cipher_state txcpr;
+	skdp_server_state* sess;
+	size_t plen;
+	skdp_errors err;
+
+	skdp_packet_header_deserialize(first, SKDP_HEADER_SIZE, &reqt);
+	reqt.pmessage = (uint8_t*)first + SKDP_HEADER_SIZE;
+	sess = NULL;
+
+	if (reqt.msglen != SKDP_REATTACH_REQUEST_MESSAGE_SIZE)
+	{
+		err = skdp_error_invalid_input;
+	}
+	else if (skdp_packet_time_valid(&reqt) == true)
+	{
+		/* the session is claimed while the proof is checked, a session owned by another connection is refused */
+		sess = skdp_server_registry_take(reg, reqt.pmessage);
+
+		if (sess != NULL && sess->exflag == skdp_flag_session_established)
+		{
+			plen = SKDP_REATTACH_REQUEST_MESSAGE_SIZE - SKDP_CONNECTION_ID_SIZE - sess->suite->tagsize;
+			resp.pmessage = mresp + SKDP_HEADER_SIZE;
+
+			if (qsc_memutils_are_equal(reqt.pmessage, sess->cid, SKDP_CONNECTION_ID_SIZE) == true &&
+				reqt.sequence == sess->rxseq + 1U)
+			{
+				qsc_memutils_copy(&rxcpr, &sess->rxcpr, sizeof(skdp_cipher_state));
+				err = server_reattach_verify(&rxcpr, first, &reqt, sess->cid, plen);
+
+				if (err == skdp_error_none)
+				{
+					/* seal the identifier back to the device under the transmit channel */
+					qsc_memutils_copy(&txcpr, &sess->txcpr, sizeof(skdp_cipher_state));
+					resp.flag = skdp_flag_reattach_response;
+					resp.msglen = (uint32_t)(SKDP_CONNECTION_ID_SIZE + sess->suite->tagsize);
+					resp.sequence = sess->txseq + 1U;
+					skdp_packet_set_utc_time(&resp);
+					skdp_packet_header_serialize(&resp, hdr);
+					qsc_memutils_copy(mresp, hdr, SKDP_HEADER_SIZE);
+					skdp_cipher_set_associated(&txcpr, hdr, SKDP_HEADER_SIZE);
+					skdp_cipher_transform(&txcpr, resp.pmessage, sess->cid, SKDP_CONNECTION_ID_SIZE);
+					plen = SKDP_HEADER_SIZE + resp.msglen;
+
+					if (skdp_transport_send(trans, mresp, plen) == plen)
+					{
+						/* keep the prior receive state and the response, in case the response is lost */
+						qsc_memutils_copy(&sess->rtcpr, &sess->rxcpr, sizeof(skdp_cipher_state));
+						qsc_memutils_copy(sess->rtresp, mresp, plen);
+						qsc_memutils_copy(&sess->rxcpr, &rxcpr, sizeof(skdp_cipher_state));
+						qsc_memutils_copy(&sess->txcpr, &txcpr, sizeof(skdp_cipher_state));
+						sess->rxseq += 1U;
+						sess->txseq += 1U;
+						sess->rtrxseq = sess->rxseq;
+						sess->rttxseq = sess->txseq;
+
+						/* move to the next identifier, so the one sent in the clear is not reused */
+						qsc_memutils_copy(ocid, sess->pcid, SKDP_CONNECTION_ID_SIZE);
+						qsc_memutils_copy(sess->pcid, sess->cid, SKDP_CONNECTION_ID_SIZE);
+						skdp_connection_id_update(sess->cid, sess->kupdate.rxsec, sess->kupdate.txsec);
+						server_registry_rekey(reg, sess, ocid);
+
+						SKDP_ATOMIC_STORE_RELAXED(&sess->rxtime, skdp_clock_now());
+						*session = sess;
+					}
+					else
+					{
+						err = skdp_error_transmit_failure;
+					}
+
+					qsc_memutils_secure_erase(&txcpr, sizeof(skdp_cipher_state));
+				}
+
+				qsc_memutils_secure_erase(&rxcpr, sizeof(skdp_cipher_state));
+			}
+			else if (qsc_memutils_are_equal(reqt.pmessage, sess->pcid, SKDP_CONNECTION_ID_SIZE) == true &&
+				sess->rtrxseq != 0U && reqt.sequence == sess->rtrxseq && sess->rxseq == sess->rtrxseq &&
+				sess->txseq == sess->rttxseq)
+			{
+				/* the response to the last reattach was lost, and no record has moved either channel since */
+				qsc_memutils_copy(&rxcpr, &sess->rtcpr, sizeof(skdp_cipher_state));
+				err = server_reattach_verify(&rxcpr, first, &reqt, sess->pcid, plen);
+
+				if (err == skdp_error_none)
+				{
+					plen = SKDP_HEADER_SIZE + SKDP_CONNECTION_ID_SIZE + sess->suite->tagsize;
+
+					if (skdp_transport_send(trans, sess->rtresp, plen) == plen)
+					{
+						SKDP_ATOMIC_STORE_RELAXED(&sess->rxtime, skdp_clock_now());
+						*session = sess;
+					}
+					else
+					{
+						err = skdp_error_transmit_failure;
+					}
+				}
+
+				qsc_memutils_secure_erase(&rxcpr, sizeof(skdp_cipher_state));
+			}
+			else
+			{
+				err = skdp_error_unsequenced;
+			}
+		}
+		else
+		{
+			err = skdp_error_key_not_recognized;
+		}
+
+		if (sess != NULL && err != skdp_error_none)
+		{
+			/* the session stays registered for the device to retry */
+			skdp_server_registry_release(reg, sess);
+		}
+	}
+	else
+	{
+		err = skdp_error_packet_expired;
+	}
+
+	if (err != skdp_error_none)
+	{
+		skdp_transport_send_error(trans, err);
+		skdp_transport_close(trans);
+	}
+
+	return err;
+}
+
+static skdp_errors server_hibernate_verify(skdp_server_state* ctx, const skdp_network_packet* packetin)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(packetin != NULL);
+
+	uint8_t hdr[SKDP_HEADER_SIZE] = { 0U };
+	skdp_errors err;
+
+	if (packetin->sequence == ctx->rxseq + 1U)
+	{
+		if (packetin->flag == skdp_flag_hibernate_ack && packetin->msglen == ctx->suite->tagsize)
+		{
+			if (skdp_packet_time_valid(packetin) == true)
+			{
+				/* the acknowledgement is the last record the device seals under its current key */
+				skdp_packet_header_serialize(packetin, hdr);
+				skdp_cipher_set_associated(&ctx->rxcpr, hdr, SKDP_HEADER_SIZE);
+
+				if (skdp_cipher_transform(&ctx->rxcpr, hdr, packetin->pmessage, 0U) == true)
+				{
+					ctx->rxseq += 1U;
+					err = skdp_error_none;
+				}
+				else
+				{
+					ctx->exflag = skdp_flag_none;
+					err = skdp_error_cipher_auth_failure;
+				}
+			}
+			else
+			{
+				err = skdp_error_packet_expired;
+			}
+		}
+		else
+		{
+			err = skdp_error_invalid_input;
+		}
+	}
+	else
+	{
+		err = skdp_error_unsequenced;
+	}
+
+	return err;
+}
+
+static void server_session_encode(const skdp_server_state* ctx, uint8_t* output, uint8_t version)
+{
+	size_t pos;
+
+	/* version || suite || flag || reserved || rxsec || txsec || cid || counters;
+	   the secrets are the ones both sides ratchet from after the hibernate exchange */
+	output[0U] = version;
+	output[1U] = (uint8_t)ctx->suite->id;
+	output[2U] = (uint8_t)skdp_flag_session_established;
+	output[3U] = 0U;
+	pos = 4U;
+	qsc_memutils_copy(output + pos, ctx->kupdate.rxsec, SKDP_KEY_UPDATE_SECRET_SIZE);
+	pos += SKDP_KEY_UPDATE_SECRET_SIZE;
+	qsc_memutils_copy(output + pos, ctx->kupdate.txsec, SKDP_KEY_UPDATE_SECRET_SIZE);
+	pos += SKDP_KEY_UPDATE_SECRET_SIZE;
+	qsc_memutils_copy(output + pos, ctx->cid, SKDP_CONNECTION_ID_SIZE);
+	pos += SKDP_CONNECTION_ID_SIZE;
+	qsc_intutils_le64to8(output + pos, ctx->rxseq);
+	pos += sizeof(uint64_t);
+	qsc_intutils_le64to8(output + pos, ctx->txseq);
+	pos += sizeof(uint64_t);
+	qsc_intutils_le64to8(output + pos, SKDP_ATOMIC_LOAD_RELAXED(&ctx->rxtime));
+	pos += sizeof(uint64_t);
+	qsc_intutils_le64to8(output + pos, ctx->kupdate.maxbytes);
+	pos += sizeof(uint64_t);
+	qsc_intutils_le64to8(output + pos, ctx->kupdate.maxrecords);
+}
+
+static bool server_session_decode(skdp_server_state* ctx, const uint8_t* input, uint8_t version)
+{
+	const skdp_cipher_suite* suite;
+	size_t pos;
+	bool res;
+
+	res = false;
+	suite = skdp_cipher_suite_from_id((skdp_suite_id)input[1U]);
+
+	if (input[0U] == version && suite != NULL && input[2U] == (uint8_t)skdp_flag_session_established)
+	{
+		pos = 4U;
+		qsc_memutils_copy(ctx->kupdate.rxsec, input + pos, SKDP_KEY_UPDATE_SECRET_SIZE);
+		pos += SKDP_KEY_UPDATE_SECRET_SIZE;
+		qsc_memutils_copy(ctx->kupdate.txsec, input + pos, SKDP_KEY_UPDATE_SECRET_SIZE);
+		pos += SKDP_KEY_UPDATE_SECRET_SIZE;
+		qsc_memutils_copy(ctx->cid, input + pos, SKDP_CONNECTION_ID_SIZE);
+		pos += SKDP_CONNECTION_ID_SIZE;
+		ctx->rxseq = qsc_intutils_le8to64(input + pos);
+		pos += sizeof(uint64_t);
+		ctx->txseq = qsc_intutils_le8to64(input + pos);
+		pos += sizeof(uint64_t);
+		ctx->rxtime = qsc_intutils_le8to64(input + pos);
+		pos += sizeof(uint64_t);
+		ctx->kupdate.maxbytes = qsc_intutils_le8to64(input + pos);
+		pos += sizeof(uint64_t);
+		ctx->kupdate.maxrecords = qsc_intutils_le8to64(input + pos);
+		ctx->kupdate.txbytes = 0U;
+		ctx->kupdate.txrecords = 0U;
+
+		/* re-expand both channels to the keys the device moved to after its acknowledgement */
+		ctx->suite = suite;
+		ctx->rxcpr.suite = suite;
+		ctx->txcpr.suite = suite;
+		skdp_key_update_ratchet(&ctx->rxcpr, ctx->kupdate.rxsec, false);
+		skdp_key_update_ratchet(&ctx->txcpr, ctx->kupdate.txsec, true);
+		ctx->exflag = skdp_flag_session_established;
+		res = true;
+	}
+
+	return res;
+}
+
+void skdp_server_set_cookie_key(skdp_server_state* ctx, const uint8_t* ckey)
+{
+	SKDP_ASSERT(ctx != NULL);
+
+	if (ctx != NULL)
+	{
+		ctx->ckey = ckey;
+	}
+}
+
+void skdp_server_set_key_update(skdp_server_state* ctx, uint64_t maxrecords, uint64_t maxbytes)
+{
+	SKDP_ASSERT(ctx != NULL);
+
+	if (ctx != NULL)
+	{
+		ctx->kupdate.maxbytes = maxbytes;
+		ctx->kupdate.maxrecords = maxrecords;
+	}
+}
+
+void skdp_server_set_replay_cache(skdp_server_state* ctx, skdp_replay_cache* cache)
+{
+	SKDP_ASSERT(ctx != NULL);
+
+	if (ctx != NULL)
+	{
+		ctx->replay = cache;
+	}
+}
+
+void skdp_server_set_revocation(skdp_server_state* ctx, skdp_revocation* rset)
+{
+	SKDP_ASSERT(ctx != NULL);
+
+	if (ctx != NULL)
+	{
+		ctx->revoked = rset;
+	}
+}
+
+void skdp_server_send_error(const qsc_socket* sock, skdp_errors error)
+{
+	SKDP_ASSERT(sock != NULL);
+
+	if (sock != NULL)
+	{
+		if (qsc_socket_is_connected(sock) == true)
+		{
+			skdp_network_packet resp = { 0 };
+			uint8_t spct[SKDP_HEADER_SIZE + SKDP_ERROR_SIZE] = { 0U };
+
+			resp.flag = skdp_flag_error_condition;
+			resp.msglen = sizeof(uint8_t);
+			resp.sequence = SKDP_SEQUENCE_TERMINATOR;
+			skdp_packet_header_serialize(&resp, spct);
+			spct[SKDP_HEADER_SIZE] = (uint8_t)error;
+			qsc_socket_send(sock, spct, sizeof(spct), qsc_socket_send_flag_none);
+		}
+	}
+}
+
+bool skdp_server_session_deserialize(skdp_server_state* ctx, const uint8_t* input, size_t inlen)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(input != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && input != NULL && inlen >= SKDP_SERVER_SESSION_SIZE)
+	{
+		res = server_session_decode(ctx, input, SKDP_SERVER_SESSION_VERSION);
+	}
+
+	return res;
+}
+
+skdp_errors skdp_server_session_export(skdp_server_state* ctx, const skdp_network_packet* packetin, const uint8_t* key, uint8_t* output, size_t otplen, size_t* outlen)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(packetin != NULL);
+	SKDP_ASSERT(key != NULL);
+	SKDP_ASSERT(output != NULL);
+	SKDP_ASSERT(outlen != NULL);
+
+	uint8_t sbuf[SKDP_SERVER_SESSION_SIZE] = { 0U };
+	skdp_errors err;
+
+	err = skdp_error_invalid_input;
+
+	if (ctx != NULL && packetin != NULL && key != NULL && output != NULL && outlen != NULL &&
+		otplen >= SKDP_SERVER_SESSION_EXPORT_SIZE && ctx->exflag == skdp_flag_hibernate)
+	{
+		*outlen = 0U;
+		err = server_hibernate_verify(ctx, packetin);
+
+		if (err == skdp_error_none)
+		{
+			server_session_encode(ctx, sbuf, SKDP_SERVER_SESSION_VERSION);
+			*outlen = skdp_session_seal(output, otplen, sbuf, sizeof(sbuf), key, skdp_session_role_server);
+
+			if (*outlen != 0U)
+			{
+				server_dispose(ctx);
+				server_kex_reset(ctx);
+			}
+			else
+			{
+				err = skdp_error_random_failure;
+			}
+		}
+
+		qsc_memutils_secure_erase(sbuf, sizeof(sbuf));
+	}
+
+	return err;
+}
+
+bool skdp_server_session_import(skdp_server_state* ctx, const uint8_t* key, const uint8_t* input, size_t inlen)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(key != NULL);
+	SKDP_ASSERT(input != NULL);
+
+	uint8_t sbuf[SKDP_SERVER_SESSION_SIZE] = { 0U };
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && key != NULL && input != NULL)
+	{
+		if (skdp_session_open(sbuf, sizeof(sbuf), input, inlen, key, skdp_session_role_server) == true)
+		{
+			res = skdp_server_session_deserialize(ctx, sbuf, sizeof(sbuf));
+		}
+
+		qsc_memutils_secure_erase(sbuf, sizeof(sbuf));
+	}
+
+	return res;
+}
+
+skdp_errors skdp_server_session_serialize(skdp_server_state* ctx, const skdp_network_packet* packetin, uint8_t* output, size_t otplen)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(packetin != NULL);
+	SKDP_ASSERT(output != NULL);
+
+	skdp_errors err;
+
+	err = skdp_error_invalid_input;
+
+	if (ctx != NULL && packetin != NULL && output != NULL && otplen >= SKDP_SERVER_SESSION_SIZE && ctx->exflag == skdp_flag_hibernate)
+	{
+		err = server_hibernate_verify(ctx, packetin);
+
+		if (err == skdp_error_none)
+		{
+			/* the live cipher states are never written; the receiver re-expands them from the secrets */
+			server_session_encode(ctx, output, SKDP_SERVER_SESSION_VERSION);
+			server_dispose(ctx);
+			server_kex_reset(ctx);
+		}
+	}
+
+	return err;
+}
+
+skdp_errors skdp_server_send_keep_alive(skdp_keep_alive_state* kctx, const qsc_socket* sock)
+{
+	SKDP_ASSERT(kctx != NULL);
+
+	skdp_errors err;
+
+	err = skdp_error_bad_keep_alive;
+
+	if (kctx != NULL)
+	{
+		if (qsc_socket_is_connected(sock) == true)
+		{
+			uint8_t spct[SKDP_HEADER_SIZE + SKDP_KEEPALIVE_MESSAGE] = { 0U };
+			skdp_network_packet resp = { 0 };
 			uint64_t etime;
 			size_t slen;
 
@@ -569,6 +1169,188 @@ skdp_errors skdp_server_send_keep_alive(skdp_keep_alive_state* kctx, const qsc_s
 	return err;
 }
 
+skdp_errors skdp_server_send_keep_alive_idle(const skdp_server_state* ctx, skdp_keep_alive_state* kctx, const qsc_socket* sock, uint64_t idle)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(kctx != NULL);
+
+	uint64_t ltime;
+	uint64_t rtime;
+	skdp_errors err;
+
+	err = skdp_error_bad_keep_alive;
+
+	if (ctx != NULL && kctx != NULL)
+	{
+		ltime = skdp_clock_now();
+		rtime = SKDP_ATOMIC_LOAD_RELAXED(&ctx->rxtime);
+
+		if (rtime != 0U && rtime <= ltime && ltime - rtime < idle)
+		{
+			/* traffic since the last probe proves liveness */
+			kctx->recd = true;
+			err = skdp_error_none;
+		}
+		else
+		{
+			err = skdp_server_send_keep_alive(kctx, sock);
+		}
+	}
+
+	return err;
+}
+
+static size_t server_keep_alive_flush(skdp_keep_alive_sweep* sweep, size_t count)
+{
+	size_t i;
+	size_t res;
+
+	res = 0U;
+
+	if (count != 0U)
+	{
+		if (sweep->submit != NULL)
+		{
+			res = sweep->submit(sweep->context, sweep->socks, sweep->arena, count);
+		}
+		else
+		{
+			for (i = 0U; i < count; ++i)
+			{
+				if (qsc_socket_send(sweep->socks[i], sweep->arena + (i * SKDP_KEEPALIVE_PACKET_SIZE), SKDP_KEEPALIVE_PACKET_SIZE, qsc_socket_send_flag_none) == SKDP_KEEPALIVE_PACKET_SIZE)
+				{
+					++res;
+				}
+			}
+		}
+	}
+
+	return res;
+}
+
+size_t skdp_server_keep_alive_sweep(skdp_keep_alive_sweep* sweep, const skdp_keep_alive_session* sessions, size_t count, uint64_t idle)
+{
+	SKDP_ASSERT(sweep != NULL);
+	SKDP_ASSERT(sessions != NULL);
+
+	skdp_network_packet resp = { 0 };
+	const skdp_keep_alive_session* sess;
+	uint64_t etime;
+	uint64_t ltime;
+	uint64_t rtime;
+	size_t i;
+	size_t pos;
+	size_t res;
+
+	res = 0U;
+
+	if (sweep != NULL && sweep->arena != NULL && sessions != NULL)
+	{
+		/* one timestamp for the whole sweep */
+		etime = qsc_timestamp_epochtime_seconds();
+		ltime = skdp_clock_now();
+		resp.flag = skdp_flag_keepalive_request;
+		resp.msglen = SKDP_KEEPALIVE_MESSAGE;
+		pos = 0U;
+
+		for (i = 0U; i < count; ++i)
+		{
+			sess = &sessions[i];
+
+			if (sess->kctx != NULL)
+			{
+				rtime = (sess->ctx != NULL) ? SKDP_ATOMIC_LOAD_RELAXED(&sess->ctx->rxtime) : 0U;
+
+				if (rtime != 0U && rtime <= ltime && ltime - rtime < idle)
+				{
+					/* traffic since the last probe proves liveness */
+					sess->kctx->recd = true;
+				}
+				else if (qsc_socket_is_connected(sess->sock) == true)
+				{
+					/* serialize the packet in place in the arena */
+					sess->kctx->etime = etime;
+					resp.sequence = sess->kctx->seqctr;
+					resp.pmessage = sweep->arena + (pos * SKDP_KEEPALIVE_PACKET_SIZE) + SKDP_HEADER_SIZE;
+					qsc_intutils_le64to8(resp.pmessage, etime);
+					skdp_packet_header_serialize(&resp, sweep->arena + (pos * SKDP_KEEPALIVE_PACKET_SIZE));
+					sweep->socks[pos] = sess->sock;
+					++pos;
+
+					if (pos == sweep->capacity)
+					{
+						res += server_keep_alive_flush(sweep, pos);
+						pos = 0U;
+					}
+				}
+			}
+		}
+
+		res += server_keep_alive_flush(sweep, pos);
+	}
+
+	return res;
+}
+
+void skdp_server_keep_alive_sweep_dispose(skdp_keep_alive_sweep* sweep)
+{
+	SKDP_ASSERT(sweep != NULL);
+
+	if (sweep != NULL)
+	{
+		if (sweep->arena != NULL)
+		{
+			qsc_memutils_alloc_free(sweep->arena);
+		}
+
+		if (sweep->socks != NULL)
+		{
+			qsc_memutils_alloc_free((void*)sweep->socks);
+		}
+
+		sweep->arena = NULL;
+		sweep->socks = NULL;
+		sweep->submit = NULL;
+		sweep->context = NULL;
+		sweep->capacity = 0U;
+	}
+}
+
+bool skdp_server_keep_alive_sweep_initialize(skdp_keep_alive_sweep* sweep, size_t capacity, skdp_keep_alive_submit submit, void* context)
+{
+	SKDP_ASSERT(sweep != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (sweep != NULL)
+	{
+		if (capacity == 0U)
+		{
+			capacity = SKDP_KEEPALIVE_BATCH;
+		}
+
+		sweep->arena = (uint8_t*)qsc_memutils_malloc(capacity * SKDP_KEEPALIVE_PACKET_SIZE);
+		sweep->socks = (const qsc_socket**)qsc_memutils_malloc(capacity * sizeof(qsc_socket*));
+		sweep->submit = submit;
+		sweep->context = context;
+		sweep->capacity = capacity;
+
+		if (sweep->arena != NULL && sweep->socks != NULL)
+		{
+			qsc_memutils_clear(sweep->arena, capacity * SKDP_KEEPALIVE_PACKET_SIZE);
+			res = true;
+		}
+		else
+		{
+			skdp_server_keep_alive_sweep_dispose(sweep);
+		}
+	}
+
+	return res;
+}
+
 void skdp_server_connection_close(skdp_server_state* ctx, qsc_socket* sock, skdp_errors error)
 {
 	SKDP_ASSERT(ctx != NULL);
@@ -599,6 +1381,27 @@ void skdp_server_connection_close(skdp_server_state* ctx, qsc_socket* sock, skdp
 	}
 }
 
+bool skdp_server_datagram_initialize(const skdp_server_state* ctx, skdp_datagram_state* dgram)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(dgram != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && dgram != NULL)
+	{
+		if (ctx->exflag == skdp_flag_session_established)
+		{
+			skdp_datagram_initialize(dgram, ctx->suite, ctx->kupdate.txsec, ctx->kupdate.rxsec);
+			res = true;
+		}
+	}
+
+	return res;
+}
+
 void skdp_server_initialize(skdp_server_state* ctx, const skdp_server_key* skey)
 {
 	SKDP_ASSERT(ctx != NULL);
@@ -611,8 +1414,87 @@ void skdp_server_initialize(skdp_server_state* ctx, const skdp_server_key* skey)
 		ctx->expiration = skey->expiration;
 		ctx->rxseq = 0;
 		ctx->txseq = 0;
+		ctx->keyset = NULL;
+		ctx->kstore = NULL;
+		ctx->revoked = NULL;
+		ctx->ckey = NULL;
+		ctx->replay = NULL;
+		ctx->suite = skdp_cipher_suite_default();
+		qsc_memutils_clear(&ctx->kupdate, sizeof(skdp_key_update));
+		qsc_memutils_clear(ctx->cid, SKDP_CONNECTION_ID_SIZE);
+		qsc_memutils_clear(ctx->pcid, SKDP_CONNECTION_ID_SIZE);
+		qsc_memutils_clear(ctx->rtresp, sizeof(ctx->rtresp));
+		qsc_memutils_clear(&ctx->rtcpr, sizeof(skdp_cipher_state));
+		ctx->rtrxseq = 0U;
+		ctx->rttxseq = 0U;
+		ctx->rxtime = 0U;
+		ctx->exflag = skdp_flag_none;
+		ctx->owned = false;
+	}
+}
+
+bool skdp_server_initialize_keyset(skdp_server_state* ctx, skdp_server_keyset* keyset)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(keyset != NULL);
+
+	skdp_server_key skey = { 0 };
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && keyset != NULL)
+	{
+		res = skdp_keyset_acquire(keyset, &skey);
+
+		if (res == true)
+		{
+			skdp_server_initialize(ctx, &skey);
+			ctx->keyset = keyset;
+		}
+
+		qsc_memutils_secure_erase(&skey, sizeof(skdp_server_key));
+	}
+
+	return res;
+}
+
+bool skdp_server_initialize_keystore(skdp_server_state* ctx, const skdp_keystore* kstore)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(kstore != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && kstore != NULL && kstore->records != NULL)
+	{
+		qsc_memutils_clear(ctx->kid, SKDP_KID_SIZE);
+		qsc_memutils_clear(ctx->sdk, SKDP_SDK_SIZE);
+		ctx->expiration = 0U;
+		ctx->rxseq = 0;
+		ctx->txseq = 0;
+		ctx->keyset = NULL;
+		ctx->kstore = kstore;
+		ctx->revoked = NULL;
+		ctx->ckey = NULL;
+		ctx->replay = NULL;
+		ctx->suite = skdp_cipher_suite_default();
+		qsc_memutils_clear(&ctx->kupdate, sizeof(skdp_key_update));
+		qsc_memutils_clear(ctx->cid, SKDP_CONNECTION_ID_SIZE);
+		qsc_memutils_clear(ctx->pcid, SKDP_CONNECTION_ID_SIZE);
+		qsc_memutils_clear(ctx->rtresp, sizeof(ctx->rtresp));
+		qsc_memutils_clear(&ctx->rtcpr, sizeof(skdp_cipher_state));
+		ctx->rtrxseq = 0U;
+		ctx->rttxseq = 0U;
+		ctx->rxtime = 0U;
 		ctx->exflag = skdp_flag_none;
+		ctx->owned = false;
+		res = true;
 	}
+
+	return res;
 }
 
 skdp_errors skdp_server_listen_ipv4(skdp_server_state* ctx, qsc_socket* sock, const qsc_ipinfo_ipv4_address* address, uint16_t port)
@@ -623,6 +1505,7 @@ skdp_errors skdp_server_listen_ipv4(skdp_server_state* ctx, qsc_socket* sock, co
 
 	qsc_socket srvs;
 	qsc_socket_exceptions serr;
+	skdp_transport trans;
 	skdp_errors err;
 
 	if (ctx != NULL && sock != NULL && address != NULL)
@@ -636,7 +1519,8 @@ skdp_errors skdp_server_listen_ipv4(skdp_server_state* ctx, qsc_socket* sock, co
 
 		if (serr == qsc_socket_exception_success)
 		{
-			err = server_key_exchange(ctx, sock);
+			skdp_transport_from_socket(&trans, sock);
+			err = server_key_exchange(ctx, &trans, NULL);
 		}
 		else
 		{
@@ -659,6 +1543,7 @@ skdp_errors skdp_server_listen_ipv6(skdp_server_state* ctx, qsc_socket* sock, co
 
 	qsc_socket srvs;
 	qsc_socket_exceptions serr;
+	skdp_transport trans;
 	skdp_errors err;
 
 	if (ctx != NULL && sock != NULL && address != NULL)
@@ -671,7 +1556,8 @@ skdp_errors skdp_server_listen_ipv6(skdp_server_state* ctx, qsc_socket* sock, co
 
 		if (serr == qsc_socket_exception_success)
 		{
-			err = server_key_exchange(ctx, sock);
+			skdp_transport_from_socket(&trans, sock);
+			err = server_key_exchange(ctx, &trans, NULL);
 		}
 		else
 		{
@@ -686,6 +1572,450 @@ skdp_errors skdp_server_listen_ipv6(skdp_server_state* ctx, qsc_socket* sock, co
 	return err;
 }
 
+skdp_errors skdp_server_listen_transport(skdp_server_state* ctx, const skdp_transport* trans)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(trans != NULL);
+
+	skdp_errors err;
+
+	if (ctx != NULL && trans != NULL && trans->send != NULL && trans->receive != NULL)
+	{
+		err = server_key_exchange(ctx, trans, NULL);
+	}
+	else
+	{
+		err = skdp_error_general_failure;
+	}
+
+	return err;
+}
+
+skdp_errors skdp_server_handshake(skdp_server_state* ctx, const uint8_t* input, size_t inlen, uint8_t* output, size_t otplen, size_t* outlen)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(input != NULL);
+	SKDP_ASSERT(output != NULL);
+	SKDP_ASSERT(outlen != NULL);
+
+	skdp_network_packet resp = { 0 };
+	skdp_network_packet reqt = { 0 };
+	skdp_errors err;
+
+	if (ctx != NULL && input != NULL && output != NULL && outlen != NULL && inlen >= SKDP_HEADER_SIZE &&
+		inlen <= SKDP_SERVER_HANDSHAKE_BUFFER_SIZE && otplen >= SKDP_SERVER_HANDSHAKE_BUFFER_SIZE)
+	{
+		*outlen = 0U;
+		skdp_packet_header_deserialize(input, SKDP_HEADER_SIZE, &reqt);
+		reqt.pmessage = (uint8_t*)input + SKDP_HEADER_SIZE;
+		resp.pmessage = output + SKDP_HEADER_SIZE;
+
+		if (reqt.flag == skdp_flag_exchange_cookie && ctx->ckey != NULL && ctx->exflag == skdp_flag_none && ctx->rxseq == 0U)
+		{
+			/* a stateless resume; the cookie carries the transcript, so a fresh state starts at the exchange */
+			ctx->exflag = skdp_flag_connect_response;
+			ctx->rxseq = 1U;
+			ctx->txseq = 1U;
+		}
+
+		if (reqt.msglen != inlen - SKDP_HEADER_SIZE)
+		{
+			err = skdp_error_invalid_input;
+		}
+		else if (reqt.flag == skdp_flag_error_condition)
+		{
+			err = (reqt.msglen != 0U) ? skdp_message_to_error(reqt.pmessage[0U]) : skdp_error_invalid_input;
+		}
+		else if (reqt.sequence != ctx->rxseq)
+		{
+			err = skdp_error_unsequenced;
+		}
+		else
+		{
+			ctx->rxseq += 1U;
+
+			/* the request flag must match the position of the exchange */
+			if (reqt.flag == skdp_flag_connect_request && ctx->exflag == skdp_flag_none &&
+				reqt.msglen == SKDP_CONNECT_REQUEST_MESSAGE_SIZE)
+			{
+				server_key_refresh(ctx, reqt.pmessage);
+				err = server_connect_response(ctx, &reqt, &resp);
+			}
+			else if (ctx->exflag == skdp_flag_connect_response &&
+				((reqt.flag == skdp_flag_exchange_request && ctx->ckey == NULL && reqt.msglen == SKDP_EXCHANGE_REQUEST_MESSAGE_SIZE) ||
+				(reqt.flag == skdp_flag_exchange_cookie && ctx->ckey != NULL)))
+			{
+				err = server_exchange_response(ctx, &reqt, &resp);
+			}
+			else if (reqt.flag == skdp_flag_establish_request && ctx->exflag == skdp_flag_exchange_response)
+			{
+				err = server_establish_response(ctx, &reqt, &resp);
+			}
+			else
+			{
+				err = skdp_error_establish_failure;
+			}
+		}
+
+		if (err == skdp_error_none)
+		{
+			skdp_packet_header_serialize(&resp, output);
+			*outlen = SKDP_HEADER_SIZE + resp.msglen;
+			ctx->txseq += 1U;
+
+			if (ctx->exflag == skdp_flag_session_established)
+			{
+				server_kex_reset(ctx);
+				/* the device reattaches to the session with this identifier */
+				skdp_connection_id_derive(ctx->cid, ctx->kupdate.rxsec, ctx->kupdate.txsec);
+				SKDP_ATOMIC_STORE_RELAXED(&ctx->rxtime, skdp_clock_now());
+			}
+		}
+		else
+		{
+			/* the output carries an error packet for the device, and the state is reset */
+			qsc_memutils_clear(&resp, sizeof(skdp_network_packet));
+			resp.flag = skdp_flag_error_condition;
+			resp.msglen = SKDP_ERROR_SIZE;
+			resp.sequence = SKDP_SEQUENCE_TERMINATOR;
+			skdp_packet_header_serialize(&resp, output);
+			output[SKDP_HEADER_SIZE] = (uint8_t)err;
+			*outlen = SKDP_HEADER_SIZE + SKDP_ERROR_SIZE;
+
+			server_kex_reset(ctx);
+			server_dispose(ctx);
+		}
+	}
+	else
+	{
+		err = skdp_error_invalid_input;
+	}
+
+	return err;
+}
+
+skdp_errors skdp_server_hibernate(skdp_server_state* ctx, const skdp_transport* trans, uint64_t idle, bool* pending)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(trans != NULL);
+	SKDP_ASSERT(pending != NULL);
+
+	uint8_t spct[SKDP_HEADER_SIZE + SKDP_MACTAG_SIZE] = { 0U };
+	skdp_network_packet resp = { 0 };
+	uint64_t ltime;
+	uint64_t rtime;
+	size_t plen;
+	skdp_errors err;
+
+	err = skdp_error_invalid_input;
+
+	if (ctx != NULL && trans != NULL && pending != NULL && ctx->exflag == skdp_flag_session_established)
+	{
+		*pending = false;
+		ltime = skdp_clock_now();
+		rtime = SKDP_ATOMIC_LOAD_RELAXED(&ctx->rxtime);
+
+		if (rtime != 0U && rtime <= ltime && ltime - rtime < idle)
+		{
+			/* the session is active */
+			err = skdp_error_none;
+		}
+		else
+		{
+			/* an empty record under the current key asks the device to acknowledge and ratchet both channels */
+			ctx->txseq += 1U;
+			resp.pmessage = spct + SKDP_HEADER_SIZE;
+			resp.flag = skdp_flag_hibernate;
+			resp.msglen = (uint32_t)ctx->suite->tagsize;
+			resp.sequence = ctx->txseq;
+			skdp_packet_set_utc_time(&resp);
+			skdp_packet_header_serialize(&resp, spct);
+			skdp_cipher_set_associated(&ctx->txcpr, spct, SKDP_HEADER_SIZE);
+			skdp_cipher_transform(&ctx->txcpr, resp.pmessage, spct, 0U);
+			plen = SKDP_HEADER_SIZE + resp.msglen;
+
+			if (skdp_transport_send(trans, spct, plen) == plen)
+			{
+				/* the session keeps receiving, but sends nothing more until it is woken */
+				ctx->exflag = skdp_flag_hibernate;
+				*pending = true;
+				err = skdp_error_none;
+			}
+			else
+			{
+				err = skdp_error_transmit_failure;
+			}
+		}
+	}
+
+	return err;
+}
+
+skdp_errors skdp_server_hibernate_complete(skdp_server_state* ctx, const skdp_network_packet* packetin, const uint8_t* key, uint8_t* output, size_t otplen, size_t* outlen)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(packetin != NULL);
+	SKDP_ASSERT(key != NULL);
+	SKDP_ASSERT(output != NULL);
+	SKDP_ASSERT(outlen != NULL);
+
+	uint8_t hbuf[SKDP_SERVER_HIBERNATE_STATE_SIZE] = { 0U };
+	skdp_errors err;
+
+	err = skdp_error_invalid_input;
+
+	if (ctx != NULL && packetin != NULL && key != NULL && output != NULL && outlen != NULL && ctx->exflag == skdp_flag_hibernate)
+	{
+		*outlen = 0U;
+		err = server_hibernate_verify(ctx, packetin);
+
+		if (err == skdp_error_none)
+		{
+			/* the record has the serialized session layout; the device identity and key expiration were
+			   erased when the key exchange completed, so they are not part of it */
+			server_session_encode(ctx, hbuf, SKDP_SERVER_HIBERNATE_VERSION);
+			*outlen = skdp_session_seal(output, otplen, hbuf, sizeof(hbuf), key, skdp_session_role_hibernated);
+
+			if (*outlen != 0U)
+			{
+				server_dispose(ctx);
+				server_kex_reset(ctx);
+			}
+			else
+			{
+				err = skdp_error_random_failure;
+			}
+		}
+
+		qsc_memutils_secure_erase(hbuf, sizeof(hbuf));
+	}
+
+	return err;
+}
+
+skdp_errors skdp_server_listen_registry(skdp_server_state* ctx, skdp_server_registry* reg, const skdp_transport* trans, skdp_server_state** session)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(reg != NULL);
+	SKDP_ASSERT(trans != NULL);
+	SKDP_ASSERT(session != NULL);
+
+	uint8_t first[SKDP_CONNECT_REQUEST_PACKET_SIZE] = { 0U };
+	skdp_errors err;
+
+	if (ctx != NULL && reg != NULL && reg->slots != NULL && trans != NULL && trans->send != NULL && trans->receive != NULL && session != NULL)
+	{
+		*session = NULL;
+
+		/* a reattach request has the size of a connect request, the flag selects the path */
+		if (skdp_transport_receive(trans, first, sizeof(first)) == sizeof(first))
+		{
+			if (first[0U] == (uint8_t)skdp_flag_reattach_request)
+			{
+				err = server_reattach(reg, trans, first, session);
+			}
+			else
+			{
+				err = server_key_exchange(ctx, trans, first);
+
+				if (err == skdp_error_none)
+				{
+					/* if the registry is full the session is still usable, but the device cannot reattach to it */
+					skdp_server_registry_add(reg, ctx);
+					*session = ctx;
+				}
+			}
+		}
+		else
+		{
+			err = skdp_error_receive_failure;
+		}
+	}
+	else
+	{
+		err = skdp_error_general_failure;
+	}
+
+	return err;
+}
+
+bool skdp_server_registry_add(skdp_server_registry* reg, skdp_server_state* ctx)
+{
+	SKDP_ASSERT(reg != NULL);
+	SKDP_ASSERT(ctx != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (reg != NULL && reg->slots != NULL && ctx != NULL)
+	{
+		qsc_async_mutex_lock(reg->mtx);
+
+		/* a session holds up to two slots, so the load factor stays at or below one half */
+		if (reg->count < (reg->capacity / 4U) && server_registry_find(reg, ctx->cid) == reg->capacity)
+		{
+			server_registry_insert(reg, ctx, ctx->cid);
+			ctx->owned = true;
+			reg->count += 1U;
+			res = true;
+		}
+
+		qsc_async_mutex_unlock(reg->mtx);
+	}
+
+	return res;
+}
+
+void skdp_server_registry_dispose(skdp_server_registry* reg)
+{
+	SKDP_ASSERT(reg != NULL);
+
+	if (reg != NULL)
+	{
+		if (reg->slots != NULL)
+		{
+			qsc_memutils_alloc_free(reg->slots);
+		}
+
+		if (reg->mtx != NULL)
+		{
+			qsc_async_mutex_destroy(reg->mtx);
+		}
+
+		qsc_memutils_clear(reg, sizeof(skdp_server_registry));
+	}
+}
+
+bool skdp_server_registry_initialize(skdp_server_registry* reg, size_t capacity)
+{
+	SKDP_ASSERT(reg != NULL);
+
+	size_t slen;
+	bool res;
+
+	res = false;
+
+	if (reg != NULL && capacity != 0U && capacity <= (SIZE_MAX / (8U * sizeof(skdp_server_registry_entry))))
+	{
+		qsc_memutils_clear(reg, sizeof(skdp_server_registry));
+		reg->capacity = 4U;
+
+		while (reg->capacity < 4U * capacity)
+		{
+			reg->capacity <<= 1U;
+		}
+
+		slen = reg->capacity * sizeof(skdp_server_registry_entry);
+		reg->slots = (skdp_server_registry_entry*)qsc_memutils_malloc(slen);
+		reg->mtx = qsc_async_mutex_create();
+
+		if (reg->slots != NULL && reg->mtx != NULL)
+		{
+			qsc_memutils_clear(reg->slots, slen);
+			res = true;
+		}
+		else
+		{
+			skdp_server_registry_dispose(reg);
+		}
+	}
+
+	return res;
+}
+
+void skdp_server_registry_release(skdp_server_registry* reg, skdp_server_state* ctx)
+{
+	SKDP_ASSERT(reg != NULL);
+	SKDP_ASSERT(ctx != NULL);
+
+	if (reg != NULL && reg->mtx != NULL && ctx != NULL)
+	{
+		qsc_async_mutex_lock(reg->mtx);
+		ctx->owned = false;
+		qsc_async_mutex_unlock(reg->mtx);
+	}
+}
+
+bool skdp_server_registry_remove(skdp_server_registry* reg, const skdp_server_state* ctx)
+{
+	SKDP_ASSERT(reg != NULL);
+	SKDP_ASSERT(ctx != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (reg != NULL && reg->slots != NULL && ctx != NULL)
+	{
+		qsc_async_mutex_lock(reg->mtx);
+		res = server_registry_unlink(reg, ctx, ctx->cid);
+
+		/* a reattached session is also indexed by its previous identifier */
+		if (server_registry_unlink(reg, ctx, ctx->pcid) == true || res == true)
+		{
+			reg->count -= 1U;
+			res = true;
+		}
+
+		qsc_async_mutex_unlock(reg->mtx);
+	}
+
+	return res;
+}
+
+skdp_server_state* skdp_server_registry_take(skdp_server_registry* reg, const uint8_t* cid)
+{
+	SKDP_ASSERT(reg != NULL);
+	SKDP_ASSERT(cid != NULL);
+
+	skdp_server_state* res;
+	size_t pos;
+
+	res = NULL;
+
+	if (reg != NULL && reg->slots != NULL && cid != NULL)
+	{
+		qsc_async_mutex_lock(reg->mtx);
+		pos = server_registry_find(reg, cid);
+
+		if (pos != reg->capacity && reg->slots[pos].state->owned == false)
+		{
+			res = reg->slots[pos].state;
+			res->owned = true;
+		}
+
+		qsc_async_mutex_unlock(reg->mtx);
+	}
+
+	return res;
+}
+
+bool skdp_server_wake(skdp_server_state* ctx, const uint8_t* key, const uint8_t* input, size_t inlen)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(key != NULL);
+	SKDP_ASSERT(input != NULL);
+
+	uint8_t hbuf[SKDP_SERVER_HIBERNATE_STATE_SIZE] = { 0U };
+	bool res;
+
+	res = false;
+
+	if (ctx != NULL && key != NULL && input != NULL)
+	{
+		if (skdp_session_open(hbuf, sizeof(hbuf), input, inlen, key, skdp_session_role_hibernated) == true)
+		{
+			/* re-expand both channels to the keys the device moved to on the hibernate record */
+			res = server_session_decode(ctx, hbuf, SKDP_SERVER_HIBERNATE_VERSION);
+		}
+
+		qsc_memutils_secure_erase(hbuf, sizeof(hbuf));
+	}
+
+	return res;
+}
+
 skdp_errors skdp_server_decrypt_packet(skdp_server_state* ctx, const skdp_network_packet* packetin, uint8_t* message, size_t message_capacity, size_t* msglen)
 {
 	SKDP_ASSERT(ctx != NULL);
@@ -702,25 +2032,33 @@ skdp_errors skdp_server_decrypt_packet(skdp_server_state* ctx, const skdp_networ
 	{
 		if (packetin->sequence == ctx->rxseq + 1U)
 		{
-			if (ctx->exflag == skdp_flag_session_established)
+			/* records the device sent before it saw a hibernate request are still opened */
+			if (ctx->exflag == skdp_flag_session_established || ctx->exflag == skdp_flag_hibernate)
 			{
 				/* change 1.1 anti-replay; verify the packet time */
 				if (skdp_packet_time_valid(packetin) == true)
 				{
-					if (packetin->flag == skdp_flag_encrypted_message &&
-						packetin->msglen >= SKDP_MACTAG_SIZE &&
-						packetin->msglen <= SKDP_MESSAGE_SIZE + SKDP_MACTAG_SIZE &&
-						packetin->msglen - SKDP_MACTAG_SIZE <= message_capacity)
+					if ((packetin->flag == skdp_flag_encrypted_message || packetin->flag == skdp_flag_key_update) &&
+						packetin->msglen >= ctx->suite->tagsize &&
+						packetin->msglen <= SKDP_MESSAGE_SIZE + ctx->suite->tagsize &&
+						packetin->msglen - ctx->suite->tagsize <= message_capacity)
 					{
 						/* serialize the header and add it to the ciphers associated data */
 						skdp_packet_header_serialize(packetin, hdr);
 						skdp_cipher_set_associated(&ctx->rxcpr, hdr, SKDP_HEADER_SIZE);
 
-						*msglen = packetin->msglen - SKDP_MACTAG_SIZE;
+						*msglen = packetin->msglen - ctx->suite->tagsize;
 
 						/* authenticate then decrypt the data */
 						if (skdp_cipher_transform(&ctx->rxcpr, message, packetin->pmessage, *msglen) == true)
 						{
+							if (packetin->flag == skdp_flag_key_update)
+							{
+								/* the sender has moved to its next key, follow it */
+								skdp_key_update_ratchet(&ctx->rxcpr, ctx->kupdate.rxsec, false);
+							}
+
+							SKDP_ATOMIC_STORE_RELAXED(&ctx->rxtime, skdp_clock_now());
 							ctx->rxseq += 1U;
 							err = skdp_error_none;
 						}
@@ -780,8 +2118,8 @@ skdp_errors skdp_server_encrypt_packet(skdp_server_state* ctx, const uint8_t* me
 
 				/* assemble the encryption packet */
 				ctx->txseq += 1U;
-				packetout->flag = skdp_flag_encrypted_message;
-				packetout->msglen = (uint32_t)msglen + SKDP_MACTAG_SIZE;
+				packetout->flag = (skdp_key_update_account(&ctx->kupdate, msglen) == true) ? skdp_flag_key_update : skdp_flag_encrypted_message;
+				packetout->msglen = (uint32_t)(msglen + ctx->suite->tagsize);
 				packetout->sequence = ctx->txseq;
 				/* change 1.1 anti-replay; set the packet utc time field */
 				skdp_packet_set_utc_time(packetout);
@@ -791,6 +2129,12 @@ skdp_errors skdp_server_encrypt_packet(skdp_server_state* ctx, const uint8_t* me
 				/* encrypt the message */
 				skdp_cipher_transform(&ctx->txcpr, packetout->pmessage, message, msglen);
 
+				if (packetout->flag == skdp_flag_key_update)
+				{
+					/* the record is sealed under the old key, every record after it under the next */
+					skdp_key_update_ratchet(&ctx->txcpr, ctx->kupdate.txsec, true);
+				}
+
 				err = skdp_error_none;
 			}
 			else
@@ -54,6 +54,13 @@
 
 #include "skdpcommon.h"
 #include "skdp.h"
+#include "skdpdatagram.h"
+#include "skdpkeyset.h"
+#include "skdpkeystore.h"
+#include "skdpreplay.h"
+#include "skdprevoke.h"
+#include "skdptransport.h"
+#include "async.h"
 #include "socketserver.h"
 
 /**
@@ -74,6 +81,48 @@
  * \note These functions and data structures are internal and non-exportable.
  */
 
+/*!
+ * \def SKDP_SERVER_SESSION_SIZE
+ * \brief The byte size of a serialized server session; the channel secrets, the connection identifier and the counters.
+ */
+#define SKDP_SERVER_SESSION_SIZE (4U + (2U * SKDP_KEY_UPDATE_SECRET_SIZE) + SKDP_CONNECTION_ID_SIZE + (5U * sizeof(uint64_t)))
+
+/*!
+ * \def SKDP_SERVER_HANDSHAKE_BUFFER_SIZE
+ * \brief The byte size of the largest key exchange packet, the input and output bound of \c skdp_server_handshake.
+ */
+#define SKDP_SERVER_HANDSHAKE_BUFFER_SIZE (SKDP_EXCHANGE_MAX_MESSAGE_SIZE + SKDP_COOKIE_SIZE)
+
+/*!
+ * \def SKDP_SERVER_HIBERNATE_STATE_SIZE
+ * \brief The byte size of a hibernated session before sealing; the serialized session layout.
+ */
+#define SKDP_SERVER_HIBERNATE_STATE_SIZE SKDP_SERVER_SESSION_SIZE
+
+/*!
+ * \def SKDP_SERVER_HIBERNATE_SIZE
+ * \brief The maximum byte size of a sealed hibernation record.
+ */
+#define SKDP_SERVER_HIBERNATE_SIZE (SKDP_SERVER_HIBERNATE_STATE_SIZE + SKDP_SESSION_EXPORT_OVERHEAD)
+
+/*!
+ * \def SKDP_SERVER_HIBERNATE_VERSION
+ * \brief The hibernated session format version.
+ */
+#define SKDP_SERVER_HIBERNATE_VERSION 0x02U
+
+/*!
+ * \def SKDP_SERVER_SESSION_EXPORT_SIZE
+ * \brief The maximum byte size of a sealed server session export.
+ */
+#define SKDP_SERVER_SESSION_EXPORT_SIZE (SKDP_SERVER_SESSION_SIZE + SKDP_SESSION_EXPORT_OVERHEAD)
+
+/*!
+ * \def SKDP_SERVER_SESSION_VERSION
+ * \brief The serialized server session format version.
+ */
+#define SKDP_SERVER_SESSION_VERSION 0x03U
+
 /*!
  * \struct skdp_server_state
  * \brief The SKDP server state structure.
@@ -83,6 +132,16 @@
  * It includes the cipher states for both the receive and transmit channels, identity and session hashes, as well as the
  * server derivation key. The structure also holds expiration information and packet sequence numbers for both receiving
  * and transmitting messages. The \c exflag field indicates the current position within the key exchange process.
+ * If \c keyset is set, the server key is re-acquired from the published keyset at the start of every key exchange.
+ * If \c kstore is set, the server key is selected from the key store using the identity in the device connect request.
+ * If \c revoked is set, a device whose key identity is in the revocation set is refused at the connect request.
+ * If \c ckey is set, the server runs the cookie handshake and keeps no transcript state between the connect response
+ * and the exchange request; driven by \c skdp_server_handshake, no server state is held for the connection either.
+ * If \c replay is set, a replayed exchange request is rejected before the server performs any key derivation.
+ * The \c suite field holds the cipher suite negotiated from the configuration string in the device connect request.
+ * The \c kupdate field holds the in-session key update secrets and counters.
+ * The \c rxtime field holds the time the last authenticated record was received, and is read by the keep-alive path.
+ * The \c cid field holds the connection identifier used by a device to reattach to the session over a new connection.
  */
 SKDP_EXPORT_API typedef struct skdp_server_state
 {
@@ -92,13 +151,99 @@ SKDP_EXPORT_API typedef struct skdp_server_state
 	QSC_SIMD_ALIGN uint8_t dsh[SKDP_STH_SIZE];	/*!< The device session hash */
 	QSC_SIMD_ALIGN uint8_t kid[SKDP_KID_SIZE];	/*!< The key identity string */
 	QSC_SIMD_ALIGN uint8_t ssh[SKDP_STH_SIZE];	/*!< The server session hash */
+	uint8_t cid[SKDP_CONNECTION_ID_SIZE];		/*!< The session connection identifier */
+	uint8_t pcid[SKDP_CONNECTION_ID_SIZE];		/*!< The identifier before the last reattach, accepted for a repeated request */
+	uint8_t rtresp[SKDP_HEADER_SIZE + SKDP_CONNECTION_ID_SIZE + SKDP_MACTAG_SIZE];	/*!< The last reattach response, resent to a repeated request */
 	QSC_SIMD_ALIGN uint8_t sdk[SKDP_SDK_SIZE];	/*!< The server derivation key */
+	skdp_cipher_state rtcpr;			/*!< The receive cipher state before the last reattach, verifies a repeated request */
 	uint64_t expiration;				/*!< The expiration time in seconds from epoch */
 	uint64_t rxseq;						/*!< The receive channel packet sequence number */
 	uint64_t txseq;						/*!< The transmit channel packet sequence number */
+	uint64_t rtrxseq;					/*!< The receive sequence number after the last reattach, zero if none */
+	uint64_t rttxseq;					/*!< The transmit sequence number after the last reattach */
+	skdp_server_keyset* keyset;			/*!< The optional published server keyset */
+	const skdp_keystore* kstore;		/*!< The optional memory-mapped server key store */
+	skdp_revocation* revoked;			/*!< The optional device revocation set */
+	const uint8_t* ckey;				/*!< The optional cookie key, enables the stateless connect response */
+	skdp_replay_cache* replay;			/*!< The optional handshake replay cache */
+	const skdp_cipher_suite* suite;		/*!< The negotiated cipher suite */
+	skdp_key_update kupdate;			/*!< The in-session key update state */
+	volatile uint64_t rxtime;			/*!< The time of the last authenticated record, in seconds */
 	skdp_flags exflag;					/*!< The key exchange position flag */
+	bool owned;							/*!< A connection owns the registered session; guarded by the registry mutex */
 } skdp_server_state;
 
+/*!
+ * \brief The keep-alive batch submission callback.
+ *
+ * \details
+ * Receives the packets built by a keep-alive sweep; packet \c i occupies \c SKDP_KEEPALIVE_PACKET_SIZE bytes at
+ * offset \c i*SKDP_KEEPALIVE_PACKET_SIZE of the arena and is destined for \c socks[i].
+ * Returns the number of packets that were submitted.
+ */
+typedef size_t (*skdp_keep_alive_submit)(void* context, const qsc_socket* const* socks, const uint8_t* arena, size_t count);
+
+/*!
+ * \struct skdp_keep_alive_session
+ * \brief A session entry in a keep-alive sweep.
+ */
+SKDP_EXPORT_API typedef struct skdp_keep_alive_session
+{
+	const skdp_server_state* ctx;		/*!< The server state, or NULL to probe unconditionally */
+	skdp_keep_alive_state* kctx;		/*!< The session keep-alive state */
+	const qsc_socket* sock;				/*!< The session socket */
+} skdp_keep_alive_session;
+
+/*!
+ * \struct skdp_keep_alive_sweep
+ * \brief The keep-alive sweep packet arena.
+ *
+ * \details
+ * The arena is allocated once and reused by every sweep. All due keep-alive packets are serialized into it back to back,
+ * and handed to the submission callback as one batch, so a sweep over many sessions makes a single pass over
+ * contiguous memory and one submission call per arena.
+ */
+SKDP_EXPORT_API typedef struct skdp_keep_alive_sweep
+{
+	uint8_t* arena;						/*!< The contiguous keep-alive packet arena */
+	const qsc_socket** socks;			/*!< The destination socket of each packet in the arena */
+	skdp_keep_alive_submit submit;		/*!< The optional batch submission callback */
+	void* context;						/*!< The submission callback context */
+	size_t capacity;					/*!< The number of packets the arena holds */
+} skdp_keep_alive_sweep;
+
+/*!
+ * \struct skdp_server_registry_entry
+ * \brief A session registry slot; a session is indexed by its identifier, and by its previous identifier after a reattach.
+ */
+SKDP_EXPORT_API typedef struct skdp_server_registry_entry
+{
+	skdp_server_state* state;			/*!< The registered session, NULL for an empty slot */
+	uint8_t cid[SKDP_CONNECTION_ID_SIZE];	/*!< The identifier the slot is indexed by */
+} skdp_server_registry_entry;
+
+/*!
+ * \struct skdp_server_registry
+ * \brief The registry of established sessions, indexed by connection identifier.
+ *
+ * \details
+ * An open-addressing table of server states keyed by their \c cid. A device that loses its connection reattaches
+ * to its registered session over a new connection with \c skdp_server_listen_registry. The registry holds pointers;
+ * the application owns the states and must remove a state before disposing of it.
+ *
+ * A registered session is owned by at most one connection. A session is owned by the connection that added it or
+ * reattached to it; when that connection fails, its thread releases the session with \c skdp_server_registry_release
+ * and no longer touches the state, and the session stays registered until it expires so the device can reattach.
+ * A reattach to a session that is still owned is refused.
+ */
+SKDP_EXPORT_API typedef struct skdp_server_registry
+{
+	skdp_server_registry_entry* slots;	/*!< The table slots */
+	qsc_mutex mtx;						/*!< The table mutex */
+	size_t capacity;					/*!< The number of slots, a power of two */
+	size_t count;						/*!< The number of registered sessions */
+} skdp_server_registry;
+
 /*!
  * \brief Close the remote session and dispose of server resources.
  *
@@ -113,6 +258,20 @@ SKDP_EXPORT_API typedef struct skdp_server_state
  */
 SKDP_EXPORT_API void skdp_server_connection_close(skdp_server_state* ctx, qsc_socket* sock, skdp_errors error);
 
+/*!
+ * \brief Initialize the datagram mode record state for an established session.
+ *
+ * \details
+ * Derives the datagram record keys from the session secrets. Call this immediately after the key exchange, before
+ * any stream record is sent, since an in-session key update advances the secrets.
+ *
+ * \param ctx [const] A pointer to the established SKDP server state.
+ * \param dgram A pointer to the datagram state.
+ *
+ * \return Returns true if the session is established and the datagram state was initialized.
+ */
+SKDP_EXPORT_API bool skdp_server_datagram_initialize(const skdp_server_state* ctx, skdp_datagram_state* dgram);
+
 /*!
  * \brief Send an error code to the remote host.
  *
@@ -124,6 +283,148 @@ SKDP_EXPORT_API void skdp_server_connection_close(skdp_server_state* ctx, qsc_so
  */
 SKDP_EXPORT_API void skdp_server_send_error(const qsc_socket* sock, skdp_errors error);
 
+/*!
+ * \brief Open the device acknowledgement of a hibernate request and export the session sealed under an export key.
+ *
+ * \details
+ * The export carries no cipher state, so it can be restored by any build of the library. The session is quiesced with
+ * the hibernate exchange: \c skdp_server_hibernate with an idle threshold of zero asks the device to acknowledge and
+ * ratchet both channels, and this function authenticates the acknowledgement, serializes the channel secrets and
+ * counters at that ratchet point, and seals them with \c skdp_session_seal. It is used for a hot restart or a
+ * migration in which a new server process adopts the session and its inherited socket descriptor.
+ * On success the state is disposed of; if the acknowledgement fails to authenticate the session is torn down.
+ *
+ * \param ctx A pointer to the SKDP server state, in the \c skdp_flag_hibernate position.
+ * \param packetin [const] The acknowledgement packet.
+ * \param key [const] The export key, \c SKDP_SESSION_EXPORT_KEY_SIZE bytes.
+ * \param output The output buffer, at least \c SKDP_SERVER_SESSION_EXPORT_SIZE bytes.
+ * \param otplen The length of the output buffer.
+ * \param outlen Receives the length of the sealed export.
+ *
+ * \return Returns \c skdp_error_none if the session was exported, otherwise an \c skdp_errors code.
+ */
+SKDP_EXPORT_API skdp_errors skdp_server_session_export(skdp_server_state* ctx, const skdp_network_packet* packetin, const uint8_t* key, uint8_t* output, size_t otplen, size_t* outlen);
+
+/*!
+ * \brief Import a session sealed by \c skdp_server_session_export.
+ *
+ * \details
+ * Authenticates and decrypts the export and restores it with \c skdp_server_session_deserialize.
+ * The server state should be initialized with \c skdp_server_initialize beforehand.
+ *
+ * \param ctx A pointer to the SKDP server state.
+ * \param key [const] The export key, \c SKDP_SESSION_EXPORT_KEY_SIZE bytes.
+ * \param input [const] The sealed export.
+ * \param inlen The length of the sealed export.
+ *
+ * \return Returns true if the session was authenticated and restored.
+ */
+SKDP_EXPORT_API bool skdp_server_session_import(skdp_server_state* ctx, const uint8_t* key, const uint8_t* input, size_t inlen);
+
+/*!
+ * \brief Restore an established session from its serialized form.
+ *
+ * \details
+ * Loads the channel secrets and counters written by \c skdp_server_session_serialize and re-expands both channel
+ * cipher states to the keys the device ratcheted to after its hibernate acknowledgement. The server derivation key
+ * and the process-local options (keyset, key store, revocation set, cookie key and replay cache) are not part of the
+ * session and are left as they are in \c ctx, so the state should be initialized with \c skdp_server_initialize first.
+ * A mismatched version or an unknown suite is rejected.
+ *
+ * \param ctx A pointer to the SKDP server state.
+ * \param input [const] The serialized session.
+ * \param inlen The length of the serialized session, \c SKDP_SERVER_SESSION_SIZE bytes.
+ *
+ * \return Returns true if the session was restored.
+ */
+SKDP_EXPORT_API bool skdp_server_session_deserialize(skdp_server_state* ctx, const uint8_t* input, size_t inlen);
+
+/*!
+ * \brief Open the device acknowledgement of a hibernate request and serialize the session.
+ *
+ * \details
+ * Writes the state needed to continue the session in another process without a new key exchange: the channel
+ * secrets the device ratcheted from after its acknowledgement, the connection identifier and the counters.
+ * The session must first be quiesced with \c skdp_server_hibernate, as for \c skdp_server_session_export.
+ * On success the state is disposed of. The output holds session secrets and must only be passed over a local,
+ * trusted channel, and erased after use.
+ *
+ * \param ctx A pointer to the SKDP server state, in the \c skdp_flag_hibernate position.
+ * \param packetin [const] The acknowledgement packet.
+ * \param output The output buffer, at least \c SKDP_SERVER_SESSION_SIZE bytes.
+ * \param otplen The length of the output buffer.
+ *
+ * \return Returns \c skdp_error_none if the session was serialized, otherwise an \c skdp_errors code.
+ */
+SKDP_EXPORT_API skdp_errors skdp_server_session_serialize(skdp_server_state* ctx, const skdp_network_packet* packetin, uint8_t* output, size_t otplen);
+
+/*!
+ * \brief Set the cookie key and enable the stateless connect response.
+ *
+ * \details
+ * In cookie mode the server encodes its half-open handshake state, the device identity and the two session hashes,
+ * into a time-stamped cookie authenticated with KMAC under the cookie key. The cookie is appended to the connect
+ * response, and the server erases its copy of that state. The client echoes the cookie in its exchange request,
+ * and the server verifies the tag and the \c SKDP_COOKIE_LIFETIME before restoring the state and continuing.
+ *
+ * The handshake is stateless only when it is driven by \c skdp_server_handshake, for example from \c skdp_engine.
+ * The connect request is answered from a scratch copy of an initialized listener state, which is then erased. The
+ * exchange request is processed by another fresh copy, and the per-connection state is allocated only if it
+ * succeeds; an abandoned handshake holds no server state and needs no cleanup. The blocking listeners keep the
+ * state and the connection's thread waiting for the exchange request, so they gain only the transcript erasure.
+ *
+ * The key is \c SKDP_COOKIE_KEY_SIZE random bytes, owned by the caller and shared by all server states of a listener;
+ * it must remain valid for the lifetime of the server state. Call after the state is initialized; pass NULL to disable.
+ *
+ * \param ctx A pointer to the SKDP server state structure.
+ * \param ckey [const] A pointer to the cookie key, or NULL.
+ */
+SKDP_EXPORT_API void skdp_server_set_cookie_key(skdp_server_state* ctx, const uint8_t* ckey);
+
+/*!
+ * \brief Enable the in-session key update.
+ *
+ * \details
+ * The transmit channel key is ratcheted forward, without a round trip, after the given number of records or
+ * message bytes, whichever is reached first; a zero value disables that trigger. Both are disabled by default,
+ * the recommended values are \c SKDP_KEY_UPDATE_RECORDS and \c SKDP_KEY_UPDATE_BYTES. The receive channel always
+ * follows a key update sent by the peer. Call this function after initialization.
+ *
+ * \param ctx A pointer to the SKDP server state structure.
+ * \param maxrecords The number of records sealed under one key.
+ * \param maxbytes The number of message bytes sealed under one key.
+ */
+SKDP_EXPORT_API void skdp_server_set_key_update(skdp_server_state* ctx, uint64_t maxrecords, uint64_t maxbytes);
+
+/*!
+ * \brief Set the handshake replay cache used by the server.
+ *
+ * \details
+ * Each exchange request is keyed by its device session hash combined with its MAC tag, and checked against the cache
+ * after the packet time check and before any cSHAKE derivation. A request seen within the packet time window is
+ * rejected with \c skdp_error_kex_auth_failure. One cache is shared by all server states of a listener, and must
+ * remain valid for the lifetime of the server state. Call after the state is initialized; pass NULL to disable.
+ *
+ * \param ctx A pointer to the SKDP server state structure.
+ * \param cache A pointer to the replay cache, or NULL.
+ */
+SKDP_EXPORT_API void skdp_server_set_replay_cache(skdp_server_state* ctx, skdp_replay_cache* cache);
+
+/*!
+ * \brief Set the device revocation set consulted by the server.
+ *
+ * \details
+ * The revocation set is checked with the device key identity on every connect request, before the server hashes the
+ * transcript or generates its session token. A revoked device receives a \c skdp_error_device_revoked error.
+ * The set must remain valid for the lifetime of the server state, and may be updated concurrently with
+ * \c skdp_revocation_add and moved to a new file with \c skdp_revocation_reopen. Call after the state is initialized;
+ * pass NULL to disable the check.
+ *
+ * \param ctx A pointer to the SKDP server state structure.
+ * \param rset A pointer to the revocation set, or NULL.
+ */
+SKDP_EXPORT_API void skdp_server_set_revocation(skdp_server_state* ctx, skdp_revocation* rset);
+
 /*!
  * \brief Send a keep-alive message to the remote host.
  *
@@ -138,6 +439,67 @@ SKDP_EXPORT_API void skdp_server_send_error(const qsc_socket* sock, skdp_errors
  */
 SKDP_EXPORT_API skdp_errors skdp_server_send_keep_alive(skdp_keep_alive_state* kctx, const qsc_socket* sock);
 
+/*!
+ * \brief Send a keep-alive message only if the session has been idle.
+ *
+ * \details
+ * Any authenticated record received from the client proves liveness. If a record was received within the
+ * idle interval, the keep-alive state is marked as answered and no probe is sent; otherwise a keep-alive
+ * message is sent with \c skdp_server_send_keep_alive. For busy sessions this removes the keep-alive traffic,
+ * the wakeup on the peer, and the send system call. This function may be called from a keep-alive thread
+ * while another thread decrypts records.
+ *
+ * \param ctx [const] A pointer to the SKDP server state structure.
+ * \param kctx A pointer to the SKDP keep-alive state structure.
+ * \param sock A pointer to the initialized socket structure.
+ * \param idle The idle interval in seconds, for example \c SKDP_KEEPALIVE_IDLE.
+ *
+ * \return Returns a value of type \c skdp_errors indicating the result of the keep-alive operation.
+ */
+SKDP_EXPORT_API skdp_errors skdp_server_send_keep_alive_idle(const skdp_server_state* ctx, skdp_keep_alive_state* kctx, const qsc_socket* sock, uint64_t idle);
+
+/*!
+ * \brief Send the due keep-alive messages of a set of sessions as a batch.
+ *
+ * \details
+ * Sessions that received an authenticated record within the idle interval are marked as answered and skipped, as in
+ * \c skdp_server_send_keep_alive_idle. A keep-alive packet for each remaining connected session is serialized into the
+ * sweep arena, using one timestamp for the whole sweep, and each full arena is passed to the submission callback.
+ * Without a callback, the packets are written to their sockets directly from the arena.
+ * A session whose packet is not submitted keeps its unanswered state and expires on the next keep-alive check.
+ *
+ * \param sweep A pointer to the initialized keep-alive sweep.
+ * \param sessions A pointer to the array of session entries.
+ * \param count The number of session entries.
+ * \param idle The idle interval in seconds, zero probes every session.
+ *
+ * \return Returns the number of keep-alive packets submitted.
+ */
+SKDP_EXPORT_API size_t skdp_server_keep_alive_sweep(skdp_keep_alive_sweep* sweep, const skdp_keep_alive_session* sessions, size_t count, uint64_t idle);
+
+/*!
+ * \brief Dispose of a keep-alive sweep.
+ *
+ * \param sweep A pointer to the keep-alive sweep.
+ */
+SKDP_EXPORT_API void skdp_server_keep_alive_sweep_dispose(skdp_keep_alive_sweep* sweep);
+
+/*!
+ * \brief Initialize a keep-alive sweep.
+ *
+ * \details
+ * Allocates an arena for \c capacity packets. The submission callback can batch the arena into a single
+ * kernel submission (for example an io_uring submission queue); when NULL, each packet is sent with \c qsc_socket_send.
+ *
+ * \param sweep A pointer to the keep-alive sweep.
+ * \param capacity The number of packets per batch, zero selects \c SKDP_KEEPALIVE_BATCH.
+ * \param submit The optional batch submission callback, or NULL.
+ * \param context The optional submission callback context.
+ *
+ * \return Returns true if the arena was allocated.
+ */
+SKDP_EXPORT_API bool skdp_server_keep_alive_sweep_initialize(skdp_keep_alive_sweep* sweep, size_t capacity, skdp_keep_alive_submit submit, void* context);
+
 /*!
  * \brief Initialize the SKDP server state.
  *
@@ -151,6 +513,37 @@ SKDP_EXPORT_API skdp_errors skdp_server_send_keep_alive(skdp_keep_alive_state* k
  */
 SKDP_EXPORT_API void skdp_server_initialize(skdp_server_state* ctx, const skdp_server_key* skey);
 
+/*!
+ * \brief Initialize the SKDP server state from a published keyset.
+ *
+ * \details
+ * This function initializes the server state with the currently published key, and binds the state to the keyset.
+ * Each subsequent key exchange acquires the key that is published when the connect request arrives, so a key
+ * published with \c skdp_keyset_publish is used by the next handshake without restarting the listener.
+ *
+ * \param ctx A pointer to the SKDP server state structure to be initialized.
+ * \param keyset A pointer to the published server keyset.
+ *
+ * \return Returns true if a published key was acquired.
+ */
+SKDP_EXPORT_API bool skdp_server_initialize_keyset(skdp_server_state* ctx, skdp_server_keyset* keyset);
+
+/*!
+ * \brief Initialize the SKDP server state from a memory-mapped key store.
+ *
+ * \details
+ * This function binds the server state to an open key store. No key is loaded at initialization; on each connect
+ * request the server key is located in the store with the server identity embedded in the device key identity.
+ * A device whose identity is not present in the store is rejected at the connect request.
+ * The key store must remain open for the lifetime of the server state.
+ *
+ * \param ctx A pointer to the SKDP server state structure to be initialized.
+ * \param kstore [const] A pointer to an open server key store.
+ *
+ * \return Returns true if the key store is open and the state was initialized.
+ */
+SKDP_EXPORT_API bool skdp_server_initialize_keystore(skdp_server_state* ctx, const skdp_keystore* kstore);
+
 /*!
  * \brief Run the IPv4 networked key exchange function.
  *
@@ -184,6 +577,199 @@ SKDP_EXPORT_API skdp_errors skdp_server_listen_ipv4(skdp_server_state* ctx, qsc_
  */
 SKDP_EXPORT_API skdp_errors skdp_server_listen_ipv6(skdp_server_state* ctx, qsc_socket* sock, const qsc_ipinfo_ipv6_address* address, uint16_t port);
 
+/*!
+ * \brief Run the key exchange function over a transport.
+ *
+ * \details
+ * This function runs the server side of the key exchange over an already connected transport, such as a socketpair,
+ * a pipe, or an application event loop. On failure an error packet is sent and the transport is closed.
+ *
+ * \param ctx A pointer to the SKDP server state structure.
+ * \param trans [const] A pointer to the connected transport.
+ *
+ * \return Returns a value of type \c skdp_errors indicating the success or failure of the key exchange.
+ */
+SKDP_EXPORT_API skdp_errors skdp_server_listen_transport(skdp_server_state* ctx, const skdp_transport* trans);
+
+/*!
+ * \brief Process one key exchange packet without blocking.
+ *
+ * \details
+ * The key exchange as a step function, for a server driven by an event loop such as \c skdp_engine. The caller
+ * frames each packet from the received bytes; a packet is \c SKDP_HEADER_SIZE bytes followed by the message length
+ * carried in its header. Each connect, exchange and establish request is passed in turn, and the response written to
+ * \c output is sent to the device. The session is established when the state reaches
+ * \c skdp_flag_session_established; records are then carried with \c skdp_server_encrypt_packet and
+ * \c skdp_server_decrypt_packet. On failure the output holds an error packet for the device, the state is reset,
+ * and the connection should be closed once the error packet is sent.
+ * The blocking listeners run the same steps over a transport.
+ *
+ * In cookie mode a freshly initialized state also accepts an exchange request echoing a cookie, and continues from
+ * the cookie; see \c skdp_server_set_cookie_key for the stateless accept path this allows.
+ *
+ * \param ctx A pointer to the initialized SKDP server state.
+ * \param input [const] The request packet.
+ * \param inlen The length of the request packet, at most \c SKDP_SERVER_HANDSHAKE_BUFFER_SIZE bytes.
+ * \param output The response buffer.
+ * \param otplen The length of the response buffer, at least \c SKDP_SERVER_HANDSHAKE_BUFFER_SIZE bytes.
+ * \param outlen Receives the number of bytes to send.
+ *
+ * \return Returns \c skdp_error_none if the request was answered, otherwise an \c skdp_errors code.
+ */
+SKDP_EXPORT_API skdp_errors skdp_server_handshake(skdp_server_state* ctx, const uint8_t* input, size_t inlen, uint8_t* output, size_t otplen, size_t* outlen);
+
+/*!
+ * \brief Request hibernation of a session that has been idle longer than a threshold.
+ *
+ * \details
+ * An idle session keeps two expanded cipher states resident. Hibernation replaces them with a compact record that
+ * holds only the channel secrets, the identifiers and the sequence counters, sealed with \c skdp_session_seal under
+ * a server hibernation key. It runs in two phases, so that no record in flight is sealed under a key the server
+ * no longer holds:
+ * - This function sends one record flagged \c skdp_flag_hibernate under the current transmit key, and moves the
+ * session to the \c skdp_flag_hibernate position. The server sends nothing more on the session; records from the
+ * device are still opened with \c skdp_server_decrypt_packet.
+ * - The device answers with a record flagged \c skdp_flag_hibernate_ack under its current transmit key, and then
+ * ratchets both channels forward. The server opens it with \c skdp_server_hibernate_complete, which seals the
+ * hibernation record and disposes of the state.
+ *
+ * Disposing of the state erases it in place; the \c skdp_server_state structure keeps its full size. Memory is
+ * only reclaimed if the caller removes the state from any registry, frees it (or returns it to its allocator), and
+ * keeps only the sealed record, of at most \c SKDP_SERVER_HIBERNATE_SIZE bytes, until the session is woken into
+ * a newly allocated state.
+ *
+ * \param ctx A pointer to the established SKDP server state.
+ * \param trans [const] A pointer to the connected session transport.
+ * \param idle The idle threshold in seconds; the request is sent if no record was received for this long.
+ * \param pending Receives true if the request was sent and the acknowledgement is awaited.
+ *
+ * \return Returns \c skdp_error_none if the request was sent or the session is still active, otherwise an
+ * \c skdp_errors code.
+ */
+SKDP_EXPORT_API skdp_errors skdp_server_hibernate(skdp_server_state* ctx, const skdp_transport* trans, uint64_t idle, bool* pending);
+
+/*!
+ * \brief Open the device acknowledgement of a hibernate request and hibernate the session.
+ *
+ * \details
+ * Authenticates the \c skdp_flag_hibernate_ack record under the current receive key, then seals the session into
+ * the hibernation record and disposes of the state. The state is not freed; the caller releases it, after removing
+ * it from any registry, and holds the record in its place.
+ * \c skdp_server_wake re-derives the keys both sides ratcheted to. If the acknowledgement fails to authenticate the
+ * session is torn down.
+ *
+ * \param ctx A pointer to the SKDP server state, in the \c skdp_flag_hibernate position.
+ * \param packetin [const] The acknowledgement packet.
+ * \param key [const] The hibernation key, \c SKDP_SESSION_EXPORT_KEY_SIZE bytes.
+ * \param output The output buffer, at least \c SKDP_SERVER_HIBERNATE_SIZE bytes.
+ * \param otplen The length of the output buffer.
+ * \param outlen Receives the length of the hibernation record.
+ *
+ * \return Returns \c skdp_error_none if the session was hibernated, otherwise an \c skdp_errors code.
+ */
+SKDP_EXPORT_API skdp_errors skdp_server_hibernate_complete(skdp_server_state* ctx, const skdp_network_packet* packetin, const uint8_t* key, uint8_t* output, size_t otplen, size_t* outlen);
+
+/*!
+ * \brief Wake a hibernated session.
+ *
+ * \details
+ * Opens the hibernation record and re-expands both channel cipher states from the stored secrets. Call this when the
+ * next record arrives on the session socket, before \c skdp_server_decrypt_packet. The server state should be
+ * initialized with \c skdp_server_initialize beforehand.
+ *
+ * \param ctx A pointer to the SKDP server state, receives the session.
+ * \param key [const] The hibernation key, \c SKDP_SESSION_EXPORT_KEY_SIZE bytes.
+ * \param input [const] The hibernation record.
+ * \param inlen The length of the hibernation record.
+ *
+ * \return Returns true if the record was authenticated and the session restored.
+ */
+SKDP_EXPORT_API bool skdp_server_wake(skdp_server_state* ctx, const uint8_t* key, const uint8_t* input, size_t inlen);
+
+/*!
+ * \brief Run the key exchange or a session reattach over a connected transport.
+ *
+ * \details
+ * Reads the first packet of the connection and dispatches on its flag. A connect request runs the key exchange
+ * with \c ctx, and the new session is added to the registry. A reattach request looks up the registered session by
+ * its connection identifier and verifies a single record sealed under the session's receive channel; on success
+ * the session continues over this transport with its cipher states and sequence numbers, a sealed response is
+ * returned to the device, and both ends move to the next connection identifier. A failed proof leaves the
+ * registered session unchanged, and a session still owned by another connection is refused.
+ * If the response is lost, the device repeats its request under the previous identifier; until a record moves
+ * either channel, the repeat is verified against the saved receive state and answered with the same response.
+ *
+ * \param ctx A pointer to an initialized server state, used if the device starts a new key exchange.
+ * \param reg A pointer to the session registry.
+ * \param trans [const] A pointer to the connected transport.
+ * \param session Receives a pointer to the established or reattached session state.
+ *
+ * \return Returns \c skdp_error_none on success, otherwise an \c skdp_errors code.
+ */
+SKDP_EXPORT_API skdp_errors skdp_server_listen_registry(skdp_server_state* ctx, skdp_server_registry* reg, const skdp_transport* trans, skdp_server_state** session);
+
+/*!
+ * \brief Add an established session to the registry, owned by the calling connection.
+ *
+ * \param reg A pointer to the session registry.
+ * \param ctx A pointer to the established server state.
+ *
+ * \return Returns true if the session was added; false if the registry is full or the identifier is registered.
+ */
+SKDP_EXPORT_API bool skdp_server_registry_add(skdp_server_registry* reg, skdp_server_state* ctx);
+
+/*!
+ * \brief Dispose of the session registry and release its memory; the registered states are not disposed.
+ *
+ * \param reg A pointer to the session registry.
+ */
+SKDP_EXPORT_API void skdp_server_registry_dispose(skdp_server_registry* reg);
+
+/*!
+ * \brief Initialize the session registry.
+ *
+ * \param reg A pointer to the session registry.
+ * \param capacity The maximum number of registered sessions.
+ *
+ * \return Returns true if the registry was initialized.
+ */
+SKDP_EXPORT_API bool skdp_server_registry_initialize(skdp_server_registry* reg, size_t capacity);
+
+/*!
+ * \brief Release a registered session owned by a failed connection, so the device can reattach to it.
+ *
+ * \details
+ * The releasing thread must not use the state afterwards, unless it claims the session again.
+ *
+ * \param reg A pointer to the session registry.
+ * \param ctx A pointer to the registered server state.
+ */
+SKDP_EXPORT_API void skdp_server_registry_release(skdp_server_registry* reg, skdp_server_state* ctx);
+
+/*!
+ * \brief Remove a session from the registry.
+ *
+ * \param reg A pointer to the session registry.
+ * \param ctx [const] A pointer to the registered server state.
+ *
+ * \return Returns true if the session was registered and has been removed.
+ */
+SKDP_EXPORT_API bool skdp_server_registry_remove(skdp_server_registry* reg, const skdp_server_state* ctx);
+
+/*!
+ * \brief Find a session by connection identifier and claim it.
+ *
+ * \details
+ * The session stays registered and is marked owned; the caller has exclusive use of the state until it is released
+ * with \c skdp_server_registry_release. The previous identifier of a reattached session also finds it.
+ *
+ * \param reg A pointer to the session registry.
+ * \param cid [const] The connection identifier, \c SKDP_CONNECTION_ID_SIZE bytes.
+ *
+ * \return Returns the server state, or NULL if no session is registered with the identifier or it is owned.
+ */
+SKDP_EXPORT_API skdp_server_state* skdp_server_registry_take(skdp_server_registry* reg, const uint8_t* cid);
+
 /*!
  * \brief Decrypt a received SKDP packet.
  *
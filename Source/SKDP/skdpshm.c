@@ -0,0 +1,449 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#	define _GNU_SOURCE
+#endif
+#include "skdpshm.h"
+#include "intutils.h"
+#include "memutils.h"
+#if defined(QSC_SYSTEM_OS_LINUX)
+#	include <limits.h>
+#	include <linux/futex.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+#if defined(QSC_SYSTEM_OS_LINUX)
+
+#define SHM_LINE_SIZE 64U
+#define SHM_MAGIC 0x4D485350444B53ULL
+#define SHM_VERSION 0x01U
+#define SHM_HEADER_SIZE 4096U
+#define SHM_CAPACITY_MIN 4096U
+#define SHM_CAPACITY_MAX (1UL << 30U)
+
+typedef struct shm_ring
+{
+	uint32_t head;					/* the consumer position */
+	uint32_t spacewait;				/* the producer is waiting for space */
+	uint8_t pad1[SHM_LINE_SIZE - (2U * sizeof(uint32_t))];
+	uint32_t tail;					/* the producer position */
+	uint32_t datawait;				/* the consumer is waiting for data */
+	uint8_t pad2[SHM_LINE_SIZE - (2U * sizeof(uint32_t))];
+} shm_ring;
+
+typedef struct shm_control
+{
+	uint64_t magic;
+	uint32_t version;
+	uint32_t capacity;
+	uint32_t closed;
+	uint8_t pad[SHM_LINE_SIZE - sizeof(uint64_t) - (3U * sizeof(uint32_t))];
+	shm_ring rings[2U];
+} shm_control;
+
+static void shm_futex_wait(uint32_t* word, uint32_t expected)
+{
+	/* the region is shared between processes, so the futex is not private */
+	syscall(SYS_futex, word, FUTEX_WAIT, expected, NULL, NULL, 0);
+}
+
+static void shm_futex_wake(uint32_t* word)
+{
+	syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+static void shm_pause(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+static bool shm_closed(const skdp_shm_channel* channel)
+{
+	return (__atomic_load_n(&((const shm_control*)channel->region)->closed, __ATOMIC_ACQUIRE) != 0U);
+}
+
+static void shm_wait(const skdp_shm_channel* channel, uint32_t* word, uint32_t* waitflag, uint32_t observed)
+{
+	/* announce the wait, then re-check the position so a publish between the two cannot be missed */
+	__atomic_store_n(waitflag, 1U, __ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n(word, __ATOMIC_SEQ_CST) == observed && shm_closed(channel) == false)
+	{
+		shm_futex_wait(word, observed);
+	}
+
+	__atomic_store_n(waitflag, 0U, __ATOMIC_SEQ_CST);
+}
+
+static void shm_shutdown(skdp_shm_channel* channel)
+{
+	shm_control* ctl;
+
+	ctl = (shm_control*)channel->region;
+	__atomic_store_n(&ctl->closed, 1U, __ATOMIC_SEQ_CST);
+
+	/* release any waiter on either side */
+	shm_futex_wake(&ctl->rings[0U].head);
+	shm_futex_wake(&ctl->rings[0U].tail);
+	shm_futex_wake(&ctl->rings[1U].head);
+	shm_futex_wake(&ctl->rings[1U].tail);
+}
+
+static void shm_map(skdp_shm_channel* channel, bool creator)
+{
+	shm_control* ctl;
+	uint8_t* data;
+
+	ctl = (shm_control*)channel->region;
+	data = channel->region + SHM_HEADER_SIZE;
+	channel->capacity = ctl->capacity;
+
+	/* the creator transmits on the first ring, the peer on the second */
+	channel->txring = &ctl->rings[(creator == true) ? 0U : 1U];
+	channel->rxring = &ctl->rings[(creator == true) ? 1U : 0U];
+	channel->txdata = data + ((creator == true) ? 0U : channel->capacity);
+	channel->rxdata = data + ((creator == true) ? channel->capacity : 0U);
+}
+
+static size_t shm_transport_receive(void* user, uint8_t* output, size_t otplen)
+{
+	return skdp_shm_receive((skdp_shm_channel*)user, output, otplen);
+}
+
+static size_t shm_transport_send(void* user, const uint8_t* input, size_t inlen)
+{
+	return skdp_shm_send((skdp_shm_channel*)user, input, inlen);
+}
+
+static void shm_transport_close(void* user)
+{
+	skdp_shm_channel* channel;
+
+	channel = (skdp_shm_channel*)user;
+
+	if (channel->region != NULL)
+	{
+		shm_shutdown(channel);
+	}
+}
+
+#endif
+
+bool skdp_shm_attach(skdp_shm_channel* channel, int32_t fd)
+{
+	SKDP_ASSERT(channel != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (channel != NULL && fd >= 0)
+	{
+		qsc_memutils_clear(channel, sizeof(skdp_shm_channel));
+		channel->fd = fd;
+
+#if defined(QSC_SYSTEM_OS_LINUX)
+		const shm_control* ctl;
+		struct stat fst;
+		void* mem;
+
+		if (fstat(fd, &fst) == 0 && (size_t)fst.st_size > SHM_HEADER_SIZE)
+		{
+			mem = mmap(NULL, (size_t)fst.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+			if (mem != MAP_FAILED)
+			{
+				channel->region = (uint8_t*)mem;
+				channel->length = (size_t)fst.st_size;
+				ctl = (const shm_control*)mem;
+
+				/* the region must be a channel of this version, with a power of two capacity in bounds and the advertised size */
+				if (ctl->magic == SHM_MAGIC && ctl->version == SHM_VERSION &&
+					ctl->capacity >= SHM_CAPACITY_MIN && ctl->capacity <= SHM_CAPACITY_MAX &&
+					(ctl->capacity & (ctl->capacity - 1U)) == 0U &&
+					channel->length == SHM_HEADER_SIZE + (2U * (size_t)ctl->capacity))
+				{
+					shm_map(channel, false);
+					res = true;
+				}
+			}
+		}
+#endif
+
+		if (res == false)
+		{
+			skdp_shm_close(channel);
+		}
+	}
+
+	return res;
+}
+
+void skdp_shm_close(skdp_shm_channel* channel)
+{
+	SKDP_ASSERT(channel != NULL);
+
+	if (channel != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_LINUX)
+		if (channel->region != NULL)
+		{
+			shm_shutdown(channel);
+			munmap(channel->region, channel->length);
+		}
+
+		if (channel->fd >= 0)
+		{
+			close(channel->fd);
+		}
+#endif
+
+		qsc_memutils_clear(channel, sizeof(skdp_shm_channel));
+		channel->fd = -1;
+	}
+}
+
+bool skdp_shm_create(skdp_shm_channel* channel, size_t capacity)
+{
+	SKDP_ASSERT(channel != NULL);
+
+	bool res;
+
+	res = false;
+
+	if (channel != NULL)
+	{
+		qsc_memutils_clear(channel, sizeof(skdp_shm_channel));
+		channel->fd = -1;
+
+#if defined(QSC_SYSTEM_OS_LINUX)
+		shm_control* ctl;
+		size_t cap;
+		void* mem;
+
+		if (capacity == 0U)
+		{
+			capacity = SKDP_SHM_CAPACITY;
+		}
+
+		if (capacity <= SHM_CAPACITY_MAX)
+		{
+			/* the ring positions wrap with a mask, so the capacity is a power of two */
+			cap = SHM_CAPACITY_MIN;
+
+			while (cap < capacity)
+			{
+				cap <<= 1U;
+			}
+
+			channel->length = SHM_HEADER_SIZE + (2U * cap);
+			channel->fd = (int32_t)memfd_create("skdp-shm", MFD_CLOEXEC);
+
+			if (channel->fd >= 0 && ftruncate(channel->fd, (off_t)channel->length) == 0)
+			{
+				mem = mmap(NULL, channel->length, PROT_READ | PROT_WRITE, MAP_SHARED, channel->fd, 0);
+
+				if (mem != MAP_FAILED)
+				{
+					/* a new memfd is zero filled, so the rings start empty */
+					channel->region = (uint8_t*)mem;
+					ctl = (shm_control*)mem;
+					ctl->capacity = (uint32_t)cap;
+					ctl->version = SHM_VERSION;
+					__atomic_store_n(&ctl->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+					shm_map(channel, true);
+					res = true;
+				}
+			}
+		}
+
+		if (res == false)
+		{
+			skdp_shm_close(channel);
+		}
+#else
+		(void)capacity;
+#endif
+	}
+
+	return res;
+}
+
+size_t skdp_shm_receive(skdp_shm_channel* channel, uint8_t* output, size_t otplen)
+{
+	SKDP_ASSERT(channel != NULL);
+	SKDP_ASSERT(output != NULL);
+
+	size_t res;
+
+	res = 0U;
+
+	if (channel != NULL && channel->region != NULL && output != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_LINUX)
+		shm_ring* ring;
+		size_t first;
+		size_t len;
+		uint32_t avail;
+		uint32_t head;
+		uint32_t pos;
+		uint32_t spins;
+		uint32_t tail;
+		bool run;
+
+		ring = (shm_ring*)channel->rxring;
+		head = ring->head;
+		spins = 0U;
+		run = true;
+
+		while (res < otplen && run == true)
+		{
+			tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+			avail = tail - head;
+
+			if (avail > channel->capacity)
+			{
+				/* the peer published a position outside the ring; the channel is treated as closed */
+				shm_shutdown(channel);
+				run = false;
+			}
+			else if (avail != 0U)
+			{
+				/* copy out, in two parts if the data wraps the end of the ring */
+				len = qsc_intutils_min((size_t)avail, otplen - res);
+				pos = head & (channel->capacity - 1U);
+				first = qsc_intutils_min(len, (size_t)(channel->capacity - pos));
+				qsc_memutils_copy(output + res, channel->rxdata + pos, first);
+				qsc_memutils_copy(output + res + first, channel->rxdata, len - first);
+				head += (uint32_t)len;
+				res += len;
+				__atomic_store_n(&ring->head, head, __ATOMIC_SEQ_CST);
+
+				if (__atomic_load_n(&ring->spacewait, __ATOMIC_SEQ_CST) != 0U)
+				{
+					shm_futex_wake(&ring->head);
+				}
+
+				spins = 0U;
+			}
+			else if (shm_closed(channel) == true)
+			{
+				run = false;
+			}
+			else if (spins < SKDP_SHM_SPIN_COUNT)
+			{
+				shm_pause();
+				++spins;
+			}
+			else
+			{
+				shm_wait(channel, &ring->tail, &ring->datawait, tail);
+			}
+		}
+#else
+		(void)otplen;
+#endif
+	}
+
+	return res;
+}
+
+size_t skdp_shm_send(skdp_shm_channel* channel, const uint8_t* input, size_t inlen)
+{
+	SKDP_ASSERT(channel != NULL);
+	SKDP_ASSERT(input != NULL);
+
+	size_t res;
+
+	res = 0U;
+
+	if (channel != NULL && channel->region != NULL && input != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_LINUX)
+		shm_ring* ring;
+		size_t first;
+		size_t len;
+		uint32_t head;
+		uint32_t pos;
+		uint32_t space;
+		uint32_t spins;
+		uint32_t tail;
+		bool run;
+
+		ring = (shm_ring*)channel->txring;
+		tail = ring->tail;
+		spins = 0U;
+		run = true;
+
+		while (res < inlen && run == true)
+		{
+			head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+			space = channel->capacity - (tail - head);
+
+			if (shm_closed(channel) == true)
+			{
+				run = false;
+			}
+			else if (tail - head > channel->capacity)
+			{
+				/* the peer published a position outside the ring; the channel is treated as closed */
+				shm_shutdown(channel);
+				run = false;
+			}
+			else if (space != 0U)
+			{
+				/* copy in, in two parts if the space wraps the end of the ring */
+				len = qsc_intutils_min((size_t)space, inlen - res);
+				pos = tail & (channel->capacity - 1U);
+				first = qsc_intutils_min(len, (size_t)(channel->capacity - pos));
+				qsc_memutils_copy(channel->txdata + pos, input + res, first);
+				qsc_memutils_copy(channel->txdata, input + res + first, len - first);
+				tail += (uint32_t)len;
+				res += len;
+				__atomic_store_n(&ring->tail, tail, __ATOMIC_SEQ_CST);
+
+				/* a wake costs a system call, and is only made when the reader sleeps */
+				if (__atomic_load_n(&ring->datawait, __ATOMIC_SEQ_CST) != 0U)
+				{
+					shm_futex_wake(&ring->tail);
+				}
+
+				spins = 0U;
+			}
+			else if (spins < SKDP_SHM_SPIN_COUNT)
+			{
+				shm_pause();
+				++spins;
+			}
+			else
+			{
+				shm_wait(channel, &ring->head, &ring->spacewait, head);
+			}
+		}
+#else
+		(void)inlen;
+#endif
+	}
+
+	return res;
+}
+
+void skdp_shm_transport(skdp_shm_channel* channel, skdp_transport* trans)
+{
+	SKDP_ASSERT(channel != NULL);
+	SKDP_ASSERT(trans != NULL);
+
+	if (channel != NULL && trans != NULL)
+	{
+		qsc_memutils_clear(trans, sizeof(skdp_transport));
+#if defined(QSC_SYSTEM_OS_LINUX)
+		trans->send = &shm_transport_send;
+		trans->receive = &shm_transport_receive;
+		trans->close = &shm_transport_close;
+#endif
+		trans->user = channel;
+	}
+}
@@ -0,0 +1,164 @@
+/* 2021-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SKDP_SHM_H
+#define SKDP_SHM_H
+
+#include "skdpcommon.h"
+#include "skdp.h"
+#include "skdptransport.h"
+
+/**
+ * \file skdpshm.h
+ * \brief The SKDP shared-memory transport.
+ *
+ * \details
+ * This header defines a transport for SKDP peers on the same host. The channel is a shared memory region,
+ * created with \c memfd_create, that holds two single-producer single-consumer byte rings, one for each direction.
+ * Handshake packets and sealed records are written into the rings unchanged, so the key exchange and record
+ * protection are the same as over a network socket.
+ *
+ * The fast path makes no system calls: a writer copies into the ring and publishes its position with a release
+ * store, and a reader that finds data copies it out. A reader that finds the ring empty spins briefly, then
+ * announces that it is waiting and sleeps on a futex in the region; the writer issues a wake only when a waiter has
+ * announced itself. A writer that finds the ring full waits for space in the same way.
+ *
+ * The creating process passes the region descriptor to its peer, by inheritance across \c fork or over a Unix
+ * domain socket, and the peer attaches to it. Closing either end wakes and releases the other. The shared memory
+ * transport is available on Linux; on other platforms creation fails.
+ */
+
+/*!
+ * \def SKDP_SHM_CAPACITY
+ * \brief The default ring capacity in bytes for each direction (a power of two).
+ */
+#define SKDP_SHM_CAPACITY (256U * 1024U)
+
+/*!
+ * \def SKDP_SHM_SPIN_COUNT
+ * \brief The number of polls of an empty or full ring before the caller sleeps.
+ */
+#define SKDP_SHM_SPIN_COUNT 1024U
+
+/*!
+ * \struct skdp_shm_channel
+ * \brief The shared-memory channel state.
+ */
+SKDP_EXPORT_API typedef struct skdp_shm_channel
+{
+	uint8_t* region;				/*!< The mapped shared region */
+	void* rxring;					/*!< The receive ring control block (internal) */
+	void* txring;					/*!< The transmit ring control block (internal) */
+	uint8_t* rxdata;				/*!< The receive ring data */
+	uint8_t* txdata;				/*!< The transmit ring data */
+	size_t length;					/*!< The mapped region length */
+	uint32_t capacity;				/*!< The ring capacity in bytes */
+	int32_t fd;						/*!< The shared memory descriptor */
+} skdp_shm_channel;
+
+/*!
+ * \brief Attach to a shared-memory channel created by the peer.
+ *
+ * \param channel A pointer to the channel state.
+ * \param fd The shared memory descriptor received from the creator; the channel takes ownership of it.
+ *
+ * \return Returns true if the region was mapped and is a valid channel.
+ */
+SKDP_EXPORT_API bool skdp_shm_attach(skdp_shm_channel* channel, int32_t fd);
+
+/*!
+ * \brief Close the channel, wake the peer, and release the mapping.
+ *
+ * \param channel A pointer to the channel state.
+ */
+SKDP_EXPORT_API void skdp_shm_close(skdp_shm_channel* channel);
+
+/*!
+ * \brief Create a shared-memory channel.
+ *
+ * \param channel A pointer to the channel state.
+ * \param capacity The ring capacity in bytes, rounded up to a power of two; zero selects \c SKDP_SHM_CAPACITY.
+ *
+ * \return Returns true if the region was created and mapped; the descriptor is in \c channel->fd.
+ */
+SKDP_EXPORT_API bool skdp_shm_create(skdp_shm_channel* channel, size_t capacity);
+
+/*!
+ * \brief Receive exactly the requested number of bytes, waiting for the peer as needed.
+ *
+ * \param channel A pointer to the channel state.
+ * \param output The output buffer.
+ * \param otplen The number of bytes to receive.
+ *
+ * \return Returns the number of bytes received; fewer than requested if the peer closed the channel.
+ */
+SKDP_EXPORT_API size_t skdp_shm_receive(skdp_shm_channel* channel, uint8_t* output, size_t otplen);
+
+/*!
+ * \brief Send a buffer, waiting for ring space as needed.
+ *
+ * \param channel A pointer to the channel state.
+ * \param input [const] The input buffer.
+ * \param inlen The number of bytes to send.
+ *
+ * \return Returns the number of bytes sent; fewer than requested if the peer closed the channel.
+ */
+SKDP_EXPORT_API size_t skdp_shm_send(skdp_shm_channel* channel, const uint8_t* input, size_t inlen);
+
+/*!
+ * \brief Bind a transport to a shared-memory channel.
+ *
+ * \param channel A pointer to the channel state.
+ * \param trans A pointer to the transport.
+ */
+SKDP_EXPORT_API void skdp_shm_transport(skdp_shm_channel* channel, skdp_transport* trans);
+
+#endif
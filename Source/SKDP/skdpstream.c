@@ -0,0 +1,433 @@
+#include "skdpstream.h"
+#include "intutils.h"
+#include "memutils.h"
+
+static skdp_stream* stream_find(skdp_stream_mux* mux, uint32_t sid)
+{
+	skdp_stream* pstm;
+	size_t i;
+
+	pstm = NULL;
+
+	if (sid != 0U)
+	{
+		for (i = 0U; i < SKDP_STREAM_MAX_STREAMS; ++i)
+		{
+			if (mux->streams[i].sid == sid)
+			{
+				pstm = &mux->streams[i];
+				break;
+			}
+		}
+	}
+
+	return pstm;
+}
+
+static skdp_stream* stream_allocate(skdp_stream_mux* mux, uint32_t sid)
+{
+	skdp_stream* pstm;
+	size_t i;
+
+	pstm = NULL;
+
+	/* a free slot has a zero stream id */
+	for (i = 0U; i < SKDP_STREAM_MAX_STREAMS; ++i)
+	{
+		if (mux->streams[i].sid == 0U)
+		{
+			pstm = &mux->streams[i];
+			qsc_memutils_clear(pstm, sizeof(skdp_stream));
+			pstm->sid = sid;
+			pstm->rxwindow = mux->window;
+			pstm->txwindow = mux->window;
+			break;
+		}
+	}
+
+	return pstm;
+}
+
+static void stream_release(skdp_stream* pstm)
+{
+	qsc_memutils_clear(pstm, sizeof(skdp_stream));
+}
+
+static void stream_notify(const skdp_stream_mux* mux, uint32_t sid, skdp_stream_events event)
+{
+	if (mux->event != NULL)
+	{
+		mux->event(mux->context, sid, event);
+	}
+}
+
+static void stream_frame_header(uint8_t* frame, skdp_stream_frames type, uint32_t sid, size_t length)
+{
+	frame[0U] = (uint8_t)type;
+	qsc_intutils_le32to8(frame + 1U, sid);
+	qsc_intutils_le16to8(frame + 5U, (uint16_t)length);
+}
+
+static void stream_reply_reset(uint8_t* reply, size_t replycap, size_t* replylen, uint32_t sid)
+{
+	/* best effort; the stream is already released locally */
+	if (*replylen + SKDP_STREAM_HEADER_SIZE <= replycap)
+	{
+		stream_frame_header(reply + *replylen, skdp_stream_frame_reset, sid, 0U);
+		*replylen += SKDP_STREAM_HEADER_SIZE;
+	}
+}
+
+bool skdp_stream_close(skdp_stream_mux* mux, uint32_t sid, uint8_t* frame, size_t* framelen)
+{
+	SKDP_ASSERT(mux != NULL);
+	SKDP_ASSERT(frame != NULL);
+	SKDP_ASSERT(framelen != NULL);
+
+	skdp_stream* pstm;
+	bool res;
+
+	res = false;
+
+	if (mux != NULL && frame != NULL && framelen != NULL)
+	{
+		*framelen = 0U;
+		pstm = stream_find(mux, sid);
+
+		if (pstm != NULL && pstm->lclosed == false)
+		{
+			stream_frame_header(frame, skdp_stream_frame_close, sid, 0U);
+			*framelen = SKDP_STREAM_HEADER_SIZE;
+			pstm->lclosed = true;
+
+			if (pstm->rclosed == true)
+			{
+				stream_release(pstm);
+			}
+
+			res = true;
+		}
+	}
+
+	return res;
+}
+
+void skdp_stream_dispose(skdp_stream_mux* mux)
+{
+	SKDP_ASSERT(mux != NULL);
+
+	if (mux != NULL)
+	{
+		qsc_memutils_clear(mux, sizeof(skdp_stream_mux));
+	}
+}
+
+void skdp_stream_initialize(skdp_stream_mux* mux, bool initiator, uint32_t window, skdp_stream_event_callback event, void* context)
+{
+	SKDP_ASSERT(mux != NULL);
+
+	if (mux != NULL)
+	{
+		qsc_memutils_clear(mux, sizeof(skdp_stream_mux));
+		mux->event = event;
+		mux->context = context;
+		mux->nextsid = (initiator == true) ? 1U : 2U;
+		mux->window = (window != 0U) ? window : SKDP_STREAM_WINDOW_SIZE;
+	}
+}
+
+bool skdp_stream_open(skdp_stream_mux* mux, uint32_t* sid, skdp_stream_receive_callback receive, void* context, uint8_t* frame, size_t* framelen)
+{
+	SKDP_ASSERT(mux != NULL);
+	SKDP_ASSERT(sid != NULL);
+	SKDP_ASSERT(frame != NULL);
+	SKDP_ASSERT(framelen != NULL);
+
+	skdp_stream* pstm;
+	bool res;
+
+	res = false;
+
+	if (mux != NULL && sid != NULL && frame != NULL && framelen != NULL)
+	{
+		*framelen = 0U;
+
+		/* stream ids are not reused within a session */
+		if (mux->nextsid < UINT32_MAX - 1U)
+		{
+			pstm = stream_allocate(mux, mux->nextsid);
+
+			if (pstm != NULL)
+			{
+				pstm->receive = receive;
+				pstm->context = context;
+				*sid = mux->nextsid;
+				mux->nextsid += 2U;
+
+				stream_frame_header(frame, skdp_stream_frame_open, *sid, 0U);
+				*framelen = SKDP_STREAM_HEADER_SIZE;
+				res = true;
+			}
+		}
+	}
+
+	return res;
+}
+
+skdp_errors skdp_stream_receive(skdp_stream_mux* mux, const uint8_t* message, size_t msglen, uint8_t* reply, size_t replycap, size_t* replylen)
+{
+	SKDP_ASSERT(mux != NULL);
+	SKDP_ASSERT(message != NULL);
+	SKDP_ASSERT(reply != NULL);
+	SKDP_ASSERT(replylen != NULL);
+
+	const uint8_t* pdat;
+	skdp_stream* pstm;
+	size_t flen;
+	size_t i;
+	size_t pos;
+	uint32_t inc;
+	uint32_t sid;
+	uint8_t type;
+	skdp_errors err;
+
+	err = skdp_error_invalid_input;
+
+	if (mux != NULL && message != NULL && reply != NULL && replylen != NULL)
+	{
+		err = skdp_error_none;
+		*replylen = 0U;
+		pos = 0U;
+
+		while (pos < msglen && err == skdp_error_none)
+		{
+			type = skdp_stream_frame_none;
+			sid = 0U;
+			flen = 0U;
+			pdat = NULL;
+			pstm = NULL;
+
+			if (msglen - pos >= SKDP_STREAM_HEADER_SIZE)
+			{
+				type = message[pos];
+				sid = qsc_intutils_le8to32(message + pos + 1U);
+				flen = qsc_intutils_le8to16(message + pos + 5U);
+				pdat = message + pos + SKDP_STREAM_HEADER_SIZE;
+			}
+
+			/* a truncated frame, or the reserved stream id, falls through to the default case */
+			if (sid != 0U && flen <= msglen - pos - SKDP_STREAM_HEADER_SIZE)
+			{
+				pos += SKDP_STREAM_HEADER_SIZE + flen;
+				pstm = stream_find(mux, sid);
+			}
+			else
+			{
+				type = skdp_stream_frame_none;
+			}
+
+			switch (type)
+			{
+				case skdp_stream_frame_open:
+				{
+					/* the peer allocates ids of the other parity, in increasing order and never reused */
+					if (pstm != NULL || (sid & 1U) == (mux->nextsid & 1U) || sid <= mux->peersid)
+					{
+						err = skdp_error_invalid_input;
+					}
+					else
+					{
+						mux->peersid = sid;
+
+						if (stream_allocate(mux, sid) != NULL)
+						{
+							stream_notify(mux, sid, skdp_stream_event_open);
+						}
+						else
+						{
+							/* refuse the stream when the table is full */
+							stream_reply_reset(reply, replycap, replylen, sid);
+						}
+					}
+
+					break;
+				}
+				case skdp_stream_frame_data:
+				{
+					if (pstm == NULL || pstm->rclosed == true || flen > pstm->rxwindow)
+					{
+						/* data on an unknown or closed stream, or beyond the granted credit, aborts the stream */
+						if (pstm != NULL)
+						{
+							stream_release(pstm);
+							stream_notify(mux, sid, skdp_stream_event_reset);
+						}
+
+						stream_reply_reset(reply, replycap, replylen, sid);
+					}
+					else
+					{
+						pstm->rxwindow -= (uint32_t)flen;
+						pstm->rxconsumed += (uint32_t)flen;
+
+						if (pstm->receive != NULL)
+						{
+							pstm->receive(pstm->context, sid, pdat, flen);
+						}
+					}
+
+					break;
+				}
+				case skdp_stream_frame_close:
+				{
+					if (pstm != NULL && pstm->rclosed == false)
+					{
+						pstm->rclosed = true;
+						stream_notify(mux, sid, skdp_stream_event_close);
+
+						/* the callback may have released or closed the stream */
+						pstm = stream_find(mux, sid);
+
+						if (pstm != NULL && pstm->lclosed == true)
+						{
+							stream_release(pstm);
+						}
+					}
+
+					break;
+				}
+				case skdp_stream_frame_reset:
+				{
+					if (pstm != NULL)
+					{
+						stream_release(pstm);
+						stream_notify(mux, sid, skdp_stream_event_reset);
+					}
+
+					break;
+				}
+				case skdp_stream_frame_window:
+				{
+					if (flen != sizeof(uint32_t))
+					{
+						err = skdp_error_invalid_input;
+					}
+					else if (pstm != NULL)
+					{
+						inc = qsc_intutils_le8to32(pdat);
+						pstm->txwindow = (inc > UINT32_MAX - pstm->txwindow) ? UINT32_MAX : pstm->txwindow + inc;
+						stream_notify(mux, sid, skdp_stream_event_window);
+					}
+
+					break;
+				}
+				default:
+				{
+					err = skdp_error_invalid_input;
+				}
+			}
+		}
+
+		/* return credit for streams that have consumed half of their window */
+		for (i = 0U; i < SKDP_STREAM_MAX_STREAMS; ++i)
+		{
+			pstm = &mux->streams[i];
+
+			if (pstm->sid != 0U && pstm->rclosed == false && pstm->rxconsumed >= mux->window / 2U &&
+				*replylen + SKDP_STREAM_WINDOW_FRAME_SIZE <= replycap)
+			{
+				stream_frame_header(reply + *replylen, skdp_stream_frame_window, pstm->sid, sizeof(uint32_t));
+				qsc_intutils_le32to8(reply + *replylen + SKDP_STREAM_HEADER_SIZE, pstm->rxconsumed);
+				*replylen += SKDP_STREAM_WINDOW_FRAME_SIZE;
+				pstm->rxwindow += pstm->rxconsumed;
+				pstm->rxconsumed = 0U;
+			}
+		}
+	}
+
+	return err;
+}
+
+bool skdp_stream_reset(skdp_stream_mux* mux, uint32_t sid, uint8_t* frame, size_t* framelen)
+{
+	SKDP_ASSERT(mux != NULL);
+	SKDP_ASSERT(frame != NULL);
+	SKDP_ASSERT(framelen != NULL);
+
+	skdp_stream* pstm;
+	bool res;
+
+	res = false;
+
+	if (mux != NULL && frame != NULL && framelen != NULL)
+	{
+		*framelen = 0U;
+		pstm = stream_find(mux, sid);
+
+		if (pstm != NULL)
+		{
+			stream_release(pstm);
+			stream_frame_header(frame, skdp_stream_frame_reset, sid, 0U);
+			*framelen = SKDP_STREAM_HEADER_SIZE;
+			res = true;
+		}
+	}
+
+	return res;
+}
+
+size_t skdp_stream_send(skdp_stream_mux* mux, uint32_t sid, const uint8_t* data, size_t datalen, uint8_t* frame, size_t* framelen)
+{
+	SKDP_ASSERT(mux != NULL);
+	SKDP_ASSERT(data != NULL);
+	SKDP_ASSERT(frame != NULL);
+	SKDP_ASSERT(framelen != NULL);
+
+	skdp_stream* pstm;
+	size_t dlen;
+
+	dlen = 0U;
+
+	if (mux != NULL && data != NULL && frame != NULL && framelen != NULL)
+	{
+		*framelen = 0U;
+		pstm = stream_find(mux, sid);
+
+		if (pstm != NULL && pstm->lclosed == false && pstm->txwindow != 0U && datalen != 0U)
+		{
+			dlen = qsc_intutils_min(datalen, SKDP_STREAM_MAX_PAYLOAD);
+			dlen = qsc_intutils_min(dlen, (size_t)pstm->txwindow);
+
+			stream_frame_header(frame, skdp_stream_frame_data, sid, dlen);
+			qsc_memutils_copy(frame + SKDP_STREAM_HEADER_SIZE, data, dlen);
+			*framelen = SKDP_STREAM_HEADER_SIZE + dlen;
+			pstm->txwindow -= (uint32_t)dlen;
+		}
+	}
+
+	return dlen;
+}
+
+bool skdp_stream_set_receive(skdp_stream_mux* mux, uint32_t sid, skdp_stream_receive_callback receive, void* context)
+{
+	SKDP_ASSERT(mux != NULL);
+
+	skdp_stream* pstm;
+	bool res;
+
+	res = false;
+
+	if (mux != NULL)
+	{
+		pstm = stream_find(mux, sid);
+
+		if (pstm != NULL)
+		{
+			pstm->receive = receive;
+			pstm->context = context;
+			res = true;
+		}
+	}
+
+	return res;
+}
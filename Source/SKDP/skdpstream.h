@@ -0,0 +1,288 @@
+/* 2021-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SKDP_STREAM_H
+#define SKDP_STREAM_H
+
+#include "skdpcommon.h"
+#include "skdp.h"
+
+/**
+ * \file skdpstream.h
+ * \brief The SKDP stream multiplexer.
+ *
+ * \details
+ * This header defines lightweight logical streams carried inside the encrypted payload of a single SKDP session,
+ * so that one key exchange and one socket can carry several independent channels (telemetry, commands, file transfer).
+ *
+ * The multiplexer works on plaintext: outbound functions write a stream frame into a caller buffer, which is then
+ * sealed with \c skdp_client_encrypt_packet or \c skdp_server_encrypt_packet; inbound, the decrypted message is passed
+ * to \c skdp_stream_receive, which dispatches each frame to the receive callback of its stream.
+ *
+ * A frame is a one byte type, a four byte little-endian stream id, a two byte little-endian payload length, and the
+ * payload; a message may carry several frames. The session initiator (the client) allocates odd stream ids, the
+ * responder even ids, so both sides can open streams without coordination. Each side opens ids in increasing order,
+ * and an id is never reused within a session; an open frame at or below the highest id the peer has opened is rejected.
+ *
+ * Each stream has a credit-based flow-control window in each direction. A sender may only send data frames within the
+ * window granted by the receiver; the receiver grants more credit with a window frame once half of the window has been
+ * delivered to the application. Data that exceeds the granted window resets the stream.
+ *
+ * A close frame half-closes the stream in the sender's direction; the stream is released when both directions are closed.
+ * A reset frame aborts the stream in both directions immediately.
+ *
+ * The multiplexer is not thread safe; calls for one session must be serialized by the caller.
+ */
+
+/*!
+ * \def SKDP_STREAM_HEADER_SIZE
+ * \brief The size (in bytes) of a stream frame header.
+ */
+#define SKDP_STREAM_HEADER_SIZE 7U
+
+/*!
+ * \def SKDP_STREAM_MAX_PAYLOAD
+ * \brief The largest stream frame payload (in bytes) that fits a single session message.
+ */
+#define SKDP_STREAM_MAX_PAYLOAD (SKDP_MESSAGE_SIZE - SKDP_STREAM_HEADER_SIZE)
+
+/*!
+ * \def SKDP_STREAM_MAX_STREAMS
+ * \brief The maximum number of concurrently open streams in a session.
+ */
+#define SKDP_STREAM_MAX_STREAMS 32U
+
+/*!
+ * \def SKDP_STREAM_WINDOW_FRAME_SIZE
+ * \brief The size (in bytes) of a window update frame.
+ */
+#define SKDP_STREAM_WINDOW_FRAME_SIZE (SKDP_STREAM_HEADER_SIZE + sizeof(uint32_t))
+
+/*!
+ * \def SKDP_STREAM_WINDOW_SIZE
+ * \brief The default initial flow-control window (in bytes) of a stream.
+ */
+#define SKDP_STREAM_WINDOW_SIZE 65536U
+
+/*!
+ * \enum skdp_stream_events
+ * \brief The stream events reported to the multiplexer event callback.
+ */
+SKDP_EXPORT_API typedef enum skdp_stream_events
+{
+	skdp_stream_event_none = 0x00U,				/*!< No event */
+	skdp_stream_event_open = 0x01U,				/*!< The peer opened a stream */
+	skdp_stream_event_close = 0x02U,			/*!< The peer closed its sending direction */
+	skdp_stream_event_reset = 0x03U,			/*!< The stream was reset, by the peer or on a flow-control violation */
+	skdp_stream_event_window = 0x04U,			/*!< The peer granted more send credit */
+} skdp_stream_events;
+
+/*!
+ * \enum skdp_stream_frames
+ * \brief The stream frame types.
+ */
+SKDP_EXPORT_API typedef enum skdp_stream_frames
+{
+	skdp_stream_frame_none = 0x00U,				/*!< No frame type was specified */
+	skdp_stream_frame_data = 0x01U,				/*!< Stream data */
+	skdp_stream_frame_open = 0x02U,				/*!< Open a stream */
+	skdp_stream_frame_close = 0x03U,			/*!< Close the sending direction of a stream */
+	skdp_stream_frame_reset = 0x04U,			/*!< Abort a stream in both directions */
+	skdp_stream_frame_window = 0x05U,			/*!< Grant send credit, the payload is a four byte increment */
+} skdp_stream_frames;
+
+/*!
+ * \brief The per-stream receive callback; invoked with the payload of each data frame.
+ */
+typedef void (*skdp_stream_receive_callback)(void* context, uint32_t sid, const uint8_t* data, size_t length);
+
+/*!
+ * \brief The multiplexer event callback; invoked on stream open, close, reset, and window events.
+ */
+typedef void (*skdp_stream_event_callback)(void* context, uint32_t sid, skdp_stream_events event);
+
+/*!
+ * \struct skdp_stream
+ * \brief The state of a single stream.
+ */
+SKDP_EXPORT_API typedef struct skdp_stream
+{
+	skdp_stream_receive_callback receive;		/*!< The stream receive callback */
+	void* context;								/*!< The receive callback context */
+	uint32_t rxconsumed;						/*!< The bytes delivered since the last window update was sent */
+	uint32_t rxwindow;							/*!< The bytes the peer may still send */
+	uint32_t txwindow;							/*!< The bytes that may still be sent */
+	uint32_t sid;								/*!< The stream id, zero for a free slot */
+	bool lclosed;								/*!< The local sending direction is closed */
+	bool rclosed;								/*!< The peer sending direction is closed */
+} skdp_stream;
+
+/*!
+ * \struct skdp_stream_mux
+ * \brief The stream multiplexer state of a session.
+ */
+SKDP_EXPORT_API typedef struct skdp_stream_mux
+{
+	skdp_stream streams[SKDP_STREAM_MAX_STREAMS];	/*!< The stream table */
+	skdp_stream_event_callback event;			/*!< The event callback */
+	void* context;								/*!< The event callback context */
+	uint32_t nextsid;							/*!< The next locally allocated stream id */
+	uint32_t peersid;							/*!< The highest stream id opened by the peer */
+	uint32_t window;							/*!< The initial window of new streams */
+} skdp_stream_mux;
+
+/*!
+ * \brief Close the sending direction of a stream.
+ *
+ * \param mux A pointer to the multiplexer state.
+ * \param sid The stream id.
+ * \param frame The output frame buffer, at least \c SKDP_STREAM_HEADER_SIZE bytes.
+ * \param framelen A pointer receiving the frame length.
+ *
+ * \return Returns true if the stream is open for sending and the close frame was written.
+ */
+SKDP_EXPORT_API bool skdp_stream_close(skdp_stream_mux* mux, uint32_t sid, uint8_t* frame, size_t* framelen);
+
+/*!
+ * \brief Dispose of the multiplexer state; all streams are released without notification.
+ *
+ * \param mux A pointer to the multiplexer state.
+ */
+SKDP_EXPORT_API void skdp_stream_dispose(skdp_stream_mux* mux);
+
+/*!
+ * \brief Initialize the multiplexer state of a session.
+ *
+ * \param mux A pointer to the multiplexer state.
+ * \param initiator Set to true on the client; the initiator allocates odd stream ids.
+ * \param window The initial flow-control window of each stream, zero selects \c SKDP_STREAM_WINDOW_SIZE.
+ * \param event The event callback, may be NULL.
+ * \param context The event callback context.
+ */
+SKDP_EXPORT_API void skdp_stream_initialize(skdp_stream_mux* mux, bool initiator, uint32_t window, skdp_stream_event_callback event, void* context);
+
+/*!
+ * \brief Open a new stream.
+ *
+ * \param mux A pointer to the multiplexer state.
+ * \param sid A pointer receiving the new stream id.
+ * \param receive The stream receive callback.
+ * \param context The receive callback context.
+ * \param frame The output frame buffer, at least \c SKDP_STREAM_HEADER_SIZE bytes.
+ * \param framelen A pointer receiving the frame length.
+ *
+ * \return Returns true if a stream slot was available and the open frame was written.
+ */
+SKDP_EXPORT_API bool skdp_stream_open(skdp_stream_mux* mux, uint32_t* sid, skdp_stream_receive_callback receive, void* context, uint8_t* frame, size_t* framelen);
+
+/*!
+ * \brief Process a decrypted session message.
+ *
+ * \details
+ * Each frame in the message is applied to its stream and data is delivered to the stream receive callback.
+ * Window updates for streams that have consumed half of their window, and reset frames for data that violated a
+ * window or addressed an unknown stream, are written to the reply buffer; when \c replylen is non-zero on return,
+ * the reply must be encrypted and sent to the peer. Window updates that do not fit the reply are sent on a later call.
+ *
+ * \param mux A pointer to the multiplexer state.
+ * \param message [const] The decrypted message.
+ * \param msglen The message length.
+ * \param reply The reply frame buffer.
+ * \param replycap The reply buffer capacity, \c SKDP_MESSAGE_SIZE is sufficient.
+ * \param replylen A pointer receiving the reply length.
+ *
+ * \return Returns \c skdp_error_none on success, or \c skdp_error_invalid_input if a frame is malformed.
+ */
+SKDP_EXPORT_API skdp_errors skdp_stream_receive(skdp_stream_mux* mux, const uint8_t* message, size_t msglen, uint8_t* reply, size_t replycap, size_t* replylen);
+
+/*!
+ * \brief Abort a stream in both directions.
+ *
+ * \param mux A pointer to the multiplexer state.
+ * \param sid The stream id.
+ * \param frame The output frame buffer, at least \c SKDP_STREAM_HEADER_SIZE bytes.
+ * \param framelen A pointer receiving the frame length.
+ *
+ * \return Returns true if the stream existed and the reset frame was written.
+ */
+SKDP_EXPORT_API bool skdp_stream_reset(skdp_stream_mux* mux, uint32_t sid, uint8_t* frame, size_t* framelen);
+
+/*!
+ * \brief Write a data frame for a stream.
+ *
+ * \details
+ * The amount of data framed is limited by the stream send window and \c SKDP_STREAM_MAX_PAYLOAD; the caller sends
+ * the remainder after the peer grants more credit, signalled by the \c skdp_stream_event_window event.
+ *
+ * \param mux A pointer to the multiplexer state.
+ * \param sid The stream id.
+ * \param data [const] The data to send.
+ * \param datalen The data length.
+ * \param frame The output frame buffer, at least \c SKDP_MESSAGE_SIZE bytes.
+ * \param framelen A pointer receiving the frame length.
+ *
+ * \return Returns the number of data bytes framed, zero if the stream is closed or has no send credit.
+ */
+SKDP_EXPORT_API size_t skdp_stream_send(skdp_stream_mux* mux, uint32_t sid, const uint8_t* data, size_t datalen, uint8_t* frame, size_t* framelen);
+
+/*!
+ * \brief Set the receive callback of a stream, typically a stream opened by the peer.
+ *
+ * \param mux A pointer to the multiplexer state.
+ * \param sid The stream id.
+ * \param receive The stream receive callback.
+ * \param context The receive callback context.
+ *
+ * \return Returns true if the stream exists.
+ */
+SKDP_EXPORT_API bool skdp_stream_set_receive(skdp_stream_mux* mux, uint32_t sid, skdp_stream_receive_callback receive, void* context);
+
+#endif
@@ -0,0 +1,111 @@
+#include "skdptransport.h"
+#include "socketbase.h"
+
+static size_t transport_socket_send(void* user, const uint8_t* input, size_t inlen)
+{
+	const qsc_socket* sock;
+	size_t res;
+
+	res = 0U;
+	sock = (const qsc_socket*)user;
+
+	if (qsc_socket_is_connected(sock) == true)
+	{
+		res = qsc_socket_send(sock, input, inlen, qsc_socket_send_flag_none);
+	}
+
+	return res;
+}
+
+static size_t transport_socket_receive(void* user, uint8_t* output, size_t otplen)
+{
+	return qsc_socket_receive((const qsc_socket*)user, output, otplen, qsc_socket_receive_flag_wait_all);
+}
+
+static void transport_socket_close(void* user)
+{
+	qsc_socket* sock;
+
+	sock = (qsc_socket*)user;
+
+	if (sock->connection_status == qsc_socket_state_connected)
+	{
+		qsc_socket_shut_down(sock, qsc_socket_shut_down_flag_both);
+	}
+}
+
+void skdp_transport_close(const skdp_transport* trans)
+{
+	SKDP_ASSERT(trans != NULL);
+
+	if (trans != NULL && trans->close != NULL)
+	{
+		trans->close(trans->user);
+	}
+}
+
+void skdp_transport_from_socket(skdp_transport* trans, qsc_socket* sock)
+{
+	SKDP_ASSERT(trans != NULL);
+	SKDP_ASSERT(sock != NULL);
+
+	if (trans != NULL && sock != NULL)
+	{
+		trans->send = &transport_socket_send;
+		trans->receive = &transport_socket_receive;
+		trans->close = &transport_socket_close;
+		trans->user = sock;
+	}
+}
+
+size_t skdp_transport_receive(const skdp_transport* trans, uint8_t* output, size_t otplen)
+{
+	SKDP_ASSERT(trans != NULL);
+	SKDP_ASSERT(output != NULL);
+
+	size_t res;
+
+	res = 0U;
+
+	if (trans != NULL && trans->receive != NULL && output != NULL)
+	{
+		res = trans->receive(trans->user, output, otplen);
+	}
+
+	return res;
+}
+
+size_t skdp_transport_send(const skdp_transport* trans, const uint8_t* input, size_t inlen)
+{
+	SKDP_ASSERT(trans != NULL);
+	SKDP_ASSERT(input != NULL);
+
+	size_t res;
+
+	res = 0U;
+
+	if (trans != NULL && trans->send != NULL && input != NULL)
+	{
+		res = trans->send(trans->user, input, inlen);
+	}
+
+	return res;
+}
+
+void skdp_transport_send_error(const skdp_transport* trans, skdp_errors error)
+{
+	SKDP_ASSERT(trans != NULL);
+
+	if (trans != NULL)
+	{
+		skdp_network_packet resp = { 0 };
+		uint8_t spct[SKDP_HEADER_SIZE + SKDP_ERROR_SIZE] = { 0U };
+
+		resp.flag = skdp_flag_error_condition;
+		resp.msglen = SKDP_ERROR_SIZE;
+		resp.sequence = SKDP_SEQUENCE_TERMINATOR;
+		skdp_packet_header_serialize(&resp, spct);
+		spct[SKDP_HEADER_SIZE] = (uint8_t)error;
+		skdp_transport_send(trans, spct, sizeof(spct));
+	}
+}
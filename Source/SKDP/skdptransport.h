@@ -0,0 +1,154 @@
+/* 2021-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SKDP_TRANSPORT_H
+#define SKDP_TRANSPORT_H
+
+#include "skdpcommon.h"
+#include "skdp.h"
+#include "socketbase.h"
+
+/**
+ * \file skdptransport.h
+ * \brief The SKDP pluggable transport.
+ *
+ * \details
+ * This header defines the transport callbacks used by the SKDP key exchange. The client and server handshakes read
+ * and write packets only through a transport, so the protocol can run over a QSC socket, a socketpair, a pipe,
+ * shared memory, or an application event loop. Running both ends over an in-process transport allows the protocol
+ * to be benchmarked without kernel networking.
+ *
+ * A transport is a table of three callbacks and a user pointer that is passed to each of them:
+ * - send: writes the whole buffer and returns the number of bytes written.
+ * - receive: blocks until the requested number of bytes is read, and returns the number read; a shorter count is a failure.
+ * - close: shuts down the underlying channel; it may be NULL.
+ *
+ * \c skdp_transport_from_socket binds a transport to a connected QSC socket; the socket connect and listen
+ * functions use it internally.
+ */
+
+/*!
+ * \brief The transport send callback; returns the number of bytes written.
+ */
+typedef size_t (*skdp_transport_send_callback)(void* user, const uint8_t* input, size_t inlen);
+
+/*!
+ * \brief The transport receive callback; reads exactly the requested length, returns the number of bytes read.
+ */
+typedef size_t (*skdp_transport_receive_callback)(void* user, uint8_t* output, size_t otplen);
+
+/*!
+ * \brief The transport close callback.
+ */
+typedef void (*skdp_transport_close_callback)(void* user);
+
+/*!
+ * \struct skdp_transport
+ * \brief The SKDP transport callback table.
+ */
+SKDP_EXPORT_API typedef struct skdp_transport
+{
+	skdp_transport_send_callback send;			/*!< The send callback */
+	skdp_transport_receive_callback receive;	/*!< The receive callback */
+	skdp_transport_close_callback close;		/*!< The optional close callback */
+	void* user;									/*!< The user pointer passed to the callbacks */
+} skdp_transport;
+
+/*!
+ * \brief Close the transport.
+ *
+ * \param trans [const] A pointer to the transport.
+ */
+SKDP_EXPORT_API void skdp_transport_close(const skdp_transport* trans);
+
+/*!
+ * \brief Bind a transport to a connected QSC socket.
+ *
+ * \details
+ * Sends and receives use \c qsc_socket_send and \c qsc_socket_receive in wait-all mode; close shuts the socket down.
+ * The socket must outlive the transport.
+ *
+ * \param trans A pointer to the transport.
+ * \param sock A pointer to the socket.
+ */
+SKDP_EXPORT_API void skdp_transport_from_socket(skdp_transport* trans, qsc_socket* sock);
+
+/*!
+ * \brief Receive exactly the requested number of bytes from the transport.
+ *
+ * \param trans [const] A pointer to the transport.
+ * \param output The output buffer.
+ * \param otplen The number of bytes to receive.
+ *
+ * \return Returns the number of bytes received.
+ */
+SKDP_EXPORT_API size_t skdp_transport_receive(const skdp_transport* trans, uint8_t* output, size_t otplen);
+
+/*!
+ * \brief Send a buffer over the transport.
+ *
+ * \param trans [const] A pointer to the transport.
+ * \param input [const] The input buffer.
+ * \param inlen The number of bytes to send.
+ *
+ * \return Returns the number of bytes sent.
+ */
+SKDP_EXPORT_API size_t skdp_transport_send(const skdp_transport* trans, const uint8_t* input, size_t inlen);
+
+/*!
+ * \brief Send an error condition packet over the transport.
+ *
+ * \param trans [const] A pointer to the transport.
+ * \param error The error code.
+ */
+SKDP_EXPORT_API void skdp_transport_send_error(const skdp_transport* trans, skdp_errors error);
+
+#endif
@@ -0,0 +1,453 @@
+#include "skdpunix.h"
+#include "intutils.h"
+#include "memutils.h"
+#if defined(QSC_SYSTEM_OS_POSIX)
+#	include <fcntl.h>
+#	include <sys/socket.h>
+#	include <sys/un.h>
+#	include <unistd.h>
+#endif
+
+#if defined(QSC_SYSTEM_OS_POSIX)
+
+static bool unix_address(struct sockaddr_un* addr, const char* path)
+{
+	size_t plen;
+	bool res;
+
+	res = false;
+	plen = strlen(path);
+
+	if (plen != 0U && plen <= SKDP_UNIX_PATH_MAX && plen < sizeof(addr->sun_path))
+	{
+		qsc_memutils_clear(addr, sizeof(struct sockaddr_un));
+		addr->sun_family = AF_UNIX;
+		qsc_memutils_copy(addr->sun_path, path, plen);
+		res = true;
+	}
+
+	return res;
+}
+
+static void unix_socket_bind(qsc_socket* sock, int32_t fd, const char* path)
+{
+	size_t plen;
+
+	qsc_memutils_clear(sock, sizeof(qsc_socket));
+	sock->connection = fd;
+	sock->connection_status = qsc_socket_state_connected;
+	sock->socket_transport = qsc_socket_transport_stream;
+
+	if (path != NULL)
+	{
+		plen = qsc_intutils_min(strlen(path), (size_t)(QSC_SOCKET_ADDRESS_MAX_SIZE - 1U));
+		qsc_memutils_copy(sock->address, path, plen);
+	}
+}
+
+static int32_t unix_stream_socket(void)
+{
+	int32_t fd;
+
+	fd = (int32_t)socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if (fd >= 0)
+	{
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+	}
+
+	return fd;
+}
+
+static bool unix_receive_all(int32_t fd, uint8_t* output, size_t otplen)
+{
+	ssize_t rlen;
+	size_t pos;
+	bool run;
+
+	pos = 0U;
+	run = true;
+
+	while (pos < otplen && run == true)
+	{
+		rlen = recv(fd, output + pos, otplen - pos, 0);
+
+		if (rlen > 0)
+		{
+			pos += (size_t)rlen;
+		}
+		else if (rlen < 0 && errno == EINTR)
+		{
+			/* interrupted, retry */
+		}
+		else
+		{
+			run = false;
+		}
+	}
+
+	return (pos == otplen);
+}
+
+static bool unix_send_all(int32_t fd, const uint8_t* input, size_t inlen)
+{
+	ssize_t slen;
+	size_t pos;
+	bool run;
+
+	pos = 0U;
+	run = true;
+
+	while (pos < inlen && run == true)
+	{
+		slen = send(fd, input + pos, inlen - pos, MSG_NOSIGNAL);
+
+		if (slen > 0)
+		{
+			pos += (size_t)slen;
+		}
+		else if (slen < 0 && errno == EINTR)
+		{
+			/* interrupted, retry */
+		}
+		else
+		{
+			run = false;
+		}
+	}
+
+	return (pos == inlen);
+}
+
+#endif
+
+skdp_errors skdp_unix_accept(int32_t listener, skdp_server_state* ctx, qsc_socket* sock)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(sock != NULL);
+
+	skdp_errors err;
+
+	if (listener >= 0 && ctx != NULL && sock != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_POSIX)
+		struct sockaddr_un addr;
+		skdp_transport trans;
+		socklen_t alen;
+		int32_t cfd;
+
+		err = skdp_error_connection_failure;
+		qsc_socket_server_initialize(sock);
+
+		do
+		{
+			cfd = (int32_t)accept(listener, NULL, NULL);
+		}
+		while (cfd < 0 && errno == EINTR);
+
+		if (cfd >= 0)
+		{
+			fcntl(cfd, F_SETFD, FD_CLOEXEC);
+			qsc_memutils_clear(&addr, sizeof(struct sockaddr_un));
+			alen = (socklen_t)(sizeof(struct sockaddr_un) - 1U);
+
+			/* the accepted socket records the path it was reached on */
+			if (getsockname(listener, (struct sockaddr*)&addr, &alen) == 0 && addr.sun_family == AF_UNIX)
+			{
+				unix_socket_bind(sock, cfd, addr.sun_path);
+			}
+			else
+			{
+				unix_socket_bind(sock, cfd, NULL);
+			}
+
+			skdp_transport_from_socket(&trans, sock);
+			err = skdp_server_listen_transport(ctx, &trans);
+		}
+#else
+		err = skdp_error_general_failure;
+#endif
+	}
+	else
+	{
+		err = skdp_error_invalid_input;
+	}
+
+	return err;
+}
+
+skdp_errors skdp_unix_connect(skdp_client_state* ctx, qsc_socket* sock, const char* path)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(sock != NULL);
+	SKDP_ASSERT(path != NULL);
+
+	skdp_errors err;
+
+	if (ctx != NULL && sock != NULL && path != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_POSIX)
+		struct sockaddr_un addr;
+		skdp_transport trans;
+		int32_t fd;
+
+		err = skdp_error_connection_failure;
+		qsc_socket_client_initialize(sock);
+
+		if (unix_address(&addr, path) == true)
+		{
+			fd = unix_stream_socket();
+
+			if (fd >= 0)
+			{
+				if (connect(fd, (const struct sockaddr*)&addr, sizeof(struct sockaddr_un)) == 0)
+				{
+					unix_socket_bind(sock, fd, path);
+					skdp_transport_from_socket(&trans, sock);
+					err = skdp_client_connect_transport(ctx, &trans);
+				}
+				else
+				{
+					close(fd);
+				}
+			}
+		}
+		else
+		{
+			err = skdp_error_invalid_input;
+		}
+#else
+		err = skdp_error_general_failure;
+#endif
+	}
+	else
+	{
+		err = skdp_error_invalid_input;
+	}
+
+	return err;
+}
+
+int32_t skdp_unix_listen(const char* path)
+{
+	SKDP_ASSERT(path != NULL);
+
+	int32_t lfd;
+
+	lfd = -1;
+
+	if (path != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_POSIX)
+		struct sockaddr_un addr;
+
+		if (unix_address(&addr, path) == true)
+		{
+			lfd = unix_stream_socket();
+
+			if (lfd >= 0)
+			{
+				/* a socket file left by a previous listener would fail the bind */
+				unlink(path);
+
+				if (bind(lfd, (const struct sockaddr*)&addr, sizeof(struct sockaddr_un)) != 0 ||
+					listen(lfd, (int)SKDP_UNIX_LISTEN_BACKLOG) != 0)
+				{
+					close(lfd);
+					lfd = -1;
+				}
+			}
+		}
+#endif
+	}
+
+	return lfd;
+}
+
+void skdp_unix_listen_close(int32_t listener, const char* path)
+{
+#if defined(QSC_SYSTEM_OS_POSIX)
+	if (listener >= 0)
+	{
+		close(listener);
+	}
+
+	if (path != NULL)
+	{
+		unlink(path);
+	}
+#else
+	(void)listener;
+	(void)path;
+#endif
+}
+
+skdp_errors skdp_unix_session_receive(int32_t channel, skdp_server_state* ctx, qsc_socket* sock)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(sock != NULL);
+
+	skdp_errors err;
+
+	if (channel >= 0 && ctx != NULL && sock != NULL)
+	{
+#if defined(QSC_SYSTEM_OS_POSIX)
+		uint8_t sbuf[SKDP_SERVER_SESSION_SIZE] = { 0U };
+		union
+		{
+			struct cmsghdr align;
+			uint8_t control[CMSG_SPACE(sizeof(int))];
+		} cbuf;
+		struct cmsghdr* cmsg;
+		struct iovec iov;
+		struct msghdr msg;
+		ssize_t rlen;
+		int32_t fd;
+		int32_t flags;
+
+		err = skdp_error_receive_failure;
+		fd = -1;
+		qsc_memutils_clear(&cbuf, sizeof(cbuf));
+		qsc_memutils_clear(&msg, sizeof(struct msghdr));
+		iov.iov_base = sbuf;
+		iov.iov_len = sizeof(sbuf);
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1U;
+		msg.msg_control = cbuf.control;
+		msg.msg_controllen = sizeof(cbuf.control);
+
+#if defined(MSG_CMSG_CLOEXEC)
+		flags = MSG_CMSG_CLOEXEC;
+#else
+		flags = 0;
+#endif
+
+		do
+		{
+			rlen = recvmsg(channel, &msg, flags);
+		}
+		while (rlen < 0 && errno == EINTR);
+
+		if (rlen > 0)
+		{
+			/* the descriptor arrives with the first byte of the state */
+			cmsg = CMSG_FIRSTHDR(&msg);
+
+			if (cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+				cmsg->cmsg_len == CMSG_LEN(sizeof(int)))
+			{
+				qsc_memutils_copy(&fd, CMSG_DATA(cmsg), sizeof(int));
+			}
+
+			/* a stream channel may deliver the state in pieces */
+			if (fd >= 0 && (msg.msg_flags & MSG_CTRUNC) == 0 &&
+				unix_receive_all(channel, sbuf + rlen, sizeof(sbuf) - (size_t)rlen) == true)
+			{
+				if (skdp_server_session_deserialize(ctx, sbuf, sizeof(sbuf)) == true)
+				{
+					fcntl(fd, F_SETFD, FD_CLOEXEC);
+					unix_socket_bind(sock, fd, NULL);
+					fd = -1;
+					err = skdp_error_none;
+				}
+				else
+				{
+					err = skdp_error_unknown_protocol;
+				}
+			}
+
+			if (fd >= 0)
+			{
+				close(fd);
+			}
+		}
+
+		qsc_memutils_secure_erase(sbuf, sizeof(sbuf));
+#else
+		err = skdp_error_general_failure;
+#endif
+	}
+	else
+	{
+		err = skdp_error_invalid_input;
+	}
+
+	return err;
+}
+
+skdp_errors skdp_unix_session_send(int32_t channel, skdp_server_state* ctx, qsc_socket* sock, const skdp_network_packet* packetin)
+{
+	SKDP_ASSERT(ctx != NULL);
+	SKDP_ASSERT(sock != NULL);
+	SKDP_ASSERT(packetin != NULL);
+
+	skdp_errors err;
+
+	if (channel >= 0 && ctx != NULL && sock != NULL && packetin != NULL && sock->connection_status == qsc_socket_state_connected)
+	{
+#if defined(QSC_SYSTEM_OS_POSIX)
+		uint8_t sbuf[SKDP_SERVER_SESSION_SIZE] = { 0U };
+		union
+		{
+			struct cmsghdr align;
+			uint8_t control[CMSG_SPACE(sizeof(int))];
+		} cbuf;
+		struct cmsghdr* cmsg;
+		struct iovec iov;
+		struct msghdr msg;
+		ssize_t slen;
+		int fd;
+
+		err = skdp_server_session_serialize(ctx, packetin, sbuf, sizeof(sbuf));
+
+		if (err == skdp_error_none)
+		{
+			fd = (int)sock->connection;
+			qsc_memutils_clear(&cbuf, sizeof(cbuf));
+			qsc_memutils_clear(&msg, sizeof(struct msghdr));
+			iov.iov_base = sbuf;
+			iov.iov_len = sizeof(sbuf);
+			msg.msg_iov = &iov;
+			msg.msg_iovlen = 1U;
+			msg.msg_control = cbuf.control;
+			msg.msg_controllen = sizeof(cbuf.control);
+			cmsg = CMSG_FIRSTHDR(&msg);
+			cmsg->cmsg_level = SOL_SOCKET;
+			cmsg->cmsg_type = SCM_RIGHTS;
+			cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+			qsc_memutils_copy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+			do
+			{
+				slen = sendmsg(channel, &msg, MSG_NOSIGNAL);
+			}
+			while (slen < 0 && errno == EINTR);
+
+			if (slen > 0 && unix_send_all(channel, sbuf + slen, sizeof(sbuf) - (size_t)slen) == true)
+			{
+				/* the session now belongs to the receiver; close only this descriptor,
+				   a shutdown would tear down the connection the receiver holds */
+				close(fd);
+				qsc_memutils_clear(sock, sizeof(qsc_socket));
+				sock->connection = QSC_UNINITIALIZED_SOCKET;
+			}
+			else
+			{
+				/* the handoff failed; keep serving the session here at the same ratchet point */
+				skdp_server_session_deserialize(ctx, sbuf, sizeof(sbuf));
+				err = skdp_error_transmit_failure;
+			}
+		}
+
+		qsc_memutils_secure_erase(sbuf, sizeof(sbuf));
+#else
+		err = skdp_error_general_failure;
+#endif
+	}
+	else
+	{
+		err = skdp_error_invalid_input;
+	}
+
+	return err;
+}
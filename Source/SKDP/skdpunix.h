@@ -0,0 +1,178 @@
+/* 2021-2026 Quantum Resistant Cryptographic Solutions Corporation
+ * All Rights Reserved.
+ *
+ * NOTICE:
+ * This software and all accompanying materials are the exclusive property of
+ * Quantum Resistant Cryptographic Solutions Corporation (QRCS). The intellectual
+ * and technical concepts contained herein are proprietary to QRCS and are
+ * protected under applicable Canadian, U.S., and international copyright,
+ * patent, and trade secret laws.
+ *
+ * CRYPTOGRAPHIC ALGORITHMS AND IMPLEMENTATIONS:
+ * - This software includes implementations of cryptographic primitives and
+ *   algorithms that are standardized or in the public domain, such as AES
+ *   and SHA-3, which are not proprietary to QRCS.
+ * - This software also includes cryptographic primitives, constructions, and
+ *   algorithms designed by QRCS, including but not limited to RCS, SCB, CSX, QMAC, and
+ *   related components, which are proprietary to QRCS.
+ * - All source code, implementations, protocol compositions, optimizations,
+ *   parameter selections, and engineering work contained in this software are
+ *   original works of QRCS and are protected under this license.
+ *
+ * LICENSE AND USE RESTRICTIONS:
+ * - This software is licensed under the Quantum Resistant Cryptographic Solutions
+ *   Public Research and Evaluation License (QRCS-PREL), 2025-2026.
+ * - Permission is granted solely for non-commercial evaluation, academic research,
+ *   cryptographic analysis, interoperability testing, and feasibility assessment.
+ * - Commercial use, production deployment, commercial redistribution, or
+ *   integration into products or services is strictly prohibited without a
+ *   separate written license agreement executed with QRCS.
+ * - Licensing and authorized distribution are solely at the discretion of QRCS.
+ *
+ * EXPERIMENTAL CRYPTOGRAPHY NOTICE:
+ * Portions of this software may include experimental, novel, or evolving
+ * cryptographic designs. Use of this software is entirely at the user's risk.
+ *
+ * DISCLAIMER:
+ * THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE, SECURITY, OR NON-INFRINGEMENT. QRCS DISCLAIMS ALL
+ * LIABILITY FOR ANY DIRECT, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING FROM THE USE OR MISUSE OF THIS SOFTWARE.
+ *
+ * FULL LICENSE:
+ * This software is subject to the Quantum Resistant Cryptographic Solutions
+ * Public Research and Evaluation License (QRCS-PREL), 2025-2026. The complete license terms
+ * are provided in the accompanying LICENSE file or at https://www.qrcscorp.ca.
+ *
+ * Written by: John G. Underhill
+ * Contact: contact@qrcscorp.ca
+ */
+
+#ifndef SKDP_UNIX_H
+#define SKDP_UNIX_H
+
+#include "skdpcommon.h"
+#include "skdp.h"
+#include "skdpclient.h"
+#include "skdpserver.h"
+#include "socketbase.h"
+
+/**
+ * \file skdpunix.h
+ * \brief The SKDP Unix domain socket transport and session handoff.
+ *
+ * \details
+ * This header defines the functions for running SKDP over AF_UNIX stream sockets between processes on one host,
+ * and for handing an established server session to another process.
+ *
+ * \c skdp_unix_listen binds a listening socket to a path, and each call to \c skdp_unix_accept takes one connection
+ * from it and runs the key exchange; \c skdp_unix_connect mirrors the IPv4 and IPv6 connect functions. The key
+ * exchange is unchanged and runs over the accepted or connected socket.
+ *
+ * \c skdp_unix_session_send moves an established session across a Unix domain channel (a socketpair or a connected
+ * AF_UNIX socket) to another process: the session socket descriptor is passed with SCM_RIGHTS, together with the
+ * serialized server state, the channel secrets and the sequence counters taken at the hibernate exchange. The
+ * receiving process re-expands the channel keys and continues the session with \c skdp_unix_session_receive without
+ * a new key exchange. This allows a front-end acceptor to perform the handshakes and dispatch finished sessions to
+ * back-end workers.
+ *
+ * The serialized state carries the session secrets; the handoff channel must only connect trusted processes.
+ * These functions are available on POSIX systems only.
+ */
+
+/*!
+ * \def SKDP_UNIX_LISTEN_BACKLOG
+ * \brief The listen backlog of the Unix domain listener.
+ */
+#define SKDP_UNIX_LISTEN_BACKLOG 32U
+
+/*!
+ * \def SKDP_UNIX_PATH_MAX
+ * \brief The maximum length of a Unix domain socket path, excluding the terminator.
+ */
+#define SKDP_UNIX_PATH_MAX 107U
+
+/*!
+ * \brief Accept a client on a Unix domain listener and perform the key exchange.
+ *
+ * \details
+ * Blocks until a client connects to the listener, then runs the key exchange over the accepted socket. The listener
+ * is left open; call this once per connection, with a separately initialized server state for each session.
+ *
+ * \param listener The listening socket descriptor returned by \c skdp_unix_listen.
+ * \param ctx A pointer to the initialized SKDP server state.
+ * \param sock A pointer to the socket structure, receives the accepted socket.
+ *
+ * \return Returns \c skdp_error_none if the session is established, otherwise an \c skdp_errors code.
+ */
+SKDP_EXPORT_API skdp_errors skdp_unix_accept(int32_t listener, skdp_server_state* ctx, qsc_socket* sock);
+
+/*!
+ * \brief Connect to an SKDP server over a Unix domain socket and perform the key exchange.
+ *
+ * \param ctx A pointer to the initialized SKDP client state.
+ * \param sock A pointer to the socket structure, receives the connected socket.
+ * \param path [const] The socket path, at most \c SKDP_UNIX_PATH_MAX characters.
+ *
+ * \return Returns \c skdp_error_none if the session is established, otherwise an \c skdp_errors code.
+ */
+SKDP_EXPORT_API skdp_errors skdp_unix_connect(skdp_client_state* ctx, qsc_socket* sock, const char* path);
+
+/*!
+ * \brief Bind a Unix domain socket to a path and listen for connections.
+ *
+ * \details
+ * A stale socket file at the path is removed before binding. The listener stays open for any number of
+ * \c skdp_unix_accept calls, and is closed and the path unlinked with \c skdp_unix_listen_close.
+ *
+ * \param path [const] The socket path, at most \c SKDP_UNIX_PATH_MAX characters.
+ *
+ * \return Returns the listening socket descriptor, or -1 on failure.
+ */
+SKDP_EXPORT_API int32_t skdp_unix_listen(const char* path);
+
+/*!
+ * \brief Close a Unix domain listener and remove its socket file.
+ *
+ * \param listener The listening socket descriptor returned by \c skdp_unix_listen.
+ * \param path [const] The socket path the listener was bound to, or NULL to leave the file in place.
+ */
+SKDP_EXPORT_API void skdp_unix_listen_close(int32_t listener, const char* path);
+
+/*!
+ * \brief Receive an established session handed off by another process.
+ *
+ * \details
+ * Receives the session socket descriptor and the serialized server state sent by \c skdp_unix_session_send, and
+ * restores the state with \c skdp_server_session_deserialize. The server state should be initialized with
+ * \c skdp_server_initialize beforehand. The socket structure is bound to the received descriptor.
+ *
+ * \param channel The Unix domain handoff channel descriptor.
+ * \param ctx A pointer to the SKDP server state, receives the session.
+ * \param sock A pointer to the socket structure, receives the session socket.
+ *
+ * \return Returns \c skdp_error_none if the session was received, otherwise an \c skdp_errors code.
+ */
+SKDP_EXPORT_API skdp_errors skdp_unix_session_receive(int32_t channel, skdp_server_state* ctx, qsc_socket* sock);
+
+/*!
+ * \brief Hand an established session off to another process.
+ *
+ * \details
+ * The session is quiesced first: the caller requests hibernation with \c skdp_server_hibernate and an idle threshold
+ * of zero, and passes the device acknowledgement to this function. The state is serialized at that ratchet point
+ * with \c skdp_server_session_serialize and sent with the session socket descriptor over the handoff channel.
+ * On success the session is moved: the local state is disposed of, and the local socket descriptor is closed without
+ * notifying the remote peer. If the handoff fails the session is restored in \c ctx and stays with the caller.
+ *
+ * \param channel The Unix domain handoff channel descriptor.
+ * \param ctx A pointer to the SKDP server state, in the \c skdp_flag_hibernate position.
+ * \param sock A pointer to the connected session socket.
+ * \param packetin [const] The device acknowledgement of the hibernate request.
+ *
+ * \return Returns \c skdp_error_none if the session was sent, otherwise an \c skdp_errors code.
+ */
+SKDP_EXPORT_API skdp_errors skdp_unix_session_send(int32_t channel, skdp_server_state* ctx, qsc_socket* sock, const skdp_network_packet* packetin);
+
+#endif
@@ -1,6 +1,7 @@
 #include "appsrv.h"
 #include "skdp.h"
 #include "skdpserver.h"
+#include "skdpkeyset.h"
 #include "acp.h"
 #include "consoleutils.h"
 #include "fileutils.h"
@@ -11,9 +12,12 @@
 #include "socketserver.h"
 #include "stringutils.h"
 #include "async.h"
+#include <signal.h>
 
 static skdp_keep_alive_state m_skdp_keep_alive;
 static skdp_server_state m_skdp_server_ctx;
+static skdp_server_keyset m_skdp_server_keys;
+static volatile sig_atomic_t m_skdp_reload_signal;
 
 typedef struct server_keepalive_loop_args
 {
@@ -259,6 +263,70 @@ static bool server_key_dialogue(skdp_server_key* skey, uint8_t keyid[SKDP_KID_SI
 	return res;
 }
 
+static bool server_key_reload(void)
+{
+	skdp_server_key skey = { 0 };
+	uint8_t serskey[SKDP_SRVKEY_ENCODED_SIZE] = { 0U };
+	char fpath[QSC_SYSTEM_MAX_PATH] = { 0 };
+	bool res;
+
+	res = server_get_storage_path(fpath, sizeof(fpath));
+
+	if (res == true)
+	{
+		qsc_folderutils_append_delimiter(fpath);
+		qsc_stringutils_concat_strings(fpath, sizeof(fpath), SKDP_SRVKEY_NAME);
+		res = qsc_fileutils_copy_file_to_stream(fpath, (char*)serskey, sizeof(serskey));
+
+		if (res == true)
+		{
+			/* new handshakes use the replacement key, established sessions are unaffected */
+			skdp_deserialize_server_key(&skey, serskey);
+			res = skdp_keyset_publish(&m_skdp_server_keys, &skey);
+		}
+
+		qsc_memutils_secure_erase(serskey, sizeof(serskey));
+		qsc_memutils_secure_erase(&skey, sizeof(skey));
+	}
+
+	if (res == true)
+	{
+		server_print_message("The server-key has been reloaded.");
+	}
+	else
+	{
+		server_print_message("Could not reload the server-key, the current key remains active.");
+	}
+
+	return res;
+}
+
+#if defined(SIGHUP)
+static void server_reload_signal(int sig)
+{
+	(void)sig;
+	m_skdp_reload_signal = 1;
+}
+
+static void server_reload_watcher(void* state)
+{
+	(void)state;
+
+	/* the key is reloaded outside of the signal handler */
+	while (true)
+	{
+		if (m_skdp_reload_signal != 0)
+		{
+			m_skdp_reload_signal = 0;
+			server_key_reload();
+			server_print_prompt();
+		}
+
+		qsc_async_thread_sleep(1000U);
+	}
+}
+#endif
+
 static skdp_errors server_keep_alive_loop(const qsc_socket* sock)
 {
 	qsc_mutex mtx;
@@ -270,7 +338,8 @@ static skdp_errors server_keep_alive_loop(const qsc_socket* sock)
 	{
 		m_skdp_keep_alive.recd = false;
 
-		serr = skdp_server_send_keep_alive(&m_skdp_keep_alive, sock);
+		/* probe only when no authenticated record arrived in the last interval */
+		serr = skdp_server_send_keep_alive_idle(&m_skdp_server_ctx, &m_skdp_keep_alive, sock, SKDP_KEEPALIVE_IDLE);
 		qsc_async_thread_sleep(SKDP_KEEPALIVE_TIMEOUT);
 
 		if (m_skdp_keep_alive.recd == false)
@@ -309,7 +378,8 @@ static void qsc_socket_receive_async_callback(qsc_socket* source, const uint8_t*
 	{
 		/* convert the bytes to packet */
 		pkt.pmessage = mpkt;
-		if (skdp_stream_to_packet(message, *msglen, &pkt, sizeof(mpkt)) == true && pkt.flag == skdp_flag_encrypted_message)
+		if (skdp_stream_to_packet(message, *msglen, &pkt, sizeof(mpkt)) == true &&
+			(pkt.flag == skdp_flag_encrypted_message || pkt.flag == skdp_flag_key_update))
 		{
 			qerr = skdp_server_decrypt_packet(&m_skdp_server_ctx, &pkt, (uint8_t*)msgstr, sizeof(msgstr), msglen);
 
@@ -376,7 +446,7 @@ static void qsc_socket_exception_callback(const qsc_socket* source, qsc_socket_e
 	}
 }
 
-static skdp_errors server_listen_ipv4(const skdp_server_key* skey)
+static skdp_errors server_listen_ipv4(skdp_server_keyset* keyset)
 {
 	qsc_socket_receive_async_state actx = { 0 };
 	qsc_socket ssck = { 0 };
@@ -393,8 +463,8 @@ static skdp_errors server_listen_ipv4(const skdp_server_key* skey)
 	qsc_memutils_clear((uint8_t*)&m_skdp_server_ctx, sizeof(m_skdp_server_ctx));
 	addt = qsc_ipinfo_ipv4_address_any();
 
-	/* initialize the client-to-client server */
-	skdp_server_initialize(&m_skdp_server_ctx, skey);
+	/* initialize the client-to-client server from the published key */
+	skdp_server_initialize_keyset(&m_skdp_server_ctx, keyset);
 	/* begin listening on the port, when a client connects it triggers the key exchange*/
 	err = skdp_server_listen_ipv4(&m_skdp_server_ctx, &ssck, &addt, SKDP_SERVER_PORT);
 
@@ -439,6 +509,11 @@ static skdp_errors server_listen_ipv4(const skdp_server_key* skey)
 					server_print_message("");
 					mlen = 0U;
 				}
+				else if (qsc_consoleutils_line_contains(sin, "skdp reload") == true)
+				{
+					server_key_reload();
+					mlen = 0U;
+				}
 			}
 
 			qsc_async_thread_wait(mthd);
@@ -464,8 +539,17 @@ int main(void)
 
 	if (server_key_dialogue(&skey, kid) == true)
 	{
+		skdp_keyset_initialize(&m_skdp_server_keys, &skey);
+		qsc_memutils_secure_erase(&skey, sizeof(skey));
+
+#if defined(SIGHUP)
+		/* SIGHUP reloads the server key without dropping the session */
+		signal(SIGHUP, &server_reload_signal);
+		qsc_async_thread_create(&server_reload_watcher, NULL);
+#endif
+		server_print_message("Enter 'skdp reload' to load a replacement server-key.");
 		server_print_message("Waiting for a connection...");
-		err = server_listen_ipv4(&skey);
+		err = server_listen_ipv4(&m_skdp_server_keys);
 
 		if (err != skdp_error_none)
 		{
@@ -478,6 +562,7 @@ int main(void)
 		server_print_message("The signature key-pair could not be created, the application will exit.");
 	}
 
+	skdp_keyset_dispose(&m_skdp_server_keys);
 	server_print_message("Press any key to close...");
 	qsc_consoleutils_get_wait();
 
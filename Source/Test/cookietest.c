@@ -0,0 +1,134 @@
+#include "cookietest.h"
+#include "skdp.h"
+#include "skdpclient.h"
+#include "skdprevoke.h"
+#include "skdpserver.h"
+#include "intutils.h"
+#include "memutils.h"
+
+typedef struct cookietest_link
+{
+	skdp_server_state sctx;
+	skdp_client_state cctx;
+	skdp_revocation rset;
+	uint8_t did[SKDP_KID_SIZE];
+	uint8_t pending[SKDP_SERVER_HANDSHAKE_BUFFER_SIZE];
+	size_t pendlen;
+	size_t pendpos;
+	skdp_errors err;
+	bool revoke;
+} cookietest_link;
+
+static size_t cookietest_send(void* user, const uint8_t* input, size_t inlen)
+{
+	cookietest_link* link;
+	skdp_errors err;
+
+	link = (cookietest_link*)user;
+
+	/* the revocation lands while the device holds the cookie */
+	if (link->revoke == true && input[0U] == (uint8_t)skdp_flag_exchange_cookie)
+	{
+		skdp_revocation_add(&link->rset, link->did);
+	}
+
+	link->pendlen = 0U;
+	link->pendpos = 0U;
+	err = skdp_server_handshake(&link->sctx, input, inlen, link->pending, sizeof(link->pending), &link->pendlen);
+
+	/* the first server failure is kept; the error notice the device sends back fails again */
+	if (link->err == skdp_error_none)
+	{
+		link->err = err;
+	}
+
+	return inlen;
+}
+
+static size_t cookietest_receive(void* user, uint8_t* output, size_t otplen)
+{
+	cookietest_link* link;
+	size_t rlen;
+
+	link = (cookietest_link*)user;
+	rlen = qsc_intutils_min(otplen, link->pendlen - link->pendpos);
+	qsc_memutils_copy(output, link->pending + link->pendpos, rlen);
+	link->pendpos += rlen;
+
+	return rlen;
+}
+
+static skdp_errors cookietest_connect(cookietest_link* link, const skdp_server_key* skey, const skdp_device_key* dkey, const uint8_t* ckey)
+{
+	skdp_transport trans = { 0 };
+	skdp_errors err;
+
+	skdp_server_initialize(&link->sctx, skey);
+	skdp_server_set_cookie_key(&link->sctx, ckey);
+	skdp_server_set_revocation(&link->sctx, &link->rset);
+	skdp_client_initialize(&link->cctx, dkey);
+	link->err = skdp_error_none;
+	trans.send = &cookietest_send;
+	trans.receive = &cookietest_receive;
+	trans.user = link;
+	err = skdp_client_connect_transport(&link->cctx, &trans);
+
+	return err;
+}
+
+bool skdptest_cookie_run(void)
+{
+	uint8_t ckey[SKDP_COOKIE_KEY_SIZE] = { 0U };
+	uint8_t kid[SKDP_KID_SIZE] = { 0x01U, 0x02U, 0x03U, 0x04U, 0x05U, 0x06U, 0x07U, 0x08U, 0x09U, 0x0AU, 0x0BU, 0x0CU, 0x0DU, 0x0EU, 0x0FU, 0x10U };
+	skdp_device_key dkey = { 0 };
+	skdp_master_key mkey = { 0 };
+	skdp_server_key skey = { 0 };
+	cookietest_link* link;
+	size_t i;
+	bool res;
+
+	res = false;
+	link = (cookietest_link*)qsc_memutils_malloc(sizeof(cookietest_link));
+
+	if (link != NULL && skdp_generate_master_key(&mkey, kid) == true)
+	{
+		qsc_memutils_clear(link, sizeof(cookietest_link));
+
+		for (i = 0U; i < sizeof(ckey); ++i)
+		{
+			ckey[i] = (uint8_t)(i + 1U);
+		}
+
+		skdp_generate_server_key(&skey, &mkey, kid);
+		skdp_generate_device_key(&dkey, &skey, kid);
+		qsc_memutils_copy(link->did, dkey.kid, SKDP_KID_SIZE);
+
+		if (skdp_revocation_initialize(&link->rset) == true)
+		{
+			/* an unrevoked device completes the exchange, then the same device is revoked mid-handshake */
+			if (cookietest_connect(link, &skey, &dkey, ckey) == skdp_error_none && link->err == skdp_error_none)
+			{
+				link->revoke = true;
+
+				if (cookietest_connect(link, &skey, &dkey, ckey) != skdp_error_none)
+				{
+					res = (link->err == skdp_error_device_revoked && link->sctx.exflag != skdp_flag_session_established);
+				}
+			}
+
+			skdp_revocation_dispose(&link->rset);
+		}
+	}
+
+	if (link != NULL)
+	{
+		qsc_memutils_secure_erase(link, sizeof(cookietest_link));
+		qsc_memutils_alloc_free(link);
+	}
+
+	qsc_memutils_secure_erase(&mkey, sizeof(skdp_master_key));
+	qsc_memutils_secure_erase(&skey, sizeof(skdp_server_key));
+	qsc_memutils_secure_erase(&dkey, sizeof(skdp_device_key));
+
+	return res;
+}
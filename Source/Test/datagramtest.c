@@ -0,0 +1,110 @@
+#include "datagramtest.h"
+#include "skdp.h"
+#include "skdpdatagram.h"
+#include "intutils.h"
+#include "memutils.h"
+#include "sha3.h"
+
+#define DATAGRAMTEST_RECORDS 8U
+
+static const uint8_t DATAGRAMTEST_LABEL[] = "skdp datagram";
+
+static void datagramtest_reference(uint8_t* key, uint8_t* nonce, const skdp_cipher_suite* suite, const uint8_t* secret)
+{
+	const size_t RNDBLK = (SKDP_CPRKEY_SIZE + SKDP_NONCE_SIZE + SKDP_PERMUTATION_RATE - 1U) / SKDP_PERMUTATION_RATE;
+	qsc_keccak_state kctx = { 0 };
+	uint8_t prnd[SKDP_PERMUTATION_RATE * 2U] = { 0U };
+
+	/* the record key and base nonce, derived as the datagram state derives them */
+	qsc_cshake_initialize(&kctx, SKDP_PERMUTATION_RATE, secret, SKDP_KEY_UPDATE_SECRET_SIZE, DATAGRAMTEST_LABEL, sizeof(DATAGRAMTEST_LABEL) - 1U, NULL, 0U);
+	qsc_cshake_squeezeblocks(&kctx, SKDP_PERMUTATION_RATE, prnd, RNDBLK);
+	qsc_memutils_copy(key, prnd, suite->keysize);
+	qsc_memutils_copy(nonce, prnd + suite->keysize, suite->noncesize);
+}
+
+static bool datagramtest_compare(const skdp_cipher_suite* suite, const uint8_t* key, const uint8_t* base, uint64_t seq, const uint8_t* record, const uint8_t* message, size_t msglen)
+{
+	uint8_t nonce[SKDP_NONCE_SIZE] = { 0U };
+	uint8_t output[SKDP_HEADER_SIZE + SKDP_MESSAGE_SIZE + SKDP_MACTAG_SIZE] = { 0U };
+	skdp_cipher_state cpr;
+	size_t i;
+	bool res;
+
+	/* a cipher initialized for this record alone, under the base nonce with the sequence folded in */
+	qsc_memutils_copy(nonce, base, suite->noncesize);
+
+	for (i = 0U; i < sizeof(uint64_t); ++i)
+	{
+		nonce[i] ^= (uint8_t)(seq >> (i * 8U));
+	}
+
+	skdp_cipher_initialize(&cpr, suite, key, nonce, true);
+	skdp_cipher_set_associated(&cpr, record, SKDP_HEADER_SIZE);
+	res = skdp_cipher_transform(&cpr, output, message, msglen);
+	skdp_cipher_dispose(&cpr);
+
+	return (res == true && qsc_intutils_are_equal8(output, record + SKDP_HEADER_SIZE, msglen + suite->tagsize) == true);
+}
+
+bool skdptest_datagram_run(void)
+{
+	uint8_t dsec[SKDP_KEY_UPDATE_SECRET_SIZE] = { 0U };
+	uint8_t ssec[SKDP_KEY_UPDATE_SECRET_SIZE] = { 0U };
+	uint8_t key[SKDP_CPRKEY_SIZE] = { 0U };
+	uint8_t base[SKDP_NONCE_SIZE] = { 0U };
+	uint8_t message[DATAGRAMTEST_RECORDS][64U] = { 0U };
+	uint8_t records[DATAGRAMTEST_RECORDS][SKDP_DATAGRAM_MTU] = { 0U };
+	size_t rlens[DATAGRAMTEST_RECORDS] = { 0U };
+	uint8_t output[SKDP_DATAGRAM_MTU] = { 0U };
+	skdp_datagram_state rcv = { 0 };
+	skdp_datagram_state snd = { 0 };
+	const skdp_cipher_suite* suite;
+	size_t i;
+	size_t mlen;
+	bool res;
+
+	res = true;
+	suite = skdp_cipher_suite_default();
+
+	for (i = 0U; i < sizeof(dsec); ++i)
+	{
+		dsec[i] = (uint8_t)i;
+		ssec[i] = (uint8_t)(0xFFU - i);
+	}
+
+	/* the device transmits under dsec and the server receives under it */
+	skdp_datagram_initialize(&snd, suite, dsec, ssec);
+	skdp_datagram_initialize(&rcv, suite, ssec, dsec);
+	datagramtest_reference(key, base, suite, dsec);
+
+	for (i = 0U; i < DATAGRAMTEST_RECORDS && res == true; ++i)
+	{
+		qsc_memutils_setvalue(message[i], (uint8_t)(i + 1U), sizeof(message[i]));
+		res = (skdp_datagram_seal(&snd, message[i], i + 1U, records[i], sizeof(records[i]), &rlens[i]) == skdp_error_none);
+
+		if (res == true)
+		{
+			res = datagramtest_compare(suite, key, base, snd.txseq, records[i], message[i], i + 1U);
+		}
+	}
+
+	/* records are opened in reverse order, each must authenticate and match its message */
+	for (i = DATAGRAMTEST_RECORDS; i > 0U && res == true; --i)
+	{
+		res = (skdp_datagram_open(&rcv, records[i - 1U], rlens[i - 1U], output, sizeof(output), &mlen) == skdp_error_none &&
+			mlen == i && qsc_intutils_are_equal8(output, message[i - 1U], mlen) == true);
+	}
+
+	if (res == true)
+	{
+		/* a replayed record is rejected */
+		res = (skdp_datagram_open(&rcv, records[0U], rlens[0U], output, sizeof(output), &mlen) == skdp_error_unsequenced);
+	}
+
+	skdp_datagram_dispose(&snd);
+	skdp_datagram_dispose(&rcv);
+	qsc_memutils_secure_erase(key, sizeof(key));
+	qsc_memutils_secure_erase(base, sizeof(base));
+
+	return res;
+}
@@ -0,0 +1,135 @@
+#include "pooltest.h"
+#include "skdp.h"
+#include "skdppool.h"
+#include "skdpserver.h"
+#include "async.h"
+#include "intutils.h"
+#include "ipinfo.h"
+#include "memutils.h"
+
+#define POOLTEST_INTERVAL 10U
+#define POOLTEST_PASSES 50U
+#define POOLTEST_PORT 38201U
+#define POOLTEST_WAIT 600U
+
+typedef struct pooltest_server
+{
+	skdp_server_state ctx;
+	qsc_socket sock;
+	qsc_ipinfo_ipv4_address address;
+	skdp_errors err;
+	volatile bool done;
+} pooltest_server;
+
+static void pooltest_listener(void* state)
+{
+	pooltest_server* srv;
+
+	srv = (pooltest_server*)state;
+	srv->err = skdp_server_listen_ipv4(&srv->ctx, &srv->sock, &srv->address, POOLTEST_PORT);
+
+	/* hold the connection open until the client side is finished */
+	while (srv->done == false)
+	{
+		qsc_async_thread_sleep(POOLTEST_INTERVAL);
+	}
+
+	skdp_server_connection_close(&srv->ctx, &srv->sock, skdp_error_none);
+}
+
+static skdp_pool_session* pooltest_checkout(skdp_pool* pool, const skdp_pool_endpoint* endpoint)
+{
+	skdp_pool_session* ps;
+	size_t i;
+
+	ps = NULL;
+
+	/* the first checkout waits for the maintenance thread to establish the session */
+	for (i = 0U; i < POOLTEST_WAIT && ps == NULL; ++i)
+	{
+		ps = skdp_pool_checkout(pool, endpoint);
+
+		if (ps == NULL)
+		{
+			qsc_async_thread_sleep(POOLTEST_INTERVAL);
+		}
+	}
+
+	return ps;
+}
+
+bool skdptest_pool_run(void)
+{
+	uint8_t cid[SKDP_CONNECTION_ID_SIZE] = { 0U };
+	uint8_t kid[SKDP_KID_SIZE] = { 0x01U, 0x02U, 0x03U, 0x04U, 0x05U, 0x06U, 0x07U, 0x08U, 0x09U, 0x0AU, 0x0BU, 0x0CU, 0x0DU, 0x0EU, 0x0FU, 0x10U };
+	skdp_device_key dkey = { 0 };
+	skdp_master_key mkey = { 0 };
+	skdp_server_key skey = { 0 };
+	skdp_pool_endpoint endpoint = { 0 };
+	skdp_pool pool = { 0 };
+	skdp_pool_session* ps;
+	pooltest_server* srv;
+	qsc_thread thd;
+	bool res;
+
+	res = false;
+	srv = (pooltest_server*)qsc_memutils_malloc(sizeof(pooltest_server));
+
+	if (srv != NULL && skdp_generate_master_key(&mkey, kid) == true)
+	{
+		qsc_memutils_clear(srv, sizeof(pooltest_server));
+		skdp_generate_server_key(&skey, &mkey, kid);
+		skdp_generate_device_key(&dkey, &skey, kid);
+		skdp_server_initialize(&srv->ctx, &skey);
+		srv->address = qsc_ipinfo_ipv4_address_from_string("127.0.0.1");
+		thd = qsc_async_thread_create(&pooltest_listener, srv);
+		qsc_async_thread_sleep(POOLTEST_INTERVAL * 10U);
+
+		skdp_pool_endpoint_ipv4(&endpoint, &srv->address, POOLTEST_PORT);
+
+		if (skdp_pool_initialize(&pool, &dkey, 1U, POOLTEST_INTERVAL) == true)
+		{
+			if (skdp_pool_add(&pool, &endpoint, 1U) == true)
+			{
+				ps = pooltest_checkout(&pool, &endpoint);
+
+				if (ps != NULL)
+				{
+					qsc_memutils_copy(cid, ps->ctx.cid, SKDP_CONNECTION_ID_SIZE);
+					skdp_pool_checkin(&pool, ps, skdp_error_none);
+
+					/* let the maintenance thread service the idle session */
+					qsc_async_thread_sleep(POOLTEST_INTERVAL * POOLTEST_PASSES);
+
+					/* the server accepts one connection, a re-established session cannot be checked out */
+					ps = skdp_pool_checkout(&pool, &endpoint);
+
+					if (ps != NULL)
+					{
+						res = (ps->ctx.exflag == skdp_flag_session_established &&
+							qsc_intutils_are_equal8(cid, ps->ctx.cid, SKDP_CONNECTION_ID_SIZE) == true);
+						skdp_pool_checkin(&pool, ps, skdp_error_none);
+					}
+				}
+			}
+
+			skdp_pool_dispose(&pool);
+		}
+
+		srv->done = true;
+		qsc_async_thread_wait(thd);
+		res = (res == true && srv->err == skdp_error_none);
+	}
+
+	if (srv != NULL)
+	{
+		qsc_memutils_clear(srv, sizeof(pooltest_server));
+		qsc_memutils_alloc_free(srv);
+	}
+
+	qsc_memutils_secure_erase(&mkey, sizeof(skdp_master_key));
+	qsc_memutils_secure_erase(&skey, sizeof(skdp_server_key));
+	qsc_memutils_secure_erase(&dkey, sizeof(skdp_device_key));
+
+	return res;
+}
@@ -0,0 +1,283 @@
+#include "sessiontest.h"
+#include "skdp.h"
+#include "skdpclient.h"
+#include "skdpserver.h"
+#include "intutils.h"
+#include "memutils.h"
+
+#define SESSIONTEST_MESSAGE_SIZE 64U
+
+typedef struct sessiontest_link
+{
+	skdp_server_state sctx;
+	skdp_client_state cctx;
+	uint8_t pending[SKDP_SERVER_HANDSHAKE_BUFFER_SIZE];
+	size_t pendlen;
+	size_t pendpos;
+} sessiontest_link;
+
+static size_t sessiontest_exchange_send(void* user, const uint8_t* input, size_t inlen)
+{
+	sessiontest_link* link;
+
+	/* the server answers each client packet as it is sent */
+	link = (sessiontest_link*)user;
+	link->pendlen = 0U;
+	link->pendpos = 0U;
+	skdp_server_handshake(&link->sctx, input, inlen, link->pending, sizeof(link->pending), &link->pendlen);
+
+	return inlen;
+}
+
+static size_t sessiontest_record_send(void* user, const uint8_t* input, size_t inlen)
+{
+	sessiontest_link* link;
+	size_t res;
+
+	link = (sessiontest_link*)user;
+	res = 0U;
+
+	if (inlen <= sizeof(link->pending))
+	{
+		qsc_memutils_copy(link->pending, input, inlen);
+		link->pendlen = inlen;
+		link->pendpos = 0U;
+		res = inlen;
+	}
+
+	return res;
+}
+
+static size_t sessiontest_receive(void* user, uint8_t* output, size_t otplen)
+{
+	sessiontest_link* link;
+	size_t rlen;
+
+	link = (sessiontest_link*)user;
+	rlen = qsc_intutils_min(otplen, link->pendlen - link->pendpos);
+	qsc_memutils_copy(output, link->pending + link->pendpos, rlen);
+	link->pendpos += rlen;
+
+	return rlen;
+}
+
+static bool sessiontest_exchange(skdp_client_state* cctx, skdp_server_state* sctx)
+{
+	uint8_t cmsg[SESSIONTEST_MESSAGE_SIZE] = { 0U };
+	uint8_t pmsg[SESSIONTEST_MESSAGE_SIZE + SKDP_MACTAG_SIZE] = { 0U };
+	uint8_t smsg[SESSIONTEST_MESSAGE_SIZE] = { 0U };
+	uint8_t tmsg[SESSIONTEST_MESSAGE_SIZE] = { 0U };
+	skdp_network_packet pkt = { 0 };
+	size_t mlen;
+	size_t i;
+	bool res;
+
+	for (i = 0U; i < sizeof(cmsg); ++i)
+	{
+		cmsg[i] = (uint8_t)i;
+		smsg[i] = (uint8_t)(0xFFU - i);
+	}
+
+	res = false;
+	pkt.pmessage = pmsg;
+
+	if (skdp_client_encrypt_packet(cctx, cmsg, sizeof(cmsg), &pkt) == skdp_error_none &&
+		skdp_server_decrypt_packet(sctx, &pkt, tmsg, sizeof(tmsg), &mlen) == skdp_error_none &&
+		mlen == sizeof(cmsg) && qsc_intutils_are_equal8(cmsg, tmsg, sizeof(cmsg)) == true)
+	{
+		if (skdp_server_encrypt_packet(sctx, smsg, sizeof(smsg), &pkt) == skdp_error_none &&
+			skdp_client_decrypt_packet(cctx, &pkt, tmsg, sizeof(tmsg), &mlen) == skdp_error_none &&
+			mlen == sizeof(smsg) && qsc_intutils_are_equal8(smsg, tmsg, sizeof(smsg)) == true)
+		{
+			res = true;
+		}
+	}
+
+	return res;
+}
+
+static bool sessiontest_quiesce(sessiontest_link* link, const skdp_server_key* skey, const skdp_device_key* dkey)
+{
+	uint8_t hmsg[SKDP_MACTAG_SIZE] = { 0U };
+	skdp_network_packet hreq = { 0 };
+	skdp_transport ctrans = { 0 };
+	skdp_transport strans = { 0 };
+	size_t mlen;
+	bool pending;
+	bool res;
+
+	res = false;
+	qsc_memutils_clear(link, sizeof(sessiontest_link));
+	skdp_server_initialize(&link->sctx, skey);
+	skdp_client_initialize(&link->cctx, dkey);
+	ctrans.send = &sessiontest_exchange_send;
+	ctrans.receive = &sessiontest_receive;
+	ctrans.user = link;
+	strans.send = &sessiontest_record_send;
+	strans.receive = &sessiontest_receive;
+	strans.user = link;
+
+	if (skdp_client_connect_transport(&link->cctx, &ctrans) == skdp_error_none &&
+		sessiontest_exchange(&link->cctx, &link->sctx) == true)
+	{
+		/* the request is sent whatever the idle time, and leaves the client with the acknowledgement pending */
+		hreq.pmessage = hmsg;
+
+		if (skdp_server_hibernate(&link->sctx, &strans, 0U, &pending) == skdp_error_none && pending == true &&
+			skdp_stream_to_packet(link->pending, link->pendlen, &hreq, sizeof(hmsg)) == true &&
+			skdp_client_decrypt_packet(&link->cctx, &hreq, hmsg, sizeof(hmsg), &mlen) == skdp_error_none)
+		{
+			res = (link->cctx.exflag == skdp_flag_hibernate);
+		}
+	}
+
+	return res;
+}
+
+static void sessiontest_keys(skdp_server_key* skey, skdp_device_key* dkey, uint8_t* ekey)
+{
+	uint8_t kid[SKDP_KID_SIZE] = { 0x01U, 0x02U, 0x03U, 0x04U, 0x05U, 0x06U, 0x07U, 0x08U, 0x09U, 0x0AU, 0x0BU, 0x0CU, 0x0DU, 0x0EU, 0x0FU, 0x10U };
+	skdp_master_key mkey = { 0 };
+	size_t i;
+
+	skdp_generate_master_key(&mkey, kid);
+	skdp_generate_server_key(skey, &mkey, kid);
+	skdp_generate_device_key(dkey, skey, kid);
+
+	for (i = 0U; i < SKDP_SESSION_EXPORT_KEY_SIZE; ++i)
+	{
+		ekey[i] = (uint8_t)(i + 1U);
+	}
+
+	qsc_memutils_secure_erase(&mkey, sizeof(skdp_master_key));
+}
+
+bool skdptest_hibernate_run(void)
+{
+	uint8_t ekey[SKDP_SESSION_EXPORT_KEY_SIZE] = { 0U };
+	uint8_t hrec[SKDP_SERVER_HIBERNATE_SIZE] = { 0U };
+	uint8_t amsg[SKDP_MACTAG_SIZE] = { 0U };
+	skdp_device_key dkey = { 0 };
+	skdp_server_key skey = { 0 };
+	skdp_network_packet ack = { 0 };
+	sessiontest_link* link;
+	skdp_server_state* snew;
+	size_t hlen;
+	bool res;
+
+	res = false;
+	link = (sessiontest_link*)qsc_memutils_malloc(sizeof(sessiontest_link));
+	snew = (skdp_server_state*)qsc_memutils_malloc(sizeof(skdp_server_state));
+
+	if (link != NULL && snew != NULL)
+	{
+		sessiontest_keys(&skey, &dkey, ekey);
+
+		if (sessiontest_quiesce(link, &skey, &dkey) == true)
+		{
+			ack.pmessage = amsg;
+
+			/* the client keeps its state; the server keeps only the record and wakes into a new state */
+			if (skdp_client_hibernate_ack(&link->cctx, &ack) == skdp_error_none &&
+				skdp_server_hibernate_complete(&link->sctx, &ack, ekey, hrec, sizeof(hrec), &hlen) == skdp_error_none &&
+				link->sctx.exflag == skdp_flag_none)
+			{
+				skdp_server_initialize(snew, &skey);
+
+				if (skdp_server_wake(snew, ekey, hrec, hlen) == true)
+				{
+					res = (sessiontest_exchange(&link->cctx, snew) == true && sessiontest_exchange(&link->cctx, snew) == true);
+				}
+			}
+		}
+	}
+
+	if (link != NULL)
+	{
+		qsc_memutils_secure_erase(link, sizeof(sessiontest_link));
+		qsc_memutils_alloc_free(link);
+	}
+
+	if (snew != NULL)
+	{
+		qsc_memutils_secure_erase(snew, sizeof(skdp_server_state));
+		qsc_memutils_alloc_free(snew);
+	}
+
+	qsc_memutils_secure_erase(hrec, sizeof(hrec));
+	qsc_memutils_secure_erase(&skey, sizeof(skdp_server_key));
+	qsc_memutils_secure_erase(&dkey, sizeof(skdp_device_key));
+
+	return res;
+}
+
+bool skdptest_session_run(void)
+{
+	uint8_t ekey[SKDP_SESSION_EXPORT_KEY_SIZE] = { 0U };
+	uint8_t cexp[SKDP_CLIENT_SESSION_EXPORT_SIZE] = { 0U };
+	uint8_t sexp[SKDP_SERVER_SESSION_EXPORT_SIZE] = { 0U };
+	uint8_t amsg[SKDP_MACTAG_SIZE] = { 0U };
+	skdp_device_key dkey = { 0 };
+	skdp_server_key skey = { 0 };
+	skdp_network_packet ack = { 0 };
+	sessiontest_link* link;
+	skdp_client_state* cnew;
+	skdp_server_state* snew;
+	size_t clen;
+	size_t slen;
+	bool res;
+
+	res = false;
+	link = (sessiontest_link*)qsc_memutils_malloc(sizeof(sessiontest_link));
+	cnew = (skdp_client_state*)qsc_memutils_malloc(sizeof(skdp_client_state));
+	snew = (skdp_server_state*)qsc_memutils_malloc(sizeof(skdp_server_state));
+
+	if (link != NULL && cnew != NULL && snew != NULL)
+	{
+		sessiontest_keys(&skey, &dkey, ekey);
+
+		if (sessiontest_quiesce(link, &skey, &dkey) == true)
+		{
+			ack.pmessage = amsg;
+
+			/* both sides export at the ratchet point, and the exports continue in fresh states */
+			if (skdp_client_session_export(&link->cctx, &ack, ekey, cexp, sizeof(cexp), &clen) == skdp_error_none &&
+				skdp_server_session_export(&link->sctx, &ack, ekey, sexp, sizeof(sexp), &slen) == skdp_error_none)
+			{
+				skdp_client_initialize(cnew, &dkey);
+				skdp_server_initialize(snew, &skey);
+
+				if (skdp_client_session_import(cnew, ekey, cexp, clen) == true &&
+					skdp_server_session_import(snew, ekey, sexp, slen) == true)
+				{
+					res = (sessiontest_exchange(cnew, snew) == true && sessiontest_exchange(cnew, snew) == true);
+				}
+			}
+		}
+	}
+
+	if (link != NULL)
+	{
+		qsc_memutils_secure_erase(link, sizeof(sessiontest_link));
+		qsc_memutils_alloc_free(link);
+	}
+
+	if (cnew != NULL)
+	{
+		qsc_memutils_secure_erase(cnew, sizeof(skdp_client_state));
+		qsc_memutils_alloc_free(cnew);
+	}
+
+	if (snew != NULL)
+	{
+		qsc_memutils_secure_erase(snew, sizeof(skdp_server_state));
+		qsc_memutils_alloc_free(snew);
+	}
+
+	qsc_memutils_secure_erase(cexp, sizeof(cexp));
+	qsc_memutils_secure_erase(sexp, sizeof(sexp));
+	qsc_memutils_secure_erase(&skey, sizeof(skdp_server_key));
+	qsc_memutils_secure_erase(&dkey, sizeof(skdp_device_key));
+
+	return res;
+}
@@ -0,0 +1,50 @@
+#include "cookietest.h"
+#include "datagramtest.h"
+#include "pooltest.h"
+#include "sessiontest.h"
+#include "consoleutils.h"
+
+static bool test_run(const char* name, bool (*test)(void))
+{
+	bool res;
+
+	res = test();
+	qsc_consoleutils_print_safe((res == true) ? "Success! " : "Failure! ");
+	qsc_consoleutils_print_line(name);
+
+	return res;
+}
+
+int main(void)
+{
+	int32_t ret;
+
+	ret = 0;
+
+	if (test_run("Cookie handshake: a device revoked while it holds a cookie is refused.", &skdptest_cookie_run) == false)
+	{
+		ret = 1;
+	}
+
+	if (test_run("Datagram: records match a freshly initialized cipher and open out of order.", &skdptest_datagram_run) == false)
+	{
+		ret = 1;
+	}
+
+	if (test_run("Connection pool: an idle session survives the maintenance passes.", &skdptest_pool_run) == false)
+	{
+		ret = 1;
+	}
+
+	if (test_run("Hibernation: a hibernated session wakes into a fresh server state.", &skdptest_hibernate_run) == false)
+	{
+		ret = 1;
+	}
+
+	if (test_run("Session export: exported sessions continue in fresh states on both sides.", &skdptest_session_run) == false)
+	{
+		ret = 1;
+	}
+
+	return ret;
+}